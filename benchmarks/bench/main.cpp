@@ -0,0 +1,1050 @@
+/**
+ * @file  main.cpp
+ * @brief Micro-benchmarks of the SQLiteC++ wrapper compared to the raw sqlite3 C API.
+ *
+ *  Each group of benchmarks runs the same operation through the wrapper and through the sqlite3_* functions,
+ * on the same connection, and the results are written as JSON to track the overhead of the wrapper over time:
+ *
+ *      SQLiteCpp_bench [--filter=<substring>] [--min-time=<seconds>] [--output=<file.json>]
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <sqlite3.h>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <SQLiteCpp/Backup.h>
+#include <SQLiteCpp/Allocator.h>
+#include <SQLiteCpp/MemoryVfs.h>
+#ifdef SQLITECPP_BENCH_VFS_URING
+#include <SQLiteCpp/UringVfs.h>
+#endif
+
+
+#ifdef SQLITECPP_ENABLE_ASSERT_HANDLER
+namespace SQLite
+{
+/// definition of the assertion handler enabled when SQLITECPP_ENABLE_ASSERT_HANDLER is defined in the project (CMakeList.txt)
+void assertion_failed(const char* apFile, const long apLine, const char* apFunc, const char* apExpr, const char* apMsg)
+{
+    // Print a message to the standard error output stream, and abort the program.
+    std::cerr << apFile << ":" << apLine << ":" << " error: assertion failed (" << apExpr << ") in " << apFunc << "() with message \"" << apMsg << "\"\n";
+    std::abort();
+}
+}
+#endif
+
+/// Number of rows of the table scanned by the benchmarks
+static const int BENCH_ROWS = 1000;
+/// Database file of the cold scan benchmarks, in the current directory
+static const char* const BENCH_FILENAME = "SQLiteCpp_bench.db3";
+
+/// Accumulate the values read by the benchmarks, so that the compiler cannot optimize them away
+static volatile int64_t sSink = 0;
+
+
+/// One operation to measure, run through one implementation (the first one of a group is its baseline)
+struct Benchmark
+{
+    std::string                     group;      ///< Operation measured, shared by all the implementations compared
+    std::string                     impl;       ///< Implementation: "raw", "wrapper"...
+    uint64_t                        items;      ///< Number of items (rows, pages...) processed by one operation
+    uint64_t                        bytes;      ///< Number of bytes processed by one operation, or 0
+    std::function<void(uint64_t)>   run;        ///< Run the given number of operations
+};
+
+/// Measure of one benchmark
+struct Result
+{
+    std::string group;      ///< Operation measured
+    std::string impl;       ///< Implementation measured
+    uint64_t    items;      ///< Number of items processed by one operation
+    uint64_t    bytes;      ///< Number of bytes processed by one operation, or 0
+    uint64_t    iterations; ///< Number of operations run for the final measure
+    double      nsPerOp;    ///< Mean duration of one operation, in nanoseconds
+};
+
+/// Options of the command line
+struct Options
+{
+    std::string filter;             ///< Only run the benchmarks whose "group/impl" name contains this substring
+    double      minTime = 0.5;      ///< Minimal duration of the measure of each benchmark, in seconds
+    std::string output;             ///< JSON output file, or empty for the standard output
+};
+
+
+/// Run a benchmark for a number of iterations growing until it lasts at least the minimal duration
+static Result measure(const Benchmark& aBenchmark, const double aMinTime)
+{
+    // a first untimed run warms up the caches
+    aBenchmark.run(1);
+    uint64_t iterations = 1;
+    for (;;)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        aBenchmark.run(iterations);
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if ((elapsed >= aMinTime) || (iterations >= (1ULL << 40)))
+        {
+            const double nsPerOp = elapsed * 1e9 / static_cast<double>(iterations);
+            return Result{aBenchmark.group, aBenchmark.impl, aBenchmark.items, aBenchmark.bytes, iterations, nsPerOp};
+        }
+        // Aim for 20% over the minimal duration, growing at most by 10 at a time as the first runs are noisy
+        double next = (elapsed > 0.0) ? (static_cast<double>(iterations) * aMinTime * 1.2 / elapsed) : 0.0;
+        if (next > static_cast<double>(iterations) * 10.0)
+        {
+            next = static_cast<double>(iterations) * 10.0;
+        }
+        iterations = (next > static_cast<double>(iterations)) ? static_cast<uint64_t>(next) : (iterations * 2);
+    }
+}
+
+/// Escape a string for JSON (the names of the benchmarks are plain ASCII)
+static std::string toJson(const std::string& aString)
+{
+    std::string json = "\"";
+    for (const char c : aString)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            json += '\\';
+        }
+        json += c;
+    }
+    return json + "\"";
+}
+
+/// Write the results as a JSON document, with the ratio of each implementation to the baseline of its group
+static void writeJson(std::ostream& aStream, const std::vector<Result>& aResults)
+{
+    aStream << "{\n";
+    aStream << "  \"sqlitecpp_version\": " << toJson(SQLITECPP_VERSION) << ",\n";
+    aStream << "  \"sqlite_version\": " << toJson(sqlite3_libversion()) << ",\n";
+    aStream << "  \"benchmarks\": [";
+    for (size_t i = 0; i < aResults.size(); ++i)
+    {
+        const Result&   result = aResults[i];
+        const double    opsPerSecond = 1e9 / result.nsPerOp;
+        aStream << (i ? ",\n" : "\n") << "    {"
+                << "\"name\": " << toJson(result.group + "/" + result.impl)
+                << ", \"group\": " << toJson(result.group)
+                << ", \"impl\": " << toJson(result.impl)
+                << ", \"iterations\": " << result.iterations
+                << ", \"ns_per_op\": " << result.nsPerOp
+                << ", \"items_per_second\": " << opsPerSecond * static_cast<double>(result.items)
+                << ", \"bytes_per_second\": " << opsPerSecond * static_cast<double>(result.bytes)
+                << "}";
+    }
+    aStream << "\n  ],\n";
+    aStream << "  \"comparisons\": [";
+    bool bFirst = true;
+    for (size_t i = 0; i < aResults.size(); ++i)
+    {
+        // the baseline of a group is the first of its benchmarks that has been run
+        const Result* pBaseline = nullptr;
+        for (size_t j = 0; (j < i) && (nullptr == pBaseline); ++j)
+        {
+            if (aResults[j].group == aResults[i].group)
+            {
+                pBaseline = &aResults[j];
+            }
+        }
+        if (nullptr != pBaseline)
+        {
+            aStream << (bFirst ? "\n" : ",\n") << "    {"
+                    << "\"group\": " << toJson(aResults[i].group)
+                    << ", \"baseline\": " << toJson(pBaseline->impl)
+                    << ", \"impl\": " << toJson(aResults[i].impl)
+                    << ", \"ratio\": " << aResults[i].nsPerOp / pBaseline->nsPerOp
+                    << "}";
+            bFirst = false;
+        }
+    }
+    aStream << "\n  ]\n";
+    aStream << "}\n";
+}
+
+/// Tell if a benchmark is selected by the filter of the command line
+static bool isSelected(const Benchmark& aBenchmark, const Options& aOptions)
+{
+    return (aBenchmark.group + "/" + aBenchmark.impl).find(aOptions.filter) != std::string::npos;
+}
+
+/// Measure a benchmark, reporting progress on the error output
+static void run(const Benchmark& aBenchmark, const Options& aOptions, std::vector<Result>& aResults)
+{
+    aResults.push_back(measure(aBenchmark, aOptions.minTime));
+    std::cerr << aBenchmark.group << "/" << aBenchmark.impl << ": " << aResults.back().nsPerOp << " ns/op\n";
+}
+
+/// Check the return code of a raw sqlite3 function
+static void check(sqlite3* apSQLite, const int aRet)
+{
+    if ((SQLITE_OK != aRet) && (SQLITE_DONE != aRet) && (SQLITE_ROW != aRet))
+    {
+        throw SQLite::Exception(apSQLite, aRet);
+    }
+}
+
+/// Fill the "bench" table with BENCH_ROWS rows
+static void fillTable(SQLite::Database& aDb)
+{
+    aDb.exec("CREATE TABLE bench (id INTEGER PRIMARY KEY, value INTEGER, name TEXT)");
+    SQLite::Transaction transaction(aDb);
+    SQLite::Statement   insert(aDb, "INSERT INTO bench VALUES (?, ?, ?)");
+    for (int i = 0; i < BENCH_ROWS; ++i)
+    {
+        insert.bind(1, i);
+        insert.bind(2, i * 7);
+        insert.bind(3, "name of the row number " + std::to_string(i));
+        insert.exec();
+        insert.reset();
+    }
+    transaction.commit();
+}
+
+
+/**
+ * @brief Benchmarks of the wrapper against the raw sqlite3 C API, on the same in-memory connection.
+ *
+ *  The raw statements are prepared on the handle of the Database, and finalized by the destructor.
+ */
+class WrapperBenchmarks
+{
+public:
+    // Open the connections and fill the tables
+    WrapperBenchmarks() :
+        mDb(":memory:", SQLite::OPEN_READWRITE),
+        mBackupSrc(":memory:", SQLite::OPEN_READWRITE)
+    {
+        fillTable(mDb);
+        // a database of a few MB for the backup
+        mBackupSrc.exec("CREATE TABLE blob (id INTEGER PRIMARY KEY, data BLOB)");
+        mBackupSrc.exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM n WHERE i < 1000) "
+                        "INSERT INTO blob SELECT i, randomblob(4000) FROM n");
+        mBackupBytes = static_cast<uint64_t>(mBackupSrc.execAndGet("PRAGMA page_count").getInt64())
+                     * static_cast<uint64_t>(mBackupSrc.execAndGet("PRAGMA page_size").getInt64());
+    }
+    // Finalize the raw statements
+    ~WrapperBenchmarks()
+    {
+        for (sqlite3_stmt* pStmt : mRawStmts)
+        {
+            sqlite3_finalize(pStmt);
+        }
+    }
+
+    /// Register the benchmarks, the raw implementation first as the baseline of each group
+    void add(std::vector<Benchmark>& aBenchmarks)
+    {
+        addPrepare(aBenchmarks);
+        addBind(aBenchmarks);
+        addExecuteStep(aBenchmarks);
+        addGetColumn(aBenchmarks);
+        addGetString(aBenchmarks);
+        addTransaction(aBenchmarks);
+        addErrorCodes(aBenchmarks);
+        addTableExists(aBenchmarks);
+        addBackup(aBenchmarks);
+    }
+
+private:
+    /// Prepare a raw statement, finalized by the destructor
+    sqlite3_stmt* prepareRaw(const char* apQuery)
+    {
+        sqlite3_stmt* pStmt = nullptr;
+        check(mDb.getHandle(), sqlite3_prepare_v2(mDb.getHandle(), apQuery, -1, &pStmt, nullptr));
+        mRawStmts.push_back(pStmt);
+        return pStmt;
+    }
+
+    /// Compile and finalize a query
+    void addPrepare(std::vector<Benchmark>& aBenchmarks)
+    {
+        static const char* const query = "SELECT id, value, name FROM bench WHERE id = ?";
+        sqlite3* const pSQLite = mDb.getHandle();
+        aBenchmarks.push_back({"prepare", "raw", 1, 0, [pSQLite](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                sqlite3_stmt* pStmt = nullptr;
+                check(pSQLite, sqlite3_prepare_v2(pSQLite, query, -1, &pStmt, nullptr));
+                sqlite3_finalize(pStmt);
+            }
+        }});
+        aBenchmarks.push_back({"prepare", "wrapper", 1, 0, [this](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                SQLite::Statement statement(mDb, query);
+            }
+        }});
+    }
+
+    /// Bind three parameters (int, int64 and text) by index, then by name
+    void addBind(std::vector<Benchmark>& aBenchmarks)
+    {
+        sqlite3_stmt* const pPositional = prepareRaw("SELECT ?, ?, ?");
+        aBenchmarks.push_back({"bind_positional", "raw", 1, 0, [pPositional](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                sqlite3_bind_int(pPositional, 1, static_cast<int>(i));
+                sqlite3_bind_int64(pPositional, 2, static_cast<sqlite3_int64>(i));
+                sqlite3_bind_text(pPositional, 3, "text", 4, SQLITE_TRANSIENT);
+            }
+        }});
+        mStatements.emplace_back(new SQLite::Statement(mDb, "SELECT ?, ?, ?"));
+        SQLite::Statement& positional = *mStatements.back();
+        aBenchmarks.push_back({"bind_positional", "wrapper", 1, 0, [&positional](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                positional.bind(1, static_cast<int>(i));
+                positional.bind(2, static_cast<long long>(i));
+                positional.bind(3, "text");
+            }
+        }});
+
+        sqlite3_stmt* const pNamed = prepareRaw("SELECT :int, :int64, :text");
+        aBenchmarks.push_back({"bind_named", "raw", 1, 0, [pNamed](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                sqlite3_bind_int(pNamed, sqlite3_bind_parameter_index(pNamed, ":int"), static_cast<int>(i));
+                sqlite3_bind_int64(pNamed, sqlite3_bind_parameter_index(pNamed, ":int64"),
+                                   static_cast<sqlite3_int64>(i));
+                sqlite3_bind_text(pNamed, sqlite3_bind_parameter_index(pNamed, ":text"), "text", 4, SQLITE_TRANSIENT);
+            }
+        }});
+        mStatements.emplace_back(new SQLite::Statement(mDb, "SELECT :int, :int64, :text"));
+        SQLite::Statement& named = *mStatements.back();
+        aBenchmarks.push_back({"bind_named", "wrapper", 1, 0, [&named](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                named.bind(":int", static_cast<int>(i));
+                named.bind(":int64", static_cast<long long>(i));
+                named.bind(":text", "text");
+            }
+        }});
+    }
+
+    /// Step through all the rows of the table, without reading them
+    void addExecuteStep(std::vector<Benchmark>& aBenchmarks)
+    {
+        sqlite3_stmt* const pStmt = prepareRaw("SELECT id, value, name FROM bench");
+        aBenchmarks.push_back({"execute_step", "raw", BENCH_ROWS, 0, [pStmt](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                while (SQLITE_ROW == sqlite3_step(pStmt))
+                {
+                }
+                sqlite3_reset(pStmt);
+            }
+        }});
+        mStatements.emplace_back(new SQLite::Statement(mDb, "SELECT id, value, name FROM bench"));
+        SQLite::Statement& query = *mStatements.back();
+        aBenchmarks.push_back({"execute_step", "wrapper", BENCH_ROWS, 0, [&query](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                while (query.executeStep())
+                {
+                }
+                query.reset();
+            }
+        }});
+    }
+
+    /// Read the two integer columns of all the rows, by index and by name
+    void addGetColumn(std::vector<Benchmark>& aBenchmarks)
+    {
+        sqlite3_stmt* const pStmt = prepareRaw("SELECT id, value, name FROM bench");
+        aBenchmarks.push_back({"get_column", "raw", BENCH_ROWS, 0, [pStmt](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                while (SQLITE_ROW == sqlite3_step(pStmt))
+                {
+                    sSink = sSink + sqlite3_column_int64(pStmt, 0) + sqlite3_column_int(pStmt, 1);
+                }
+                sqlite3_reset(pStmt);
+            }
+        }});
+        mStatements.emplace_back(new SQLite::Statement(mDb, "SELECT id, value, name FROM bench"));
+        SQLite::Statement& query = *mStatements.back();
+        aBenchmarks.push_back({"get_column", "wrapper_by_index", BENCH_ROWS, 0, [&query](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                while (query.executeStep())
+                {
+                    sSink = sSink + query.getColumn(0).getInt64() + query.getColumn(1).getInt();
+                }
+                query.reset();
+            }
+        }});
+        aBenchmarks.push_back({"get_column", "wrapper_by_name", BENCH_ROWS, 0, [&query](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                while (query.executeStep())
+                {
+                    sSink = sSink + query.getColumn("id").getInt64() + query.getColumn("value").getInt();
+                }
+                query.reset();
+            }
+        }});
+    }
+
+    /// Copy the text column of all the rows into a std::string
+    void addGetString(std::vector<Benchmark>& aBenchmarks)
+    {
+        sqlite3_stmt* const pStmt = prepareRaw("SELECT id, value, name FROM bench");
+        aBenchmarks.push_back({"get_string", "raw", BENCH_ROWS, 0, [pStmt](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                while (SQLITE_ROW == sqlite3_step(pStmt))
+                {
+                    const char* pText = reinterpret_cast<const char*>(sqlite3_column_text(pStmt, 2));
+                    const std::string name(pText, static_cast<size_t>(sqlite3_column_bytes(pStmt, 2)));
+                    sSink = sSink + static_cast<int64_t>(name.size());
+                }
+                sqlite3_reset(pStmt);
+            }
+        }});
+        mStatements.emplace_back(new SQLite::Statement(mDb, "SELECT id, value, name FROM bench"));
+        SQLite::Statement& query = *mStatements.back();
+        aBenchmarks.push_back({"get_string", "wrapper", BENCH_ROWS, 0, [&query](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                while (query.executeStep())
+                {
+                    const std::string name = query.getColumn(2).getString();
+                    sSink = sSink + static_cast<int64_t>(name.size());
+                }
+                query.reset();
+            }
+        }});
+    }
+
+    /// Begin and commit an empty transaction
+    void addTransaction(std::vector<Benchmark>& aBenchmarks)
+    {
+        sqlite3* const pSQLite = mDb.getHandle();
+        aBenchmarks.push_back({"transaction", "raw", 1, 0, [pSQLite](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                check(pSQLite, sqlite3_exec(pSQLite, "BEGIN", nullptr, nullptr, nullptr));
+                check(pSQLite, sqlite3_exec(pSQLite, "COMMIT", nullptr, nullptr, nullptr));
+            }
+        }});
+        aBenchmarks.push_back({"transaction", "wrapper", 1, 0, [this](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                SQLite::Transaction transaction(mDb);
+                transaction.commit();
+            }
+        }});
+    }
+
+    /// Look up a row, and fail to insert a duplicated primary key, with exceptions and with error codes
+    void addErrorCodes(std::vector<Benchmark>& aBenchmarks)
+    {
+        sqlite3_stmt* const pLookup = prepareRaw("SELECT value FROM bench WHERE id = ?");
+        aBenchmarks.push_back({"lookup", "raw", 1, 0, [pLookup](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                check(nullptr, sqlite3_bind_int(pLookup, 1, static_cast<int>(i % BENCH_ROWS)));
+                check(nullptr, sqlite3_step(pLookup));
+                sSink = sSink + sqlite3_column_int(pLookup, 0);
+                sqlite3_reset(pLookup);
+            }
+        }});
+        mStatements.emplace_back(new SQLite::Statement(mDb, "SELECT value FROM bench WHERE id = ?"));
+        SQLite::Statement& lookup = *mStatements.back();
+        aBenchmarks.push_back({"lookup", "wrapper", 1, 0, [&lookup](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                lookup.bind(1, static_cast<int>(i % BENCH_ROWS));
+                lookup.executeStep();
+                sSink = sSink + lookup.getColumn(0).getInt();
+                lookup.reset();
+            }
+        }});
+        aBenchmarks.push_back({"lookup", "error_code", 1, 0, [&lookup](uint64_t aIterations)
+        {
+            std::error_code error;
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                lookup.bind(1, static_cast<int>(i % BENCH_ROWS), error);
+                if (lookup.executeStep(error))
+                {
+                    sSink = sSink + lookup.getColumn(0).getInt();
+                }
+                lookup.reset(error);
+            }
+        }});
+
+        // the same error as a SQLITE_BUSY retried in a loop, but reproducible on a single connection
+        sqlite3_stmt* const pInsert = prepareRaw("INSERT INTO bench (id) VALUES (1)");
+        aBenchmarks.push_back({"constraint_error", "raw", 1, 0, [pInsert](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                sSink = sSink + sqlite3_step(pInsert);
+                sqlite3_reset(pInsert);
+            }
+        }});
+        mStatements.emplace_back(new SQLite::Statement(mDb, "INSERT INTO bench (id) VALUES (1)"));
+        SQLite::Statement& insert = *mStatements.back();
+        aBenchmarks.push_back({"constraint_error", "wrapper", 1, 0, [&insert](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                try
+                {
+                    insert.exec();
+                }
+                catch (const SQLite::Exception& e)
+                {
+                    sSink = sSink + e.getErrorCode();
+                }
+                insert.tryReset();
+            }
+        }});
+        aBenchmarks.push_back({"constraint_error", "error_code", 1, 0, [&insert](uint64_t aIterations)
+        {
+            std::error_code error;
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                insert.exec(error);
+                sSink = sSink + error.value();
+                insert.reset(error);
+            }
+        }});
+    }
+
+    /// Test if a table exists, by a query on sqlite_master or by a lookup in the cached catalog
+    void addTableExists(std::vector<Benchmark>& aBenchmarks)
+    {
+        sqlite3* const pSQLite = mDb.getHandle();
+        aBenchmarks.push_back({"table_exists", "raw", 1, 0, [pSQLite](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                sqlite3_stmt* pStmt = nullptr;
+                check(pSQLite, sqlite3_prepare_v2(pSQLite, "SELECT count(*) FROM sqlite_master "
+                                                  "WHERE type='table' AND name=?", -1, &pStmt, nullptr));
+                sqlite3_bind_text(pStmt, 1, "bench", -1, SQLITE_STATIC);
+                check(pSQLite, sqlite3_step(pStmt));
+                sSink = sSink + sqlite3_column_int(pStmt, 0);
+                sqlite3_finalize(pStmt);
+            }
+        }});
+        aBenchmarks.push_back({"table_exists", "wrapper", 1, 0, [this](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                sSink = sSink + (mDb.tableExists("bench") ? 1 : 0);
+            }
+        }});
+    }
+
+    /// Copy the whole source database into a new in-memory database
+    void addBackup(std::vector<Benchmark>& aBenchmarks)
+    {
+        sqlite3* const pSrc = mBackupSrc.getHandle();
+        aBenchmarks.push_back({"backup", "raw", 1, mBackupBytes, [pSrc](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                sqlite3* pDest = nullptr;
+                check(pDest, sqlite3_open(":memory:", &pDest));
+                sqlite3_backup* pBackup = sqlite3_backup_init(pDest, "main", pSrc, "main");
+                check(pDest, sqlite3_backup_step(pBackup, -1));
+                check(pDest, sqlite3_backup_finish(pBackup));
+                sqlite3_close(pDest);
+            }
+        }});
+        aBenchmarks.push_back({"backup", "wrapper", 1, mBackupBytes, [this](uint64_t aIterations)
+        {
+            for (uint64_t i = 0; i < aIterations; ++i)
+            {
+                SQLite::Database dest(":memory:", SQLite::OPEN_READWRITE);
+                SQLite::Backup backup(dest, mBackupSrc);
+                backup.executeStep();
+            }
+        }});
+    }
+
+private:
+    SQLite::Database                                mDb;            ///< Connection with the "bench" table
+    SQLite::Database                                mBackupSrc;     ///< Source database of the backup benchmarks
+    uint64_t                                        mBackupBytes;   ///< Size of the source database of the backup
+    std::vector<sqlite3_stmt*>                      mRawStmts;      ///< Raw statements, finalized by the destructor
+    std::vector<std::unique_ptr<SQLite::Statement>> mStatements;    ///< Statements of the wrapper benchmarks
+};
+
+
+/// Typical small workload: create a table, insert rows in a transaction, then read them back
+static void allocatorWorkload(uint64_t aIterations)
+{
+    for (uint64_t i = 0; i < aIterations; ++i)
+    {
+        SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+        fillTable(db);
+        SQLite::Statement query(db, "SELECT id, value, name FROM bench WHERE value % 3 = 0 ORDER BY name");
+        while (query.executeStep())
+        {
+            sSink = sSink + static_cast<int64_t>(query.getColumn(2).getString().size());
+        }
+    }
+}
+
+/// Compare the memory allocators of SQLite on the same workload, switching them while no connection is open
+static void runAllocatorBenchmarks(const Options& aOptions, std::vector<Result>& aResults)
+{
+    static const SQLite::Allocator allocators[] = {SQLite::Allocator::Default, SQLite::Allocator::Pool};
+    static const char* const names[] = {"default", "pool"};
+    for (size_t i = 0; i < 2; ++i)
+    {
+        const Benchmark benchmark = {"allocator", names[i], BENCH_ROWS, 0, allocatorWorkload};
+        if (isSelected(benchmark, aOptions))
+        {
+            sqlite3_shutdown();
+            SQLite::configureAllocator(allocators[i]);
+            run(benchmark, aOptions, aResults);
+        }
+    }
+    sqlite3_shutdown();
+    SQLite::configureAllocator(SQLite::Allocator::Default);
+}
+
+
+/// Create the database file of the cold scan benchmarks, with rows large enough to span many pages
+static void createScanDatabase(const char* apVfs)
+{
+    SQLite::Database db(BENCH_FILENAME, SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE, 0, apVfs);
+    db.exec("CREATE TABLE scan (id INTEGER PRIMARY KEY, data BLOB)");
+    db.exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM n WHERE i < 4000) "
+            "INSERT INTO scan SELECT i, randomblob(1000) FROM n");
+}
+
+/// Drop the database file from the page cache of the OS, so that the scan reads it from the disk (best effort)
+static void dropFileCache()
+{
+#ifdef __linux__
+    const int fd = open(BENCH_FILENAME, O_RDONLY);
+    if (fd >= 0)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#endif
+}
+
+/// Return a benchmark of a full table scan through a VFS, each time by a new connection with a small page cache
+static Benchmark scanBenchmark(const char* apImpl, const char* apVfs, const bool abDropCache)
+{
+    return {"cold_scan", apImpl, 4000, 0, [apVfs, abDropCache](uint64_t aIterations)
+    {
+        for (uint64_t i = 0; i < aIterations; ++i)
+        {
+            if (abDropCache)
+            {
+                dropFileCache();
+            }
+            SQLite::Database db(BENCH_FILENAME, SQLite::OPEN_READONLY, 0, apVfs);
+            db.exec("PRAGMA cache_size=16");
+            sSink = sSink + db.execAndGet("SELECT sum(length(data)) FROM scan").getInt64();
+        }
+    }};
+}
+
+/// Compare full scans of a database file through the default VFS, the io_uring VFS (if built) and the memory VFS
+static void runScanBenchmarks(const Options& aOptions, std::vector<Result>& aResults)
+{
+    SQLite::registerMemoryVfs();
+#ifdef SQLITECPP_BENCH_VFS_URING
+    SQLite::registerUringVfs();
+#endif
+    // the memory VFS gives the lower bound of the scan without any I/O
+    const Benchmark benchmarks[] = {
+        scanBenchmark("unix", nullptr, true),
+#ifdef SQLITECPP_BENCH_VFS_URING
+        scanBenchmark("unix-uring", SQLite::URING_VFS_NAME, true),
+#endif
+        scanBenchmark("memory", SQLite::MEMORY_VFS_NAME, false)
+    };
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        if (isSelected(benchmark, aOptions))
+        {
+            const bool bMemory = (benchmark.impl == "memory");
+            std::remove(BENCH_FILENAME);
+            createScanDatabase(bMemory ? SQLite::MEMORY_VFS_NAME : nullptr);
+            run(benchmark, aOptions, aResults);
+            if (bMemory)
+            {
+                SQLite::deleteMemoryFile(BENCH_FILENAME);
+            }
+            else
+            {
+                std::remove(BENCH_FILENAME);
+            }
+        }
+    }
+}
+
+
+/// Return a benchmark of a query reading all its rows, prepared once and reset after each run
+static Benchmark queryBenchmark(SQLite::Database& aDb, const char* apGroup, const char* apImpl, const char* apQuery)
+{
+    std::shared_ptr<SQLite::Statement> query = std::make_shared<SQLite::Statement>(aDb, apQuery);
+    return {apGroup, apImpl, BENCH_ROWS, 0, [query](uint64_t aIterations)
+    {
+        for (uint64_t i = 0; i < aIterations; ++i)
+        {
+            query->bind(1, "NAME OF THE ROW NUMBER 500");
+            while (query->executeStep())
+            {
+                sSink = sSink + query->getColumnCount();
+            }
+            query->reset();
+        }
+    }};
+}
+
+/// Compare the built-in collations to SQL functions and to the collations of SQLite, in sorts and in index lookups
+static void runCollationBenchmarks(const Options& aOptions, std::vector<Result>& aResults)
+{
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.createCollation("ascii_nocase", SQLite::AsciiNoCaseCollation());
+    db.createCollation("natsort", SQLite::NaturalCollation());
+    db.createCollation("utf8_binary", SQLite::Utf8BinaryCollation());
+    fillTable(db);
+    db.exec("UPDATE bench SET name = upper(name) WHERE id % 2 = 0");
+    db.exec("CREATE INDEX bench_nocase ON bench(name COLLATE ascii_nocase)");
+
+    // the first parameter is unused by the sorts; "ascii_nocase" reads the bench_nocase index instead of sorting
+    const Benchmark benchmarks[] = {
+        queryBenchmark(db, "order_nocase", "lower", "SELECT name, ?1 FROM bench ORDER BY lower(name)"),
+        queryBenchmark(db, "order_nocase", "sqlite_nocase", "SELECT name, ?1 FROM bench ORDER BY name COLLATE NOCASE"),
+        queryBenchmark(db, "order_nocase", "ascii_nocase",
+                       "SELECT name, ?1 FROM bench ORDER BY name COLLATE ascii_nocase"),
+        queryBenchmark(db, "order_binary", "sqlite_binary", "SELECT name, ?1 FROM bench ORDER BY name COLLATE BINARY"),
+        queryBenchmark(db, "order_binary", "utf8_binary",
+                       "SELECT name, ?1 FROM bench ORDER BY name COLLATE utf8_binary"),
+        queryBenchmark(db, "order_natural", "sqlite_binary", "SELECT name, ?1 FROM bench ORDER BY name COLLATE BINARY"),
+        queryBenchmark(db, "order_natural", "natsort", "SELECT name, ?1 FROM bench ORDER BY name COLLATE natsort"),
+        queryBenchmark(db, "lookup_nocase", "lower", "SELECT name FROM bench WHERE lower(name) = lower(?1)"),
+        queryBenchmark(db, "lookup_nocase", "ascii_nocase_index",
+                       "SELECT name FROM bench WHERE name = ?1 COLLATE ascii_nocase")
+    };
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        if (isSelected(benchmark, aOptions))
+        {
+            run(benchmark, aOptions, aResults);
+        }
+    }
+}
+
+
+/// Number of rows written by one operation of the sharded benchmarks
+static const int SHARDED_ROWS = 20000;
+
+/// Return a benchmark replacing SHARDED_ROWS keyed rows, in one transaction per shard run by one thread per shard
+static Benchmark shardedBenchmark(const std::shared_ptr<SQLite::ShardedDatabase>& apDb, const char* apImpl)
+{
+    std::vector<long long> keys;
+    for (long long key = 0; key < SHARDED_ROWS; ++key)
+    {
+        keys.push_back(key);
+    }
+    const std::shared_ptr<std::vector<std::vector<size_t> > > groups =
+        std::make_shared<std::vector<std::vector<size_t> > >(apDb->partition(keys));
+    return {"sharded_insert", apImpl, SHARDED_ROWS, 0, [apDb, groups](uint64_t aIterations)
+    {
+        for (uint64_t i = 0; i < aIterations; ++i)
+        {
+            apDb->forEachShard([&groups](SQLite::Database& aShard, size_t aIndex)
+            {
+                SQLite::Transaction transaction(aShard);
+                SQLite::Statement insert(aShard, "INSERT OR REPLACE INTO bench VALUES (?, ?, ?)");
+                for (const size_t key : (*groups)[aIndex])
+                {
+                    insert.bind(1, static_cast<long long>(key));
+                    insert.bind(2, static_cast<long long>(key * 7));
+                    insert.bind(3, "name of the row number " + std::to_string(key));
+                    insert.exec();
+                    insert.reset();
+                }
+                transaction.commit();
+            });
+        }
+    }};
+}
+
+/// Compare the writes to a single database file with the same writes spread over several shards
+static void runShardedBenchmarks(const Options& aOptions, std::vector<Result>& aResults)
+{
+    static const size_t shardCounts[] = {1, 4};
+    static const char* const names[] = {"1_shard", "4_shards"};
+    for (size_t i = 0; i < 2; ++i)
+    {
+        std::vector<std::string> filenames;
+        for (size_t shard = 0; shard < shardCounts[i]; ++shard)
+        {
+            filenames.push_back("SQLiteCpp_bench_shard" + std::to_string(shard) + ".db3");
+            std::remove(filenames.back().c_str());
+        }
+        {
+            const std::shared_ptr<SQLite::ShardedDatabase> db = std::make_shared<SQLite::ShardedDatabase>(filenames);
+            const Benchmark benchmark = shardedBenchmark(db, names[i]);
+            if (isSelected(benchmark, aOptions))
+            {
+                db->forEachShard([](SQLite::Database& aShard, size_t)
+                {
+                    aShard.exec("PRAGMA journal_mode=WAL");
+                    aShard.exec("PRAGMA synchronous=NORMAL");
+                    aShard.exec("CREATE TABLE bench (id INTEGER PRIMARY KEY, value INTEGER, name TEXT)");
+                });
+                run(benchmark, aOptions, aResults);
+            }
+        }
+        for (const std::string& filename : filenames)
+        {
+            std::remove(filename.c_str());
+            std::remove((filename + "-wal").c_str());
+            std::remove((filename + "-shm").c_str());
+        }
+    }
+}
+
+
+/// Number of rows of the table of the parallel scan benchmarks
+static const int PARALLEL_SCAN_ROWS = 200000;
+
+/// Compare a scan of a table summing its rows on one connection with the same scan split into 4 partitions
+static void runParallelScanBenchmarks(const Options& aOptions, std::vector<Result>& aResults)
+{
+    std::remove(BENCH_FILENAME);
+    {
+        SQLite::Database db(BENCH_FILENAME, SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+        db.exec("CREATE TABLE scan (id INTEGER PRIMARY KEY, value INTEGER)");
+        db.exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM n WHERE i < "
+                + std::to_string(PARALLEL_SCAN_ROWS) + ") INSERT INTO scan SELECT i, i % 1000 FROM n");
+    }
+    {
+        SQLite::Database        db(BENCH_FILENAME, SQLite::OPEN_READONLY);
+        SQLite::ParallelScan    scan(BENCH_FILENAME, "scan", 4);
+        const Benchmark benchmarks[] = {
+            {"parallel_scan", "1_connection", PARALLEL_SCAN_ROWS, 0, [&db](uint64_t aIterations)
+            {
+                for (uint64_t i = 0; i < aIterations; ++i)
+                {
+                    SQLite::Statement query(db, "SELECT value FROM scan");
+                    while (query.executeStep())
+                    {
+                        sSink = sSink + query.getColumn(0).getInt64();
+                    }
+                }
+            }},
+            {"parallel_scan", "4_partitions", PARALLEL_SCAN_ROWS, 0, [&scan](uint64_t aIterations)
+            {
+                for (uint64_t i = 0; i < aIterations; ++i)
+                {
+                    sSink = sSink + scan.reduce("SELECT value FROM scan WHERE rowid BETWEEN ?1 AND ?2", int64_t(0),
+                                                [](int64_t& aSum, SQLite::Statement& aQuery)
+                                                {
+                                                    aSum += aQuery.getColumn(0).getInt64();
+                                                },
+                                                std::plus<int64_t>());
+                }
+            }}
+        };
+        for (const Benchmark& benchmark : benchmarks)
+        {
+            if (isSelected(benchmark, aOptions))
+            {
+                run(benchmark, aOptions, aResults);
+            }
+        }
+    }
+    std::remove(BENCH_FILENAME);
+}
+
+
+/// Number of records of the file of the bulk import benchmarks
+static const int BULK_IMPORT_ROWS = 100000;
+
+/// Compare an import of a CSV file line by line, in a single transaction, with the BulkImporter pipeline
+static void runBulkImportBenchmarks(const Options& aOptions, std::vector<Result>& aResults)
+{
+    const char* const csvFilename = "SQLiteCpp_bench_import.csv";
+    {
+        std::ofstream csv(csvFilename, std::ios::out | std::ios::binary);
+        for (int i = 0; i < BULK_IMPORT_ROWS; ++i)
+        {
+            csv << i << ",name " << i << "," << (i % 1000) << "\n";
+        }
+    }
+    std::ifstream file(csvFilename, std::ios::in | std::ios::binary | std::ios::ate);
+    const uint64_t bytes = static_cast<uint64_t>(file.tellg());
+    std::remove(BENCH_FILENAME);
+    {
+        SQLite::Database db(BENCH_FILENAME, SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+        db.exec("CREATE TABLE import (id INTEGER, name TEXT, value INTEGER)");
+        SQLite::BulkImporter importer(db, "import");
+        const Benchmark benchmarks[] = {
+            {"bulk_import", "getline", BULK_IMPORT_ROWS, bytes, [&db, csvFilename](uint64_t aIterations)
+            {
+                for (uint64_t i = 0; i < aIterations; ++i)
+                {
+                    db.exec("DELETE FROM import");
+                    SQLite::Transaction transaction(db);
+                    SQLite::Statement   insert(db, "INSERT INTO import VALUES (?, ?, ?)");
+                    std::ifstream       csv(csvFilename, std::ios::in | std::ios::binary);
+                    std::string         line;
+                    while (std::getline(csv, line))
+                    {
+                        const size_t first = line.find(',');
+                        const size_t second = line.find(',', first + 1);
+                        insert.bind(1, line.substr(0, first));
+                        insert.bind(2, line.substr(first + 1, second - first - 1));
+                        insert.bind(3, line.substr(second + 1));
+                        insert.exec();
+                        insert.reset();
+                    }
+                    transaction.commit();
+                }
+            }},
+            {"bulk_import", "pipeline", BULK_IMPORT_ROWS, bytes, [&db, &importer, csvFilename](uint64_t aIterations)
+            {
+                for (uint64_t i = 0; i < aIterations; ++i)
+                {
+                    db.exec("DELETE FROM import");
+                    sSink = sSink + importer.importFile(csvFilename).rows;
+                }
+            }}
+        };
+        for (const Benchmark& benchmark : benchmarks)
+        {
+            if (isSelected(benchmark, aOptions))
+            {
+                run(benchmark, aOptions, aResults);
+            }
+        }
+    }
+    std::remove(BENCH_FILENAME);
+    std::remove(csvFilename);
+}
+
+
+/// Parse the command line
+static bool parseOptions(int argc, char** argv, Options& aOptions)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        if (0 == arg.compare(0, 9, "--filter="))
+        {
+            aOptions.filter = arg.substr(9);
+        }
+        else if (0 == arg.compare(0, 11, "--min-time="))
+        {
+            aOptions.minTime = std::atof(arg.c_str() + 11);
+        }
+        else if (0 == arg.compare(0, 9, "--output="))
+        {
+            aOptions.output = arg.substr(9);
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0]
+                      << " [--filter=<substring>] [--min-time=<seconds>] [--output=<file.json>]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::vector<Result> results;
+        {
+            // all the connections are closed before switching the allocator
+            WrapperBenchmarks       wrapperBenchmarks;
+            std::vector<Benchmark>  benchmarks;
+            wrapperBenchmarks.add(benchmarks);
+            for (const Benchmark& benchmark : benchmarks)
+            {
+                if (isSelected(benchmark, options))
+                {
+                    run(benchmark, options, results);
+                }
+            }
+        }
+        runAllocatorBenchmarks(options, results);
+        runScanBenchmarks(options, results);
+        runCollationBenchmarks(options, results);
+        runShardedBenchmarks(options, results);
+        runParallelScanBenchmarks(options, results);
+        runBulkImportBenchmarks(options, results);
+
+        if (options.output.empty())
+        {
+            writeJson(std::cout, results);
+        }
+        else
+        {
+            std::ofstream file(options.output.c_str());
+            writeJson(file, results);
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "SQLite exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
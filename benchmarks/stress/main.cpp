@@ -0,0 +1,627 @@
+/**
+ * @file  main.cpp
+ * @brief Multi-threaded stress test of concurrent readers and writers, each with its own Database connection.
+ *
+ *  For each combination of journal mode, synchronous level and number of threads, a fresh database file
+ * is filled in a temporary directory, then readers and writers run the workload for a fixed duration.
+ * SQLITE_BUSY errors are retried with an exponential backoff, and counted. Results are written as JSON:
+ *
+ *      SQLiteCpp_stress [--workload=point|range|insert|batch|mixed] [--read=point|range] [--write=insert|batch]
+ *                       [--writers=<percent>] [--threads=1,4,16,64] [--journal=wal,delete] [--synchronous=normal,full]
+ *                       [--duration=<seconds>] [--rows=<count>] [--busy-timeout=<ms>] [--max-retries=<count>]
+ *                       [--dir=<directory>] [--output=<file.json>]
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <SQLiteCpp/Profiler.h>
+
+
+#ifdef SQLITECPP_ENABLE_ASSERT_HANDLER
+namespace SQLite
+{
+/// definition of the assertion handler enabled when SQLITECPP_ENABLE_ASSERT_HANDLER is defined in the project (CMakeList.txt)
+void assertion_failed(const char* apFile, const long apLine, const char* apFunc, const char* apExpr, const char* apMsg)
+{
+    // Print a message to the standard error output stream, and abort the program.
+    std::cerr << apFile << ":" << apLine << ":" << " error: assertion failed (" << apExpr << ") in " << apFunc << "() with message \"" << apMsg << "\"\n";
+    std::abort();
+}
+}
+#endif
+
+/// Number of rows read by a range scan
+static const int RANGE_ROWS = 100;
+/// Number of rows inserted by a batched insert
+static const int BATCH_ROWS = 100;
+
+
+/// Operation run in a loop by a reader or a writer thread
+enum class Operation
+{
+    PointLookup,    ///< Read one row by its primary key
+    RangeScan,      ///< Read RANGE_ROWS consecutive rows
+    Insert,         ///< Insert one row, in its own implicit transaction
+    BatchInsert     ///< Insert BATCH_ROWS rows in one transaction
+};
+
+/// Options of the command line
+struct Options
+{
+    std::string                 workload = "mixed";     ///< Name of the preset workload
+    Operation                   read = Operation::PointLookup;
+    Operation                   write = Operation::Insert;
+    int                         writersPercent = 25;    ///< Share of the threads running the write operation
+    std::vector<int>            threads = {1, 4, 16, 64};
+    std::vector<std::string>    journalModes = {"wal", "delete"};
+    std::vector<std::string>    synchronousLevels = {"normal", "full"};
+    double                      duration = 2.0;         ///< Duration of each run, in seconds
+    int                         rows = 10000;           ///< Number of rows of the table at the start of each run
+    int                         busyTimeoutMs = 0;      ///< Busy timeout of the connections (0: retried by the harness)
+    int                         maxRetries = 100;       ///< Retries of an operation failing with SQLITE_BUSY
+    std::string                 dir;                    ///< Directory of the temporary database files
+    std::string                 output;                 ///< JSON output file, or empty for the standard output
+};
+
+/// Parameters of one run
+struct Run
+{
+    std::string journalMode;
+    std::string synchronous;
+    int         readers;
+    int         writers;
+};
+
+/// Counters of one thread, or of all the threads of a role once merged
+struct Counters
+{
+    std::unique_ptr<SQLite::LatencyHistogram>   latency{new SQLite::LatencyHistogram()};    ///< Including retries
+    uint64_t                                    ops = 0;        ///< Operations completed
+    uint64_t                                    attempts = 0;   ///< Attempts, including the retried ones
+    uint64_t                                    busy = 0;       ///< Attempts failing with SQLITE_BUSY or SQLITE_LOCKED
+    uint64_t                                    retries = 0;    ///< Attempts made again after a busy one
+    uint64_t                                    failures = 0;   ///< Operations given up after maxRetries
+
+    /// Add the counters of another thread
+    void merge(const Counters& aOther)
+    {
+        latency->merge(*aOther.latency);
+        ops += aOther.ops;
+        attempts += aOther.attempts;
+        busy += aOther.busy;
+        retries += aOther.retries;
+        failures += aOther.failures;
+    }
+};
+
+
+/// Return the name of an operation
+static const char* getName(const Operation aOperation)
+{
+    switch (aOperation)
+    {
+    case Operation::PointLookup:    return "point";
+    case Operation::RangeScan:      return "range";
+    case Operation::Insert:         return "insert";
+    case Operation::BatchInsert:    return "batch";
+    }
+    return "";
+}
+
+/// Return the path of the database file of the runs
+static std::string getFilename(const Options& aOptions)
+{
+    return aOptions.dir + "/SQLiteCpp_stress.db3";
+}
+
+/// Remove the database file and its journals
+static void removeFiles(const std::string& aFilename)
+{
+    static const char* const suffixes[] = {"", "-journal", "-wal", "-shm"};
+    for (const char* suffix : suffixes)
+    {
+        std::remove((aFilename + suffix).c_str());
+    }
+}
+
+/// Create the database file of a run, with its journal mode
+static void createDatabase(const Options& aOptions, const Run& aRun)
+{
+    removeFiles(getFilename(aOptions));
+    SQLite::Database db(getFilename(aOptions), SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.execAndGet("PRAGMA journal_mode=" + aRun.journalMode);
+    db.exec("CREATE TABLE kv (id INTEGER PRIMARY KEY, value INTEGER, payload TEXT)");
+    db.exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM n WHERE i < " + std::to_string(aOptions.rows) +
+            ") INSERT INTO kv SELECT i, i * 7, printf('%.64c', 'a') FROM n");
+}
+
+
+/**
+ * @brief One reader or writer thread, with its own connection and prepared statements.
+ */
+class Worker
+{
+public:
+    // Open the connection of the worker
+    Worker(const Options& aOptions, const Run& aRun, const Operation aOperation, const unsigned aSeed) :
+        mOptions(aOptions),
+        mOperation(aOperation),
+        mDb(getFilename(aOptions), SQLite::OPEN_READWRITE, aOptions.busyTimeoutMs),
+        mPointLookup(mDb, "SELECT value, payload FROM kv WHERE id = ?"),
+        mRangeScan(mDb, "SELECT id, value, payload FROM kv WHERE id BETWEEN ? AND ?"),
+        mInsert(mDb, "INSERT INTO kv (value, payload) VALUES (?, ?)"),
+        mRandom(aSeed)
+    {
+        mDb.exec("PRAGMA synchronous=" + aRun.synchronous);
+    }
+
+    /// Run the operation until stopped, the thread only starting its measures when told to
+    void run(const std::atomic<bool>& abStarted, const std::atomic<bool>& abStopped)
+    {
+        try
+        {
+            while (!abStarted.load())
+            {
+                std::this_thread::yield();
+            }
+            while (!abStopped.load(std::memory_order_relaxed))
+            {
+                runOperation();
+            }
+        }
+        catch (std::exception& e)
+        {
+            mError = e.what();
+        }
+    }
+
+    /// Counters of the worker, once stopped
+    const Counters& getCounters() const
+    {
+        return mCounters;
+    }
+
+    /// Error stopping the worker, if any
+    const std::string& getError() const
+    {
+        return mError;
+    }
+
+private:
+    /// Run the operation once, retrying it with an exponential backoff while it fails with SQLITE_BUSY
+    void runOperation()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::microseconds backoff(50);
+        for (int retry = 0; ; ++retry)
+        {
+            ++mCounters.attempts;
+            try
+            {
+                runAttempt();
+                break;
+            }
+            catch (SQLite::Exception& e)
+            {
+                const int code = e.getErrorCode() & 0xff;
+                if ((SQLITE_BUSY != code) && (SQLITE_LOCKED != code))
+                {
+                    throw;
+                }
+                mPointLookup.tryReset();
+                mRangeScan.tryReset();
+                mInsert.tryReset();
+                ++mCounters.busy;
+                if (retry >= mOptions.maxRetries)
+                {
+                    ++mCounters.failures;
+                    return;
+                }
+                ++mCounters.retries;
+                std::this_thread::sleep_for(std::chrono::microseconds(mRandom() % (backoff.count() + 1)));
+                backoff = std::min(backoff * 2, std::chrono::microseconds(10000));
+            }
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        mCounters.latency->record(static_cast<uint64_t>(elapsedNs));
+        ++mCounters.ops;
+    }
+
+    /// Run one attempt of the operation
+    void runAttempt()
+    {
+        switch (mOperation)
+        {
+        case Operation::PointLookup:
+        {
+            mPointLookup.bind(1, getRandomId());
+            while (mPointLookup.executeStep())
+            {
+                mSink += mPointLookup.getColumn(0).getInt64() + mPointLookup.getColumn(1).getBytes();
+            }
+            mPointLookup.reset();
+            break;
+        }
+        case Operation::RangeScan:
+        {
+            const long long first = getRandomId();
+            mRangeScan.bind(1, first);
+            mRangeScan.bind(2, first + RANGE_ROWS - 1);
+            while (mRangeScan.executeStep())
+            {
+                mSink += mRangeScan.getColumn(1).getInt64() + mRangeScan.getColumn(2).getBytes();
+            }
+            mRangeScan.reset();
+            break;
+        }
+        case Operation::Insert:
+        {
+            insertRow();
+            break;
+        }
+        case Operation::BatchInsert:
+        {
+            SQLite::Transaction transaction(mDb);
+            for (int i = 0; i < BATCH_ROWS; ++i)
+            {
+                insertRow();
+            }
+            transaction.commit();
+            break;
+        }
+        }
+    }
+
+    /// Insert one row
+    void insertRow()
+    {
+        mInsert.bind(1, static_cast<long long>(mRandom()));
+        mInsert.bind(2, "inserted by a writer thread of the stress test");
+        mInsert.exec();
+        mInsert.reset();
+    }
+
+    /// Return the id of one of the rows the table was filled with
+    long long getRandomId()
+    {
+        return 1 + static_cast<long long>(mRandom() % static_cast<unsigned>(mOptions.rows));
+    }
+
+private:
+    const Options&      mOptions;
+    const Operation     mOperation;
+    SQLite::Database    mDb;
+    SQLite::Statement   mPointLookup;
+    SQLite::Statement   mRangeScan;
+    SQLite::Statement   mInsert;
+    std::mt19937        mRandom;
+    Counters            mCounters;
+    std::string         mError;
+    int64_t             mSink = 0;      ///< Accumulate the values read, so that the reads cannot be optimized away
+};
+
+
+/// Write the counters of one role of a run as a JSON object
+static void writeJson(std::ostream& aStream, const char* apRole, const Operation aOperation, const Counters& aCounters,
+                      const double aSeconds)
+{
+    const double busyRate = aCounters.attempts ? (static_cast<double>(aCounters.busy) / aCounters.attempts) : 0.0;
+    aStream << "\"" << apRole << "\": {"
+            << "\"operation\": \"" << getName(aOperation) << "\""
+            << ", \"ops\": " << aCounters.ops
+            << ", \"ops_per_second\": " << static_cast<double>(aCounters.ops) / aSeconds
+            << ", \"p50_ns\": " << aCounters.latency->getPercentile(50.0)
+            << ", \"p99_ns\": " << aCounters.latency->getPercentile(99.0)
+            << ", \"p999_ns\": " << aCounters.latency->getPercentile(99.9)
+            << ", \"max_ns\": " << aCounters.latency->getMax()
+            << ", \"attempts\": " << aCounters.attempts
+            << ", \"busy\": " << aCounters.busy
+            << ", \"busy_rate\": " << busyRate
+            << ", \"retries\": " << aCounters.retries
+            << ", \"failures\": " << aCounters.failures
+            << "}";
+}
+
+/// Run the workload with the parameters of a run, and write its results as a JSON object
+static void runStress(const Options& aOptions, const Run& aRun, std::ostream& aStream)
+{
+    createDatabase(aOptions, aRun);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < aRun.readers + aRun.writers; ++i)
+    {
+        const Operation operation = (i < aRun.readers) ? aOptions.read : aOptions.write;
+        workers.emplace_back(new Worker(aOptions, aRun, operation, static_cast<unsigned>(i + 1)));
+    }
+    std::atomic<bool> bStarted(false);
+    std::atomic<bool> bStopped(false);
+    std::vector<std::thread> threads;
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        threads.emplace_back(&Worker::run, worker.get(), std::cref(bStarted), std::cref(bStopped));
+    }
+    const auto start = std::chrono::steady_clock::now();
+    bStarted = true;
+    std::this_thread::sleep_for(std::chrono::duration<double>(aOptions.duration));
+    bStopped = true;
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Counters readers;
+    Counters writers;
+    for (int i = 0; i < aRun.readers + aRun.writers; ++i)
+    {
+        if (!workers[i]->getError().empty())
+        {
+            throw SQLite::Exception("worker thread failed: " + workers[i]->getError());
+        }
+        ((i < aRun.readers) ? readers : writers).merge(workers[i]->getCounters());
+    }
+    workers.clear();
+    removeFiles(getFilename(aOptions));
+
+    aStream << "    {\"workload\": \"" << aOptions.workload << "\""
+            << ", \"journal_mode\": \"" << aRun.journalMode << "\""
+            << ", \"synchronous\": \"" << aRun.synchronous << "\""
+            << ", \"threads\": " << aRun.readers + aRun.writers
+            << ", \"readers\": " << aRun.readers
+            << ", \"writers\": " << aRun.writers
+            << ", \"seconds\": " << seconds
+            << ", \"ops_per_second\": " << static_cast<double>(readers.ops + writers.ops) / seconds
+            << ",\n     ";
+    writeJson(aStream, "read", aOptions.read, readers, seconds);
+    aStream << ",\n     ";
+    writeJson(aStream, "write", aOptions.write, writers, seconds);
+    aStream << "}";
+
+    std::cerr << aRun.journalMode << "/" << aRun.synchronous << " " << aRun.readers << "R+" << aRun.writers << "W: "
+              << static_cast<double>(readers.ops + writers.ops) / seconds << " ops/s, "
+              << readers.busy + writers.busy << " busy\n";
+}
+
+
+/// Split a comma separated list
+static std::vector<std::string> split(const std::string& aList)
+{
+    std::vector<std::string> items;
+    std::istringstream stream(aList);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+/// Parse the name of an operation
+static bool parseOperation(const std::string& aName, Operation& aOperation)
+{
+    static const Operation operations[] = {
+        Operation::PointLookup, Operation::RangeScan, Operation::Insert, Operation::BatchInsert
+    };
+    for (const Operation operation : operations)
+    {
+        if (aName == getName(operation))
+        {
+            aOperation = operation;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Apply a preset workload: one read-only or write-only operation, or "mixed" point lookups and inserts
+static bool parseWorkload(const std::string& aName, Options& aOptions)
+{
+    aOptions.workload = aName;
+    if (aName == "mixed")
+    {
+        aOptions.read = Operation::PointLookup;
+        aOptions.write = Operation::Insert;
+        aOptions.writersPercent = 25;
+        return true;
+    }
+    Operation operation;
+    if (!parseOperation(aName, operation))
+    {
+        return false;
+    }
+    const bool bWrite = (Operation::Insert == operation) || (Operation::BatchInsert == operation);
+    (bWrite ? aOptions.write : aOptions.read) = operation;
+    aOptions.writersPercent = bWrite ? 100 : 0;
+    return true;
+}
+
+/// Parse the command line, the preset workload first so that the other options can change it
+static bool parseOptions(int argc, char** argv, Options& aOptions)
+{
+    const char* pTmpDir = std::getenv("TMPDIR");
+    if (nullptr == pTmpDir)
+    {
+        pTmpDir = std::getenv("TEMP");
+    }
+    aOptions.dir = pTmpDir ? pTmpDir : ".";
+
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::stable_partition(args.begin(), args.end(), [](const std::string& aArg)
+    {
+        return (0 == aArg.compare(0, 11, "--workload="));
+    });
+    for (const std::string& arg : args)
+    {
+        const size_t equal = arg.find('=');
+        const std::string name = arg.substr(0, equal);
+        const std::string value = (equal != std::string::npos) ? arg.substr(equal + 1) : "";
+        bool bValid = (equal != std::string::npos) && !value.empty();
+        if (!bValid)
+        {
+            // no value
+        }
+        else if (name == "--workload")
+        {
+            bValid = parseWorkload(value, aOptions);
+        }
+        else if (name == "--read")
+        {
+            bValid = parseOperation(value, aOptions.read)
+                  && ((Operation::PointLookup == aOptions.read) || (Operation::RangeScan == aOptions.read));
+        }
+        else if (name == "--write")
+        {
+            bValid = parseOperation(value, aOptions.write)
+                  && ((Operation::Insert == aOptions.write) || (Operation::BatchInsert == aOptions.write));
+        }
+        else if (name == "--writers")
+        {
+            aOptions.writersPercent = std::atoi(value.c_str());
+            bValid = (aOptions.writersPercent >= 0) && (aOptions.writersPercent <= 100);
+        }
+        else if (name == "--threads")
+        {
+            aOptions.threads.clear();
+            for (const std::string& count : split(value))
+            {
+                aOptions.threads.push_back(std::atoi(count.c_str()));
+                bValid = bValid && (aOptions.threads.back() > 0);
+            }
+        }
+        else if (name == "--journal")
+        {
+            aOptions.journalModes = split(value);
+        }
+        else if (name == "--synchronous")
+        {
+            aOptions.synchronousLevels = split(value);
+        }
+        else if (name == "--duration")
+        {
+            aOptions.duration = std::atof(value.c_str());
+        }
+        else if (name == "--rows")
+        {
+            aOptions.rows = std::atoi(value.c_str());
+            bValid = (aOptions.rows > RANGE_ROWS);
+        }
+        else if (name == "--busy-timeout")
+        {
+            aOptions.busyTimeoutMs = std::atoi(value.c_str());
+        }
+        else if (name == "--max-retries")
+        {
+            aOptions.maxRetries = std::atoi(value.c_str());
+        }
+        else if (name == "--dir")
+        {
+            aOptions.dir = value;
+        }
+        else if (name == "--output")
+        {
+            aOptions.output = value;
+        }
+        else
+        {
+            bValid = false;
+        }
+        if (!bValid)
+        {
+            std::cerr << "invalid option '" << arg << "', usage: " << argv[0]
+                      << " [--workload=point|range|insert|batch|mixed] [--read=point|range] [--write=insert|batch]"
+                         " [--writers=<percent>] [--threads=1,4,16,64] [--journal=wal,delete]"
+                         " [--synchronous=normal,full] [--duration=<seconds>] [--rows=<count>]"
+                         " [--busy-timeout=<ms>] [--max-retries=<count>] [--dir=<directory>] [--output=<file.json>]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Split a number of threads between readers and writers, with at least one of each when the mix has both
+static Run getRun(const Options& aOptions, const std::string& aJournalMode, const std::string& aSynchronous,
+                  const int aThreads)
+{
+    int writers = (aThreads * aOptions.writersPercent + 50) / 100;
+    if ((aOptions.writersPercent > 0) && (writers == 0))
+    {
+        writers = 1;
+    }
+    else if ((aOptions.writersPercent < 100) && (writers == aThreads) && (aThreads > 1))
+    {
+        writers = aThreads - 1;
+    }
+    return Run{aJournalMode, aSynchronous, aThreads - writers, writers};
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::ostringstream runs;
+        bool bFirst = true;
+        for (const std::string& journalMode : options.journalModes)
+        {
+            for (const std::string& synchronous : options.synchronousLevels)
+            {
+                for (const int threads : options.threads)
+                {
+                    runs << (bFirst ? "\n" : ",\n");
+                    runStress(options, getRun(options, journalMode, synchronous, threads), runs);
+                    bFirst = false;
+                }
+            }
+        }
+
+        std::ofstream file;
+        if (!options.output.empty())
+        {
+            file.open(options.output.c_str());
+        }
+        std::ostream& output = options.output.empty() ? std::cout : file;
+        output << "{\n";
+        output << "  \"sqlitecpp_version\": \"" << SQLITECPP_VERSION << "\",\n";
+        output << "  \"sqlite_version\": \"" << sqlite3_libversion() << "\",\n";
+        output << "  \"threadsafe\": " << sqlite3_threadsafe() << ",\n";
+        output << "  \"runs\": [" << runs.str() << "\n  ]\n";
+        output << "}\n";
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "SQLite exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file    Allocator.h
+ * @ingroup SQLiteCpp
+ * @brief   Pluggable memory allocator for SQLite, with a size-class pool allocator and per-class accounting.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace SQLite
+{
+
+
+/// Memory allocators that can be installed for all SQLite allocations by configureAllocator()
+enum class Allocator
+{
+    Default,    ///< The allocator SQLite was using before the first call to configureAllocator() (the system malloc)
+    Pool        ///< Size-class pool allocator with thread-local caches, see getAllocatorStats()
+};
+
+/**
+ * @brief Accounting of the memory allocated by SQLite through the Pool allocator.
+ *
+ *  Small allocations are rounded up to one of the size classes and served from pools of blocks,
+ * larger ones go straight to the system malloc. Bytes are counted by size of the blocks handed to SQLite.
+ */
+struct AllocatorStats
+{
+    /// Accounting of one size class
+    struct SizeClass
+    {
+        size_t      size;               ///< Size of the blocks of this class, in bytes
+        uint64_t    allocations;        ///< Number of allocations served by this class
+        uint64_t    blocksInUse;        ///< Number of blocks currently allocated
+        uint64_t    bytesInUse;         ///< Bytes currently allocated (blocksInUse * size)
+        uint64_t    bytesReserved;      ///< Bytes carved out of the system for this class (in use or cached)
+    };
+
+    std::vector<SizeClass>  sizeClasses;        ///< Accounting of each size class, by increasing block size
+    uint64_t                largeAllocations;   ///< Number of allocations too large for any size class
+    uint64_t                largeBytesInUse;    ///< Bytes currently allocated by these large allocations
+    uint64_t                bytesInUse;         ///< Total bytes currently allocated
+    uint64_t                peakBytesInUse;     ///< Highest bytesInUse since installation or resetAllocatorPeak()
+};
+
+/**
+ * @brief Install the memory allocator used by SQLite for all its allocations, with SQLITE_CONFIG_MALLOC.
+ *
+ *  This must be called before SQLite is initialized, that is before opening the first Database,
+ * or after sqlite3_shutdown() once all the connections are closed. Memory allocated by one allocator
+ * must not outlive it: switch back to Allocator::Default only when SQLite holds no memory of the Pool.
+ *
+ * @param[in] aAllocator    Allocator to install
+ *
+ * @throw SQLite::Exception if SQLite is already initialized (SQLITE_MISUSE),
+ *                          or if the Pool still has blocks in use when switching back to the Default allocator
+ */
+void configureAllocator(const Allocator aAllocator);
+
+/// Return the allocator currently installed by configureAllocator().
+Allocator getAllocator() noexcept; // nothrow
+
+/// Return the accounting of the Pool allocator (all zeros if it was never installed).
+AllocatorStats getAllocatorStats();
+
+/// Restart the measure of the peak usage of the Pool allocator from its current usage.
+void resetAllocatorPeak() noexcept; // nothrow
+
+
+}  // namespace SQLite
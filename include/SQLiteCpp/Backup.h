@@ -99,6 +99,12 @@ public:
     Backup(Database& aDestDatabase,
            Database& aSrcDatabase);
 
+    /// Move the SQLite Backup resource to a new Backup object.
+    Backup(Backup&& aBackup) noexcept; // nothrow
+
+    /// Release the current SQLite Backup resource, then move the other one here.
+    Backup& operator=(Backup&& aBackup) noexcept; // nothrow
+
     /// Release the SQLite Backup resource.
     ~Backup();
 
@@ -0,0 +1,135 @@
+/**
+ * @file    BulkImporter.h
+ * @ingroup SQLiteCpp
+ * @brief   Import of CSV and delimited files into a table, by a pipeline of reader, parser and writer threads.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <SQLiteCpp/Statement.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+
+namespace SQLite
+{
+
+
+// Forward declaration
+class Database;
+
+/// Options of a BulkImporter.
+struct BulkImportOptions
+{
+    char        delimiter = ',';                ///< Separator of the fields ('\t' for TSV)
+    char        quote = '"';                    ///< Quote of the fields containing delimiters, quotes or newlines
+    bool        bHeader = false;                ///< true to skip the first record, the names of the columns
+    bool        bEmptyAsNull = false;           ///< true to insert empty fields as NULL, instead of empty strings
+    size_t      parsers = 0;                    ///< Number of parser threads, or 0 for the hardware threads minus 2
+    size_t      chunkSize = 1024 * 1024;        ///< Number of bytes read at once, then parsed as a batch of records
+    size_t      chunksInFlight = 8;             ///< Most chunks read but not written yet, bounding the memory used
+    size_t      rowsPerTransaction = 100000;    ///< Number of rows inserted by each transaction
+    bool        bBulkPragmas = true;            ///< true for "PRAGMA synchronous=OFF" and a larger cache meanwhile
+};
+
+/// Throughput and stall times of the stages of an import by a BulkImporter.
+struct BulkImportStats
+{
+    uint64_t    rows;               ///< Number of rows inserted
+    uint64_t    bytes;              ///< Number of bytes read
+    uint64_t    chunks;             ///< Number of chunks read, parsed and written
+    double      seconds;            ///< Duration of the import
+    double      readerStall;        ///< Seconds the reader waited for chunks to be written (memory bound reached)
+    double      parserStall;        ///< Seconds the parsers waited for chunks to be read, summed over the parsers
+    double      writerStall;        ///< Seconds the writer waited for the next chunk to be parsed
+
+    /// Return the number of rows inserted per second
+    double getRowsPerSecond() const noexcept // nothrow
+    {
+        return (seconds > 0.0) ? static_cast<double>(rows) / seconds : 0.0;
+    }
+};
+
+/**
+ * @brief Import of CSV (RFC 4180) and delimited files into a table, by a pipeline of threads.
+ *
+ *  A reader thread reads the input by chunks of whole records, several parser threads split the records
+ * of the chunks into fields in place (unquoting them and terminating them by a null character), and the calling
+ * thread writes the parsed chunks in their order in the input: the fields are bound to the cached insert Statement
+ * with bindNoCopy(), straight from the buffers they were read into, with no copy from the input to SQLite.
+ *
+ *  Rows are inserted by transactions of BulkImportOptions::rowsPerTransaction rows, with "PRAGMA synchronous=OFF"
+ * and a larger page cache meanwhile, restored at the end. If an error stops the import (a record without the
+ * number of fields of the table, an unterminated quote...), the rows of the transactions committed before it stay
+ * in the table. Records end by "\n" or "\r\n", and the empty lines are skipped.
+ */
+class BulkImporter
+{
+public:
+    /**
+     * @brief Prepare the insert statement of the imported rows.
+     *
+     * @param[in] aDatabase Database Connection, used only by the calling thread
+     * @param[in] aTable    Name of the table
+     * @param[in] aColumns  Names of the columns of the fields of the records, in their order,
+     *                      or none for all the columns of the table (see Database::getSchema())
+     * @param[in] aOptions  Options of the import
+     *
+     * @throw SQLite::Exception in case of error, or if the table does not exist
+     */
+    BulkImporter(Database&                          aDatabase,
+                 const std::string&                 aTable,
+                 const std::vector<std::string>&    aColumns = std::vector<std::string>(),
+                 const BulkImportOptions&           aOptions = BulkImportOptions());
+
+    /**
+     * @brief Import a file.
+     *
+     * @param[in] aFilename Path to the file
+     *
+     * @return the statistics of the import
+     *
+     * @throw SQLite::Exception in case of error, then the pending transaction is rolled back
+     */
+    BulkImportStats importFile(const std::string& aFilename);
+
+    /**
+     * @brief Import a stream, read from its current position to its end.
+     *
+     * @param[in] aInput    Stream to read, in binary mode
+     *
+     * @return the statistics of the import
+     *
+     * @throw SQLite::Exception in case of error, then the pending transaction is rolled back
+     */
+    BulkImportStats importStream(std::istream& aInput);
+
+    /// Return the number of fields of each record, the number of columns inserted.
+    size_t getColumnCount() const noexcept // nothrow
+    {
+        return mColumns.size();
+    }
+
+private:
+    /// @{ BulkImporter must be non-copyable
+    BulkImporter(const BulkImporter&);
+    BulkImporter& operator=(const BulkImporter&);
+    /// @}
+
+private:
+    Database&                   mDatabase;  ///< Database Connection of the table
+    std::vector<std::string>    mColumns;   ///< Names of the columns inserted
+    Statement                   mInsert;    ///< Insert statement, prepared once
+    BulkImportOptions           mOptions;   ///< Options of the import
+};
+
+
+}  // namespace SQLite
@@ -0,0 +1,89 @@
+/**
+ * @file    Collation.h
+ * @ingroup SQLiteCpp
+ * @brief   Collating sequences implemented by C++ comparators, and built-in collations for common orders.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <cstddef>
+
+
+namespace SQLite
+{
+
+
+/**
+ * @brief Collation comparing texts with the letters of the ASCII range folded to lower case.
+ *
+ *  Unlike lower() in a query, it can be used by an index: "CREATE INDEX idx ON t(name COLLATE ascii_nocase)".
+ * It is the order of the NOCASE built-in collation of SQLite, without its overhead of a function call
+ * through the sqlite3_stricmp() table per character.
+ */
+struct AsciiNoCaseCollation
+{
+    /// Compare two UTF-8 texts: negative, zero or positive as aLeft is lower, equal or greater than aRight
+    int operator()(const char* apLeft, size_t aLeftSize, const char* apRight, size_t aRightSize) const noexcept;
+};
+
+/**
+ * @brief Collation comparing runs of decimal digits by their numerical value, and other bytes as binary.
+ *
+ *  "file2" is sorted before "file10", and "v1.9" before "v1.10". Numbers of any length are compared
+ * without conversion; for equal numbers, the one with fewer leading zeros comes first ("1" < "01").
+ */
+struct NaturalCollation
+{
+    /// Compare two UTF-8 texts: negative, zero or positive as aLeft is lower, equal or greater than aRight
+    int operator()(const char* apLeft, size_t aLeftSize, const char* apRight, size_t aRightSize) const noexcept;
+};
+
+/**
+ * @brief Collation comparing texts byte per byte, which sorts UTF-8 texts in the order of their code points.
+ *
+ *  It is the order of the BINARY built-in collation of SQLite, as a baseline and to be composed with other orders.
+ */
+struct Utf8BinaryCollation
+{
+    /// Compare two UTF-8 texts: negative, zero or positive as aLeft is lower, equal or greater than aRight
+    int operator()(const char* apLeft, size_t aLeftSize, const char* apRight, size_t aRightSize) const noexcept;
+};
+
+
+/// @cond
+namespace detail
+{
+
+/**
+ * @brief Callbacks of a collation implemented by a comparator of type C.
+ *
+ *  The comparator is allocated as the user data of the collation, and called directly:
+ * there is no std::function nor virtual call on the path of each comparison.
+ */
+template<typename C>
+struct CollationFunction
+{
+    /// xCompare callback, with the UTF-8 texts and their sizes in bytes (the comparator must not throw)
+    static int compare(void* apComparator, int aLeftSize, const void* apLeft,
+                       int aRightSize, const void* apRight) noexcept // nothrow
+    {
+        return (*static_cast<C*>(apComparator))(static_cast<const char*>(apLeft), static_cast<size_t>(aLeftSize),
+                                                 static_cast<const char*>(apRight), static_cast<size_t>(aRightSize));
+    }
+
+    /// xDestroy callback, deleting the comparator
+    static void destroy(void* apComparator) noexcept // nothrow
+    {
+        delete static_cast<C*>(apComparator);
+    }
+};
+
+}  // namespace detail
+/// @endcond
+
+
+}  // namespace SQLite
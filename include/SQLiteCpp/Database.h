@@ -10,9 +10,19 @@
  */
 #pragma once
 
+#include <SQLiteCpp/Assertion.h>
+#include <SQLiteCpp/Collation.h>
 #include <SQLiteCpp/Column.h>
+#include <SQLiteCpp/Function.h>
+#include <SQLiteCpp/Profiler.h>
+#include <SQLiteCpp/Schema.h>
+#include <SQLiteCpp/TableFunction.h>
 #include <SQLiteCpp/Utils.h>    // definition of nullptr for C++98/C++03 compilers
 
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
 #include <string.h>
 
 // Forward declarations to avoid inclusion of <sqlite3.h> in a header
@@ -43,6 +53,15 @@ extern const int OPEN_CREATE;       // SQLITE_OPEN_CREATE
 /// Enable URI filename interpretation, parsed according to RFC 3986 (ex. "file:data.db?mode=ro&cache=private")
 extern const int OPEN_URI;          // SQLITE_OPEN_URI
 
+/// The connection has no mutex of its own (multi-thread mode): it must be used by one thread at a time
+extern const int OPEN_NOMUTEX;      // SQLITE_OPEN_NOMUTEX
+/// The connection has its own mutex (serialized mode), even if SQLite was initialized in ThreadingMode::MultiThread
+extern const int OPEN_FULLMUTEX;    // SQLITE_OPEN_FULLMUTEX
+/// The connection shares its page cache with the other connections of the process opened on the same database
+extern const int OPEN_SHAREDCACHE;  // SQLITE_OPEN_SHAREDCACHE
+/// The connection has its own page cache, even if shared cache mode was enabled globally
+extern const int OPEN_PRIVATECACHE; // SQLITE_OPEN_PRIVATECACHE
+
 extern const int OK;                ///< SQLITE_OK (used by inline check() bellow)
 
 extern const char*  VERSION;        ///< SQLITE_VERSION string from the sqlite3.h used at compile time
@@ -53,6 +72,66 @@ const char* getLibVersion() noexcept; // nothrow
 /// Return SQLite version number using runtime call to the compiled library
 int   getLibVersionNumber() noexcept; // nothrow
 
+// Forward declaration
+class VirtualTableBase;
+
+/**
+ * @brief Resource usage statistics of a Database Connection, from sqlite3_db_status().
+ *
+ * @see Database::getStats()
+ */
+struct DatabaseStats
+{
+    int cacheHit;               ///< SQLITE_DBSTATUS_CACHE_HIT: page cache hits
+    int cacheMiss;              ///< SQLITE_DBSTATUS_CACHE_MISS: page cache misses
+    int cacheWrite;             ///< SQLITE_DBSTATUS_CACHE_WRITE: dirty pages written to disk
+    int cacheUsed;              ///< SQLITE_DBSTATUS_CACHE_USED: bytes of heap memory used by the page cache
+    int cacheUsedShared;        ///< SQLITE_DBSTATUS_CACHE_USED_SHARED: the same, shared caches divided between users
+    int lookasideUsed;          ///< SQLITE_DBSTATUS_LOOKASIDE_USED: lookaside memory slots currently checked out
+    int lookasideHighwater;     ///< SQLITE_DBSTATUS_LOOKASIDE_USED highwater: most slots ever checked out at once
+    int lookasideHit;           ///< SQLITE_DBSTATUS_LOOKASIDE_HIT: allocations satisfied from lookaside memory
+    int lookasideMissSize;      ///< SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE: misses because the request was too large
+    int lookasideMissFull;      ///< SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL: misses because all slots were in use
+    int schemaUsed;             ///< SQLITE_DBSTATUS_SCHEMA_USED: bytes of heap memory used by the schemas
+    int stmtUsed;               ///< SQLITE_DBSTATUS_STMT_USED: bytes of heap memory used by the prepared statements
+    int deferredFks;            ///< SQLITE_DBSTATUS_DEFERRED_FKS: 1 if there are unresolved deferred foreign keys
+
+    /// Return the ratio of page cache hits over page cache lookups (0.0 if there was none)
+    double getCacheHitRatio() const noexcept // nothrow
+    {
+        const int lookups = cacheHit + cacheMiss;
+        return (lookups > 0) ? static_cast<double>(cacheHit) / lookups : 0.0;
+    }
+};
+
+/**
+ * @brief Lookaside memory allocator configuration of a Database Connection.
+ *
+ * @see Database::setLookaside() and Database::adviseLookaside()
+ */
+struct LookasideConfig
+{
+    int slotSize;   ///< Size of each lookaside memory slot, in bytes, or -1 if unknown
+    int slotCount;  ///< Number of lookaside memory slots, or -1 if unknown
+
+    /// Return false for the default configuration of the library, unknown as it depends on its version and build
+    bool isKnown() const noexcept // nothrow
+    {
+        return (slotSize >= 0) && (slotCount >= 0);
+    }
+};
+
+/**
+ * @brief Compute the activity between two samples of the statistics of a Database Connection.
+ *
+ *  Counters of events (cache hits, misses and writes, lookaside hits and misses) are subtracted,
+ * while gauges (memory used, slots in use, highwater mark and deferred foreign keys) are those of aAfter.
+ *
+ * @param[in] aAfter    Latest sample
+ * @param[in] aBefore   Earlier sample of the same connection, taken without resetting the counters meanwhile
+ */
+DatabaseStats operator-(const DatabaseStats& aAfter, const DatabaseStats& aBefore) noexcept; // nothrow
+
 
 /**
  * @brief RAII management of a SQLite Database Connection.
@@ -70,6 +149,10 @@ int   getLibVersionNumber() noexcept; // nothrow
  * 2) the SQLite "Serialized" mode is not supported by SQLiteC++,
  *    because of the way it shares the underling SQLite precompiled statement
  *    in a custom shared pointer (See the inner class "Statement::Ptr").
+ *
+ *  So the mutex of each connection can be saved, by opening it with OPEN_NOMUTEX, or by calling
+ * SQLite::initialize(ThreadingMode::MultiThread) at startup. In debug builds, a connection without mutex then
+ * asserts that it is used only by the thread that opened it, or that took it over with acquireOwnership().
  */
 class Database
 {
@@ -120,6 +203,22 @@ public:
              const int          aBusyTimeoutMs  = 0,
              const std::string& aVfs            = "");
 
+    /**
+     * @brief Move the connection to a new Database object.
+     *
+     *  Statement, Column and Backup objects keep working, as they use the underlying connection;
+     * a Transaction or a QueryGuard refers to the Database object itself, so must not outlive the move.
+     * The moved-from Database has no connection anymore: it can only be destroyed or assigned to.
+     */
+    Database(Database&& aDatabase) noexcept; // nothrow
+
+    /**
+     * @brief Close the SQLite database connection, then move the other one here.
+     *
+     * @warning assert in case of error closing the connection (see ~Database())
+     */
+    Database& operator=(Database&& aDatabase) noexcept; // nothrow
+
     /**
      * @brief Close the SQLite database connection.
      *
@@ -188,6 +287,29 @@ public:
         return exec(aQueries.c_str());
     }
 
+    /**
+     * @brief Execute one or multiple statements without results, setting an error code instead of throwing.
+     *
+     * @param[in]  apQueries one or multiple UTF-8 encoded, semicolon-separate SQL statements
+     * @param[out] aError    the error of the execution (see Errors.h), or an empty error code
+     *
+     * @return number of rows modified by the *last* INSERT, UPDATE or DELETE statement, or 0 on error
+     */
+    int exec(const char* apQueries, std::error_code& aError) noexcept;
+
+    /**
+     * @brief Execute one or multiple statements without results, setting an error code instead of throwing.
+     *
+     * @param[in]  aQueries  one or multiple UTF-8 encoded, semicolon-separate SQL statements
+     * @param[out] aError    the error of the execution (see Errors.h), or an empty error code
+     *
+     * @return number of rows modified by the *last* INSERT, UPDATE or DELETE statement, or 0 on error
+     */
+    inline int exec(const std::string& aQueries, std::error_code& aError) noexcept
+    {
+        return exec(aQueries.c_str(), aError);
+    }
+
     /**
      * @brief Shortcut to execute a one step query and fetch the first column of the result.
      *
@@ -236,7 +358,8 @@ public:
     /**
      * @brief Shortcut to test if a table exists.
      *
-     *  Table names are case sensitive.
+     *  Table names are case sensitive. The lookup is done in the catalog of getSchema(),
+     * so that repeated calls do not query sqlite_master as long as the schema does not change.
      *
      * @param[in] apTableName an UTF-8 encoded case sensitive Table name
      *
@@ -259,9 +382,19 @@ public:
      */
     inline bool tableExists(const std::string& aTableName)
     {
-        return tableExists(aTableName.c_str());
+        return getSchema().tableExists(aTableName);
     }
 
+    /**
+     * @brief Return the catalog of the tables, views, columns and indexes of the main database.
+     *
+     *  It is created and loaded on first use, then loaded again only when "PRAGMA schema_version" changes,
+     * so that its lookups cost a hash probe instead of the preparation and execution of a query.
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    Schema& getSchema();
+
     /**
      * @brief Get the rowid of the most recent successful INSERT into the database from the current connection.
      *
@@ -275,6 +408,14 @@ public:
     /// Get total number of rows modified by all INSERT, UPDATE or DELETE statement since connection (not DROP table).
     int getTotalChanges() const noexcept; // nothrow
 
+    /**
+     * @brief Interrupt the statements running on the connection, as soon as possible.
+     *
+     *  Safe to call from any thread: it is the way out of a runaway query. The statements being executed
+     * fail with SQLITE_INTERRUPT, thrown as a SQLite::InterruptedException. See also QueryGuard.
+     */
+    void interrupt() noexcept; // nothrow
+
     /// Return the numeric result code for the most recent failed API call (if any).
     int getErrorCode() const noexcept; // nothrow
     /// Return the extended numeric result code for the most recent failed API call (if any).
@@ -288,6 +429,30 @@ public:
         return mFilename;
     }
 
+    /**
+     * @brief Make the current thread the owner of the connection, to hand it over to another thread.
+     *
+     *  A connection without mutex (see hasMutex()) is owned by the thread that opened it. In debug builds,
+     * exec() and the Statement constructors assert that they are called by the owner thread:
+     * the new thread shall call acquireOwnership() once the previous owner is done with the connection.
+     */
+    void acquireOwnership() noexcept // nothrow
+    {
+        mOwnerThread = std::this_thread::get_id();
+    }
+
+    /// Return true if the connection is owned by the current thread (see acquireOwnership()).
+    bool isOwnedByCurrentThread() const noexcept // nothrow
+    {
+        return std::this_thread::get_id() == mOwnerThread;
+    }
+
+    /// Return true if the connection has its own mutex (serialized mode), false if opened without (multi-thread mode).
+    bool hasMutex() const noexcept // nothrow
+    {
+        return mbMutex;
+    }
+
     /**
      * @brief Return raw pointer to SQLite Database Connection Handle.
      *
@@ -358,6 +523,273 @@ public:
                               apApp, apFunc, apStep, apFinal, apDestroy);
     }
 
+#if (__cplusplus >= 201402L) || ( defined(_MSC_VER) && (_MSC_VER >= 1900) ) // c++14: Visual Studio 2015
+    /**
+     * @brief Create or redefine a SQL function implemented by a C++ function, lambda or function object.
+     *
+     *  The number of arguments of the SQL function is the number of parameters of the callable.
+     * The code converting each SQL argument to the type of its parameter, and the result to a SQL value,
+     * is generated at compile time: there is no std::function nor virtual call on the path of each row.
+     *
+     *  Parameters and result can be int, unsigned int, long, long long, unsigned long, unsigned long long,
+     * double, bool, const char* and std::string (UTF-8 text, valid only during the call for const char*),
+     * std::string_view and std::optional<T> (empty for NULL) with C++17, or sqlite3_value* for raw access;
+     * a function returning void returns NULL. An exception thrown by the callable becomes the error
+     * of the SQL statement, with the message given by what().
+     *
+     * @code
+     * db.createFunction("weight", [](long long aId, std::string_view aName) -> double {...}, SQLite::Deterministic);
+     * @endcode
+     *
+     * @note Requires std=C++14
+     *
+     * @param[in] apFuncName    Name of the SQL function to be created or redefined
+     * @param[in] aFunction     Callable, moved to be owned by the connection until the function is redefined
+     * @param[in] aFlags        Deterministic if the callable always returns the same result for the same arguments
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template<typename F>
+    void createFunction(const char* apFuncName, F aFunction, const FunctionFlags aFlags = NonDeterministic)
+    {
+        typedef detail::ScalarFunction<F> Function;
+        // Note: the callable is deleted by Function::destroy() even if the creation fails
+        createFunction(apFuncName, Function::ARITY, (Deterministic == aFlags), new F(std::move(aFunction)),
+                       &Function::call, nullptr, nullptr, &Function::destroy);
+    }
+
+    /**
+     * @brief Create or redefine a SQL function implemented by a C++ function, lambda or function object.
+     *
+     * @see createFunction(const char*, F, FunctionFlags)
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template<typename F>
+    inline void createFunction(const std::string& aFuncName, F aFunction, const FunctionFlags aFlags = NonDeterministic)
+    {
+        createFunction(aFuncName.c_str(), std::move(aFunction), aFlags);
+    }
+
+    /**
+     * @brief Create or redefine an aggregate SQL function implemented by a StateT class.
+     *
+     *  A StateT is default constructed for each group of rows, in place in the memory SQLite provides
+     * with sqlite3_aggregate_context() (no heap allocation per group), then its step() member function
+     * is called with the arguments of each row, and finalize() returns the result of the group
+     * before the state is destroyed. For a group without any row, finalize() is called on a new state.
+     *
+     *  The number and types of the arguments are those of the parameters of step(), and the types of
+     * arguments and result are converted as with createFunction(const char*, F, FunctionFlags).
+     * An exception thrown by step() or finalize() becomes the error of the SQL statement.
+     *
+     * @code
+     * struct Average
+     * {
+     *     double sum = 0.0;
+     *     long long count = 0;
+     *     void step(double aValue) { sum += aValue; ++count; }
+     *     std::optional<double> finalize() { return count ? std::optional<double>(sum / count) : std::nullopt; }
+     * };
+     * db.createAggregate<Average>("average", SQLite::Deterministic);
+     * @endcode
+     *
+     * @note Requires std=C++14, and an alignment of StateT of at most 8 bytes
+     *
+     * @tparam  StateT  Default constructible class with step(Args...) and finalize() member functions
+     *
+     * @param[in] apFuncName    Name of the SQL aggregate function to be created or redefined
+     * @param[in] aFlags        Deterministic if the aggregate always returns the same result for the same rows
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template<typename StateT>
+    void createAggregate(const char* apFuncName, const FunctionFlags aFlags = NonDeterministic)
+    {
+        typedef detail::AggregateFunction<StateT> Aggregate;
+        createFunction(apFuncName, Aggregate::ARITY, (Deterministic == aFlags), nullptr,
+                       nullptr, &Aggregate::step, &Aggregate::final, nullptr);
+    }
+
+    /**
+     * @brief Create or redefine an aggregate SQL function implemented by a StateT class.
+     *
+     * @see createAggregate(const char*, FunctionFlags)
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template<typename StateT>
+    inline void createAggregate(const std::string& aFuncName, const FunctionFlags aFlags = NonDeterministic)
+    {
+        createAggregate<StateT>(aFuncName.c_str(), aFlags);
+    }
+#endif // c++14
+
+    /**
+     * @brief Create or redefine a collating sequence in the sqlite database.
+     *
+     *  This is the equivalent of the sqlite3_create_collation_v2 command.
+     * @see http://www.sqlite.org/c3ref/create_collation.html
+     *
+     * @note UTF-8 text encoding assumed.
+     *
+     * @param[in] apCollationName   Name of the collation to be created or redefined
+     * @param[in] apApp             Arbitrary pointer of user data, given as first argument of apCompare
+     * @param[in] apCompare         Pointer to a C-function comparing two texts given with their sizes in bytes
+     * @param[in] apDestroy         If not nullptr, the destructor for the application data pointer,
+     *                              also called if the creation fails
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    void createCollation(const char* apCollationName,
+                         void*       apApp,
+                         int       (*apCompare)(void*, int, const void*, int, const void*),
+                         void      (*apDestroy)(void*));
+
+    /**
+     * @brief Create or redefine a collating sequence implemented by a C++ comparator.
+     *
+     *  The comparator is called directly by SQLite, without std::function nor virtual call, for each comparison
+     * of ORDER BY, GROUP BY, DISTINCT, comparison operators and indexes using the collation
+     * ("CREATE INDEX idx ON t(name COLLATE natsort)"). The collation must be created on each connection
+     * using such an index, and must always give the same order, else the index is corrupted.
+     * See AsciiNoCaseCollation, NaturalCollation and Utf8BinaryCollation for built-in comparators.
+     *
+     * @code
+     * db.createCollation("natsort", SQLite::NaturalCollation());
+     * db.createCollation("reverse", [](const char* apLeft, size_t aLeftSize, const char* apRight, size_t aRightSize) {
+     *     return SQLite::Utf8BinaryCollation()(apRight, aRightSize, apLeft, aLeftSize);
+     * });
+     * @endcode
+     *
+     * @param[in] apCollationName   Name of the collation to be created or redefined
+     * @param[in] aComparator       Callable with a "int (const char*, size_t, const char*, size_t)" signature,
+     *                              returning a negative, zero or positive result as the left UTF-8 text
+     *                              is lower, equal or greater than the right one; it must not throw
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template<typename C>
+    void createCollation(const char* apCollationName, C aComparator)
+    {
+        typedef detail::CollationFunction<C> Collation;
+        createCollation(apCollationName, new C(std::move(aComparator)), &Collation::compare, &Collation::destroy);
+    }
+
+    /**
+     * @brief Create or redefine a collating sequence implemented by a C++ comparator.
+     *
+     * @see createCollation(const char*, C)
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template<typename C>
+    inline void createCollation(const std::string& aCollationName, C aComparator)
+    {
+        createCollation(aCollationName.c_str(), std::move(aComparator));
+    }
+
+    /**
+     * @brief Register a C++ table as an eponymous virtual table of the connection, readable as any other table.
+     *
+     *  The indexes of the table are sorted by this call (see VirtualTableBase::refresh()).
+     * Equality and range constraints on its Indexed columns are then pushed down to them by SQLite,
+     * so that the table can be joined with on-disk tables without copying it into a temporary table.
+     *
+     * @code
+     * SQLite::VirtualTable<Employee> table(employees);
+     * table.addColumn("id", &Employee::id, SQLite::Indexed).addColumn("name", &Employee::name);
+     * db.createModule("employees", table);
+     * SQLite::Statement query(db, "SELECT e.name, o.amount FROM orders o JOIN employees e ON e.id = o.employee_id");
+     * @endcode
+     *
+     * @see https://www.sqlite.org/vtab.html#eponymous_only_virtual_tables
+     *
+     * @param[in] apModuleName  Name of the module and of the table
+     * @param[in] aTable        Table with all its columns, which must outlive the connection
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    void createModule(const char* apModuleName, VirtualTableBase& aTable);
+
+    /**
+     * @brief Register a C++ table as an eponymous virtual table of the connection, readable as any other table.
+     *
+     * @see createModule(const char*, VirtualTableBase&)
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    inline void createModule(const std::string& aModuleName, VirtualTableBase& aTable)
+    {
+        createModule(aModuleName.c_str(), aTable);
+    }
+
+#if (__cplusplus >= 201402L) || ( defined(_MSC_VER) && (_MSC_VER >= 1900) ) // c++14: Visual Studio 2015
+    /**
+     * @brief Create a table-valued SQL function streaming the rows of a Generator returned by a C++ callable.
+     *
+     *  The function is an eponymous virtual table, called in the FROM clause of a query with its arguments,
+     * converted as with createFunction(const char*, F, FunctionFlags). Its rows are generated one at a time
+     * as SQLite reads them, without being materialized, and a LIMIT stops the generation early.
+     * The arguments stay valid as long as the Generator, which can thus keep a const char* to a text.
+     *
+     * @code
+     * db.createTableFunction("split", [](std::string aText) {
+     *     size_t position = 0;
+     *     return SQLite::Generator<std::tuple<std::string>>([aText, position](std::tuple<std::string>& aRow) mutable {
+     *         if (position > aText.size()) return false;
+     *         const size_t end = std::min(aText.find(',', position), aText.size());
+     *         std::get<0>(aRow) = aText.substr(position, end - position);
+     *         position = end + 1;
+     *         return true;
+     *     });
+     * }, {"token", "text"});
+     * SQLite::Statement query(db, "SELECT token FROM split('a,b,c')");
+     * @endcode
+     *
+     * @see https://www.sqlite.org/vtab.html#table_valued_functions
+     *
+     * @param[in] apFuncName    Name of the SQL function and of its virtual table
+     * @param[in] aFunction     Callable returning a Generator of std::tuple, owned by the connection
+     * @param[in] aNames        Names of the columns of the rows then of the arguments (hidden columns),
+     *                          or empty for "value" (or "value1", "value2"...) and "arg1", "arg2"...
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template<typename F>
+    void createTableFunction(const char* apFuncName, F aFunction, const std::vector<std::string>& aNames = {})
+    {
+        detail::TableFunctionBase* pFunction = new detail::TableFunction<F>(aNames, std::move(aFunction));
+        createTableFunction(apFuncName, pFunction);
+    }
+
+    /**
+     * @brief Create a table-valued SQL function streaming the rows of a Generator returned by a C++ callable.
+     *
+     * @see createTableFunction(const char*, F, const std::vector<std::string>&)
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template<typename F>
+    inline void createTableFunction(const std::string& aFuncName, F aFunction,
+                                    const std::vector<std::string>& aNames = {})
+    {
+        createTableFunction(aFuncName.c_str(), std::move(aFunction), aNames);
+    }
+#endif // c++14
+
+    /**
+     * @brief Register a table-valued SQL function, as an eponymous virtual table owning the function.
+     *
+     * @see createTableFunction(const char*, F, const std::vector<std::string>&)
+     *
+     * @param[in] apFuncName    Name of the SQL function and of its virtual table
+     * @param[in] apFunction    Function allocated with new, deleted by the connection (even in case of error)
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    void createTableFunction(const char* apFuncName, detail::TableFunctionBase* apFunction);
+
     /**
      * @brief Load a module into the current sqlite database instance. 
      *
@@ -420,12 +852,115 @@ public:
     */
     static bool isUnencrypted(const std::string& aFilename);
 
+    /**
+     * @brief Start aggregating the execution times of all statements of the connection.
+     *
+     *  This registers a sqlite3_trace_v2() callback timing each execution of a statement and counting its rows,
+     * aggregated per SQL text (before parameter expansion) in latency histograms, see getProfile().
+     *  Calling it again only updates the slow threshold, keeping the statistics gathered so far.
+     *
+     * @param[in] aSlowThresholdNs  Executions at least this slow (in nanoseconds) record their expanded SQL
+     *                              for the slowest one (0 to disable)
+     * @param[in] aMaxStatements    Number of distinct statements tracked; further ones are aggregated as "<other>"
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    void enableProfiling(const long long aSlowThresholdNs = 0, const int aMaxStatements = 512);
+
+    /**
+     * @brief Stop aggregating the execution times of the statements, keeping the statistics gathered so far.
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    void disableProfiling();
+
+    /**
+     * @brief Return the execution statistics of all statements, gathered since enableProfiling() or the last reset.
+     *
+     *  It can be called periodically from another thread to scrape the statistics,
+     * as long as the Database object is not destroyed meanwhile.
+     *
+     * @param[in] abReset   Reset the statistics after reading them
+     *
+     * @return one StatementProfile per distinct SQL text, or an empty list if profiling was never enabled
+     */
+    std::vector<StatementProfile> getProfile(const bool abReset = false);
+
+    /// Forget the execution statistics gathered so far.
+    void resetProfile() noexcept; // nothrow
+
+    /**
+     * @brief Return the resource usage statistics of the connection, from sqlite3_db_status().
+     *
+     *  Counters of events accumulate since the connection was opened (or since the last reset),
+     * use operator- on two samples to compute the activity in between.
+     *
+     * @param[in] abReset   Reset the counters of events and the highwater mark after reading them
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    DatabaseStats getStats(const bool abReset = false) const;
+
+    /**
+     * @brief Configure the lookaside memory allocator of the connection, with SQLITE_DBCONFIG_LOOKASIDE.
+     *
+     *  The lookaside allocator serves the small and short lived allocations of the connection (parsed SQL,
+     * prepared statements, records...) from a pool of fixed size slots, much faster than the general allocator.
+     * Requests larger than a slot, or made while all slots are in use, fall back to the general allocator:
+     * use getStats() to look at lookasideMissSize and lookasideMissFull, or let adviseLookaside() do it.
+     *
+     *  This can only be done while no lookaside memory is in use, typically right after opening the connection.
+     *
+     * @param[in] aSlotSize     Size of each slot, in bytes (rounded down to a multiple of 8, 0 to disable lookaside)
+     * @param[in] aSlotCount    Number of slots (0 to disable lookaside)
+     * @param[in] apBuffer      Memory of at least aSlotSize*aSlotCount bytes for the slots, 8 bytes aligned,
+     *                          that must outlive the connection, or nullptr to let SQLite allocate it
+     *
+     * @throw SQLite::Exception in case of error (SQLITE_BUSY if lookaside memory is currently in use)
+     */
+    void setLookaside(const int aSlotSize, const int aSlotCount, void* apBuffer = nullptr);
+
+    /**
+     * @brief Return the lookaside configuration of the connection.
+     *
+     *  Unless set by setLookaside(), the connection uses the default of the library (SQLITE_DEFAULT_LOOKASIDE
+     * or SQLITE_CONFIG_LOOKASIDE), which cannot be read back: the configuration returned is then unknown (-1).
+     */
+    const LookasideConfig& getLookaside() const noexcept // nothrow
+    {
+        return mLookaside;
+    }
+
+    /**
+     * @brief Recommend a lookaside configuration from the statistics of the connection after a warm-up.
+     *
+     *  Slots are made larger when more than 5% of the lookaside requests were too large for them,
+     * more numerous when more than 1% of them found all slots in use, and fewer when less than half of them
+     * were ever used at once. Otherwise the current configuration is returned, as it is while it is unknown
+     * (not set by setLookaside()).
+     *
+     * @param[in] aStats    Statistics of the connection with its current configuration, or the delta of two samples
+     *                      (the highwater mark being only meaningful if reset at the start of the warm-up)
+     */
+    LookasideConfig adviseLookaside(const DatabaseStats& aStats) const noexcept; // nothrow
+
 private:
     /// @{ Database must be non-copyable
     Database(const Database&);
     Database& operator=(const Database&);
     /// @}
 
+    /// Close the SQLite database connection, if not moved to another Database object
+    void close() noexcept;
+
+    /// In debug builds, assert that a connection without mutex is used by the thread owning it
+    void checkOwnership() const noexcept // nothrow
+    {
+#ifndef NDEBUG
+        SQLITECPP_ASSERT((mbMutex || isOwnedByCurrentThread()), "connection used by a thread not owning it");
+#endif
+    }
+
     /**
      * @brief Check if aRet equal SQLITE_OK, else throw a SQLite::Exception with the SQLite error message
      */
@@ -433,13 +968,18 @@ private:
     {
         if (SQLite::OK != aRet)
         {
-            throw SQLite::Exception(mpSQLite, aRet);
+            SQLite::throwException(mpSQLite, aRet);
         }
     }
 
 private:
-    sqlite3*    mpSQLite;   ///< Pointer to SQLite Database Connection Handle
-    std::string mFilename;  ///< UTF-8 filename used to open the database
+    sqlite3*                    mpSQLite;   ///< Pointer to SQLite Database Connection Handle
+    std::string                 mFilename;  ///< UTF-8 filename used to open the database
+    std::unique_ptr<Profiler>   mpProfiler; ///< Execution statistics, created by enableProfiling()
+    std::unique_ptr<Schema>     mpSchema;   ///< Catalog of the schema, created by getSchema()
+    LookasideConfig             mLookaside; ///< Lookaside configuration set by setLookaside(), or unknown
+    std::thread::id             mOwnerThread;   ///< Thread owning the connection, see acquireOwnership()
+    bool                        mbMutex;        ///< true if the connection has its own mutex (serialized mode)
 };
 
 
@@ -149,4 +149,10 @@ inline std::error_code make_error_code(Error e)
 {
     return { static_cast<int>(e), SQLite_exception_category() };
 }
+
+/// Return the std::error_code of a SQLite result code, or an empty error code for SQLITE_OK
+inline std::error_code to_error_code(const int ret) noexcept
+{
+    return (SQLITE_OK == ret) ? std::error_code() : make_error_code(static_cast<Error>(ret));
+}
 } // namespace SQLite
@@ -97,5 +97,33 @@ private:
     int mExtendedErrcode; ///< Detailed error code if any
 };
 
+/**
+ * @brief Exception of a statement interrupted (SQLITE_INTERRUPT) by Database::interrupt() or by a QueryGuard.
+ *
+ *  A distinct type so that a query stopped on purpose, to enforce a deadline or on a cancellation,
+ * can be told apart from a failure.
+ */
+class InterruptedException : public Exception
+{
+public:
+    /**
+     * @brief Encapsulation of the error message of the interrupted connection.
+     *
+     * @param[in] apSQLite  The SQLite object, to obtain detailed error messages from.
+     * @param[in] ret       Return value from function call that failed (SQLITE_INTERRUPT).
+     */
+    InterruptedException(sqlite3* apSQLite, int ret);
+};
+
+/**
+ * @brief Throw the exception of a failed function call on a connection.
+ *
+ * @param[in] apSQLite  The SQLite object, to obtain detailed error messages from.
+ * @param[in] ret       Return value from function call that failed.
+ *
+ * @throw SQLite::InterruptedException for SQLITE_INTERRUPT, else SQLite::Exception
+ */
+void throwException(sqlite3* apSQLite, int ret);
+
 
 }  // namespace SQLite
@@ -0,0 +1,325 @@
+/**
+ * @file    Function.h
+ * @ingroup SQLiteCpp
+ * @brief   Conversions between SQL values and C++ types for the SQL functions and aggregates created from C++.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if (__cplusplus >= 201703L) || (defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L)) // c++17
+#include <optional>
+#include <string_view>
+#define SQLITECPP_HAVE_STD_OPTIONAL
+#endif
+
+// Forward declarations to avoid inclusion of <sqlite3.h> in a header
+struct sqlite3_context;
+
+#ifndef SQLITE_USE_LEGACY_STRUCT // Since SQLITE 3.19 (used by default since SQLiteCpp 2.1.0)
+typedef struct sqlite3_value sqlite3_value;
+#else // Before SQLite 3.19 (legacy struct forward declaration can be activated with CMake SQLITECPP_LEGACY_STRUCT var)
+struct Mem;
+typedef struct Mem sqlite3_value;
+#endif
+
+
+namespace SQLite
+{
+
+
+/// Flags of the SQL functions created by Database::createFunction() from C++ callables
+enum FunctionFlags
+{
+    NonDeterministic = 0,   ///< The function may return different results for the same arguments, like random()
+    Deterministic = 1       ///< The function always returns the same result for the same arguments (most do)
+};
+
+/// @cond
+/// implementation detail of the SQL functions created from C++ callables.
+namespace detail
+{
+
+/// Tag selecting the overload of getValue() converting a SQL value to T
+template<typename T>
+struct Type
+{
+};
+
+// Conversions of the SQL values of the arguments, implemented in Function.cpp (text is UTF-8, NULL is 0 or empty)
+bool                isNull(sqlite3_value* apValue) noexcept; // nothrow
+int                 getValue(sqlite3_value* apValue, Type<int>) noexcept; // nothrow
+unsigned int        getValue(sqlite3_value* apValue, Type<unsigned int>) noexcept; // nothrow
+long                getValue(sqlite3_value* apValue, Type<long>) noexcept; // nothrow
+long long           getValue(sqlite3_value* apValue, Type<long long>) noexcept; // nothrow
+unsigned long       getValue(sqlite3_value* apValue, Type<unsigned long>) noexcept; // nothrow
+unsigned long long  getValue(sqlite3_value* apValue, Type<unsigned long long>) noexcept; // nothrow
+double              getValue(sqlite3_value* apValue, Type<double>) noexcept; // nothrow
+bool                getValue(sqlite3_value* apValue, Type<bool>) noexcept; // nothrow
+const char*         getValue(sqlite3_value* apValue, Type<const char*>) noexcept; // nothrow
+std::string         getValue(sqlite3_value* apValue, Type<std::string>);
+
+/// The raw SQL value, for the functions needing its type or its blob
+inline sqlite3_value* getValue(sqlite3_value* apValue, Type<sqlite3_value*>) noexcept // nothrow
+{
+    return apValue;
+}
+
+// Conversions of the result to a SQL value, implemented in Function.cpp (text is copied, unsigned stored as 64 bits)
+void setResult(sqlite3_context* apContext, std::nullptr_t) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, int aResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, unsigned int aResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, long aResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, long long aResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, unsigned long aResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, unsigned long long aResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, double aResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, bool aResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, const char* apResult) noexcept; // nothrow
+void setResult(sqlite3_context* apContext, const std::string& aResult) noexcept; // nothrow
+
+#ifdef SQLITECPP_HAVE_STD_OPTIONAL
+std::string_view    getValue(sqlite3_value* apValue, Type<std::string_view>) noexcept; // nothrow
+void                setResult(sqlite3_context* apContext, std::string_view aResult) noexcept; // nothrow
+
+/// A SQL NULL is an empty std::optional
+template<typename T>
+inline std::optional<T> getValue(sqlite3_value* apValue, Type<std::optional<T>>)
+{
+    return isNull(apValue) ? std::optional<T>() : std::optional<T>(getValue(apValue, Type<T>()));
+}
+
+/// An empty std::optional is a SQL NULL
+template<typename T>
+inline void setResult(sqlite3_context* apContext, const std::optional<T>& aResult)
+{
+    if (aResult)
+    {
+        setResult(apContext, *aResult);
+    }
+    else
+    {
+        setResult(apContext, nullptr);
+    }
+}
+#endif
+
+// Errors of the SQL functions, and access to their C++ callable
+void setError(sqlite3_context* apContext, const char* apMessage) noexcept; // nothrow
+void setErrorNoMemory(sqlite3_context* apContext) noexcept; // nothrow
+void* getUserData(sqlite3_context* apContext) noexcept; // nothrow
+void* getAggregateContext(sqlite3_context* apContext, const int aSize) noexcept; // nothrow
+
+#if (__cplusplus >= 201402L) || ( defined(_MSC_VER) && (_MSC_VER >= 1900) ) // c++14: Visual Studio 2015
+
+/// Return type and decayed parameter types of a function pointer, lambda or function object
+template<typename F>
+struct FunctionTraits : FunctionTraits<decltype(&F::operator())>
+{
+};
+
+template<typename R, typename... Args>
+struct FunctionTraits<R(*)(Args...)>
+{
+    typedef R                                               Result;
+    typedef std::tuple<typename std::decay<Args>::type...>  Arguments;
+    static const int                                        ARITY = static_cast<int>(sizeof...(Args));
+};
+
+template<typename R, typename C, typename... Args>
+struct FunctionTraits<R(C::*)(Args...) const> : FunctionTraits<R(*)(Args...)>
+{
+};
+
+template<typename R, typename C, typename... Args>
+struct FunctionTraits<R(C::*)(Args...)> : FunctionTraits<R(*)(Args...)>
+{
+};
+
+/// Call the function with its arguments converted from SQL values, and convert its result to a SQL value
+template<typename F, typename R, typename... Args, std::size_t... I>
+inline void invoke(sqlite3_context* apContext, F& aFunction, sqlite3_value** apArgs,
+                   Type<R>, std::tuple<Args...>*, std::index_sequence<I...>)
+{
+    (void)apArgs; // unused by functions without parameter
+    setResult(apContext, aFunction(getValue(apArgs[I], Type<Args>())...));
+}
+
+/// Call a function returning void, with a SQL NULL result
+template<typename F, typename... Args, std::size_t... I>
+inline void invoke(sqlite3_context* /*apContext*/, F& aFunction, sqlite3_value** apArgs,
+                   Type<void>, std::tuple<Args...>*, std::index_sequence<I...>)
+{
+    (void)apArgs; // unused by functions without parameter
+    aFunction(getValue(apArgs[I], Type<Args>())...);
+}
+
+/**
+ * @brief Callbacks of a scalar SQL function implemented by a C++ callable of type F.
+ *
+ *  The callable is allocated as the user data of the function, and called directly:
+ * there is no std::function nor virtual call on the path of each row.
+ */
+template<typename F>
+struct ScalarFunction
+{
+    typedef FunctionTraits<F> Traits;
+
+    /// Number of arguments of the SQL function
+    static const int ARITY = Traits::ARITY;
+
+    /// xFunc callback, mapping exceptions to errors of the SQL statement
+    static void call(sqlite3_context* apContext, int /*aNbArgs*/, sqlite3_value** apArgs) noexcept // nothrow
+    {
+        try
+        {
+            invoke(apContext, *static_cast<F*>(getUserData(apContext)), apArgs, Type<typename Traits::Result>(),
+                   static_cast<typename Traits::Arguments*>(nullptr), std::make_index_sequence<ARITY>());
+        }
+        catch (const std::bad_alloc&)
+        {
+            setErrorNoMemory(apContext);
+        }
+        catch (const std::exception& e)
+        {
+            setError(apContext, e.what());
+        }
+        catch (...)
+        {
+            setError(apContext, "unknown exception in a SQL function");
+        }
+    }
+
+    /// xDestroy callback, deleting the callable
+    static void destroy(void* apFunction) noexcept // nothrow
+    {
+        delete static_cast<F*>(apFunction);
+    }
+};
+
+/**
+ * @brief Callbacks of an aggregate SQL function implemented by a StateT class, with one instance per group.
+ *
+ *  The state is constructed in place in the memory of sqlite3_aggregate_context(), zeroed by SQLite
+ * on the first step of a group, and destroyed after finalize(): there is no heap allocation per group.
+ */
+template<typename StateT>
+struct AggregateFunction
+{
+    /// Memory of the aggregate context of a group
+    struct Context
+    {
+        alignas(StateT) unsigned char   storage[sizeof(StateT)];    ///< The state, once constructed
+        bool                            bConstructed;               ///< Zeroed by SQLite, true once constructed
+    };
+    static_assert(alignof(StateT) <= 8, "the memory of sqlite3_aggregate_context() is only aligned on 8 bytes");
+
+    typedef FunctionTraits<decltype(&StateT::step)>     StepTraits;
+    typedef FunctionTraits<decltype(&StateT::finalize)> FinalizeTraits;
+
+    /// Number of arguments of the SQL function
+    static const int ARITY = StepTraits::ARITY;
+
+    /// Destroy the state of a group when leaving the scope of finalize(), even on exception
+    struct Destroyer
+    {
+        Context& context;
+        ~Destroyer()
+        {
+            reinterpret_cast<StateT*>(context.storage)->~StateT();
+            context.bConstructed = false;
+        }
+    };
+
+    /// xStep callback, constructing the state on the first row of a group
+    static void step(sqlite3_context* apContext, int /*aNbArgs*/, sqlite3_value** apArgs) noexcept // nothrow
+    {
+        try
+        {
+            Context* pContext = static_cast<Context*>(getAggregateContext(apContext, sizeof(Context)));
+            if (nullptr == pContext)
+            {
+                setErrorNoMemory(apContext);
+                return;
+            }
+            if (!pContext->bConstructed)
+            {
+                new (pContext->storage) StateT();
+                pContext->bConstructed = true;
+            }
+            StateT& state = *reinterpret_cast<StateT*>(pContext->storage);
+            auto stepState = [&state](auto&&... aArgs) { state.step(std::forward<decltype(aArgs)>(aArgs)...); };
+            invoke(apContext, stepState, apArgs, Type<void>(),
+                   static_cast<typename StepTraits::Arguments*>(nullptr), std::make_index_sequence<ARITY>());
+        }
+        catch (const std::bad_alloc&)
+        {
+            setErrorNoMemory(apContext);
+        }
+        catch (const std::exception& e)
+        {
+            setError(apContext, e.what());
+        }
+        catch (...)
+        {
+            setError(apContext, "unknown exception in a SQL aggregate");
+        }
+    }
+
+    /// xFinal callback, returning the result of the state (a new one for an empty group) and destroying it
+    static void final(sqlite3_context* apContext) noexcept // nothrow
+    {
+        try
+        {
+            Context* pContext = static_cast<Context*>(getAggregateContext(apContext, 0));
+            if ((nullptr != pContext) && pContext->bConstructed)
+            {
+                Destroyer destroyer{*pContext};
+                finalize(apContext, *reinterpret_cast<StateT*>(pContext->storage));
+            }
+            else
+            {
+                StateT state;
+                finalize(apContext, state);
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+            setErrorNoMemory(apContext);
+        }
+        catch (const std::exception& e)
+        {
+            setError(apContext, e.what());
+        }
+        catch (...)
+        {
+            setError(apContext, "unknown exception in a SQL aggregate");
+        }
+    }
+
+    /// Set the result of the aggregate from the result of finalize()
+    static void finalize(sqlite3_context* apContext, StateT& aState)
+    {
+        auto finalizeState = [&aState]() { return aState.finalize(); };
+        invoke(apContext, finalizeState, nullptr, Type<typename FinalizeTraits::Result>(),
+               static_cast<std::tuple<>*>(nullptr), std::index_sequence<>());
+    }
+};
+
+#endif // c++14
+
+}  // namespace detail
+/// @endcond
+
+
+}  // namespace SQLite
@@ -0,0 +1,172 @@
+/**
+ * @file    Interrupt.h
+ * @ingroup SQLiteCpp
+ * @brief   Deadlines and cancellation of the queries of a Database Connection.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+
+namespace SQLite
+{
+
+
+// Forward declaration
+class Database;
+
+/**
+ * @brief Flag to cancel the queries of a QueryGuard, from any thread.
+ *
+ *  Copies share the same flag: keep one in the thread running the queries, and give one to the thread
+ * (or the server shedding load) that may cancel them. Once cancelled, a token stays cancelled.
+ */
+class CancellationToken
+{
+public:
+    /// Create a token not cancelled yet
+    CancellationToken();
+
+    /// Cancel the queries guarded by this token or one of its copies, from any thread.
+    void cancel() noexcept // nothrow
+    {
+        mpCancelled->store(true, std::memory_order_relaxed);
+    }
+
+    /// Return true once the token has been cancelled.
+    bool isCancelled() const noexcept // nothrow
+    {
+        return mpCancelled->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool> > mpCancelled; ///< Flag shared by the copies of the token
+};
+
+
+/**
+ * @brief RAII guard interrupting the queries of a Database Connection after a deadline, or on a cancellation.
+ *
+ *  While the guard is alive, SQLite calls it back every aNbSteps instructions of its virtual machine
+ * (with sqlite3_progress_handler()), so that a statement running past the deadline or after a cancellation
+ * of the token is stopped within a few microseconds, and fails with a SQLite::InterruptedException:
+ *
+ * @code
+ * SQLite::QueryGuard guard(db, std::chrono::milliseconds(200), token);
+ * SQLite::Statement query(db, "SELECT ...");
+ * while (query.executeStep()) // throws SQLite::InterruptedException after 200ms or on token.cancel()
+ * {
+ *     ...
+ * }
+ * @endcode
+ *
+ *  The deadline covers everything done on the connection in the scope of the guard, including the preparation
+ * of statements. A connection has only one progress handler: guards must not be nested nor overlap
+ * on the same connection, and the last one destroyed removes the handler. Use Database::interrupt()
+ * to stop a query of a connection without guard.
+ */
+class QueryGuard
+{
+public:
+    /// Default number of virtual machine instructions between two checks of the deadline and the token
+    static const int DEFAULT_STEPS = 1000;
+
+    /**
+     * @brief Interrupt the queries of the connection running longer than a timeout from now.
+     *
+     * @param[in] aDatabase Connection of the queries
+     * @param[in] aTimeout  Time left to the queries of the scope
+     * @param[in] aNbSteps  Number of virtual machine instructions between two checks (lower to react faster)
+     */
+    QueryGuard(Database& aDatabase, const std::chrono::steady_clock::duration aTimeout,
+               const int aNbSteps = DEFAULT_STEPS);
+
+    /**
+     * @brief Interrupt the queries of the connection running past a deadline.
+     *
+     * @param[in] aDatabase Connection of the queries
+     * @param[in] aDeadline Time at which the queries of the scope are interrupted
+     * @param[in] aNbSteps  Number of virtual machine instructions between two checks (lower to react faster)
+     */
+    QueryGuard(Database& aDatabase, const std::chrono::steady_clock::time_point aDeadline,
+               const int aNbSteps = DEFAULT_STEPS);
+
+    /**
+     * @brief Interrupt the queries of the connection when a token is cancelled.
+     *
+     * @param[in] aDatabase Connection of the queries
+     * @param[in] aToken    Token cancelling the queries of the scope, from any thread
+     * @param[in] aNbSteps  Number of virtual machine instructions between two checks (lower to react faster)
+     */
+    QueryGuard(Database& aDatabase, const CancellationToken& aToken, const int aNbSteps = DEFAULT_STEPS);
+
+    /**
+     * @brief Interrupt the queries of the connection running longer than a timeout, or when a token is cancelled.
+     *
+     * @param[in] aDatabase Connection of the queries
+     * @param[in] aTimeout  Time left to the queries of the scope
+     * @param[in] aToken    Token cancelling the queries of the scope, from any thread
+     * @param[in] aNbSteps  Number of virtual machine instructions between two checks (lower to react faster)
+     */
+    QueryGuard(Database& aDatabase, const std::chrono::steady_clock::duration aTimeout,
+               const CancellationToken& aToken, const int aNbSteps = DEFAULT_STEPS);
+
+    /**
+     * @brief Interrupt the queries of the connection running past a deadline, or when a token is cancelled.
+     *
+     * @param[in] aDatabase Connection of the queries
+     * @param[in] aDeadline Time at which the queries of the scope are interrupted
+     * @param[in] aToken    Token cancelling the queries of the scope, from any thread
+     * @param[in] aNbSteps  Number of virtual machine instructions between two checks (lower to react faster)
+     */
+    QueryGuard(Database& aDatabase, const std::chrono::steady_clock::time_point aDeadline,
+               const CancellationToken& aToken, const int aNbSteps = DEFAULT_STEPS);
+
+    /// Remove the progress handler of the connection.
+    ~QueryGuard();
+
+    /// Return the time at which the queries of the scope are interrupted (time_point::max() without deadline).
+    std::chrono::steady_clock::time_point getDeadline() const noexcept // nothrow
+    {
+        return mDeadline;
+    }
+
+    /// Return true once the deadline is past, to tell a timeout from a cancellation.
+    bool isExpired() const noexcept // nothrow
+    {
+        return std::chrono::steady_clock::now() >= mDeadline;
+    }
+
+    /// Return true once the token has been cancelled.
+    bool isCancelled() const noexcept // nothrow
+    {
+        return mToken.isCancelled();
+    }
+
+private:
+    /// @{ QueryGuard must be non-copyable
+    QueryGuard(const QueryGuard&);
+    QueryGuard& operator=(const QueryGuard&);
+    /// @}
+
+    /// Install the progress handler of the connection
+    void install(const int aNbSteps);
+
+    /// Callback registered with sqlite3_progress_handler(), returning non-zero to interrupt the query.
+    static int onProgress(void* apGuard) noexcept; // nothrow
+
+private:
+    Database&                               mDatabase;  ///< Connection of the guarded queries
+    std::chrono::steady_clock::time_point   mDeadline;  ///< Time at which queries are interrupted
+    CancellationToken                       mToken;     ///< Token cancelling the queries
+};
+
+
+}  // namespace SQLite
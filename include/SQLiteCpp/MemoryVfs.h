@@ -0,0 +1,53 @@
+/**
+ * @file    MemoryVfs.h
+ * @ingroup SQLiteCpp
+ * @brief   In-process memory VFS, sharing named in-memory databases between the connections of a process.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <string>
+
+
+namespace SQLite
+{
+
+
+/// Name of the memory VFS, to give as the apVfs parameter of the Database constructor
+extern const char* const MEMORY_VFS_NAME;
+
+/**
+ * @brief Register the memory VFS with SQLite, under the name MEMORY_VFS_NAME.
+ *
+ *  Files of the memory VFS live in the memory of the process, in chunks of 64KB, and are shared by name:
+ * all the connections opening "cache.db" with this VFS see the same database, with the usual locking
+ * of SQLite between them. Shared memory is also provided, so that a database in WAL mode lets readers
+ * run concurrently with a writer, unlike ":memory:" databases in shared-cache mode and their table-level locks.
+ *
+ *  A database stays in memory after its last connection is closed, until deleted by deleteMemoryFile().
+ * Journals and WAL files are deleted by SQLite as usual. Registering again has no effect.
+ *
+ * @param[in] abMakeDefault Also make it the default VFS of SQLite
+ *
+ * @throw SQLite::Exception in case of error
+ */
+void registerMemoryVfs(const bool abMakeDefault = false);
+
+/**
+ * @brief Delete a file of the memory VFS, freeing its memory once no connection uses it anymore.
+ *
+ * @param[in] aName Name of the file, as given to the Database constructor
+ *
+ * @return true if the file existed
+ */
+bool deleteMemoryFile(const std::string& aName);
+
+/// Return true if a file of the memory VFS exists.
+bool memoryFileExists(const std::string& aName);
+
+
+}  // namespace SQLite
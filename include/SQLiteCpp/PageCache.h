@@ -0,0 +1,82 @@
+/**
+ * @file    PageCache.h
+ * @ingroup SQLiteCpp
+ * @brief   Pluggable page cache for SQLite, sharing a global memory budget between all connections.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace SQLite
+{
+
+
+/// Page caches that can be installed for all SQLite connections by configurePageCache()
+enum class PageCache
+{
+    Default,    ///< The page cache SQLite was using before the first call to configurePageCache()
+    Sharded     ///< Sharded, lock-striped page cache with a global memory budget and CLOCK eviction
+};
+
+/// Default memory budget of the Sharded page cache, in bytes
+const size_t DEFAULT_PAGE_CACHE_BUDGET = 64 * 1024 * 1024;
+
+/**
+ * @brief Statistics of the Sharded page cache, summed over all connections.
+ */
+struct PageCacheStats
+{
+    uint64_t    hits;       ///< Pages found in the cache
+    uint64_t    misses;     ///< Pages not found in the cache (then read from the database file)
+    uint64_t    evictions;  ///< Unpinned pages discarded to stay within the memory budget
+    uint64_t    pages;      ///< Pages currently in the cache
+    uint64_t    bytes;      ///< Memory currently used by the pages of the purgeable caches, in bytes
+    uint64_t    budget;     ///< Memory budget for the pages of the purgeable caches, in bytes
+    uint64_t    caches;     ///< Number of caches currently open (one per database file of each connection)
+
+    /// Return the ratio of hits over lookups (0.0 if there was none)
+    double getHitRatio() const noexcept // nothrow
+    {
+        const uint64_t lookups = hits + misses;
+        return (lookups > 0) ? static_cast<double>(hits) / lookups : 0.0;
+    }
+};
+
+/**
+ * @brief Install the page cache used by all SQLite connections, with SQLITE_CONFIG_PCACHE2.
+ *
+ *  The Sharded page cache keeps the pages of all connections in a fixed number of shards, each protected
+ * by its own mutex, and evicts unpinned pages with the CLOCK algorithm once the memory used by all
+ * the purgeable caches (those of database files, not of in-memory databases) exceeds a global budget.
+ * Hot pages of all connections thus compete for the same memory, that stays flat as connections are added;
+ * the cache_size of each connection is not used anymore. Pages are still private to their connection,
+ * since SQLite gives each one its own copy of the content of a database file.
+ *
+ *  This must be called before SQLite is initialized, that is before opening the first Database,
+ * or after sqlite3_shutdown() once all the connections are closed.
+ *
+ * @param[in] aPageCache    Page cache to install
+ * @param[in] aBudgetBytes  Memory budget of the Sharded page cache, in bytes
+ *
+ * @throw SQLite::Exception if SQLite is already initialized (SQLITE_MISUSE)
+ */
+void configurePageCache(const PageCache aPageCache, const size_t aBudgetBytes = DEFAULT_PAGE_CACHE_BUDGET);
+
+/// Change the memory budget of the Sharded page cache, taking effect as new pages are loaded.
+void setPageCacheBudget(const size_t aBudgetBytes) noexcept; // nothrow
+
+/// Return the statistics of the Sharded page cache (all zeros if it was never installed).
+PageCacheStats getPageCacheStats() noexcept; // nothrow
+
+/// Reset the hits, misses and evictions counters of the Sharded page cache.
+void resetPageCacheStats() noexcept; // nothrow
+
+
+}  // namespace SQLite
@@ -0,0 +1,159 @@
+/**
+ * @file    ParallelScan.h
+ * @ingroup SQLiteCpp
+ * @brief   Scan of a table split into rowid ranges, read concurrently by several connections.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace SQLite
+{
+
+
+// Forward declaration
+class Snapshot;
+
+/// A range of rowids of a table, bounds included.
+struct RowidRange
+{
+    long long   first;  ///< First rowid of the range
+    long long   last;   ///< Last rowid of the range
+};
+
+/**
+ * @brief Scan of a table split into rowid ranges, each one read by its own connection on its own thread.
+ *
+ *  The range between min(rowid) and max(rowid) of the table is split into partitions of the same width,
+ * read concurrently by as many read-only connections. The query of the scan reads one partition, with its
+ * first and last rowids bound to the parameters ?1 and ?2, for instance:
+ * @code
+ * SQLite::ParallelScan scan("data.db3", "measure", 4);
+ * const double total = scan.reduce("SELECT value FROM measure WHERE rowid BETWEEN ?1 AND ?2", 0.0,
+ *     [](double& aSum, SQLite::Statement& aQuery) { aSum += aQuery.getColumn(0).getDouble(); },
+ *     std::plus<double>());
+ * @endcode
+ *
+ *  Each partition is read in a transaction of its own, so the partitions can see different versions of the
+ * database if it is written meanwhile, unless they all open the same Snapshot of a database in WAL mode
+ * (see setSnapshot(), which requires SQLITE_ENABLE_SNAPSHOT). Rowids shall be spread evenly for the partitions
+ * to be balanced: the partitions of a table with large gaps in its rowids read different numbers of rows.
+ */
+class ParallelScan
+{
+public:
+    /**
+     * @brief Open the read-only connections of the partitions.
+     *
+     * @param[in] aFilename     UTF-8 path/uri to the database file
+     * @param[in] aTable        Name of the table (or of a view with a rowid) to split into rowid ranges
+     * @param[in] aPartitions   Number of partitions and of connections, or 0 for the number of hardware threads
+     * @param[in] aFlags        Flags added to SQLite::OPEN_READONLY|SQLite::OPEN_NOMUTEX (SQLite::OPEN_URI...)
+     * @param[in] aVfs          UTF-8 name of the VFS to use, or "" for the default one
+     *
+     * @throw SQLite::Exception in case of error opening the database
+     */
+    ParallelScan(const std::string& aFilename,
+                 const std::string& aTable,
+                 const size_t       aPartitions = 0,
+                 const int          aFlags = 0,
+                 const std::string& aVfs = "");
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    /**
+     * @brief Read all the partitions at the given Snapshot of a database in WAL mode, or at the latest version.
+     *
+     * @param[in] apSnapshot    Snapshot opened by each partition (kept by the caller), or nullptr
+     */
+    void setSnapshot(const Snapshot* apSnapshot) noexcept // nothrow
+    {
+        mpSnapshot = apSnapshot;
+    }
+#endif // SQLITE_ENABLE_SNAPSHOT
+
+    /// Return the number of partitions, the most rowid ranges of a scan.
+    size_t getPartitionCount() const noexcept // nothrow
+    {
+        return mReaders.size();
+    }
+
+    /**
+     * @brief Split the rowids of the table into ranges of the same width, one for each partition at most.
+     *
+     * @return the ranges, in increasing order of rowids, or none for an empty table
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    std::vector<RowidRange> getRanges();
+
+    /**
+     * @brief Call a function with each row of the query run on each partition, concurrently.
+     *
+     *  All the partitions complete before the first exception thrown by one of them, if any, is thrown again.
+     * If a thread cannot be started, the partitions already started complete, then the std::system_error is thrown.
+     *
+     * @param[in] aQuery    UTF-8 SQL query reading the rowids between ?1 and ?2
+     * @param[in] aFunction Function called with the Statement on each row and the index of its partition,
+     *                      concurrently for different partitions
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    void forEachRow(const std::string& aQuery, const std::function<void(Statement&, size_t)>& aFunction);
+
+    /**
+     * @brief Fold the rows of each partition into a partial result, then combine the partial results.
+     *
+     * @param[in] aQuery        UTF-8 SQL query reading the rowids between ?1 and ?2
+     * @param[in] aInit         Initial value of the partial result of each partition, and of the final result
+     * @param[in] aAccumulate   Function adding a row to a partial result: void(T&, Statement&), called concurrently
+     * @param[in] aCombine      Function combining two results: T(const T&, const T&), called by the calling thread
+     *
+     * @return aInit combined with the partial results, in the order of the partitions
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    template <typename T, typename Accumulate, typename Combine>
+    T reduce(const std::string& aQuery, const T& aInit, Accumulate aAccumulate, Combine aCombine)
+    {
+        std::vector<T> partials(mReaders.size(), aInit);
+        forEachRow(aQuery, [&partials, &aAccumulate](Statement& aStatement, size_t aPartition)
+        {
+            aAccumulate(partials[aPartition], aStatement);
+        });
+        T result = aInit;
+        for (const T& partial : partials)
+        {
+            result = aCombine(result, partial);
+        }
+        return result;
+    }
+
+private:
+    /// @{ ParallelScan must be non-copyable
+    ParallelScan(const ParallelScan&);
+    ParallelScan& operator=(const ParallelScan&);
+    /// @}
+
+    /// Start a read transaction on a connection, at the Snapshot if any
+    void beginRead(Database& aReader);
+
+private:
+    std::vector<Database>   mReaders;       ///< Read-only connection of each partition
+    std::string             mRangeQuery;    ///< Query of the min(rowid) and max(rowid) of the table
+    const Snapshot*         mpSnapshot;     ///< Snapshot read by all the partitions, or nullptr
+};
+
+
+}  // namespace SQLite
@@ -0,0 +1,204 @@
+/**
+ * @file    Profiler.h
+ * @ingroup SQLiteCpp
+ * @brief   Statement level profiling of a Database Connection, aggregated in latency histograms.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Forward declarations to avoid inclusion of <sqlite3.h> in a header
+struct sqlite3;
+struct sqlite3_stmt;
+
+
+namespace SQLite
+{
+
+
+/**
+ * @brief HDR-style histogram of latencies, in nanoseconds.
+ *
+ *  Values are recorded in power-of-two buckets, each split in 16 linear sub-buckets,
+ * giving a relative precision better than 6.25% over the whole range (from 1ns up to about 39 hours).
+ * Recording is a few relaxed atomic operations, without any lock nor allocation,
+ * so any thread can read or reset the histogram while another one records values.
+ */
+class LatencyHistogram
+{
+public:
+    /// Number of bits of linear sub-buckets in each power of two bucket
+    static const int SUB_BUCKET_BITS = 4;
+    /// Number of linear sub-buckets in each power of two bucket
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    /// Highest recordable power of two, larger values are clamped
+    static const int MAX_VALUE_BITS = 47;
+    /// Total number of buckets
+    static const int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    /// Create an empty histogram
+    LatencyHistogram() noexcept;
+
+    /// Copy a snapshot of the histogram
+    LatencyHistogram(const LatencyHistogram& aOther) noexcept;
+    LatencyHistogram& operator=(const LatencyHistogram& aOther) noexcept;
+
+    /// Record a value, in nanoseconds.
+    void record(const uint64_t aValueNs) noexcept; // nothrow
+
+    /// Add all the values recorded in another histogram.
+    void merge(const LatencyHistogram& aOther) noexcept; // nothrow
+
+    /// Forget all recorded values.
+    void reset() noexcept; // nothrow
+
+    /// Number of recorded values
+    uint64_t getCount() const noexcept; // nothrow
+    /// Sum of all recorded values, in nanoseconds
+    uint64_t getTotal() const noexcept; // nothrow
+    /// Largest recorded value, in nanoseconds
+    uint64_t getMax() const noexcept; // nothrow
+
+    /**
+     * @brief Return the value at a given percentile (0.0 to 100.0) of the recorded values, in nanoseconds.
+     *
+     *  The result is the upper bound of the sub-bucket containing the percentile (never above getMax()),
+     * or 0 if nothing was recorded.
+     */
+    uint64_t getPercentile(const double aPercentile) const noexcept; // nothrow
+
+private:
+    /// Index of the sub-bucket a value is recorded in.
+    static int getBucketIndex(uint64_t aValueNs) noexcept; // nothrow
+    /// Highest value recorded in a sub-bucket.
+    static uint64_t getBucketUpperBound(const int aIndex) noexcept; // nothrow
+
+private:
+    std::atomic<uint64_t>   mBuckets[BUCKET_COUNT]; ///< Number of values recorded in each sub-bucket
+    std::atomic<uint64_t>   mCount;                 ///< Number of recorded values
+    std::atomic<uint64_t>   mTotal;                 ///< Sum of the recorded values
+    std::atomic<uint64_t>   mMax;                   ///< Largest recorded value
+};
+
+
+/**
+ * @brief Statistics of all executions of one SQL statement, as returned by Database::getProfile().
+ *
+ *  Statements are identified by their SQL text before parameter expansion (their "fingerprint"),
+ * so that all executions of a query with different bound values are aggregated together.
+ */
+struct StatementProfile
+{
+    std::string         sql;            ///< SQL text of the statement, with its parameters unexpanded
+    uint64_t            count;          ///< Number of executions
+    uint64_t            totalNs;        ///< Total time spent executing the statement
+    uint64_t            p50Ns;          ///< Median execution time
+    uint64_t            p99Ns;          ///< 99th percentile execution time
+    uint64_t            maxNs;          ///< Slowest execution time
+    uint64_t            rows;           ///< Total number of rows returned
+    uint64_t            slowestNs;      ///< Time of the slowest execution above the threshold (0 if none)
+    std::string         slowestSql;     ///< SQL text of this slowest execution, with its bound values expanded
+    LatencyHistogram    histogram;      ///< Full distribution of the execution times
+};
+
+
+/**
+ * @brief Aggregate the execution times of the statements of a Database Connection.
+ *
+ *  Registered with sqlite3_trace_v2() by Database::enableProfiling(), it receives an event each time a statement
+ * starts (SQLITE_TRACE_STMT), returns a row (SQLITE_TRACE_ROW) and finishes (SQLITE_TRACE_PROFILE).
+ * Execution times are measured with std::chrono::steady_clock between the start and the end events,
+ * since the time reported by SQLite has only the resolution of the VFS clock (a millisecond for the unix VFS).
+ * Statistics are kept in a fixed size open addressing table of entries which are never moved nor freed
+ * until the Profiler is destroyed, so recording is lock-free, and reading or resetting them from an other thread
+ * (to scrape them periodically) is safe.
+ *
+ * This is a internal class, not part of the API: use Database::enableProfiling() and Database::getProfile().
+ */
+class Profiler
+{
+public:
+    /**
+     * @brief Prepare an empty table of statistics.
+     *
+     * @param[in] aSlowThresholdNs  Executions at least this slow have their expanded SQL recorded (0 to disable)
+     * @param[in] aMaxStatements    Number of distinct statements tracked; further ones are aggregated as "<other>"
+     */
+    Profiler(const uint64_t aSlowThresholdNs, const size_t aMaxStatements);
+    ~Profiler();
+
+    /// Set the execution time above which the expanded SQL of a statement is recorded (0 to disable).
+    inline void setSlowThreshold(const uint64_t aSlowThresholdNs) noexcept // nothrow
+    {
+        mSlowThresholdNs.store(aSlowThresholdNs, std::memory_order_relaxed);
+    }
+
+    /// Return a copy of the statistics of all statements executed so far, optionally resetting them.
+    std::vector<StatementProfile> getProfile(const bool abReset);
+
+    /// Forget all statistics.
+    void reset() noexcept; // nothrow
+
+    /// Callback registered with sqlite3_trace_v2().
+    static int trace(unsigned aType, void* apProfiler, void* apStmt, void* apData);
+
+private:
+    /// @{ Profiler must be non-copyable
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+    /// @}
+
+    /// Statistics of one statement fingerprint
+    struct Entry
+    {
+        Entry(const uint64_t aHash, const char* apSql);
+
+        const uint64_t          hash;           ///< FNV-1a hash of the SQL text
+        const std::string       sql;            ///< SQL text with its parameters unexpanded
+        LatencyHistogram        histogram;      ///< Execution times
+        std::atomic<uint64_t>   rows;           ///< Rows returned
+        std::mutex              slowestMutex;   ///< Protect the slowest execution, updated only for outliers
+        uint64_t                slowestNs;      ///< Time of the slowest execution above the threshold
+        std::string             slowestSql;     ///< Expanded SQL of this slowest execution
+    };
+
+    /// Start time and rows returned so far by a statement that has not finished yet
+    struct Running
+    {
+        sqlite3_stmt*   pStmt;      ///< Statement currently running
+        uint64_t        startNs;    ///< Time it started running (steady_clock)
+        uint64_t        rows;       ///< Rows returned so far
+    };
+
+    /// Find or create the entry of the given statement
+    Entry& getEntry(sqlite3_stmt* apStmt);
+    /// Find the slot of a running statement, or nullptr
+    Running* getRunning(sqlite3_stmt* apStmt) noexcept;
+    /// Record the start of an execution of a statement
+    void onStmt(sqlite3_stmt* apStmt) noexcept;
+    /// Record a row returned by a statement
+    void onRow(sqlite3_stmt* apStmt) noexcept;
+    /// Record the end of an execution of a statement
+    void onProfile(sqlite3_stmt* apStmt, uint64_t aElapsedNs);
+
+private:
+    static const size_t         RUNNING_COUNT = 8;  ///< Number of interleaved statements timed by the Profiler
+
+    std::atomic<uint64_t>       mSlowThresholdNs;   ///< Executions at least this slow record their expanded SQL
+    std::vector<std::atomic<Entry*> > mEntries;     ///< Open addressing table of statements, inserted with CAS
+    Entry                       mOverflow;          ///< Statistics of statements not fitting in the table
+    Running                     mRunning[RUNNING_COUNT];    ///< Statements currently running
+    size_t                      mNextRunning;               ///< Next slot to reuse when all of them are taken
+};
+
+
+}  // namespace SQLite
@@ -0,0 +1,137 @@
+/**
+ * @file    QueryPlan.h
+ * @ingroup SQLiteCpp
+ * @brief   Query plan of a Statement, as a tree of steps, and baselines of plans to catch index regressions.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace SQLite
+{
+
+
+// Forward declaration
+class Database;
+
+/**
+ * @brief One step of a query plan, that is one row of "EXPLAIN QUERY PLAN".
+ */
+struct QueryPlanStep
+{
+    int                         id;         ///< Id of the step (its row number with SQLite before 3.24.0)
+    int                         parent;     ///< Id of the parent step, 0 for the top level steps
+    std::string                 detail;     ///< Description of the step, like "SEARCH t USING INDEX idx (a=?)"
+    std::vector<QueryPlanStep>  children;   ///< Sub-steps, in the order given by SQLite
+
+    /// Return the detail with "SCAN TABLE t" and "SEARCH TABLE t" of SQLite before 3.36.0 written "SCAN t"/"SEARCH t"
+    std::string getNormalizedDetail() const;
+
+    /// true if the step reads a whole table or index ("SCAN t", but not "SCAN CONSTANT ROW")
+    bool isFullScan() const;
+
+    /// true if the step sorts or deduplicates rows in a temporary b-tree ("USE TEMP B-TREE FOR ORDER BY")
+    bool usesTempBTree() const;
+};
+
+/**
+ * @brief Query plan of a Statement, as returned by Statement::explainQueryPlan().
+ *
+ *  Since SQLite 3.24.0 the steps form a tree (subqueries, compound selects...);
+ * with older versions the steps are all at the top level.
+ */
+struct QueryPlan
+{
+    std::vector<QueryPlanStep>  steps;      ///< Top level steps
+
+    /// Return the plan as text, one step detail per line, indented by two spaces for each level of the tree.
+    std::string toString() const;
+
+    /**
+     * @brief Return the full scans and temporary b-trees of the plan, in the order of the plan.
+     *
+     *  A full scan is identified by its table only ("SCAN t"), whether it reads the table or one of its indexes,
+     * and a temporary b-tree by its detail ("USE TEMP B-TREE FOR ORDER BY").
+     */
+    std::vector<std::string> getCostlySteps() const;
+};
+
+
+/**
+ * @brief Baselines of the query plans of a set of queries, stored as text files, to catch index regressions in tests.
+ *
+ *  Each registered query has its plan stored in a file "<name>.plan" of the baseline directory, written by update().
+ * check() then reports any full scan or temporary b-tree in the current plan of a query that its baseline
+ * does not contain, as happens when an index is dropped or a schema change makes a query stop using it.
+ * Other changes of the plans are not reported, and a query without a baseline file has an empty baseline.
+ *
+ * @code
+ * SQLite::QueryPlanBaseline baseline("tests/plans");
+ * baseline.add("user_by_email", "SELECT * FROM user WHERE email = ?");
+ * EXPECT_TRUE(baseline.check(db).empty());
+ * @endcode
+ */
+class QueryPlanBaseline
+{
+public:
+    /// Costly step of the current plan of a query not found in its baseline
+    struct Regression
+    {
+        std::string name;       ///< Name of the query
+        std::string step;       ///< Full scan or temporary b-tree step, see QueryPlan::getCostlySteps()
+        std::string plan;       ///< Current plan of the query, see QueryPlan::toString()
+    };
+
+    /**
+     * @brief Create an empty set of queries, with baselines in the given directory.
+     *
+     * @param[in] aDirectory    Existing directory of the "<name>.plan" baseline files
+     */
+    explicit QueryPlanBaseline(const std::string& aDirectory);
+
+    /**
+     * @brief Register a query to check.
+     *
+     * @param[in] aName     Name of the query, used as the base name of its baseline file
+     * @param[in] aQuery    UTF-8 SQL query, with parameters left unbound
+     */
+    void add(const std::string& aName, const std::string& aQuery);
+
+    /**
+     * @brief Compare the current plans of the queries against their baselines.
+     *
+     * @param[in] aDatabase Connection to the database with the schema to check
+     *
+     * @return The full scans and temporary b-trees not found in the baselines (empty if no regression)
+     *
+     * @throw SQLite::Exception in case of error (query failing to compile, unreadable baseline file)
+     */
+    std::vector<Regression> check(Database& aDatabase) const;
+
+    /**
+     * @brief Write the current plans of all the queries as their new baselines.
+     *
+     * @param[in] aDatabase Connection to the database with the schema of reference
+     *
+     * @throw SQLite::Exception in case of error (query failing to compile, baseline file not writable)
+     */
+    void update(Database& aDatabase) const;
+
+    /// Return the path of the baseline file of a query.
+    std::string getFilename(const std::string& aName) const;
+
+private:
+    std::string                                         mDirectory; ///< Directory of the baseline files
+    std::vector<std::pair<std::string, std::string>>    mQueries;   ///< Name and SQL of the registered queries
+};
+
+
+}  // namespace SQLite
@@ -20,14 +20,30 @@
 #pragma once
 
 // Include useful headers of SQLiteC++
+#include <SQLiteCpp/Allocator.h>
 #include <SQLiteCpp/Assertion.h>
+#include <SQLiteCpp/BulkImporter.h>
+#include <SQLiteCpp/Collation.h>
 #include <SQLiteCpp/Column.h>
 #include <SQLiteCpp/Database.h>
 #include <SQLiteCpp/Errors.h>
 #include <SQLiteCpp/Exception.h>
 #include <SQLiteCpp/ExceptionsMapper.h>
+#include <SQLiteCpp/Function.h>
+#include <SQLiteCpp/Interrupt.h>
+#include <SQLiteCpp/MemoryVfs.h>
+#include <SQLiteCpp/PageCache.h>
+#include <SQLiteCpp/ParallelScan.h>
+#include <SQLiteCpp/Profiler.h>
+#include <SQLiteCpp/QueryPlan.h>
+#include <SQLiteCpp/Schema.h>
+#include <SQLiteCpp/ShardedDatabase.h>
+#include <SQLiteCpp/Snapshot.h>
 #include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/TableFunction.h>
+#include <SQLiteCpp/Threading.h>
 #include <SQLiteCpp/Transaction.h>
+#include <SQLiteCpp/VirtualTable.h>
 
 /**
  * @brief Version numbers for SQLiteC++ are provided in the same way as
@@ -0,0 +1,138 @@
+/**
+ * @file    Schema.h
+ * @ingroup SQLiteCpp
+ * @brief   Catalog of the tables, columns and indexes of a database, cached until its schema changes.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Forward declarations to avoid inclusion of <sqlite3.h> in a header
+struct sqlite3;
+struct sqlite3_stmt;
+
+
+namespace SQLite
+{
+
+
+/// A column of a table or of a view, from "PRAGMA table_info".
+struct SchemaColumn
+{
+    std::string name;           ///< Name of the column
+    std::string type;           ///< Declared type ("INTEGER", "VARCHAR(20)"...), or empty
+    bool        bNotNull;       ///< true for a NOT NULL column
+    bool        bHasDefault;    ///< true if the column has a DEFAULT value
+    std::string defaultValue;   ///< SQL text of the DEFAULT value
+    int         primaryKey;     ///< Position of the column in the primary key, from 1, or 0
+};
+
+/// An index of a table, from "PRAGMA index_list" and "PRAGMA index_info".
+struct SchemaIndex
+{
+    std::string                 name;       ///< Name of the index ("sqlite_autoindex_..." for constraints)
+    std::string                 table;      ///< Name of the indexed table
+    bool                        bUnique;    ///< true for a UNIQUE index
+    std::vector<std::string>    columns;    ///< Names of the indexed columns, an empty name for an expression
+};
+
+/// A table or a view of the catalog.
+struct SchemaTable
+{
+    std::string                 name;       ///< Name of the table
+    bool                        bView;      ///< true for a view
+    std::vector<SchemaColumn>   columns;    ///< Columns, in the order of their declaration
+    std::vector<std::string>    indexes;    ///< Names of the indexes of the table
+
+    /// Return the column of the given name (case sensitive), or nullptr.
+    const SchemaColumn* getColumn(const std::string& aName) const noexcept; // nothrow
+};
+
+
+/**
+ * @brief Catalog of the tables, views, columns and indexes of the main database of a connection.
+ *
+ *  The catalog is loaded on the first lookup, from sqlite_master and the table_info and index_list pragmas
+ * of each table, then kept until the schema changes: each lookup only compares "PRAGMA schema_version"
+ * (read by a statement prepared once) to the version of the catalog before probing a hash table,
+ * instead of preparing and running a query on sqlite_master. This detects the changes made by other
+ * connections as well, and those of a transaction not committed yet. As a rollback can bring back
+ * a previous version, a catalog loaded within a transaction is loaded again on each lookup.
+ *
+ *  Names are case sensitive, as stored in sqlite_master. Pointers returned by the lookups are valid
+ * until the next lookup following a change of the schema.
+ *
+ * This is a internal class, created by Database::getSchema().
+ */
+class Schema
+{
+public:
+    /**
+     * @brief Prepare the catalog of a connection, loaded on the first lookup.
+     *
+     * @param[in] apSQLite  The SQLite Database Connection
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    explicit Schema(sqlite3* apSQLite);
+
+    /// Finalize the statement reading the version of the schema.
+    ~Schema();
+
+    /**
+     * @brief Load the catalog again if the schema changed since it was loaded.
+     *
+     * @return true if the catalog was (re)loaded
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    bool refresh();
+
+    /// Return true if a table (not a view) of this name exists.
+    bool tableExists(const std::string& aName)
+    {
+        const SchemaTable* pTable = getTable(aName);
+        return (nullptr != pTable) && !pTable->bView;
+    }
+
+    /// Return the table or view of the given name, or nullptr.
+    const SchemaTable* getTable(const std::string& aName);
+
+    /// Return the index of the given name, or nullptr.
+    const SchemaIndex* getIndex(const std::string& aName);
+
+    /// Return the names of all the tables and views, sorted.
+    std::vector<std::string> getTableNames();
+
+    /// Return the "PRAGMA schema_version" of the catalog, or -1 before it is loaded or if loaded in a transaction.
+    int getVersion() const noexcept // nothrow
+    {
+        return mVersion;
+    }
+
+private:
+    /// @{ Schema must be non-copyable
+    Schema(const Schema&);
+    Schema& operator=(const Schema&);
+    /// @}
+
+    /// Load the tables with their columns, then the indexes
+    void load();
+
+private:
+    sqlite3*                                        mpSQLite;       ///< The SQLite Database Connection
+    sqlite3_stmt*                                   mpVersionStmt;  ///< "PRAGMA schema_version", prepared once
+    int                                             mVersion;       ///< Version of the loaded catalog, or -1
+    std::unordered_map<std::string, SchemaTable>    mTables;        ///< Tables and views by name
+    std::unordered_map<std::string, SchemaIndex>    mIndexes;       ///< Indexes by name
+};
+
+
+}  // namespace SQLite
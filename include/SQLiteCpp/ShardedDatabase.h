@@ -0,0 +1,278 @@
+/**
+ * @file    ShardedDatabase.h
+ * @ingroup SQLiteCpp
+ * @brief   Database split across several files, with keys placed by consistent hashing.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace SQLite
+{
+
+
+/**
+ * @brief Database split across several files (shards), each one with its own connection and its own write lock.
+ *
+ *  A key (the text or the integer identifying a row) is placed on a shard by consistent hashing: each shard owns
+ * DEFAULT_VIRTUAL_NODES points on a ring of 64 bits hashes, and a key goes to the shard of the first point following
+ * its hash. Points are derived from the index of the shard, not from its filename, so the shards can be moved,
+ * and adding a shard at the end of the list only moves to it about 1/N of the keys, without moving any other one.
+ *
+ *  Keyed operations run on the connection of their shard with withShard(), serialized by a mutex per shard:
+ * writers of different shards run in parallel, as do the per-shard jobs of forEachShard() (one thread per shard).
+ * The scatter-gather queries queryAll(), queryMerged() and queryAggregate() run the same query on every shard
+ * concurrently, then concatenate, merge in order or combine the results.
+ *
+ *  A transaction, a unique constraint or a join only spans a single shard: rows to be used together shall share
+ * the same key. Each connection is used by one thread at a time, so the shards can be opened with OPEN_NOMUTEX.
+ */
+class ShardedDatabase
+{
+public:
+    /// Default number of points of each shard on the hash ring
+    static const int DEFAULT_VIRTUAL_NODES = 64;
+
+    /**
+     * @brief Open the database file of each shard.
+     *
+     * @param[in] aFilenames        UTF-8 path/uri to the database file of each shard, in a fixed order
+     * @param[in] aFlags            SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE by default, see Database
+     * @param[in] aBusyTimeoutMs    Amount of milliseconds to wait before returning SQLITE_BUSY (see setBusyTimeout())
+     * @param[in] aVirtualNodes     Number of points of each shard on the hash ring (more spread the keys more evenly)
+     *
+     * @throw SQLite::Exception in case of error opening a file, or without any shard
+     */
+    explicit ShardedDatabase(const std::vector<std::string>& aFilenames,
+                             const int aFlags = SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE,
+                             const int aBusyTimeoutMs = 0,
+                             const int aVirtualNodes = DEFAULT_VIRTUAL_NODES);
+
+    /// Return the number of shards.
+    size_t getShardCount() const noexcept // nothrow
+    {
+        return mShards.size();
+    }
+
+    /// Return the index of the shard of a text key.
+    size_t getShardIndex(const std::string& aKey) const noexcept; // nothrow
+
+    /// Return the index of the shard of an integer key.
+    size_t getShardIndex(const long long aKey) const noexcept; // nothrow
+
+    /**
+     * @brief Return the connection of a shard, for a single threaded use (setup, migrations...).
+     *
+     *  The calling thread takes over the connection (see Database::acquireOwnership()),
+     * which may have been used last by a thread of withShard() or forEachShard().
+     *
+     * @warning unlike withShard() and forEachShard(), the use of the connection is not serialized
+     */
+    Database& getShard(const size_t aIndex)
+    {
+        Database& shard = mShards.at(aIndex);
+        std::lock_guard<std::mutex> lock(mMutexes[aIndex]);
+        shard.acquireOwnership();
+        return shard;
+    }
+
+    /**
+     * @brief Group the indexes of a batch of keys by shard, to write each group in a transaction of its shard.
+     *
+     * @return the indexes in aKeys of the keys of each shard, in the order of aKeys
+     */
+    template <typename Key>
+    std::vector<std::vector<size_t> > partition(const std::vector<Key>& aKeys) const
+    {
+        std::vector<std::vector<size_t> > groups(mShards.size());
+        for (size_t i = 0; i < aKeys.size(); ++i)
+        {
+            groups[getShardIndex(aKeys[i])].push_back(i);
+        }
+        return groups;
+    }
+
+    /**
+     * @brief Call a function with the connection of the shard of a key, while no other thread uses this shard.
+     *
+     * @param[in] aKey      Text or integer key
+     * @param[in] aFunction Function called with the Database of the shard, whose result is returned
+     */
+    template <typename Key, typename Function>
+    auto withShard(const Key& aKey, Function aFunction) -> decltype(aFunction(std::declval<Database&>()))
+    {
+        const size_t index = getShardIndex(aKey);
+        std::lock_guard<std::mutex> lock(mMutexes[index]);
+        mShards[index].acquireOwnership();
+        return aFunction(mShards[index]);
+    }
+
+    /**
+     * @brief Call a function with the connection of each shard, concurrently on one thread per shard.
+     *
+     *  Each call is serialized with the other users of its shard. All the calls complete before the first
+     * exception thrown by one of them, if any, is thrown again. If a thread cannot be started, the calls already
+     * started complete, then the std::system_error is thrown.
+     *
+     * @param[in] aFunction Function called with the Database of each shard and its index
+     */
+    void forEachShard(const std::function<void(Database&, size_t)>& aFunction);
+
+    /**
+     * @brief Run a query on every shard concurrently, and concatenate their rows in the order of the shards.
+     *
+     * @param[in] aQuery    UTF-8 SQL query run on each shard
+     * @param[in] aMapper   Function returning a Row from the current row of the Statement, called concurrently
+     */
+    template <typename Row, typename Mapper>
+    std::vector<Row> queryAll(const std::string& aQuery, Mapper aMapper)
+    {
+        std::vector<std::vector<Row> > parts = scatter<Row>(aQuery, aMapper);
+        size_t count = 0;
+        for (const std::vector<Row>& part : parts)
+        {
+            count += part.size();
+        }
+        std::vector<Row> rows;
+        rows.reserve(count);
+        for (std::vector<Row>& part : parts)
+        {
+            std::move(part.begin(), part.end(), std::back_inserter(rows));
+        }
+        return rows;
+    }
+
+    /**
+     * @brief Run an ordered query on every shard concurrently, and merge their sorted rows.
+     *
+     *  The query shall sort its rows ("ORDER BY") consistently with aLess, so that the rows of the shards are
+     * merged in a single pass. A "LIMIT n" applies to each shard: keep the first n rows of the result.
+     *
+     * @param[in] aQuery    UTF-8 SQL query run on each shard
+     * @param[in] aMapper   Function returning a Row from the current row of the Statement, called concurrently
+     * @param[in] aLess     Strict weak ordering of the rows, the one of the "ORDER BY" of the query
+     */
+    template <typename Row, typename Mapper, typename Less>
+    std::vector<Row> queryMerged(const std::string& aQuery, Mapper aMapper, Less aLess)
+    {
+        std::vector<std::vector<Row> > parts = scatter<Row>(aQuery, aMapper);
+        typedef std::pair<size_t, size_t> Cursor; // next row of each shard: (shard, row)
+        std::vector<Cursor> heap;
+        size_t count = 0;
+        for (size_t shard = 0; shard < parts.size(); ++shard)
+        {
+            count += parts[shard].size();
+            if (!parts[shard].empty())
+            {
+                heap.push_back(Cursor(shard, 0));
+            }
+        }
+        // a min-heap of the next rows, equal rows in the order of the shards
+        const auto greater = [&parts, &aLess](const Cursor& aLeft, const Cursor& aRight)
+        {
+            const Row& left = parts[aLeft.first][aLeft.second];
+            const Row& right = parts[aRight.first][aRight.second];
+            return aLess(right, left) || (!aLess(left, right) && (aRight.first < aLeft.first));
+        };
+        std::make_heap(heap.begin(), heap.end(), greater);
+        std::vector<Row> rows;
+        rows.reserve(count);
+        while (!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            Cursor& cursor = heap.back();
+            rows.push_back(std::move(parts[cursor.first][cursor.second]));
+            if (++cursor.second < parts[cursor.first].size())
+            {
+                std::push_heap(heap.begin(), heap.end(), greater);
+            }
+            else
+            {
+                heap.pop_back();
+            }
+        }
+        return rows;
+    }
+
+    /**
+     * @brief Run an aggregate query on every shard concurrently, and combine the partial results.
+     *
+     *  The rows of each shard are folded into aInit with aCombine, then the partial results of the shards:
+     * for instance "SELECT count(*)" or "SELECT sum(x)" with std::plus, "SELECT max(x)" with a max function.
+     * An average shall be computed from a sum and a count.
+     *
+     * @param[in] aQuery    UTF-8 SQL query run on each shard
+     * @param[in] aMapper   Function returning a T from the current row of the Statement, called concurrently
+     * @param[in] aInit     Identity value of the combination
+     * @param[in] aCombine  Associative function combining two T, called concurrently
+     */
+    template <typename T, typename Mapper, typename Combine>
+    T queryAggregate(const std::string& aQuery, Mapper aMapper, const T& aInit, Combine aCombine)
+    {
+        std::vector<T> partials(mShards.size(), aInit);
+        forEachShard([&](Database& aDatabase, size_t aIndex)
+        {
+            Statement query(aDatabase, aQuery);
+            while (query.executeStep())
+            {
+                partials[aIndex] = aCombine(partials[aIndex], aMapper(query));
+            }
+        });
+        T result = aInit;
+        for (const T& partial : partials)
+        {
+            result = aCombine(result, partial);
+        }
+        return result;
+    }
+
+private:
+    /// @{ ShardedDatabase must be non-copyable
+    ShardedDatabase(const ShardedDatabase&);
+    ShardedDatabase& operator=(const ShardedDatabase&);
+    /// @}
+
+    /// Return the index of the shard of the first point of the ring following a hash
+    size_t getShardOfHash(const uint64_t aHash) const noexcept; // nothrow
+
+    /// Run a query on every shard concurrently, and return the rows of each shard
+    template <typename Row, typename Mapper>
+    std::vector<std::vector<Row> > scatter(const std::string& aQuery, Mapper& aMapper)
+    {
+        std::vector<std::vector<Row> > parts(mShards.size());
+        forEachShard([&](Database& aDatabase, size_t aIndex)
+        {
+            Statement query(aDatabase, aQuery);
+            while (query.executeStep())
+            {
+                parts[aIndex].push_back(aMapper(query));
+            }
+        });
+        return parts;
+    }
+
+private:
+    std::vector<Database>                       mShards;    ///< Connection of each shard
+    std::vector<std::mutex>                     mMutexes;   ///< Serialize the use of the connection of each shard
+    std::vector<std::pair<uint64_t, size_t> >   mRing;      ///< Points of the shards on the ring, sorted by hash
+};
+
+
+}  // namespace SQLite
@@ -0,0 +1,115 @@
+/**
+ * @file    Snapshot.h
+ * @ingroup SQLiteCpp
+ * @brief   A Snapshot records the state of a WAL database to open read transactions on it from other connections.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+
+#include <SQLiteCpp/Database.h>
+
+#include <string>
+
+// Forward declaration to avoid inclusion of <sqlite3.h> in a header
+struct sqlite3_snapshot;
+
+namespace SQLite
+{
+
+/**
+ * @brief RAII encapsulation of a SQLite WAL Snapshot.
+ *
+ * A Snapshot records the state of a database in WAL mode, so that read transactions
+ * started later on other connections (to the same database file) can see exactly this version of the database,
+ * instead of the most recent one. This enables consistent parallel reads across a pool of connections.
+ *
+ * Usage:
+ * @code
+ * SQLite::Transaction transaction(writerOrReaderDb);   // a read transaction must be open on the source
+ * (void)writerOrReaderDb.execAndGet("SELECT count(*) FROM sqlite_master");
+ * SQLite::Snapshot snapshot(writerOrReaderDb);
+ *
+ * readerDb.exec("BEGIN");                              // on each reader: start a (deferred) transaction
+ * snapshot.open(readerDb);                             // before reading anything
+ * @endcode
+ *
+ *  Require definition of the SQLITE_ENABLE_SNAPSHOT preprocessor macro :
+ * - when building the SQLite library itself,
+ * - and also when compiling this wrapper.
+ *
+ * Thread-safety: a Snapshot object can be opened from multiple threads, each on its own Database connection,
+ * as long as the Snapshot itself is not destroyed meanwhile.
+ */
+class Snapshot
+{
+public:
+    /**
+     * @brief Record the current state of the given schema of the database connection.
+     *
+     *  The connection must be in WAL mode, and have an open read transaction
+     * (that is, a "BEGIN" followed by at least one read of the database).
+     *
+     * Exception is thrown in case of error, then the Snapshot object is NOT constructed.
+     *
+     * @param[in] aDatabase     Database connection with an open read transaction
+     * @param[in] apSchema      Name of the schema, "main" for the main database
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    explicit Snapshot(Database& aDatabase, const char* apSchema = "main");
+
+    /// Free the SQLite Snapshot object.
+    ~Snapshot();
+
+    /**
+     * @brief Start a read transaction on the given connection that sees the database as recorded by this Snapshot.
+     *
+     *  The connection must have started a transaction ("BEGIN") without having read anything yet.
+     * Fails with SQLITE_BUSY_SNAPSHOT if the snapshot has been checkpointed away meanwhile.
+     *
+     * @param[in] aDatabase     Database connection, in a transaction that has not read the database yet
+     * @param[in] apSchema      Name of the schema, "main" for the main database
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    void open(Database& aDatabase, const char* apSchema = "main") const;
+
+    /**
+     * @brief Compare the age of two snapshots of the same database file.
+     *
+     * @return negative if this snapshot is older than aOther, 0 if they are the same, positive if it is newer
+     */
+    int compare(const Snapshot& aOther) const noexcept; // nothrow
+
+    /// Return the schema name used to record this Snapshot.
+    inline const std::string& getSchema() const noexcept // nothrow
+    {
+        return mSchema;
+    }
+
+    /// Return raw pointer to SQLite Snapshot Object.
+    inline sqlite3_snapshot* getHandle() const noexcept // nothrow
+    {
+        return mpSnapshot;
+    }
+
+private:
+    /// @{ Snapshot must be non-copyable
+    Snapshot(const Snapshot&);
+    Snapshot& operator=(const Snapshot&);
+    /// @}
+
+private:
+    sqlite3_snapshot*   mpSnapshot; ///< Pointer to SQLite Snapshot Object
+    std::string         mSchema;    ///< Name of the schema the Snapshot was recorded on
+};
+
+}  // namespace SQLite
+
+#endif // SQLITE_ENABLE_SNAPSHOT
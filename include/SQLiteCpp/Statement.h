@@ -11,10 +11,12 @@
 #pragma once
 
 #include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/QueryPlan.h>
 
 #include <string>
 #include <map>
 #include <climits> // For INT_MAX
+#include <system_error>
 
 // Forward declarations to avoid inclusion of <sqlite3.h> in a header
 struct sqlite3;
@@ -28,9 +30,51 @@ namespace SQLite
 // Forward declaration
 class Database;
 class Column;
+class Statement;
 
 extern const int OK; ///< SQLITE_OK
 
+/**
+ * @brief Counters of the operations performed by the SQLite virtual machine for a Statement.
+ *
+ * @see Statement::getStatus()
+ */
+struct StatementStatus
+{
+    int fullscanSteps;  ///< SQLITE_STMTSTATUS_FULLSCAN_STEP: steps forward in a table as part of a full table scan
+    int sorts;          ///< SQLITE_STMTSTATUS_SORT: sort operations
+    int autoIndexes;    ///< SQLITE_STMTSTATUS_AUTOINDEX: rows inserted into transient automatic indices
+    int vmSteps;        ///< SQLITE_STMTSTATUS_VM_STEP: virtual machine operations
+    int memUsed;        ///< SQLITE_STMTSTATUS_MEMUSED: bytes of heap memory used by the prepared statement
+};
+
+/**
+ * @brief What to do when a Statement expected to use indexes performs a full scan or builds an automatic index.
+ *
+ * @see Statement::setFullScanPolicy()
+ */
+enum class FullScanPolicy
+{
+    Ignore, ///< No check (default)
+    Log,    ///< Report the Statement to the full scan handler (see setFullScanHandler()), then go on
+    Throw   ///< Throw a SQLite::Exception
+};
+
+/**
+ * @brief Handler called when a Statement with the FullScanPolicy::Log policy performs a full scan.
+ *
+ *  An exception thrown by the handler goes through Statement::executeStep() and Statement::exec(),
+ * while their variants setting an error code report it as Error::error.
+ */
+typedef void (*FullScanHandler)(const Statement& aStatement, const StatementStatus& aStatus);
+
+/**
+ * @brief Set the handler called when a Statement with the FullScanPolicy::Log policy performs a full scan.
+ *
+ * @param[in] apHandler Function to call, or nullptr to restore the default handler writing to std::cerr
+ */
+void setFullScanHandler(FullScanHandler apHandler) noexcept; // nothrow
+
 /**
  * @brief RAII encapsulation of a prepared SQLite Statement.
  *
@@ -73,6 +117,41 @@ public:
      */
     Statement(Database& aDatabase, const std::string& aQuery);
 
+    /**
+     * @brief Compile and register the SQL query, setting an error code instead of throwing an exception on error.
+     *
+     * @param[in]  aDatabase the SQLite Database Connection
+     * @param[in]  apQuery   an UTF-8 encoded query string
+     * @param[out] aError    the error of the compilation (see Errors.h), or an empty error code
+     *
+     *  On error, the Statement is constructed without a prepared statement:
+     * its executions, resets and bindings fail with SQLITE_MISUSE, so it is to be discarded.
+     *
+     * @throw std::bad_alloc only
+     */
+    Statement(Database& aDatabase, const char* apQuery, std::error_code& aError);
+
+    /**
+     * @brief Compile and register the SQL query, setting an error code instead of throwing an exception on error.
+     *
+     * @param[in]  aDatabase the SQLite Database Connection
+     * @param[in]  aQuery    an UTF-8 encoded query string
+     * @param[out] aError    the error of the compilation (see Errors.h), or an empty error code
+     *
+     * @throw std::bad_alloc only
+     */
+    Statement(Database& aDatabase, const std::string& aQuery, std::error_code& aError);
+
+    /**
+     * @brief Move the prepared statement, its bindings and its current row to a new Statement object.
+     *
+     *  The moved-from Statement has no prepared statement anymore: it can only be destroyed or assigned to.
+     */
+    Statement(Statement&& aStatement) noexcept; // nothrow
+
+    /// Finalize the prepared statement unless it is still used by a Column, then move the other one here.
+    Statement& operator=(Statement&& aStatement) noexcept; // nothrow
+
     /// Finalize and unregister the SQL query from the SQLite Database Connection.
     ~Statement();
 
@@ -82,6 +161,9 @@ public:
     /// Reset the statement. Returns the sqlite result code instead of throwing an exception on error.
     int tryReset() noexcept;
 
+    /// Reset the statement. Sets an error code (see Errors.h) instead of throwing an exception on error.
+    void reset(std::error_code& aError) noexcept;
+
     /**
      * @brief Clears away all the bindings of a prepared statement.
      *
@@ -90,6 +172,9 @@ public:
      */
     void clearBindings(); // throw(SQLite::Exception)
 
+    /// Clears away all the bindings. Sets an error code (see Errors.h) instead of throwing an exception on error.
+    void clearBindings(std::error_code& aError) noexcept;
+
     ////////////////////////////////////////////////////////////////////////////
     // Bind a value to a parameter of the SQL statement,
     // in the form "?" (unnamed), "?NNN", ":VVV", "@VVV" or "$VVV".
@@ -385,6 +470,89 @@ public:
         bind(aName.c_str());
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Non-throwing bind() and bindNoCopy(), setting a std::error_code (see Errors.h) instead of throwing
+    // a SQLite::Exception: SQLITE_RANGE for an unknown parameter, SQLITE_TOOBIG, SQLITE_NOMEM...
+    // The error code is cleared on success.
+
+    /// Bind an int value to a parameter (aIndex >= 1), setting an error code instead of throwing
+    void bind(const int aIndex, const int           aValue, std::error_code& aError) noexcept;
+    /// Bind a 32bits unsigned int value to a parameter (aIndex >= 1), setting an error code instead of throwing
+    void bind(const int aIndex, const unsigned      aValue, std::error_code& aError) noexcept;
+
+#if (LONG_MAX == INT_MAX) // sizeof(long)==4 means the data model of the system is ILP32 (32bits OS or Windows 64bits)
+    /// Bind a 32bits long value to a parameter (aIndex >= 1), setting an error code instead of throwing
+    void bind(const int aIndex, const long          aValue, std::error_code& aError) noexcept
+    {
+        bind(aIndex, static_cast<int>(aValue), aError);
+    }
+#else // sizeof(long)==8 means the data model of the system is LLP64 (64bits Linux)
+    /// Bind a 64bits long value to a parameter (aIndex >= 1), setting an error code instead of throwing
+    void bind(const int aIndex, const long          aValue, std::error_code& aError) noexcept
+    {
+        bind(aIndex, static_cast<long long>(aValue), aError);
+    }
+#endif
+
+    /// Bind a 64bits int value to a parameter (aIndex >= 1), setting an error code instead of throwing
+    void bind(const int aIndex, const long long     aValue, std::error_code& aError) noexcept;
+    /// Bind a double (64bits float) value to a parameter (aIndex >= 1), setting an error code instead of throwing
+    void bind(const int aIndex, const double        aValue, std::error_code& aError) noexcept;
+    /// Bind a string value to a parameter (aIndex >= 1), making a copy, setting an error code instead of throwing
+    void bind(const int aIndex, const std::string&  aValue, std::error_code& aError) noexcept;
+    /// Bind a text value to a parameter (aIndex >= 1), making a copy, setting an error code instead of throwing
+    void bind(const int aIndex, const char*         apValue, std::error_code& aError) noexcept;
+    /// Bind a binary blob value to a parameter (aIndex >= 1), making a copy, setting an error code instead of throwing
+    void bind(const int aIndex, const void*         apValue, const int aSize, std::error_code& aError) noexcept;
+    /// Bind a string value to a parameter (aIndex >= 1), without copy, setting an error code instead of throwing
+    void bindNoCopy(const int aIndex, const std::string&    aValue, std::error_code& aError) noexcept;
+    /// Bind a text value to a parameter (aIndex >= 1), without copy, setting an error code instead of throwing
+    void bindNoCopy(const int aIndex, const char*           apValue, std::error_code& aError) noexcept;
+    /// Bind a binary blob value to a parameter (aIndex >= 1), without copy, setting an error code instead of throwing
+    void bindNoCopy(const int aIndex, const void*           apValue, const int aSize,
+                    std::error_code& aError) noexcept;
+    /// Bind a NULL value to a parameter (aIndex >= 1), setting an error code instead of throwing
+    void bind(const int aIndex, std::error_code& aError) noexcept;
+
+    /// Bind an int value to a named parameter, setting an error code instead of throwing
+    void bind(const char* apName, const int             aValue, std::error_code& aError) noexcept;
+    /// Bind a 32bits unsigned int value to a named parameter, setting an error code instead of throwing
+    void bind(const char* apName, const unsigned        aValue, std::error_code& aError) noexcept;
+
+#if (LONG_MAX == INT_MAX) // sizeof(long)==4 means the data model of the system is ILP32 (32bits OS or Windows 64bits)
+    /// Bind a 32bits long value to a named parameter, setting an error code instead of throwing
+    void bind(const char* apName, const long            aValue, std::error_code& aError) noexcept
+    {
+        bind(apName, static_cast<int>(aValue), aError);
+    }
+#else // sizeof(long)==8 means the data model of the system is LLP64 (64bits Linux)
+    /// Bind a 64bits long value to a named parameter, setting an error code instead of throwing
+    void bind(const char* apName, const long            aValue, std::error_code& aError) noexcept
+    {
+        bind(apName, static_cast<long long>(aValue), aError);
+    }
+#endif
+
+    /// Bind a 64bits int value to a named parameter, setting an error code instead of throwing
+    void bind(const char* apName, const long long       aValue, std::error_code& aError) noexcept;
+    /// Bind a double (64bits float) value to a named parameter, setting an error code instead of throwing
+    void bind(const char* apName, const double          aValue, std::error_code& aError) noexcept;
+    /// Bind a string value to a named parameter, making a copy, setting an error code instead of throwing
+    void bind(const char* apName, const std::string&    aValue, std::error_code& aError) noexcept;
+    /// Bind a text value to a named parameter, making a copy, setting an error code instead of throwing
+    void bind(const char* apName, const char*           apValue, std::error_code& aError) noexcept;
+    /// Bind a binary blob value to a named parameter, making a copy, setting an error code instead of throwing
+    void bind(const char* apName, const void*           apValue, const int aSize, std::error_code& aError) noexcept;
+    /// Bind a string value to a named parameter, without copy, setting an error code instead of throwing
+    void bindNoCopy(const char* apName, const std::string&  aValue, std::error_code& aError) noexcept;
+    /// Bind a text value to a named parameter, without copy, setting an error code instead of throwing
+    void bindNoCopy(const char* apName, const char*         apValue, std::error_code& aError) noexcept;
+    /// Bind a binary blob value to a named parameter, without copy, setting an error code instead of throwing
+    void bindNoCopy(const char* apName, const void*         apValue, const int aSize,
+                    std::error_code& aError) noexcept;
+    /// Bind a NULL value to a named parameter, setting an error code instead of throwing
+    void bind(const char* apName, std::error_code& aError) noexcept;
+
     ////////////////////////////////////////////////////////////////////////////
 
     /**
@@ -419,6 +587,19 @@ public:
      */
     int tryExecuteStep() noexcept;
 
+    /**
+     * @brief Execute a step of the prepared query, setting an error code instead of throwing an exception on error.
+     *
+     *  Same as executeStep(), for the hot paths where errors like SQLITE_BUSY are expected and retried:
+     * no exception is thrown, and the error code is cleared on success. A full scan forbidden
+     * by FullScanPolicy::Throw is reported as Error::error, as is an exception of the full scan handler.
+     *
+     * @param[out] aError   the error of the execution (see Errors.h), or an empty error code
+     *
+     * @return true if there is another row ready, false if the query has finished executing or on error
+     */
+    bool executeStep(std::error_code& aError) noexcept;
+
     /**
      * @brief Execute a one-step query with no expected result.
      *
@@ -441,6 +622,18 @@ public:
      */
     int exec();
 
+    /**
+     * @brief Execute a one-step query with no expected result, setting an error code instead of throwing.
+     *
+     *  Same as exec(), without exception: rows of results are reported as Error::misuse, and a full scan
+     * forbidden by FullScanPolicy::Throw, or an exception of the full scan handler, as Error::error.
+     *
+     * @param[out] aError   the error of the execution (see Errors.h), or an empty error code
+     *
+     * @return number of row modified by this SQL statement (INSERT, UPDATE or DELETE), or 0 on error
+     */
+    int exec(std::error_code& aError) noexcept;
+
     ////////////////////////////////////////////////////////////////////////////
 
     /**
@@ -627,6 +820,44 @@ public:
     /// Return UTF-8 encoded English language explanation of the most recent failed API call (if any).
     const char* getErrorMsg() const noexcept; // nothrow
 
+    /**
+     * @brief Return the counters of the operations performed by the SQLite virtual machine for this Statement.
+     *
+     *  Counters accumulate over all executions of the Statement, unless reset.
+     * They are all zero for a Statement that failed to compile.
+     *
+     * @param[in] abReset   Reset the counters (but the memory used) after reading them
+     */
+    StatementStatus getStatus(const bool abReset = false) noexcept; // nothrow
+
+    /**
+     * @brief Flag this Statement as expected to use indexes only, and check it after each complete execution.
+     *
+     *  When executeStep() returns false or exec() succeeds, any step of a full table scan
+     * or any row inserted in an automatic index since the previous check is reported according to the policy.
+     * This catches queries that silently stopped using an index, for instance after a schema change.
+     *
+     * @param[in] aPolicy   FullScanPolicy::Ignore (default), FullScanPolicy::Log or FullScanPolicy::Throw
+     */
+    void setFullScanPolicy(const FullScanPolicy aPolicy) noexcept; // nothrow
+
+    /// Return the full scan policy of this Statement.
+    inline FullScanPolicy getFullScanPolicy() const noexcept // nothrow
+    {
+        return mFullScanPolicy;
+    }
+
+    /**
+     * @brief Return the plan chosen by SQLite to execute this Statement, from "EXPLAIN QUERY PLAN".
+     *
+     *  The plan is computed on the SQL of the Statement, without its bound values.
+     *
+     * @see QueryPlanBaseline to check the plans of a set of queries against stored baselines
+     *
+     * @throw SQLite::Exception in case of error
+     */
+    QueryPlan explainQueryPlan() const;
+
 private:
     /**
      * @brief Shared pointer to the sqlite3_stmt SQLite Statement Object.
@@ -640,8 +871,14 @@ private:
     public:
         // Prepare the statement and initialize its reference counter
         Ptr(sqlite3* apSQLite, std::string& aQuery);
+        // Prepare the statement, setting an error code instead of throwing an exception on error
+        Ptr(sqlite3* apSQLite, std::string& aQuery, std::error_code& aError);
         // Copy constructor increments the ref counter
         Ptr(const Ptr& aPtr);
+        // Move constructor takes the reference of the other pointer, leaving it empty
+        Ptr(Ptr&& aPtr) noexcept;
+        // Release the reference of this pointer, then take the one of the other pointer
+        Ptr& operator=(Ptr&& aPtr) noexcept;
         // Decrement the ref counter and finalize the sqlite3_stmt when it reaches 0
         ~Ptr();
 
@@ -662,6 +899,9 @@ private:
         Ptr& operator=(const Ptr& aPtr);
         /// @}
 
+        // Decrement the ref counter and finalize the sqlite3_stmt when it reaches 0
+        void release() noexcept;
+
     private:
         sqlite3*        mpSQLite;    //!< Pointer to SQLite Database Connection Handle
         sqlite3_stmt*   mpStmt;      //!< Pointer to SQLite Statement Object
@@ -684,10 +924,25 @@ private:
     {
         if (SQLite::OK != aRet)
         {
-            throw SQLite::Exception(mStmtPtr, aRet);
+            SQLite::throwException(mStmtPtr, aRet);
         }
     }
 
+    /**
+     * @brief Apply the full scan policy at the end of an execution of the Statement.
+     */
+    void checkFullScan();
+
+    /**
+     * @brief Apply the full scan policy, returning false for a full scan forbidden by FullScanPolicy::Throw.
+     */
+    bool applyFullScanPolicy();
+
+    /**
+     * @brief Apply the full scan policy, returning false for a forbidden full scan or an exception of the handler.
+     */
+    bool tryApplyFullScanPolicy() noexcept; // nothrow
+
     /**
      * @brief Check if there is a row of result returned by executeStep(), else throw a SQLite::Exception.
      */
@@ -721,6 +976,9 @@ private:
     mutable TColumnNames    mColumnNames;   //!< Map of columns index by name (mutable so getColumnIndex can be const)
     bool                    mbHasRow;           //!< true when a row has been fetched with executeStep()
     bool                    mbDone;         //!< true when the last executeStep() had no more row to fetch
+    FullScanPolicy          mFullScanPolicy;    //!< What to do when the Statement performs a full scan
+    int                     mFullscanSteps;     //!< Full scan steps counted at the previous check
+    int                     mAutoIndexes;       //!< Automatic index rows counted at the previous check
 };
 
 
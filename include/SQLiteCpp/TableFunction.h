@@ -0,0 +1,239 @@
+/**
+ * @file    TableFunction.h
+ * @ingroup SQLiteCpp
+ * @brief   Table-valued SQL functions streaming the rows of C++ generators.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <SQLiteCpp/Function.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Forward declarations to avoid inclusion of <sqlite3.h> in a header
+struct sqlite3_module;
+
+
+namespace SQLite
+{
+
+
+/**
+ * @brief Lazy sequence of rows, returned by the C++ callables of table-valued functions.
+ *
+ *  The rows are pulled one at a time by SQLite from a callable filling the next row and returning true,
+ * or returning false at the end of the sequence. It is not called again once SQLite has enough rows,
+ * as with a LIMIT clause, so that the sequence can be infinite.
+ *
+ * @code
+ * SQLite::Generator<std::tuple<long long>> range(long long aFirst, long long aLast)
+ * {
+ *     return SQLite::Generator<std::tuple<long long>>([aFirst, aLast](std::tuple<long long>& aRow) mutable {
+ *         std::get<0>(aRow) = aFirst;
+ *         return (aFirst++ <= aLast);
+ *     });
+ * }
+ * @endcode
+ *
+ * @tparam  Row std::tuple of the values of the columns, of types convertible to SQL values (see createFunction())
+ */
+template<typename Row>
+class Generator
+{
+public:
+    typedef Row value_type;
+
+    /**
+     * @brief Create a sequence of rows from a callable.
+     *
+     * @param[in] aNext Callable with a "bool (Row&)" signature, filling the next row and returning true, or false
+     */
+    template<typename F>
+    explicit Generator(F aNext) :
+        mNext(std::move(aNext))
+    {
+    }
+
+    /// Fill the next row, and return true, or return false at the end of the sequence
+    bool next(Row& aRow)
+    {
+        return mNext(aRow);
+    }
+
+private:
+    std::function<bool(Row&)> mNext; ///< Callable generating the rows
+};
+
+
+/// @cond
+namespace detail
+{
+
+/// Rows of one call of a table-valued function, read by a cursor of its virtual table
+class RowSource
+{
+public:
+    virtual ~RowSource() {}
+
+    /// Move to the next row, returning false at the end
+    virtual bool next() = 0;
+
+    /// Set the value of a column of the current row as result of a SQL function.
+    virtual void setResult(sqlite3_context* apContext, const int aColumn) const = 0;
+};
+
+/**
+ * @brief Type independent part of a table-valued function: the sqlite3_module of its eponymous virtual table.
+ *
+ *  Its columns are the ones of the rows followed by hidden columns for the arguments,
+ * given by equality constraints: "SELECT * FROM f(1, 2)" is "SELECT * FROM f WHERE arg1 = 1 AND arg2 = 2".
+ */
+class TableFunctionBase
+{
+public:
+    /**
+     * @brief Declare the columns of the virtual table.
+     *
+     * @param[in] aNames        Names of the columns of the rows, then of the arguments, or empty for default names
+     * @param[in] aNbColumns    Number of columns of the rows
+     * @param[in] aNbArgs       Number of arguments of the function
+     *
+     * @throw SQLite::Exception if the number of names does not match the columns and arguments
+     */
+    TableFunctionBase(const std::vector<std::string>& aNames, const int aNbColumns, const int aNbArgs);
+
+    /// Destroy the function
+    virtual ~TableFunctionBase();
+
+    /// Call the function with the values of its arguments, returning the rows to read (allocated with new)
+    virtual RowSource* call(sqlite3_value** apArgs) = 0;
+
+    /// Return the "CREATE TABLE x(...)" declaration of the columns, given to sqlite3_declare_vtab().
+    const std::string& getDeclaration() const noexcept // nothrow
+    {
+        return mDeclaration;
+    }
+
+    /// Return the number of columns of the rows, the arguments being the hidden columns after them.
+    int getColumnCount() const noexcept // nothrow
+    {
+        return mNbColumns;
+    }
+
+    /// Return the number of arguments of the function.
+    int getArgCount() const noexcept // nothrow
+    {
+        return mNbArgs;
+    }
+
+    /// Return the sqlite3_module of the table-valued functions, given to sqlite3_create_module_v2().
+    static const sqlite3_module* getModule() noexcept; // nothrow
+
+    /// xDestroy callback of the module, deleting the function
+    static void destroy(void* apFunction) noexcept; // nothrow
+
+private:
+    /// @{ TableFunctionBase must be non-copyable
+    TableFunctionBase(const TableFunctionBase&);
+    TableFunctionBase& operator=(const TableFunctionBase&);
+    /// @}
+
+private:
+    std::string mDeclaration;   ///< Declaration of the columns
+    int         mNbColumns;     ///< Number of columns of the rows
+    int         mNbArgs;        ///< Number of arguments, as hidden columns
+};
+
+#if (__cplusplus >= 201402L) || ( defined(_MSC_VER) && (_MSC_VER >= 1900) ) // c++14: Visual Studio 2015
+
+/// Rows of a Generator of std::tuple, converted to SQL values column by column
+template<typename Row>
+class GeneratorSource : public RowSource
+{
+public:
+    explicit GeneratorSource(Generator<Row>&& aGenerator) :
+        mGenerator(std::move(aGenerator)),
+        mRow()
+    {
+    }
+
+    /// Generate the next row
+    virtual bool next() override
+    {
+        return mGenerator.next(mRow);
+    }
+
+    /// Set the value of a column of the current row, through a table of the conversions of each column
+    virtual void setResult(sqlite3_context* apContext, const int aColumn) const override
+    {
+        setColumn(apContext, aColumn, std::make_index_sequence<std::tuple_size<Row>::value>());
+    }
+
+private:
+    template<std::size_t I>
+    static void setValue(sqlite3_context* apContext, const Row& aRow)
+    {
+        detail::setResult(apContext, std::get<I>(aRow));
+    }
+
+    template<std::size_t... I>
+    void setColumn(sqlite3_context* apContext, const int aColumn, std::index_sequence<I...>) const
+    {
+        typedef void (*Setter)(sqlite3_context*, const Row&);
+        static const Setter setters[] = { &setValue<I>... };
+        setters[aColumn](apContext, mRow);
+    }
+
+private:
+    Generator<Row>  mGenerator; ///< Generator of the rows
+    Row             mRow;       ///< Current row
+};
+
+/// Call the function with its arguments converted from SQL values, returning its Generator
+template<typename F, typename... Args, std::size_t... I>
+inline auto call(F& aFunction, sqlite3_value** apArgs, std::tuple<Args...>*, std::index_sequence<I...>)
+    -> typename FunctionTraits<F>::Result
+{
+    (void)apArgs; // unused by functions without parameter
+    return aFunction(getValue(apArgs[I], Type<Args>())...);
+}
+
+/// Table-valued function implemented by a C++ callable of type F returning a Generator
+template<typename F>
+class TableFunction : public TableFunctionBase
+{
+public:
+    typedef FunctionTraits<F>                       Traits;
+    typedef typename Traits::Result::value_type     Row;
+
+    TableFunction(const std::vector<std::string>& aNames, F&& aFunction) :
+        TableFunctionBase(aNames, static_cast<int>(std::tuple_size<Row>::value), Traits::ARITY),
+        mFunction(std::move(aFunction))
+    {
+    }
+
+    /// Call the function, its rows being generated on demand
+    virtual RowSource* call(sqlite3_value** apArgs) override
+    {
+        return new GeneratorSource<Row>(detail::call(mFunction, apArgs,
+                                                     static_cast<typename Traits::Arguments*>(nullptr),
+                                                     std::make_index_sequence<Traits::ARITY>()));
+    }
+
+private:
+    F mFunction; ///< The C++ callable
+};
+
+#endif // c++14
+
+}  // namespace detail
+/// @endcond
+
+
+}  // namespace SQLite
@@ -0,0 +1,48 @@
+/**
+ * @file    Threading.h
+ * @ingroup SQLiteCpp
+ * @brief   Threading mode of SQLite, chosen at startup.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+
+namespace SQLite
+{
+
+
+/// Threading modes of SQLite, see https://www.sqlite.org/threadsafe.html
+enum class ThreadingMode
+{
+    SingleThread,   ///< SQLITE_CONFIG_SINGLETHREAD: no mutex at all, SQLite must be used by one thread only
+    MultiThread,    ///< SQLITE_CONFIG_MULTITHREAD: no mutex on connections, each one used by one thread at a time
+    Serialized      ///< SQLITE_CONFIG_SERIALIZED: a mutex on each connection (the default of most builds)
+};
+
+/**
+ * @brief Choose the threading mode of SQLite, with sqlite3_config(), then initialize it.
+ *
+ *  In MultiThread mode, connections are opened without their own mutex (as with OPEN_NOMUTEX),
+ * saving a lock and an unlock on each call to SQLite, so each Database must be used by one thread at a time:
+ * in debug builds, Database asserts that it is used only by the thread owning it (see Database::acquireOwnership()).
+ * OPEN_NOMUTEX and OPEN_FULLMUTEX still choose the mode of each connection, unless SQLite is in SingleThread mode.
+ *
+ *  This must be called before SQLite is initialized, that is before opening the first Database,
+ * or after sqlite3_shutdown() once all the connections are closed.
+ *
+ * @param[in] aMode     Threading mode of SQLite
+ *
+ * @throw SQLite::Exception if SQLite is already initialized in another mode (SQLITE_MISUSE),
+ *                          or if the mode is not supported by the SQLite library (compiled with SQLITE_THREADSAFE=0)
+ */
+void initialize(const ThreadingMode aMode);
+
+/// Return the threading mode chosen by initialize(), or else the default mode of the SQLite library.
+ThreadingMode getThreadingMode() noexcept; // nothrow
+
+
+}  // namespace SQLite
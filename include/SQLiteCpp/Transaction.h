@@ -12,6 +12,8 @@
 
 #include <SQLiteCpp/Exception.h>
 
+#include <system_error>
+
 
 namespace SQLite
 {
@@ -52,6 +54,26 @@ public:
      */
     explicit Transaction(Database& aDatabase);
 
+    /**
+     * @brief Begins the SQLite transaction, setting an error code instead of throwing an exception on error.
+     *
+     * @param[in]  aDatabase the SQLite Database Connection
+     * @param[out] aError    the error of the "BEGIN" (see Errors.h), or an empty error code
+     *
+     * On error, the Transaction is NOT initiated, and it has nothing to rollback.
+     */
+    Transaction(Database& aDatabase, std::error_code& aError) noexcept;
+
+    /**
+     * @brief Move the pending transaction to a new Transaction object, leaving nothing to rollback to the other.
+     */
+    Transaction(Transaction&& aTransaction) noexcept; // nothrow
+
+    /**
+     * @brief Safely rollback the current transaction if it has not been committed, then move the other one here.
+     */
+    Transaction& operator=(Transaction&& aTransaction) noexcept; // nothrow
+
     /**
      * @brief Safely rollback the transaction if it has not been committed.
      */
@@ -62,14 +84,25 @@ public:
      */
     void commit();
 
+    /**
+     * @brief Commit the transaction, setting an error code instead of throwing an exception on error.
+     *
+     *  On error (SQLITE_BUSY...), the transaction is still pending: commit can be retried,
+     * else it is rollbacked by the destructor. Committing twice is reported as Error::misuse.
+     */
+    void commit(std::error_code& aError) noexcept;
+
 private:
     // Transaction must be non-copyable
     Transaction(const Transaction&);
     Transaction& operator=(const Transaction&);
     /// @}
 
+    /// Rollback the transaction if it has not been committed, ignoring errors
+    void rollback() noexcept;
+
 private:
-    Database&   mDatabase;  ///< Reference to the SQLite Database Connection
+    Database*   mpDatabase; ///< Pointer to the SQLite Database Connection (rather than a reference, to be assignable)
     bool        mbCommited; ///< True when commit has been called
 };
 
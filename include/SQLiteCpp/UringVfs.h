@@ -0,0 +1,66 @@
+/**
+ * @file    UringVfs.h
+ * @ingroup SQLiteCpp
+ * @brief   Linux VFS reading database files through io_uring, with asynchronous read-ahead for sequential scans.
+ *
+ *  Part of the optional SQLiteCpp_vfs_uring library (CMake option SQLITECPP_BUILD_VFS_URING).
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <cstdint>
+
+
+namespace SQLite
+{
+
+
+/// Name of the io_uring VFS, to give as the apVfs parameter of the Database constructor
+extern const char* const URING_VFS_NAME;
+
+/// Default size of each of the two read-ahead buffers of a database file, in bytes
+const int DEFAULT_URING_READ_AHEAD = 256 * 1024;
+
+/**
+ * @brief Statistics of the io_uring VFS, summed over all database files.
+ */
+struct UringVfsStats
+{
+    uint64_t    reads;              ///< Reads of the main database files requested by SQLite
+    uint64_t    readAheadHits;      ///< Reads served from a read-ahead buffer
+    uint64_t    readAheadRequests;  ///< Asynchronous read-ahead requests issued
+    uint64_t    readAheadBytes;     ///< Bytes read ahead
+    bool        bUring;             ///< io_uring is available (else reads fall back to pread())
+};
+
+/**
+ * @brief Register the io_uring VFS with SQLite, under the name URING_VFS_NAME.
+ *
+ *  The VFS wraps the default unix VFS, and only changes how the main database files are read:
+ * reads are submitted to a per-file io_uring (falling back to pread() if the kernel does not support it),
+ * and once three consecutive reads are sequential, the next pages are read ahead asynchronously
+ * in two alternating buffers, so that a full table scan on a cold cache waits less for the disk.
+ * Read-ahead buffers are discarded on any write, truncation or change of lock, since other connections
+ * may then have modified the file. Journals and WAL files are left to the unix VFS.
+ *
+ *  The reads use the descriptor of the file opened by the unix VFS, so as not to release its POSIX locks.
+ * If this descriptor cannot be found and checked against the file, the file is read by the unix VFS.
+ *
+ *  Registering again only changes the size of the read-ahead buffers of the files opened afterward.
+ *
+ * @param[in] aReadAheadBytes   Size of each of the two read-ahead buffers of a database file (0 to disable read-ahead)
+ * @param[in] abMakeDefault     Also make it the default VFS of SQLite
+ *
+ * @throw SQLite::Exception in case of error
+ */
+void registerUringVfs(const int aReadAheadBytes = DEFAULT_URING_READ_AHEAD, const bool abMakeDefault = false);
+
+/// Return the statistics of the io_uring VFS.
+UringVfsStats getUringVfsStats() noexcept; // nothrow
+
+
+}  // namespace SQLite
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <cstddef>
+#include <string>
 
 /**
  * @brief A macro to disallow the copy constructor and operator= functions.
@@ -31,8 +32,7 @@
 #endif  // nullptr
 #endif  // _MSC_VER < 1600
 #elif defined(__APPLE__) // AppleClang
-#elif defined(__clang__) && __has_feature(cxx_nullptr) // Clang 3.0+
-#else // GCC or older Clang
+#else // GCC or Clang
 #if (__cplusplus < 201103L) && !defined(__GXX_EXPERIMENTAL_CXX0X__) // before C++11 on GCC4.7 and Visual Studio 2010
 #ifndef HAVE_NULLPTR
 #define HAVE_NULLPTR    ///< A macro to avoid double definition of nullptr
@@ -67,3 +67,24 @@ const nullptr_t nullptr = {};
 #if _MSC_VER
 #define snprintf _snprintf
 #endif
+
+namespace SQLite
+{
+
+/// Quote an identifier (table or column name) between double quotes, doubling the double quotes it contains.
+inline std::string quoteIdentifier(const std::string& aName)
+{
+    std::string quoted("\"");
+    for (size_t i = 0; i < aName.size(); ++i)
+    {
+        quoted += aName[i];
+        if ('"' == aName[i])
+        {
+            quoted += '"';
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
+
+}  // namespace SQLite
@@ -0,0 +1,297 @@
+/**
+ * @file    VirtualTable.h
+ * @ingroup SQLiteCpp
+ * @brief   Virtual tables exposing C++ containers to SQL, with sorted indexes to push down filters.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <SQLiteCpp/Function.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Forward declarations to avoid inclusion of <sqlite3.h> in a header
+struct sqlite3_module;
+
+
+namespace SQLite
+{
+
+
+/// Whether a column of a VirtualTable has a sorted index, to look up rows by equality or range constraints
+enum ColumnIndex
+{
+    NotIndexed = 0, ///< Constraints on the column are checked row by row
+    Indexed = 1     ///< Equality and range constraints on the column are looked up in a sorted index
+};
+
+/// @cond
+namespace detail
+{
+
+// SQL types of the columns of a VirtualTable, and comparisons of their values, implemented in VirtualTable.cpp
+const char* getSqlType(Type<int>) noexcept; // nothrow
+const char* getSqlType(Type<unsigned int>) noexcept; // nothrow
+const char* getSqlType(Type<long>) noexcept; // nothrow
+const char* getSqlType(Type<long long>) noexcept; // nothrow
+const char* getSqlType(Type<bool>) noexcept; // nothrow
+const char* getSqlType(Type<double>) noexcept; // nothrow
+const char* getSqlType(Type<std::string>) noexcept; // nothrow
+bool isComparable(Type<int>, sqlite3_value* apValue) noexcept; // nothrow
+bool isComparable(Type<unsigned int>, sqlite3_value* apValue) noexcept; // nothrow
+bool isComparable(Type<long>, sqlite3_value* apValue) noexcept; // nothrow
+bool isComparable(Type<long long>, sqlite3_value* apValue) noexcept; // nothrow
+bool isComparable(Type<bool>, sqlite3_value* apValue) noexcept; // nothrow
+bool isComparable(Type<double>, sqlite3_value* apValue) noexcept; // nothrow
+bool isComparable(Type<std::string>, sqlite3_value* apValue) noexcept; // nothrow
+int compareValue(long long aValue, sqlite3_value* apValue) noexcept; // nothrow
+int compareValue(double aValue, sqlite3_value* apValue) noexcept; // nothrow
+int compareValue(const std::string& aValue, sqlite3_value* apValue) noexcept; // nothrow
+
+/// Compare the smaller integer types as 64 bits integers
+inline int compareValue(int aValue, sqlite3_value* apValue) noexcept // nothrow
+{
+    return compareValue(static_cast<long long>(aValue), apValue);
+}
+inline int compareValue(unsigned int aValue, sqlite3_value* apValue) noexcept // nothrow
+{
+    return compareValue(static_cast<long long>(aValue), apValue);
+}
+inline int compareValue(long aValue, sqlite3_value* apValue) noexcept // nothrow
+{
+    return compareValue(static_cast<long long>(aValue), apValue);
+}
+inline int compareValue(bool aValue, sqlite3_value* apValue) noexcept // nothrow
+{
+    return compareValue(static_cast<long long>(aValue), apValue);
+}
+
+}  // namespace detail
+/// @endcond
+
+/**
+ * @brief Type independent part of a VirtualTable: the sqlite3_module callbacks and the sorted indexes.
+ *
+ *  This is the class given to Database::createModule(), which makes the table available to SQL
+ * as an eponymous virtual table, that is a read-only table named after the module.
+ */
+class VirtualTableBase
+{
+public:
+    /// Destroy the table, which must not be used by any connection anymore
+    virtual ~VirtualTableBase();
+
+    /**
+     * @brief Sort again the indexes of the table, after a change of its rows.
+     *
+     *  Until then, a query using an index after rows were added or removed fails with an error.
+     * The rows must not change while a query is reading the table, nor from an other thread.
+     */
+    void refresh();
+
+    /// Return the "CREATE TABLE x(...)" declaration of the columns, given to sqlite3_declare_vtab().
+    std::string getDeclaration() const;
+
+    /// Return the sqlite3_module of the virtual tables, given to sqlite3_create_module_v2().
+    static const sqlite3_module* getModule() noexcept; // nothrow
+
+    /// @cond
+    /// Callbacks of the module, not part of the API: see VirtualTable.cpp
+    struct Callbacks;
+    /// @endcond
+
+protected:
+    /// Create a table without any column
+    VirtualTableBase();
+
+    /**
+     * @brief Declare a column, with the SQL type of its values.
+     *
+     * @param[in] aName     Name of the column
+     * @param[in] apType    SQL type of the column: "INTEGER", "REAL" or "TEXT"
+     * @param[in] aIndex    Indexed to maintain a sorted index of the column
+     */
+    void declareColumn(const std::string& aName, const char* apType, const ColumnIndex aIndex);
+
+    /// Return the number of rows of the table.
+    virtual size_t getRowCount() const noexcept = 0; // nothrow
+
+    /// Set the value of a column of a row as result of a SQL function.
+    virtual void setResult(sqlite3_context* apContext, const size_t aRow, const int aColumn) const = 0;
+
+    /// Return true if the value of a column of a row is less than the one of an other row.
+    virtual bool isLess(const size_t aLeftRow, const size_t aRightRow, const int aColumn) const = 0;
+
+    /**
+     * @brief Compare the value of a column of a row to a SQL value, of a type comparable to the column.
+     *
+     * @return negative if the value of the row is lower, 0 if equal, positive if greater
+     */
+    virtual int compare(const size_t aRow, const int aColumn, sqlite3_value* apValue) const = 0;
+
+    /// Return true if a SQL value can be compared to the values of the column by compare().
+    virtual bool isComparable(const int aColumn, sqlite3_value* apValue) const = 0;
+
+private:
+    /// @{ VirtualTableBase must be non-copyable
+    VirtualTableBase(const VirtualTableBase&);
+    VirtualTableBase& operator=(const VirtualTableBase&);
+    /// @}
+
+    /// Declaration of a column
+    struct ColumnInfo
+    {
+        std::string         name;       ///< Name of the column
+        const char*         pType;      ///< SQL type of the column
+        bool                bIndexed;   ///< true if the column has a sorted index
+        std::vector<size_t> index;      ///< Rows sorted by the value of the column, if indexed
+    };
+
+    /// Return the first position in the index of a column with a value not less (or greater if abUpper) than apValue.
+    size_t search(const int aColumn, sqlite3_value* apValue, const bool abUpper) const;
+
+private:
+    std::vector<ColumnInfo> mColumns;   ///< Columns of the table
+};
+
+
+/**
+ * @brief Read-only virtual table exposing a std::vector of C++ objects, one row per object.
+ *
+ *  Each column is a data member of the objects. Equality and range constraints (=, <, <=, >, >=)
+ * on an Indexed column are pushed down to a sorted index of the rows, built when the table is registered
+ * (and again by refresh()), so that SQLite can look up rows in place, for instance in a join
+ * with an on-disk table, without copying the container into a temporary table.
+ * The rowid of a row is its position in the vector.
+ *
+ * @code
+ * struct Employee { long long id; std::string name; double salary; };
+ * std::vector<Employee> employees = ...;
+ * SQLite::VirtualTable<Employee> table(employees);
+ * table.addColumn("id", &Employee::id, SQLite::Indexed);
+ * table.addColumn("name", &Employee::name, SQLite::Indexed);
+ * table.addColumn("salary", &Employee::salary);
+ * db.createModule("employees", table);
+ * db.exec("SELECT o.amount, e.name FROM orders o JOIN employees e ON e.id = o.employee_id");
+ * @endcode
+ *
+ *  The table and the vector must outlive the connections using them, and must not change
+ * while a query reads them.
+ *
+ * @tparam  T   Type of the rows; columns can be int, unsigned int, long, long long, bool, double or std::string
+ */
+template<typename T>
+class VirtualTable : public VirtualTableBase
+{
+public:
+    /**
+     * @brief Expose the objects of a vector, without any column until addColumn() is called.
+     *
+     * @param[in] aRows     Objects to expose, referenced by the table
+     */
+    explicit VirtualTable(const std::vector<T>& aRows) :
+        mRows(aRows)
+    {
+    }
+
+    /**
+     * @brief Add a column for a data member of the objects, before registering the table.
+     *
+     * @param[in] aName     Name of the column
+     * @param[in] apMember  Pointer to the data member
+     * @param[in] aIndex    Indexed to push down the equality and range constraints on the column
+     *
+     * @return this table, to chain the calls
+     */
+    template<typename V>
+    VirtualTable& addColumn(const std::string& aName, V T::* apMember, const ColumnIndex aIndex = NotIndexed)
+    {
+        declareColumn(aName, detail::getSqlType(detail::Type<V>()), aIndex);
+        mColumns.push_back(std::unique_ptr<Column>(new MemberColumn<V>(apMember)));
+        return *this;
+    }
+
+protected:
+    /// Return the number of rows of the table.
+    virtual size_t getRowCount() const noexcept override // nothrow
+    {
+        return mRows.size();
+    }
+
+    /// Set the value of a column of a row as result of a SQL function.
+    virtual void setResult(sqlite3_context* apContext, const size_t aRow, const int aColumn) const override
+    {
+        mColumns[static_cast<size_t>(aColumn)]->setResult(apContext, mRows[aRow]);
+    }
+
+    /// Return true if the value of a column of a row is less than the one of an other row.
+    virtual bool isLess(const size_t aLeftRow, const size_t aRightRow, const int aColumn) const override
+    {
+        return mColumns[static_cast<size_t>(aColumn)]->isLess(mRows[aLeftRow], mRows[aRightRow]);
+    }
+
+    /// Compare the value of a column of a row to a SQL value, of a type comparable to the column.
+    virtual int compare(const size_t aRow, const int aColumn, sqlite3_value* apValue) const override
+    {
+        return mColumns[static_cast<size_t>(aColumn)]->compare(mRows[aRow], apValue);
+    }
+
+    /// Return true if a SQL value can be compared to the values of the column by compare().
+    virtual bool isComparable(const int aColumn, sqlite3_value* apValue) const override
+    {
+        return mColumns[static_cast<size_t>(aColumn)]->isComparable(apValue);
+    }
+
+private:
+    /// Access to the values of a column
+    struct Column
+    {
+        virtual ~Column() {}
+        virtual void setResult(sqlite3_context* apContext, const T& aRow) const = 0;
+        virtual bool isLess(const T& aLeft, const T& aRight) const = 0;
+        virtual int compare(const T& aRow, sqlite3_value* apValue) const = 0;
+        virtual bool isComparable(sqlite3_value* apValue) const = 0;
+    };
+
+    /// Access to the values of a column mapped to a data member of type V
+    template<typename V>
+    struct MemberColumn : public Column
+    {
+        explicit MemberColumn(V T::* apMember) :
+            mpMember(apMember)
+        {
+        }
+        virtual void setResult(sqlite3_context* apContext, const T& aRow) const override
+        {
+            detail::setResult(apContext, aRow.*mpMember);
+        }
+        virtual bool isLess(const T& aLeft, const T& aRight) const override
+        {
+            return (aLeft.*mpMember) < (aRight.*mpMember);
+        }
+        virtual int compare(const T& aRow, sqlite3_value* apValue) const override
+        {
+            return detail::compareValue(aRow.*mpMember, apValue);
+        }
+        virtual bool isComparable(sqlite3_value* apValue) const override
+        {
+            return detail::isComparable(detail::Type<V>(), apValue);
+        }
+
+        V T::* mpMember; ///< Pointer to the data member
+    };
+
+private:
+    const std::vector<T>&                   mRows;      ///< Objects exposed as rows
+    std::vector<std::unique_ptr<Column>>    mColumns;   ///< Access to the values of each column
+};
+
+
+}  // namespace SQLite
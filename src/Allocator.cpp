@@ -0,0 +1,489 @@
+/**
+ * @file    Allocator.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Pluggable memory allocator for SQLite, with a size-class pool allocator and per-class accounting.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/Allocator.h>
+
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace SQLite
+{
+
+namespace
+{
+
+// Size of the blocks of each size class, in bytes (multiples of 8 to keep the alignment required by SQLite)
+const size_t SIZE_CLASSES[] = {
+    16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024, 1280, 1536, 1792, 2048, 2560, 3072, 3584, 4096
+};
+const size_t CLASS_COUNT    = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+const size_t MAX_CLASS_SIZE = SIZE_CLASSES[CLASS_COUNT - 1];
+const uint32_t LARGE_CLASS  = 0xFFFFFFFF;   // Size class of the allocations going straight to the system malloc
+const size_t CHUNK_SIZE     = 64 * 1024;    // Blocks are carved out of chunks of this size
+const unsigned BATCH_SIZE   = 32;           // Number of blocks moved at once between a thread cache and its pool
+const unsigned CACHE_SIZE   = 2 * BATCH_SIZE;   // Maximum number of blocks of each class cached by a thread
+
+// Header in front of each block, keeping it 8 bytes aligned
+struct Header
+{
+    uint32_t    sizeClass;  // Index of the size class, or LARGE_CLASS
+    uint32_t    size;       // Usable size of the block
+};
+
+// A free block is linked to the next one in its list through its user memory
+struct FreeBlock
+{
+    FreeBlock*  pNext;
+};
+
+// Global pool of blocks of one size class
+struct ClassPool
+{
+    std::mutex              mutex;          // Protect the free list and the chunks
+    FreeBlock*              pFree;          // Blocks given back by the thread caches
+    char*                   pCarve;         // Remaining space of the last chunk
+    size_t                  carveRemaining; // Bytes available at pCarve
+    std::vector<void*>      chunks;         // All chunks of memory allocated for this class
+    std::atomic<uint64_t>   allocations;
+    std::atomic<uint64_t>   blocksInUse;
+    std::atomic<uint64_t>   bytesReserved;
+};
+
+// State of the Pool allocator, shared by all threads
+struct Pool
+{
+    Pool() :
+        largeAllocations(0), largeBytesInUse(0),
+        bytesInUse(0), peakBytesInUse(0), generation(1)
+    {
+        for (size_t size = 0, c = 0; size <= MAX_CLASS_SIZE; size += 8)
+        {
+            while (SIZE_CLASSES[c] < size)
+            {
+                ++c;
+            }
+            classOfSize[size / 8] = static_cast<uint8_t>(c);
+        }
+        for (size_t c = 0; c < CLASS_COUNT; ++c)
+        {
+            classes[c].pFree = nullptr;
+            classes[c].pCarve = nullptr;
+            classes[c].carveRemaining = 0;
+            classes[c].allocations = 0;
+            classes[c].blocksInUse = 0;
+            classes[c].bytesReserved = 0;
+        }
+    }
+    ~Pool()
+    {
+        // Memory still in use by SQLite at exit is left alone
+        if (0 == bytesInUse.load())
+        {
+            release();
+        }
+    }
+
+    // Free all the chunks once no block is in use anymore, and invalidate the thread caches
+    void release()
+    {
+        for (size_t c = 0; c < CLASS_COUNT; ++c)
+        {
+            std::lock_guard<std::mutex> lock(classes[c].mutex);
+            for (size_t i = 0; i < classes[c].chunks.size(); ++i)
+            {
+                std::free(classes[c].chunks[i]);
+            }
+            classes[c].chunks.clear();
+            classes[c].pFree = nullptr;
+            classes[c].pCarve = nullptr;
+            classes[c].carveRemaining = 0;
+            classes[c].bytesReserved = 0;
+        }
+        ++generation;
+    }
+
+    uint8_t                 classOfSize[MAX_CLASS_SIZE / 8 + 1];    // Size class of each size, rounded up to 8
+    ClassPool               classes[CLASS_COUNT];
+    std::atomic<uint64_t>   largeAllocations;
+    std::atomic<uint64_t>   largeBytesInUse;
+    std::atomic<uint64_t>   bytesInUse;
+    std::atomic<uint64_t>   peakBytesInUse;
+    std::atomic<unsigned>   generation;     // Incremented each time the chunks are released
+};
+
+Pool gPool;
+
+// Blocks cached by a thread, to allocate and free without any lock nor contention in the common case.
+// Trivially destructible so that it stays usable while the other thread_local objects are destroyed.
+struct ThreadCache
+{
+    unsigned    generation;                 // Generation of the Pool the cached blocks belong to
+    bool        bFlushed;                   // The thread is exiting, its blocks were given back
+    FreeBlock*  pFree[CLASS_COUNT];
+    unsigned    count[CLASS_COUNT];
+};
+
+thread_local ThreadCache tCache;
+
+// Give the blocks of a thread back to the Pool when the thread exits
+struct ThreadCacheFlusher
+{
+    ~ThreadCacheFlusher();
+};
+
+thread_local ThreadCacheFlusher tCacheFlusher;
+
+// Give all the blocks of a list back to the pool of their size class
+void giveBack(const size_t aClass, FreeBlock* apFirst, FreeBlock* apLast)
+{
+    ClassPool& pool = gPool.classes[aClass];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    apLast->pNext = pool.pFree;
+    pool.pFree = apFirst;
+}
+
+ThreadCacheFlusher::~ThreadCacheFlusher()
+{
+    if (tCache.generation == gPool.generation.load())
+    {
+        for (size_t c = 0; c < CLASS_COUNT; ++c)
+        {
+            if (nullptr != tCache.pFree[c])
+            {
+                FreeBlock* pLast = tCache.pFree[c];
+                while (nullptr != pLast->pNext)
+                {
+                    pLast = pLast->pNext;
+                }
+                giveBack(c, tCache.pFree[c], pLast);
+            }
+        }
+    }
+    tCache.bFlushed = true;
+}
+
+// Make sure the cache of the thread holds blocks of the current generation of the Pool
+ThreadCache& getThreadCache()
+{
+    ThreadCache& cache = tCache;
+    const unsigned generation = gPool.generation.load(std::memory_order_relaxed);
+    if (cache.generation != generation)
+    {
+        (void)&tCacheFlusher; // Construct the flusher of the thread on first use
+        std::memset(cache.pFree, 0, sizeof(cache.pFree));
+        std::memset(cache.count, 0, sizeof(cache.count));
+        cache.generation = generation;
+    }
+    return cache;
+}
+
+// Take a batch of blocks from the pool of a size class (from its free list, or else from a chunk)
+bool refill(ThreadCache& aCache, const size_t aClass)
+{
+    ClassPool& pool = gPool.classes[aClass];
+    const size_t blockSize = sizeof(Header) + SIZE_CLASSES[aClass];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    unsigned count = 0;
+    while ((count < BATCH_SIZE) && (nullptr != pool.pFree))
+    {
+        FreeBlock* pBlock = pool.pFree;
+        pool.pFree = pBlock->pNext;
+        pBlock->pNext = aCache.pFree[aClass];
+        aCache.pFree[aClass] = pBlock;
+        ++count;
+    }
+    while (count < BATCH_SIZE)
+    {
+        if (pool.carveRemaining < blockSize)
+        {
+            void* pChunk = std::malloc(CHUNK_SIZE);
+            if (nullptr == pChunk)
+            {
+                break;
+            }
+            pool.chunks.push_back(pChunk);
+            pool.pCarve = static_cast<char*>(pChunk);
+            pool.carveRemaining = CHUNK_SIZE;
+            pool.bytesReserved.fetch_add(CHUNK_SIZE, std::memory_order_relaxed);
+        }
+        FreeBlock* pBlock = reinterpret_cast<FreeBlock*>(pool.pCarve + sizeof(Header));
+        pool.pCarve += blockSize;
+        pool.carveRemaining -= blockSize;
+        pBlock->pNext = aCache.pFree[aClass];
+        aCache.pFree[aClass] = pBlock;
+        ++count;
+    }
+    aCache.count[aClass] += count;
+    return (count > 0);
+}
+
+// Account for bytes allocated, updating the peak usage
+void addInUse(const uint64_t aBytes) noexcept // nothrow
+{
+    const uint64_t inUse = gPool.bytesInUse.fetch_add(aBytes, std::memory_order_relaxed) + aBytes;
+    uint64_t peak = gPool.peakBytesInUse.load(std::memory_order_relaxed);
+    while ((inUse > peak) && !gPool.peakBytesInUse.compare_exchange_weak(peak, inUse, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Round up a size to the usable size of the block that would be allocated
+int poolRoundup(int aSize)
+{
+    const size_t size = (aSize > 0) ? static_cast<size_t>(aSize) : 1;
+    if (size <= MAX_CLASS_SIZE)
+    {
+        return static_cast<int>(SIZE_CLASSES[gPool.classOfSize[(size + 7) / 8]]);
+    }
+    return static_cast<int>((size + 7) & ~static_cast<size_t>(7));
+}
+
+// sqlite3_mem_methods::xMalloc
+void* poolMalloc(int aSize)
+{
+    const size_t size = (aSize > 0) ? static_cast<size_t>(aSize) : 1;
+    Header* pHeader = nullptr;
+    if (size <= MAX_CLASS_SIZE)
+    {
+        const size_t sizeClass = gPool.classOfSize[(size + 7) / 8];
+        ThreadCache& cache = getThreadCache();
+        if (cache.bFlushed)
+        {
+            // The thread is exiting: do not cache anything anymore
+            ThreadCache local = ThreadCache();
+            if (!refill(local, sizeClass))
+            {
+                return nullptr;
+            }
+            FreeBlock* pBlock = local.pFree[sizeClass];
+            if (nullptr != pBlock->pNext)
+            {
+                FreeBlock* pLast = pBlock->pNext;
+                while (nullptr != pLast->pNext)
+                {
+                    pLast = pLast->pNext;
+                }
+                giveBack(sizeClass, pBlock->pNext, pLast);
+            }
+            pHeader = reinterpret_cast<Header*>(pBlock) - 1;
+        }
+        else
+        {
+            if ((nullptr == cache.pFree[sizeClass]) && !refill(cache, sizeClass))
+            {
+                return nullptr;
+            }
+            FreeBlock* pBlock = cache.pFree[sizeClass];
+            cache.pFree[sizeClass] = pBlock->pNext;
+            --cache.count[sizeClass];
+            pHeader = reinterpret_cast<Header*>(pBlock) - 1;
+        }
+        pHeader->sizeClass = static_cast<uint32_t>(sizeClass);
+        pHeader->size = static_cast<uint32_t>(SIZE_CLASSES[sizeClass]);
+        ClassPool& pool = gPool.classes[sizeClass];
+        pool.allocations.fetch_add(1, std::memory_order_relaxed);
+        pool.blocksInUse.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        const size_t rounded = (size + 7) & ~static_cast<size_t>(7);
+        pHeader = static_cast<Header*>(std::malloc(sizeof(Header) + rounded));
+        if (nullptr == pHeader)
+        {
+            return nullptr;
+        }
+        pHeader->sizeClass = LARGE_CLASS;
+        pHeader->size = static_cast<uint32_t>(rounded);
+        gPool.largeAllocations.fetch_add(1, std::memory_order_relaxed);
+        gPool.largeBytesInUse.fetch_add(rounded, std::memory_order_relaxed);
+    }
+    addInUse(pHeader->size);
+    return pHeader + 1;
+}
+
+// sqlite3_mem_methods::xFree
+void poolFree(void* apMemory)
+{
+    if (nullptr == apMemory)
+    {
+        return;
+    }
+    Header* pHeader = static_cast<Header*>(apMemory) - 1;
+    const uint32_t size = pHeader->size;
+    gPool.bytesInUse.fetch_sub(size, std::memory_order_relaxed);
+    if (LARGE_CLASS == pHeader->sizeClass)
+    {
+        gPool.largeBytesInUse.fetch_sub(size, std::memory_order_relaxed);
+        std::free(pHeader);
+        return;
+    }
+    const size_t sizeClass = pHeader->sizeClass;
+    gPool.classes[sizeClass].blocksInUse.fetch_sub(1, std::memory_order_relaxed);
+    FreeBlock* pBlock = static_cast<FreeBlock*>(apMemory);
+    ThreadCache& cache = getThreadCache();
+    if (cache.bFlushed)
+    {
+        pBlock->pNext = nullptr;
+        giveBack(sizeClass, pBlock, pBlock);
+        return;
+    }
+    pBlock->pNext = cache.pFree[sizeClass];
+    cache.pFree[sizeClass] = pBlock;
+    if (++cache.count[sizeClass] > CACHE_SIZE)
+    {
+        // Give half of the cached blocks back to the pool, for other threads to use
+        FreeBlock* pLast = pBlock;
+        for (unsigned i = 1; i < BATCH_SIZE; ++i)
+        {
+            pLast = pLast->pNext;
+        }
+        cache.pFree[sizeClass] = pLast->pNext;
+        cache.count[sizeClass] -= BATCH_SIZE;
+        giveBack(sizeClass, pBlock, pLast);
+    }
+}
+
+// sqlite3_mem_methods::xSize
+int poolSize(void* apMemory)
+{
+    return (nullptr != apMemory) ? static_cast<int>((static_cast<Header*>(apMemory) - 1)->size) : 0;
+}
+
+// sqlite3_mem_methods::xRealloc
+void* poolRealloc(void* apMemory, int aSize)
+{
+    const int oldSize = poolSize(apMemory);
+    if (poolRoundup(aSize) == oldSize)
+    {
+        return apMemory;
+    }
+    void* pNew = poolMalloc(aSize);
+    if (nullptr != pNew)
+    {
+        std::memcpy(pNew, apMemory, static_cast<size_t>((oldSize < aSize) ? oldSize : aSize));
+        poolFree(apMemory);
+    }
+    return pNew;
+}
+
+// sqlite3_mem_methods::xInit
+int poolInit(void*)
+{
+    return SQLITE_OK;
+}
+
+// sqlite3_mem_methods::xShutdown
+void poolShutdown(void*)
+{
+}
+
+const sqlite3_mem_methods sPoolMethods = {
+    poolMalloc, poolFree, poolRealloc, poolSize, poolRoundup, poolInit, poolShutdown, nullptr
+};
+
+std::mutex          gConfigMutex;                   // Serialize the calls to configureAllocator()
+sqlite3_mem_methods gDefaultMethods;                // Allocator of SQLite before the first configuration
+bool                gbDefaultSaved = false;
+Allocator           gAllocator = Allocator::Default;
+
+} // namespace
+
+
+// Install the memory allocator used by SQLite for all its allocations, with SQLITE_CONFIG_MALLOC.
+void configureAllocator(const Allocator aAllocator)
+{
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    if (aAllocator == gAllocator)
+    {
+        return;
+    }
+    int ret = SQLITE_OK;
+    if (!gbDefaultSaved)
+    {
+        ret = sqlite3_config(SQLITE_CONFIG_GETMALLOC, &gDefaultMethods);
+        if (SQLITE_OK != ret)
+        {
+            throw SQLite::Exception("Cannot configure the allocator once SQLite is initialized", ret);
+        }
+        gbDefaultSaved = true;
+    }
+    if (Allocator::Pool == aAllocator)
+    {
+        gPool.largeAllocations = 0;
+        gPool.peakBytesInUse = gPool.bytesInUse.load();
+        for (size_t c = 0; c < CLASS_COUNT; ++c)
+        {
+            gPool.classes[c].allocations = 0;
+        }
+        ret = sqlite3_config(SQLITE_CONFIG_MALLOC, &sPoolMethods);
+    }
+    else
+    {
+        if (0 != gPool.bytesInUse.load())
+        {
+            throw SQLite::Exception("Cannot switch allocator while SQLite holds memory of the pool", SQLITE_MISUSE);
+        }
+        ret = sqlite3_config(SQLITE_CONFIG_MALLOC, &gDefaultMethods);
+    }
+    if (SQLITE_OK != ret)
+    {
+        throw SQLite::Exception("Cannot configure the allocator once SQLite is initialized", ret);
+    }
+    if (Allocator::Default == aAllocator)
+    {
+        gPool.release();
+    }
+    gAllocator = aAllocator;
+}
+
+// Return the allocator currently installed by configureAllocator().
+Allocator getAllocator() noexcept // nothrow
+{
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    return gAllocator;
+}
+
+// Return the accounting of the Pool allocator.
+AllocatorStats getAllocatorStats()
+{
+    AllocatorStats stats;
+    stats.sizeClasses.resize(CLASS_COUNT);
+    for (size_t c = 0; c < CLASS_COUNT; ++c)
+    {
+        const ClassPool& pool = gPool.classes[c];
+        AllocatorStats::SizeClass& sizeClass = stats.sizeClasses[c];
+        sizeClass.size = SIZE_CLASSES[c];
+        sizeClass.allocations = pool.allocations.load(std::memory_order_relaxed);
+        sizeClass.blocksInUse = pool.blocksInUse.load(std::memory_order_relaxed);
+        sizeClass.bytesInUse = sizeClass.blocksInUse * sizeClass.size;
+        sizeClass.bytesReserved = pool.bytesReserved.load(std::memory_order_relaxed);
+    }
+    stats.largeAllocations = gPool.largeAllocations.load(std::memory_order_relaxed);
+    stats.largeBytesInUse = gPool.largeBytesInUse.load(std::memory_order_relaxed);
+    stats.bytesInUse = gPool.bytesInUse.load(std::memory_order_relaxed);
+    stats.peakBytesInUse = gPool.peakBytesInUse.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Restart the measure of the peak usage of the Pool allocator from its current usage.
+void resetAllocatorPeak() noexcept // nothrow
+{
+    gPool.peakBytesInUse.store(gPool.bytesInUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+
+}  // namespace SQLite
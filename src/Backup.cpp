@@ -69,6 +69,28 @@ Backup::Backup(Database &aDestDatabase, Database &aSrcDatabase) :
     }
 }
 
+// Move the SQLite Backup resource to a new Backup object
+Backup::Backup(Backup&& aBackup) noexcept : // nothrow
+    mpSQLiteBackup(aBackup.mpSQLiteBackup)
+{
+    aBackup.mpSQLiteBackup = NULL;
+}
+
+// Release the current SQLite Backup resource, then move the other one here
+Backup& Backup::operator=(Backup&& aBackup) noexcept // nothrow
+{
+    if (this != &aBackup)
+    {
+        if (NULL != mpSQLiteBackup)
+        {
+            sqlite3_backup_finish(mpSQLiteBackup);
+        }
+        mpSQLiteBackup = aBackup.mpSQLiteBackup;
+        aBackup.mpSQLiteBackup = NULL;
+    }
+    return *this;
+}
+
 // Release resource for SQLite database backup
 Backup::~Backup()
 {
@@ -0,0 +1,612 @@
+/**
+ * @file    BulkImporter.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Import of CSV and delimited files into a table, by a pipeline of reader, parser and writer threads.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/BulkImporter.h>
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Schema.h>
+#include <SQLiteCpp/Transaction.h>
+#include <SQLiteCpp/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+namespace SQLite
+{
+
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+// Return the seconds elapsed since a time point
+double getSecondsSince(const Clock::time_point& aStart)
+{
+    return std::chrono::duration<double>(Clock::now() - aStart).count();
+}
+
+// Return the given columns, or all the columns of the table
+std::vector<std::string> getColumns(Database& aDatabase, const std::string& aTable,
+                                    const std::vector<std::string>& aColumns)
+{
+    if (!aColumns.empty())
+    {
+        return aColumns;
+    }
+    const SchemaTable* pTable = aDatabase.getSchema().getTable(aTable);
+    if ((nullptr == pTable) || pTable->bView)
+    {
+        throw SQLite::Exception("no such table: " + aTable);
+    }
+    std::vector<std::string> columns;
+    for (const SchemaColumn& column : pTable->columns)
+    {
+        columns.push_back(column.name);
+    }
+    return columns;
+}
+
+// Return the "INSERT INTO table (columns) VALUES (?, ...)" statement of the rows
+std::string getInsertQuery(const std::string& aTable, const std::vector<std::string>& aColumns)
+{
+    std::string columns;
+    std::string values;
+    for (const std::string& column : aColumns)
+    {
+        columns += (columns.empty() ? "" : ", ") + quoteIdentifier(column);
+        values += values.empty() ? "?" : ", ?";
+    }
+    return "INSERT INTO " + quoteIdentifier(aTable) + " (" + columns + ") VALUES (" + values + ")";
+}
+
+/// A chunk of whole records of the input, then the fields of its records once parsed
+struct Chunk
+{
+    uint64_t                    sequence;   ///< Position of the chunk in the input, from 0
+    std::vector<char>           buffer;     ///< Records, followed by a null character
+    size_t                      size;       ///< Number of bytes of the records
+    std::vector<const char*>    fields;     ///< Fields of the records, in the buffer, or nullptr for a NULL
+    uint64_t                    rows;       ///< Number of records parsed
+    std::exception_ptr          error;      ///< Error of the parse, thrown once the rows before it are written
+};
+
+/// State shared by the stages of the pipeline, protected by its mutex
+struct Pipeline
+{
+    std::mutex                                  mutex;
+    std::condition_variable                     readerCondition;    ///< A chunk was written, or stop
+    std::condition_variable                     parserCondition;    ///< A chunk was read, end of input, or stop
+    std::condition_variable                     writerCondition;    ///< A chunk was parsed, end of input, or stop
+    std::deque<std::unique_ptr<Chunk> >         toParse;            ///< Chunks read, in order
+    std::map<uint64_t, std::unique_ptr<Chunk> > parsed;             ///< Chunks parsed, by sequence
+    size_t                                      inFlight = 0;       ///< Number of chunks read but not written yet
+    uint64_t                                    chunks = 0;         ///< Number of chunks read
+    uint64_t                                    bytes = 0;          ///< Number of bytes read
+    bool                                        bEndOfInput = false;
+    bool                                        bStop = false;      ///< An error stops all the stages
+    std::exception_ptr                          error;              ///< First error of a stage
+    double                                      readerStall = 0.0;
+    double                                      parserStall = 0.0;
+    double                                      writerStall = 0.0;
+
+    // Stop all the stages on the first error
+    void fail(const std::exception_ptr& aError)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+            {
+                error = aError;
+            }
+            bStop = true;
+        }
+        readerCondition.notify_all();
+        parserCondition.notify_all();
+        writerCondition.notify_all();
+    }
+};
+
+// Read the input by chunks of whole records, at most BulkImportOptions::chunksInFlight at once
+void readChunks(std::istream& aInput, const BulkImportOptions& aOptions, Pipeline& aPipeline)
+{
+    std::vector<char> partial; // beginning of the last record of the previous chunk
+    uint64_t sequence = 0;
+    bool bEndOfInput = false;
+    while (!bEndOfInput)
+    {
+        {
+            std::unique_lock<std::mutex> lock(aPipeline.mutex);
+            const Clock::time_point start = Clock::now();
+            aPipeline.readerCondition.wait(lock, [&aPipeline, &aOptions]
+            {
+                return aPipeline.bStop || (aPipeline.inFlight < aOptions.chunksInFlight);
+            });
+            aPipeline.readerStall += getSecondsSince(start);
+            if (aPipeline.bStop)
+            {
+                return;
+            }
+            ++aPipeline.inFlight;
+        }
+
+        std::unique_ptr<Chunk> chunk(new Chunk());
+        chunk->sequence = sequence++;
+        chunk->rows = 0;
+        std::vector<char>& buffer = chunk->buffer;
+        buffer.resize(std::max(aOptions.chunkSize, 2 * partial.size()) + 1);
+        std::copy(partial.begin(), partial.end(), buffer.begin());
+        size_t size = partial.size();
+        size_t scanned = 0;
+        size_t end = 0; // end of the last whole record
+        bool bQuoted = false;
+        bool bFieldStart = true; // a chunk starts with a record
+        for (;;)
+        {
+            if (size + 1 == buffer.size())
+            {
+                buffer.resize(2 * buffer.size()); // a record larger than a chunk
+            }
+            aInput.read(&buffer[size], static_cast<std::streamsize>(buffer.size() - 1 - size));
+            const size_t count = static_cast<size_t>(aInput.gcount());
+            size += count;
+            if (aInput.bad())
+            {
+                throw SQLite::Exception("error reading the input of the import");
+            }
+            bEndOfInput = aInput.eof();
+            // a newline ends a record unless it is quoted, a quote opening only a field as in parseChunk()
+            for (; scanned < size; ++scanned)
+            {
+                const char c = buffer[scanned];
+                if (bQuoted)
+                {
+                    bQuoted = (aOptions.quote != c);
+                    bFieldStart = !bQuoted; // a quote following the closing one is an escaped quote
+                }
+                else if ((aOptions.quote == c) && bFieldStart)
+                {
+                    bQuoted = true;
+                }
+                else
+                {
+                    bFieldStart = (aOptions.delimiter == c) || ('\n' == c);
+                    if ('\n' == c)
+                    {
+                        end = scanned + 1;
+                    }
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(aPipeline.mutex);
+                aPipeline.bytes += count;
+            }
+            if (bEndOfInput || (end > 0))
+            {
+                break;
+            }
+        }
+        if (bEndOfInput)
+        {
+            end = size; // the last record may have no newline
+        }
+        partial.assign(buffer.begin() + static_cast<std::ptrdiff_t>(end),
+                       buffer.begin() + static_cast<std::ptrdiff_t>(size));
+        buffer[end] = '\0';
+        chunk->size = end;
+
+        {
+            std::lock_guard<std::mutex> lock(aPipeline.mutex);
+            aPipeline.toParse.push_back(std::move(chunk));
+            aPipeline.chunks = sequence;
+            aPipeline.bEndOfInput = bEndOfInput;
+        }
+        aPipeline.parserCondition.notify_one();
+    }
+    aPipeline.parserCondition.notify_all();
+    aPipeline.writerCondition.notify_all();
+}
+
+// Split the records of a chunk into fields in place, unquoted and terminated by a null character
+void parseChunk(Chunk& aChunk, const BulkImportOptions& aOptions, const size_t aColumnCount)
+{
+    const char delimiter = aOptions.delimiter;
+    const char quote = aOptions.quote;
+    char* p = aChunk.buffer.data();
+    char* const end = p + aChunk.size;
+    bool bHeader = aOptions.bHeader && (0 == aChunk.sequence);
+    aChunk.fields.reserve(aChunk.size / 8);
+    while (p < end)
+    {
+        // skip the empty lines
+        if ('\n' == *p)
+        {
+            ++p;
+            continue;
+        }
+        if (('\r' == *p) && (p + 1 < end) && ('\n' == p[1]))
+        {
+            p += 2;
+            continue;
+        }
+
+        const size_t first = aChunk.fields.size();
+        bool bEndOfRecord = false;
+        while (!bEndOfRecord)
+        {
+            char* const field = p;
+            char* out = p; // end of the field, once unquoted
+            const bool bQuoted = (quote == *p);
+            if (bQuoted)
+            {
+                ++p;
+                for (;;)
+                {
+                    if (p == end)
+                    {
+                        throw SQLite::Exception("unterminated quoted field in the input of the import");
+                    }
+                    if (quote != *p)
+                    {
+                        *out++ = *p++;
+                    }
+                    else if ((p + 1 < end) && (quote == p[1]))
+                    {
+                        *out++ = quote; // an escaped quote
+                        p += 2;
+                    }
+                    else
+                    {
+                        ++p;
+                        break;
+                    }
+                }
+                if ((p + 1 < end) && ('\r' == *p) && ('\n' == p[1]))
+                {
+                    ++p;
+                }
+                if ((p < end) && (delimiter != *p) && ('\n' != *p))
+                {
+                    throw SQLite::Exception("unexpected character after a quoted field in the input of the import");
+                }
+            }
+            else
+            {
+                while ((p < end) && (delimiter != *p) && ('\n' != *p))
+                {
+                    ++p;
+                }
+                out = p;
+                if ((out > field) && ('\r' == out[-1]) && ((p == end) || ('\n' == *p)))
+                {
+                    --out; // "\r\n" ends the record
+                }
+            }
+            bEndOfRecord = (p == end) || ('\n' == *p);
+            if (p < end)
+            {
+                ++p; // skip the delimiter or the newline
+            }
+            *out = '\0'; // overwrites the delimiter, the newline or the null character following the chunk
+            aChunk.fields.push_back((aOptions.bEmptyAsNull && !bQuoted && (out == field)) ? nullptr : field);
+        }
+
+        const size_t count = aChunk.fields.size() - first;
+        if (bHeader)
+        {
+            aChunk.fields.resize(first);
+            bHeader = false;
+        }
+        else if (count != aColumnCount)
+        {
+            throw SQLite::Exception("record of " + std::to_string(count) + " fields instead of " +
+                                    std::to_string(aColumnCount) + " in the input of the import");
+        }
+        else
+        {
+            ++aChunk.rows;
+        }
+    }
+}
+
+// Parse the chunks read, in any order, until the end of the input
+void parseChunks(const BulkImportOptions& aOptions, const size_t aColumnCount, Pipeline& aPipeline)
+{
+    double stall = 0.0;
+    for (;;)
+    {
+        std::unique_ptr<Chunk> chunk;
+        {
+            std::unique_lock<std::mutex> lock(aPipeline.mutex);
+            const Clock::time_point start = Clock::now();
+            aPipeline.parserCondition.wait(lock, [&aPipeline]
+            {
+                return aPipeline.bStop || !aPipeline.toParse.empty() || aPipeline.bEndOfInput;
+            });
+            stall += getSecondsSince(start);
+            if (aPipeline.bStop || aPipeline.toParse.empty())
+            {
+                aPipeline.parserStall += stall;
+                return;
+            }
+            chunk = std::move(aPipeline.toParse.front());
+            aPipeline.toParse.pop_front();
+        }
+
+        // an error is thrown by the writer after the records preceding it, as if they were parsed one by one
+        try
+        {
+            parseChunk(*chunk, aOptions, aColumnCount);
+        }
+        catch (...)
+        {
+            chunk->fields.resize(static_cast<size_t>(chunk->rows) * aColumnCount);
+            chunk->error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(aPipeline.mutex);
+            const uint64_t sequence = chunk->sequence;
+            aPipeline.parsed[sequence] = std::move(chunk);
+        }
+        aPipeline.writerCondition.notify_one();
+    }
+}
+
+/// Set "PRAGMA synchronous=OFF" and a larger page cache, restored at the end of the import
+class BulkPragmas
+{
+public:
+    BulkPragmas(Database& aDatabase, const bool abEnabled) :
+        mDatabase(aDatabase),
+        mbEnabled(abEnabled),
+        mSynchronous(0),
+        mCacheSize(0)
+    {
+        if (mbEnabled)
+        {
+            mSynchronous = mDatabase.execAndGet("PRAGMA synchronous").getInt();
+            mCacheSize = mDatabase.execAndGet("PRAGMA cache_size").getInt();
+            mDatabase.exec("PRAGMA synchronous=OFF");
+            mDatabase.exec("PRAGMA cache_size=-65536"); // 64 MiB
+        }
+    }
+
+    ~BulkPragmas()
+    {
+        if (mbEnabled)
+        {
+            std::error_code error; // ignored, as the destructor shall not throw
+            mDatabase.exec("PRAGMA synchronous=" + std::to_string(mSynchronous), error);
+            mDatabase.exec("PRAGMA cache_size=" + std::to_string(mCacheSize), error);
+        }
+    }
+
+private:
+    /// @{ BulkPragmas must be non-copyable
+    BulkPragmas(const BulkPragmas&);
+    BulkPragmas& operator=(const BulkPragmas&);
+    /// @}
+
+private:
+    Database&   mDatabase;      ///< Database Connection of the import
+    bool        mbEnabled;      ///< false to leave the pragmas unchanged
+    int         mSynchronous;   ///< Previous "PRAGMA synchronous"
+    int         mCacheSize;     ///< Previous "PRAGMA cache_size"
+};
+
+} // namespace
+
+
+// Prepare the insert statement of the imported rows
+BulkImporter::BulkImporter(Database&                        aDatabase,
+                           const std::string&               aTable,
+                           const std::vector<std::string>&  aColumns /* = std::vector<std::string>() */,
+                           const BulkImportOptions&         aOptions /* = BulkImportOptions() */) :
+    mDatabase(aDatabase),
+    mColumns(getColumns(aDatabase, aTable, aColumns)),
+    mInsert(aDatabase, getInsertQuery(aTable, mColumns)),
+    mOptions(aOptions)
+{
+    if (0 == mOptions.chunksInFlight)
+    {
+        mOptions.chunksInFlight = 1;
+    }
+    if (0 == mOptions.chunkSize)
+    {
+        mOptions.chunkSize = 1;
+    }
+    if (0 == mOptions.rowsPerTransaction)
+    {
+        mOptions.rowsPerTransaction = 1;
+    }
+}
+
+// Import a file
+BulkImportStats BulkImporter::importFile(const std::string& aFilename)
+{
+    std::ifstream input(aFilename.c_str(), std::ios::in | std::ios::binary);
+    if (!input.is_open())
+    {
+        throw SQLite::Exception("unable to open the file to import: " + aFilename);
+    }
+    return importStream(input);
+}
+
+// Import a stream: read by a thread, parsed by others, and written by the calling thread
+BulkImportStats BulkImporter::importStream(std::istream& aInput)
+{
+    const Clock::time_point start = Clock::now();
+    BulkPragmas pragmas(mDatabase, mOptions.bBulkPragmas);
+
+    size_t parsers = mOptions.parsers;
+    if (0 == parsers)
+    {
+        // keep a hardware thread for the reader and one for the writer
+        const size_t threads = std::thread::hardware_concurrency();
+        parsers = (threads > 3) ? (threads - 2) : 1;
+    }
+
+    Pipeline pipeline;
+    std::vector<std::thread> threads;
+    threads.reserve(parsers + 1);
+    try
+    {
+        threads.emplace_back([&aInput, &pipeline, this]
+        {
+            try
+            {
+                readChunks(aInput, mOptions, pipeline);
+            }
+            catch (...)
+            {
+                pipeline.fail(std::current_exception());
+            }
+        });
+        for (size_t i = 0; i < parsers; ++i)
+        {
+            threads.emplace_back([&pipeline, this]
+            {
+                try
+                {
+                    parseChunks(mOptions, mColumns.size(), pipeline);
+                }
+                catch (...)
+                {
+                    pipeline.fail(std::current_exception());
+                }
+            });
+        }
+    }
+    catch (...)
+    {
+        // a thread could not be started (std::system_error): stop those already running before throwing
+        pipeline.fail(std::current_exception());
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        throw;
+    }
+
+    // write the parsed chunks in their order in the input
+    uint64_t rows = 0;
+    try
+    {
+        const int columnCount = static_cast<int>(mColumns.size());
+        Transaction transaction(mDatabase);
+        size_t pending = 0; // rows of the transaction
+        for (uint64_t next = 0; ; ++next)
+        {
+            std::unique_ptr<Chunk> chunk;
+            {
+                std::unique_lock<std::mutex> lock(pipeline.mutex);
+                const Clock::time_point wait = Clock::now();
+                pipeline.writerCondition.wait(lock, [&pipeline, next]
+                {
+                    return pipeline.bStop || (pipeline.parsed.count(next) > 0) ||
+                           (pipeline.bEndOfInput && (pipeline.chunks == next));
+                });
+                pipeline.writerStall += getSecondsSince(wait);
+                const auto found = pipeline.parsed.find(next);
+                if (pipeline.bStop || (pipeline.parsed.end() == found))
+                {
+                    break;
+                }
+                chunk = std::move(found->second);
+                pipeline.parsed.erase(found);
+            }
+
+            const char* const* field = chunk->fields.data();
+            for (uint64_t row = 0; row < chunk->rows; ++row)
+            {
+                for (int column = 1; column <= columnCount; ++column, ++field)
+                {
+                    if (nullptr == *field)
+                    {
+                        mInsert.bind(column);
+                    }
+                    else
+                    {
+                        mInsert.bindNoCopy(column, *field);
+                    }
+                }
+                mInsert.exec();
+                mInsert.reset();
+                if (++pending == mOptions.rowsPerTransaction)
+                {
+                    transaction.commit();
+                    transaction = Transaction(mDatabase);
+                    pending = 0;
+                }
+            }
+            rows += chunk->rows;
+            if (chunk->error)
+            {
+                std::rethrow_exception(chunk->error);
+            }
+            chunk.reset(); // release the buffer, whose fields are bound no more
+
+            {
+                std::lock_guard<std::mutex> lock(pipeline.mutex);
+                --pipeline.inFlight;
+            }
+            pipeline.readerCondition.notify_one();
+        }
+
+        bool bStopped;
+        {
+            std::lock_guard<std::mutex> lock(pipeline.mutex);
+            bStopped = pipeline.bStop;
+        }
+        if (!bStopped)
+        {
+            transaction.commit();
+        }
+    }
+    catch (...)
+    {
+        pipeline.fail(std::current_exception());
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    // the fields bound no longer exist, and a failed insert leaves the statement to be reset
+    std::error_code error;
+    mInsert.reset(error);
+    mInsert.clearBindings(error);
+    if (pipeline.error)
+    {
+        std::rethrow_exception(pipeline.error);
+    }
+
+    BulkImportStats stats;
+    stats.rows = rows;
+    stats.bytes = pipeline.bytes;
+    stats.chunks = pipeline.chunks;
+    stats.seconds = getSecondsSince(start);
+    stats.readerStall = pipeline.readerStall;
+    stats.parserStall = pipeline.parserStall;
+    stats.writerStall = pipeline.writerStall;
+    return stats;
+}
+
+
+}  // namespace SQLite
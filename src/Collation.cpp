@@ -0,0 +1,138 @@
+/**
+ * @file    Collation.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Collating sequences implemented by C++ comparators, and built-in collations for common orders.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/Collation.h>
+
+#include <string.h>
+
+
+namespace SQLite
+{
+
+
+namespace
+{
+
+/// Return the byte folded to lower case if it is an ASCII upper case letter
+inline unsigned char toLowerAscii(const unsigned char aByte) noexcept // nothrow
+{
+    return ((aByte >= 'A') && (aByte <= 'Z')) ? static_cast<unsigned char>(aByte + ('a' - 'A')) : aByte;
+}
+
+/// true for an ASCII decimal digit
+inline bool isDigit(const char aByte) noexcept // nothrow
+{
+    return (aByte >= '0') && (aByte <= '9');
+}
+
+/// Compare two sizes, as the tie-break of texts with a common prefix
+inline int compareSizes(const size_t aLeftSize, const size_t aRightSize) noexcept // nothrow
+{
+    return (aLeftSize < aRightSize) ? -1 : ((aLeftSize > aRightSize) ? 1 : 0);
+}
+
+}  // namespace
+
+
+// Compare with the ASCII letters folded to lower case, then by size
+int AsciiNoCaseCollation::operator()(const char* apLeft, size_t aLeftSize,
+                                     const char* apRight, size_t aRightSize) const noexcept // nothrow
+{
+    const unsigned char* pLeft = reinterpret_cast<const unsigned char*>(apLeft);
+    const unsigned char* pRight = reinterpret_cast<const unsigned char*>(apRight);
+    const size_t size = (aLeftSize < aRightSize) ? aLeftSize : aRightSize;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (pLeft[i] != pRight[i])
+        {
+            const int left = toLowerAscii(pLeft[i]);
+            const int right = toLowerAscii(pRight[i]);
+            if (left != right)
+            {
+                return left - right;
+            }
+        }
+    }
+    return compareSizes(aLeftSize, aRightSize);
+}
+
+// Compare runs of digits by value (by number of significant digits, then digit by digit), other bytes as binary
+int NaturalCollation::operator()(const char* apLeft, size_t aLeftSize,
+                                 const char* apRight, size_t aRightSize) const noexcept // nothrow
+{
+    int leadingZeros = 0; // tie-break of the first equal numbers written with different numbers of leading zeros
+    size_t left = 0;
+    size_t right = 0;
+    while ((left < aLeftSize) && (right < aRightSize))
+    {
+        if (isDigit(apLeft[left]) && isDigit(apRight[right]))
+        {
+            size_t leftStart = left;
+            size_t rightStart = right;
+            while ((leftStart < aLeftSize) && ('0' == apLeft[leftStart]))
+            {
+                ++leftStart;
+            }
+            while ((rightStart < aRightSize) && ('0' == apRight[rightStart]))
+            {
+                ++rightStart;
+            }
+            size_t leftEnd = leftStart;
+            size_t rightEnd = rightStart;
+            while ((leftEnd < aLeftSize) && isDigit(apLeft[leftEnd]))
+            {
+                ++leftEnd;
+            }
+            while ((rightEnd < aRightSize) && isDigit(apRight[rightEnd]))
+            {
+                ++rightEnd;
+            }
+            const int digits = compareSizes(leftEnd - leftStart, rightEnd - rightStart);
+            if (0 != digits)
+            {
+                return digits;
+            }
+            const int value = memcmp(apLeft + leftStart, apRight + rightStart, leftEnd - leftStart);
+            if (0 != value)
+            {
+                return value;
+            }
+            if (0 == leadingZeros)
+            {
+                leadingZeros = compareSizes(leftStart - left, rightStart - right);
+            }
+            left = leftEnd;
+            right = rightEnd;
+        }
+        else if (apLeft[left] != apRight[right])
+        {
+            return static_cast<unsigned char>(apLeft[left]) - static_cast<unsigned char>(apRight[right]);
+        }
+        else
+        {
+            ++left;
+            ++right;
+        }
+    }
+    const int rest = compareSizes(aLeftSize - left, aRightSize - right);
+    return (0 != rest) ? rest : leadingZeros;
+}
+
+// Compare byte per byte, then by size
+int Utf8BinaryCollation::operator()(const char* apLeft, size_t aLeftSize,
+                                    const char* apRight, size_t aRightSize) const noexcept // nothrow
+{
+    const size_t size = (aLeftSize < aRightSize) ? aLeftSize : aRightSize;
+    const int comparison = (size > 0) ? memcmp(apLeft, apRight, size) : 0;
+    return (0 != comparison) ? comparison : compareSizes(aLeftSize, aRightSize);
+}
+
+
+}  // namespace SQLite
@@ -12,11 +12,15 @@
 
 #include <SQLiteCpp/Statement.h>
 #include <SQLiteCpp/Assertion.h>
+#include <SQLiteCpp/Errors.h>
 #include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/VirtualTable.h>
 
 #include <sqlite3.h>
+#include <algorithm>
 #include <fstream>
 #include <string.h>
+#include <utility>
 
 #ifndef SQLITE_DETERMINISTIC
 #define SQLITE_DETERMINISTIC 0x800
@@ -30,6 +34,10 @@ const int   OPEN_READONLY   = SQLITE_OPEN_READONLY;
 const int   OPEN_READWRITE  = SQLITE_OPEN_READWRITE;
 const int   OPEN_CREATE     = SQLITE_OPEN_CREATE;
 const int   OPEN_URI        = SQLITE_OPEN_URI;
+const int   OPEN_NOMUTEX    = SQLITE_OPEN_NOMUTEX;
+const int   OPEN_FULLMUTEX  = SQLITE_OPEN_FULLMUTEX;
+const int   OPEN_SHAREDCACHE    = SQLITE_OPEN_SHAREDCACHE;
+const int   OPEN_PRIVATECACHE   = SQLITE_OPEN_PRIVATECACHE;
 
 const int   OK              = SQLITE_OK;
 
@@ -49,13 +57,35 @@ int getLibVersionNumber() noexcept // nothrow
 }
 
 
+// Lookaside configuration of a connection not set by setLookaside(): the default of the library, unknown
+static const LookasideConfig UNKNOWN_LOOKASIDE = { -1, -1 };
+
+// Compute the activity between two samples of the statistics of a Database Connection.
+DatabaseStats operator-(const DatabaseStats& aAfter, const DatabaseStats& aBefore) noexcept // nothrow
+{
+    DatabaseStats delta = aAfter;
+    delta.cacheHit -= aBefore.cacheHit;
+    delta.cacheMiss -= aBefore.cacheMiss;
+    delta.cacheWrite -= aBefore.cacheWrite;
+    delta.lookasideHit -= aBefore.lookasideHit;
+    delta.lookasideMissSize -= aBefore.lookasideMissSize;
+    delta.lookasideMissFull -= aBefore.lookasideMissFull;
+    return delta;
+}
+
+
 // Open the provided database UTF-8 filename with SQLite::OPEN_xxx provided flags.
 Database::Database(const char* apFilename,
                    const int   aFlags         /* = SQLite::OPEN_READONLY*/,
                    const int   aBusyTimeoutMs /* = 0 */,
                    const char* apVfs          /* = nullptr*/) :
     mpSQLite(nullptr),
-    mFilename(apFilename)
+    mFilename(apFilename),
+    mpProfiler(),
+    mpSchema(),
+    mLookaside(UNKNOWN_LOOKASIDE),
+    mOwnerThread(std::this_thread::get_id()),
+    mbMutex(true)
 {
     const int ret = sqlite3_open_v2(apFilename, &mpSQLite, aFlags, apVfs);
     if (SQLITE_OK != ret)
@@ -64,6 +94,7 @@ Database::Database(const char* apFilename,
         sqlite3_close(mpSQLite); // close is required even in case of error on opening
         throw exception;
     }
+    mbMutex = (nullptr != sqlite3_db_mutex(mpSQLite)); // none with OPEN_NOMUTEX or in multi-thread mode
     if (aBusyTimeoutMs > 0)
     {
         setBusyTimeout(aBusyTimeoutMs);
@@ -76,7 +107,12 @@ Database::Database(const std::string& aFilename,
                    const int          aBusyTimeoutMs /* = 0 */,
                    const std::string& aVfs           /* = "" */) :
     mpSQLite(nullptr),
-    mFilename(aFilename)
+    mFilename(aFilename),
+    mpProfiler(),
+    mpSchema(),
+    mLookaside(UNKNOWN_LOOKASIDE),
+    mOwnerThread(std::this_thread::get_id()),
+    mbMutex(true)
 {
     const int ret = sqlite3_open_v2(aFilename.c_str(), &mpSQLite, aFlags, aVfs.empty() ? nullptr : aVfs.c_str());
     if (SQLITE_OK != ret)
@@ -85,16 +121,56 @@ Database::Database(const std::string& aFilename,
         sqlite3_close(mpSQLite); // close is required even in case of error on opening
         throw exception;
     }
+    mbMutex = (nullptr != sqlite3_db_mutex(mpSQLite)); // none with OPEN_NOMUTEX or in multi-thread mode
     if (aBusyTimeoutMs > 0)
     {
         setBusyTimeout(aBusyTimeoutMs);
     }
 }
 
+// Move the connection to a new Database object
+Database::Database(Database&& aDatabase) noexcept : // nothrow
+    mpSQLite(aDatabase.mpSQLite),
+    mFilename(std::move(aDatabase.mFilename)),
+    mpProfiler(std::move(aDatabase.mpProfiler)),
+    mpSchema(std::move(aDatabase.mpSchema)),
+    mLookaside(aDatabase.mLookaside),
+    mOwnerThread(aDatabase.mOwnerThread),
+    mbMutex(aDatabase.mbMutex)
+{
+    aDatabase.mpSQLite = nullptr;
+}
+
+// Close the SQLite database connection, then move the other one here
+Database& Database::operator=(Database&& aDatabase) noexcept // nothrow
+{
+    if (this != &aDatabase)
+    {
+        close();
+        mpSQLite = aDatabase.mpSQLite;
+        mFilename = std::move(aDatabase.mFilename);
+        mpProfiler = std::move(aDatabase.mpProfiler); // the previous Profiler is deleted after its connection
+        mpSchema = std::move(aDatabase.mpSchema);
+        mLookaside = aDatabase.mLookaside;
+        mOwnerThread = aDatabase.mOwnerThread;
+        mbMutex = aDatabase.mbMutex;
+        aDatabase.mpSQLite = nullptr;
+    }
+    return *this;
+}
+
 // Close the SQLite database connection.
 Database::~Database()
 {
+    close();
+}
+
+// Close the SQLite database connection, if not moved to another Database object
+void Database::close() noexcept
+{
+    mpSchema.reset(); // finalize its statement before closing the connection
     const int ret = sqlite3_close(mpSQLite);
+    mpSQLite = nullptr;
 
     // Avoid unreferenced variable warning when build in release mode
     (void) ret;
@@ -126,6 +202,7 @@ void Database::setBusyTimeout(const int aBusyTimeoutMs)
 // Shortcut to execute one or multiple SQL statements without results (UPDATE, INSERT, ALTER, COMMIT, CREATE...).
 int Database::exec(const char* apQueries)
 {
+    checkOwnership();
     const int ret = sqlite3_exec(mpSQLite, apQueries, nullptr, nullptr, nullptr);
     check(ret);
 
@@ -133,6 +210,14 @@ int Database::exec(const char* apQueries)
     return sqlite3_changes(mpSQLite);
 }
 
+// Execute one or multiple statements without results, setting an error code instead of throwing an exception
+int Database::exec(const char* apQueries, std::error_code& aError) noexcept
+{
+    checkOwnership();
+    aError = to_error_code(sqlite3_exec(mpSQLite, apQueries, nullptr, nullptr, nullptr));
+    return aError ? 0 : sqlite3_changes(mpSQLite);
+}
+
 // Shortcut to execute a one step query and fetch the first column of the result.
 // WARNING: Be very careful with this dangerous method: you have to
 // make a COPY OF THE result, else it will be destroy before the next line
@@ -149,10 +234,17 @@ Column Database::execAndGet(const char* apQuery)
 // Shortcut to test if a table exists.
 bool Database::tableExists(const char* apTableName)
 {
-    Statement query(*this, "SELECT count(*) FROM sqlite_master WHERE type='table' AND name=?");
-    query.bind(1, apTableName);
-    (void)query.executeStep(); // Cannot return false, as the above query always return a result
-    return (1 == query.getColumn(0).getInt());
+    return getSchema().tableExists(apTableName);
+}
+
+// Return the catalog of the schema, created on first use
+Schema& Database::getSchema()
+{
+    if (!mpSchema)
+    {
+        mpSchema.reset(new Schema(mpSQLite));
+    }
+    return *mpSchema;
 }
 
 // Get the rowid of the most recent successful INSERT into the database from the current connection.
@@ -167,6 +259,12 @@ int Database::getTotalChanges() const noexcept // nothrow
     return sqlite3_total_changes(mpSQLite);
 }
 
+// Interrupt the statements running on the connection, from any thread
+void Database::interrupt() noexcept // nothrow
+{
+    sqlite3_interrupt(mpSQLite);
+}
+
 // Return the numeric result code for the most recent failed API call (if any).
 int Database::getErrorCode() const noexcept // nothrow
 {
@@ -206,6 +304,38 @@ void Database::createFunction(const char*   apFuncName,
     check(ret);
 }
 
+// Create or redefine a collating sequence, destroying the user data if the creation fails
+void Database::createCollation(const char*  apCollationName,
+                               void*        apApp,
+                               int        (*apCompare)(void*, int, const void*, int, const void*),
+                               void       (*apDestroy)(void*))
+{
+    const int ret = sqlite3_create_collation_v2(mpSQLite, apCollationName, SQLITE_UTF8,
+                                                apApp, apCompare, apDestroy);
+    if ((SQLITE_OK != ret) && (nullptr != apDestroy))
+    {
+        // Note: unlike sqlite3_create_function_v2(), the destructor is not called by SQLite on error
+        apDestroy(apApp);
+    }
+    check(ret);
+}
+
+// Register a C++ table as an eponymous virtual table, after sorting its indexes
+void Database::createModule(const char* apModuleName, VirtualTableBase& aTable)
+{
+    aTable.refresh();
+    const int ret = sqlite3_create_module_v2(mpSQLite, apModuleName, VirtualTableBase::getModule(), &aTable, nullptr);
+    check(ret);
+}
+
+// Register a table-valued function as an eponymous virtual table, deleted by the connection
+void Database::createTableFunction(const char* apFuncName, detail::TableFunctionBase* apFunction)
+{
+    const int ret = sqlite3_create_module_v2(mpSQLite, apFuncName, detail::TableFunctionBase::getModule(),
+                                             apFunction, &detail::TableFunctionBase::destroy);
+    check(ret);
+}
+
 // Load an extension into the sqlite database. Only affects the current connection.
 // Parameter details can be found here: http://www.sqlite.org/c3ref/load_extension.html
 void Database::loadExtension(const char* apExtensionName, const char *apEntryPointName)
@@ -290,4 +420,121 @@ bool Database::isUnencrypted(const std::string& aFilename)
     throw exception;
 }
 
+// Start aggregating the execution times of all statements of the connection.
+void Database::enableProfiling(const long long aSlowThresholdNs /* = 0 */, const int aMaxStatements /* = 512 */)
+{
+    const uint64_t slowThresholdNs = (aSlowThresholdNs > 0) ? static_cast<uint64_t>(aSlowThresholdNs) : 0;
+    if (!mpProfiler)
+    {
+        mpProfiler.reset(new Profiler(slowThresholdNs, (aMaxStatements > 0) ? aMaxStatements : 1));
+    }
+    else
+    {
+        mpProfiler->setSlowThreshold(slowThresholdNs);
+    }
+    const int ret = sqlite3_trace_v2(mpSQLite, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW,
+                                     &Profiler::trace, mpProfiler.get());
+    check(ret);
+}
+
+// Stop aggregating the execution times of the statements, keeping the statistics gathered so far.
+void Database::disableProfiling()
+{
+    const int ret = sqlite3_trace_v2(mpSQLite, 0, nullptr, nullptr);
+    check(ret);
+}
+
+// Return the execution statistics of all statements, gathered since enableProfiling() or the last reset.
+std::vector<StatementProfile> Database::getProfile(const bool abReset /* = false */)
+{
+    if (!mpProfiler)
+    {
+        return std::vector<StatementProfile>();
+    }
+    return mpProfiler->getProfile(abReset);
+}
+
+// Return the resource usage statistics of the connection, from sqlite3_db_status().
+DatabaseStats Database::getStats(const bool abReset /* = false */) const
+{
+    struct Status
+    {
+        int     op;         // SQLITE_DBSTATUS_xxx
+        int*    pCurrent;   // Where to store the current value (or nullptr)
+        int*    pHighwater; // Where to store the highwater mark (or nullptr)
+    };
+    DatabaseStats stats;
+    int unused = 0;
+    // NOTE: the lookaside hit and miss counters are reported in the highwater mark, their current value is always 0
+    const Status statuses[] = {
+        { SQLITE_DBSTATUS_CACHE_HIT,            &stats.cacheHit,        nullptr },
+        { SQLITE_DBSTATUS_CACHE_MISS,           &stats.cacheMiss,       nullptr },
+        { SQLITE_DBSTATUS_CACHE_WRITE,          &stats.cacheWrite,      nullptr },
+        { SQLITE_DBSTATUS_CACHE_USED,           &stats.cacheUsed,       nullptr },
+        { SQLITE_DBSTATUS_CACHE_USED_SHARED,    &stats.cacheUsedShared, nullptr },
+        { SQLITE_DBSTATUS_LOOKASIDE_USED,       &stats.lookasideUsed,   &stats.lookasideHighwater },
+        { SQLITE_DBSTATUS_LOOKASIDE_HIT,        nullptr,                &stats.lookasideHit },
+        { SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE,  nullptr,                &stats.lookasideMissSize },
+        { SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL,  nullptr,                &stats.lookasideMissFull },
+        { SQLITE_DBSTATUS_SCHEMA_USED,          &stats.schemaUsed,      nullptr },
+        { SQLITE_DBSTATUS_STMT_USED,            &stats.stmtUsed,        nullptr },
+        { SQLITE_DBSTATUS_DEFERRED_FKS,         &stats.deferredFks,     nullptr }
+    };
+    for (size_t i = 0; i < sizeof(statuses) / sizeof(statuses[0]); ++i)
+    {
+        int current = 0;
+        int highwater = 0;
+        const int ret = sqlite3_db_status(mpSQLite, statuses[i].op, &current, &highwater, abReset ? 1 : 0);
+        check(ret);
+        *(statuses[i].pCurrent ? statuses[i].pCurrent : &unused) = current;
+        *(statuses[i].pHighwater ? statuses[i].pHighwater : &unused) = highwater;
+    }
+    return stats;
+}
+
+// Configure the lookaside memory allocator of the connection, with SQLITE_DBCONFIG_LOOKASIDE.
+void Database::setLookaside(const int aSlotSize, const int aSlotCount, void* apBuffer /* = nullptr */)
+{
+    const int ret = sqlite3_db_config(mpSQLite, SQLITE_DBCONFIG_LOOKASIDE, apBuffer, aSlotSize, aSlotCount);
+    check(ret);
+    mLookaside.slotSize = aSlotSize & ~7;
+    mLookaside.slotCount = aSlotCount;
+}
+
+// Recommend a lookaside configuration from the statistics of the connection after a warm-up.
+LookasideConfig Database::adviseLookaside(const DatabaseStats& aStats) const noexcept // nothrow
+{
+    LookasideConfig advice = mLookaside;
+    const long long requests = static_cast<long long>(aStats.lookasideHit)
+                             + aStats.lookasideMissSize + aStats.lookasideMissFull;
+    if ((requests <= 0) || !advice.isKnown() || (0 == advice.slotSize) || (0 == advice.slotCount))
+    {
+        return advice;
+    }
+    // Too many requests larger than a slot: grow the slots by half (SQLite caps them to 65528 bytes)
+    if (aStats.lookasideMissSize * 20LL > requests)
+    {
+        advice.slotSize = std::min((advice.slotSize + advice.slotSize / 2 + 7) & ~7, 65528);
+    }
+    // Too many requests while all slots were in use: double them, else shrink them to the observed peak plus 25%
+    if (aStats.lookasideMissFull * 100LL > requests)
+    {
+        advice.slotCount *= 2;
+    }
+    else if ((0 == aStats.lookasideMissFull) && (aStats.lookasideHighwater * 2 < advice.slotCount))
+    {
+        advice.slotCount = std::max(aStats.lookasideHighwater + aStats.lookasideHighwater / 4, 8);
+    }
+    return advice;
+}
+
+// Forget the execution statistics gathered so far.
+void Database::resetProfile() noexcept // nothrow
+{
+    if (mpProfiler)
+    {
+        mpProfiler->reset();
+    }
+}
+
 }  // namespace SQLite
@@ -64,4 +64,20 @@ const char* Exception::getErrorStr() const noexcept // nothrow
 }
 
 
+// Exception of an interrupted statement
+InterruptedException::InterruptedException(sqlite3* apSQLite, int ret) :
+    Exception(apSQLite, ret)
+{
+}
+
+// Throw the exception of a failed function call, of a distinct type for an interruption
+void throwException(sqlite3* apSQLite, int ret)
+{
+    if (SQLITE_INTERRUPT == ret)
+    {
+        throw SQLite::InterruptedException(apSQLite, ret);
+    }
+    throw SQLite::Exception(apSQLite, ret);
+}
+
 }  // namespace SQLite
@@ -0,0 +1,208 @@
+/**
+ * @file    Function.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Conversions between SQL values and C++ types for the SQL functions and aggregates created from C++.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/Function.h>
+
+#include <sqlite3.h>
+
+
+namespace SQLite
+{
+namespace detail
+{
+
+
+// Return true if the SQL value is NULL
+bool isNull(sqlite3_value* apValue) noexcept // nothrow
+{
+    return (SQLITE_NULL == sqlite3_value_type(apValue));
+}
+
+// Return the SQL value as an int
+int getValue(sqlite3_value* apValue, Type<int>) noexcept // nothrow
+{
+    return sqlite3_value_int(apValue);
+}
+
+// Return the SQL value as an unsigned int
+unsigned int getValue(sqlite3_value* apValue, Type<unsigned int>) noexcept // nothrow
+{
+    return static_cast<unsigned int>(sqlite3_value_int64(apValue));
+}
+
+// Return the SQL value as a long
+long getValue(sqlite3_value* apValue, Type<long>) noexcept // nothrow
+{
+    return static_cast<long>(sqlite3_value_int64(apValue));
+}
+
+// Return the SQL value as a long long
+long long getValue(sqlite3_value* apValue, Type<long long>) noexcept // nothrow
+{
+    return sqlite3_value_int64(apValue);
+}
+
+// Return the SQL value as an unsigned long
+unsigned long getValue(sqlite3_value* apValue, Type<unsigned long>) noexcept // nothrow
+{
+    return static_cast<unsigned long>(sqlite3_value_int64(apValue));
+}
+
+// Return the SQL value as an unsigned long long
+unsigned long long getValue(sqlite3_value* apValue, Type<unsigned long long>) noexcept // nothrow
+{
+    return static_cast<unsigned long long>(sqlite3_value_int64(apValue));
+}
+
+// Return the SQL value as a double
+double getValue(sqlite3_value* apValue, Type<double>) noexcept // nothrow
+{
+    return sqlite3_value_double(apValue);
+}
+
+// Return the SQL value as a bool
+bool getValue(sqlite3_value* apValue, Type<bool>) noexcept // nothrow
+{
+    return (0 != sqlite3_value_int64(apValue));
+}
+
+// Return the SQL value as a UTF-8 text, valid until the function returns (empty string for NULL)
+const char* getValue(sqlite3_value* apValue, Type<const char*>) noexcept // nothrow
+{
+    const char* pText = reinterpret_cast<const char*>(sqlite3_value_text(apValue));
+    return (nullptr != pText) ? pText : "";
+}
+
+// Return the SQL value as a copy of its UTF-8 text (empty string for NULL)
+std::string getValue(sqlite3_value* apValue, Type<std::string>)
+{
+    // Note: sqlite3_value_text() must be called before sqlite3_value_bytes() to get the size of the UTF-8 text
+    const char* pText = reinterpret_cast<const char*>(sqlite3_value_text(apValue));
+    return (nullptr != pText) ? std::string(pText, static_cast<size_t>(sqlite3_value_bytes(apValue))) : std::string();
+}
+
+// Set a NULL result
+void setResult(sqlite3_context* apContext, std::nullptr_t) noexcept // nothrow
+{
+    sqlite3_result_null(apContext);
+}
+
+// Set an int result
+void setResult(sqlite3_context* apContext, int aResult) noexcept // nothrow
+{
+    sqlite3_result_int(apContext, aResult);
+}
+
+// Set an unsigned int result
+void setResult(sqlite3_context* apContext, unsigned int aResult) noexcept // nothrow
+{
+    sqlite3_result_int64(apContext, static_cast<sqlite3_int64>(aResult));
+}
+
+// Set a long result
+void setResult(sqlite3_context* apContext, long aResult) noexcept // nothrow
+{
+    sqlite3_result_int64(apContext, static_cast<sqlite3_int64>(aResult));
+}
+
+// Set a long long result
+void setResult(sqlite3_context* apContext, long long aResult) noexcept // nothrow
+{
+    sqlite3_result_int64(apContext, aResult);
+}
+
+// Set an unsigned long result, stored as a signed 64 bits integer
+void setResult(sqlite3_context* apContext, unsigned long aResult) noexcept // nothrow
+{
+    sqlite3_result_int64(apContext, static_cast<sqlite3_int64>(aResult));
+}
+
+// Set an unsigned long long result, stored as a signed 64 bits integer
+void setResult(sqlite3_context* apContext, unsigned long long aResult) noexcept // nothrow
+{
+    sqlite3_result_int64(apContext, static_cast<sqlite3_int64>(aResult));
+}
+
+// Set a double result
+void setResult(sqlite3_context* apContext, double aResult) noexcept // nothrow
+{
+    sqlite3_result_double(apContext, aResult);
+}
+
+// Set a bool result, as 0 or 1
+void setResult(sqlite3_context* apContext, bool aResult) noexcept // nothrow
+{
+    sqlite3_result_int(apContext, aResult ? 1 : 0);
+}
+
+// Set a copy of a UTF-8 text as result (NULL for a null pointer)
+void setResult(sqlite3_context* apContext, const char* apResult) noexcept // nothrow
+{
+    if (nullptr != apResult)
+    {
+        sqlite3_result_text(apContext, apResult, -1, SQLITE_TRANSIENT);
+    }
+    else
+    {
+        sqlite3_result_null(apContext);
+    }
+}
+
+// Set a copy of a UTF-8 text as result
+void setResult(sqlite3_context* apContext, const std::string& aResult) noexcept // nothrow
+{
+    sqlite3_result_text64(apContext, aResult.data(), aResult.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+}
+
+#ifdef SQLITECPP_HAVE_STD_OPTIONAL
+// Return the SQL value as a view of its UTF-8 text, valid until the function returns (empty for NULL)
+std::string_view getValue(sqlite3_value* apValue, Type<std::string_view>) noexcept // nothrow
+{
+    const char* pText = reinterpret_cast<const char*>(sqlite3_value_text(apValue));
+    return (nullptr != pText) ? std::string_view(pText, static_cast<size_t>(sqlite3_value_bytes(apValue)))
+                              : std::string_view();
+}
+
+// Set a copy of a UTF-8 text as result
+void setResult(sqlite3_context* apContext, std::string_view aResult) noexcept // nothrow
+{
+    // Note: an empty view can have a null pointer, which would be a NULL result
+    const char* pText = (nullptr != aResult.data()) ? aResult.data() : "";
+    sqlite3_result_text64(apContext, pText, aResult.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+}
+#endif
+
+// Report the message of an exception as the error of the SQL statement
+void setError(sqlite3_context* apContext, const char* apMessage) noexcept // nothrow
+{
+    sqlite3_result_error(apContext, apMessage, -1);
+}
+
+// Report an out of memory error
+void setErrorNoMemory(sqlite3_context* apContext) noexcept // nothrow
+{
+    sqlite3_result_error_nomem(apContext);
+}
+
+// Return the user data of the SQL function, that is its C++ callable
+void* getUserData(sqlite3_context* apContext) noexcept // nothrow
+{
+    return sqlite3_user_data(apContext);
+}
+
+// Return the memory of the aggregate context of the current group, allocated and zeroed on the first call
+void* getAggregateContext(sqlite3_context* apContext, const int aSize) noexcept // nothrow
+{
+    return sqlite3_aggregate_context(apContext, aSize);
+}
+
+
+}  // namespace detail
+}  // namespace SQLite
@@ -0,0 +1,103 @@
+/**
+ * @file    Interrupt.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Deadlines and cancellation of the queries of a Database Connection.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/Interrupt.h>
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+
+
+namespace SQLite
+{
+
+
+// Create a token not cancelled yet
+CancellationToken::CancellationToken() :
+    mpCancelled(std::make_shared<std::atomic<bool> >(false))
+{
+}
+
+
+// Interrupt the queries running longer than a timeout from now
+QueryGuard::QueryGuard(Database& aDatabase, const std::chrono::steady_clock::duration aTimeout,
+                       const int aNbSteps) :
+    mDatabase(aDatabase),
+    mDeadline(std::chrono::steady_clock::now() + aTimeout),
+    mToken()
+{
+    install(aNbSteps);
+}
+
+// Interrupt the queries running past a deadline
+QueryGuard::QueryGuard(Database& aDatabase, const std::chrono::steady_clock::time_point aDeadline,
+                       const int aNbSteps) :
+    mDatabase(aDatabase),
+    mDeadline(aDeadline),
+    mToken()
+{
+    install(aNbSteps);
+}
+
+// Interrupt the queries when a token is cancelled
+QueryGuard::QueryGuard(Database& aDatabase, const CancellationToken& aToken, const int aNbSteps) :
+    mDatabase(aDatabase),
+    mDeadline(std::chrono::steady_clock::time_point::max()),
+    mToken(aToken)
+{
+    install(aNbSteps);
+}
+
+// Interrupt the queries running longer than a timeout, or when a token is cancelled
+QueryGuard::QueryGuard(Database& aDatabase, const std::chrono::steady_clock::duration aTimeout,
+                       const CancellationToken& aToken, const int aNbSteps) :
+    mDatabase(aDatabase),
+    mDeadline(std::chrono::steady_clock::now() + aTimeout),
+    mToken(aToken)
+{
+    install(aNbSteps);
+}
+
+// Interrupt the queries running past a deadline, or when a token is cancelled
+QueryGuard::QueryGuard(Database& aDatabase, const std::chrono::steady_clock::time_point aDeadline,
+                       const CancellationToken& aToken, const int aNbSteps) :
+    mDatabase(aDatabase),
+    mDeadline(aDeadline),
+    mToken(aToken)
+{
+    install(aNbSteps);
+}
+
+// Remove the progress handler of the connection
+QueryGuard::~QueryGuard()
+{
+    sqlite3_progress_handler(mDatabase.getHandle(), 0, nullptr, nullptr);
+}
+
+// Install the progress handler of the connection
+void QueryGuard::install(const int aNbSteps)
+{
+    if (aNbSteps <= 0)
+    {
+        throw SQLite::Exception("a QueryGuard needs a positive number of steps between two checks");
+    }
+    sqlite3_progress_handler(mDatabase.getHandle(), aNbSteps, &QueryGuard::onProgress, this);
+}
+
+// Check the token first, then the clock, every N instructions of the virtual machine
+int QueryGuard::onProgress(void* apGuard) noexcept // nothrow
+{
+    const QueryGuard& guard = *static_cast<const QueryGuard*>(apGuard);
+    return (guard.isCancelled() || guard.isExpired()) ? 1 : 0;
+}
+
+
+}  // namespace SQLite
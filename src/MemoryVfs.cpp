@@ -0,0 +1,641 @@
+/**
+ * @file    MemoryVfs.cpp
+ * @ingroup SQLiteCpp
+ * @brief   In-process memory VFS, sharing named in-memory databases between the connections of a process.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/MemoryVfs.h>
+
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SQLite
+{
+
+const char* const MEMORY_VFS_NAME = "sqlitecpp-memory";
+
+namespace
+{
+
+const size_t CHUNK_SIZE = 64 * 1024;    // Files are stored in chunks of this size
+const int SHM_LOCK_COUNT = 8;           // SQLITE_SHM_NLOCK
+
+// Content, locks and shared memory of a file, shared by all its handles
+struct MemFile
+{
+    MemFile() :
+        size(0), openCount(0), bDeleted(false), sharedCount(0), bReserved(false), bPending(false),
+        bExclusive(false), shmRefs(0)
+    {
+        for (int i = 0; i < SHM_LOCK_COUNT; ++i)
+        {
+            shmShared[i] = 0;
+            shmExclusive[i] = false;
+        }
+    }
+    ~MemFile()
+    {
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            std::free(chunks[i]);
+        }
+        freeShm();
+    }
+    void freeShm()
+    {
+        for (size_t i = 0; i < shmRegions.size(); ++i)
+        {
+            std::free(shmRegions[i]);
+        }
+        shmRegions.clear();
+    }
+
+    std::mutex          mutex;          // Protect everything below but openCount and bDeleted
+    std::vector<char*>  chunks;
+    sqlite3_int64       size;
+    int                 openCount;      // Number of handles, protected by the registry mutex
+    bool                bDeleted;       // Removed from the registry, freed on last close
+    int                 sharedCount;    // Handles holding a SHARED lock or more
+    bool                bReserved;
+    bool                bPending;
+    bool                bExclusive;
+    std::vector<char*>  shmRegions;
+    int                 shmRefs;        // Handles having mapped the shared memory
+    int                 shmShared[SHM_LOCK_COUNT];
+    bool                shmExclusive[SHM_LOCK_COUNT];
+};
+
+// The sqlite3_file of a handle opened on a MemFile
+struct MemHandle
+{
+    sqlite3_file    base;
+    MemFile*        pFile;
+    const char*     pName;          // Key of the file in the registry (owned by the registry)
+    int             lock;           // SQLITE_LOCK_xxx held by this handle
+    bool            bReserved;      // This handle holds the RESERVED lock
+    bool            bDeleteOnClose;
+    bool            bShmMapped;
+    unsigned        shmSharedMask;  // Shared memory locks held by this handle
+    unsigned        shmExclusiveMask;
+};
+
+typedef std::map<std::string, MemFile*> Registry;
+
+std::mutex              gRegistryMutex;
+Registry                gRegistry;
+std::atomic<unsigned>   gTempCount(0);
+sqlite3_vfs             gVfs;
+std::mutex              gRegisterMutex;
+bool                    gbRegistered = false;
+
+inline MemHandle* getHandle(sqlite3_file* apFile)
+{
+    return reinterpret_cast<MemHandle*>(apFile);
+}
+
+inline sqlite3_vfs* getDefaultVfs(sqlite3_vfs* apVfs)
+{
+    return static_cast<sqlite3_vfs*>(apVfs->pAppData);
+}
+
+// Remove a file from the registry, and free it if no handle uses it, with the registry mutex held
+void removeFile(Registry::iterator aIt)
+{
+    MemFile* pFile = aIt->second;
+    gRegistry.erase(aIt);
+    if (0 == pFile->openCount)
+    {
+        delete pFile;
+    }
+    else
+    {
+        pFile->bDeleted = true;
+    }
+}
+
+int memClose(sqlite3_file* apFile)
+{
+    MemHandle* pHandle = getHandle(apFile);
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    MemFile* pFile = pHandle->pFile;
+    --pFile->openCount;
+    if (pHandle->bDeleteOnClose && !pFile->bDeleted)
+    {
+        Registry::iterator it = gRegistry.find(pHandle->pName);
+        if ((gRegistry.end() != it) && (pFile == it->second))
+        {
+            removeFile(it);
+            return SQLITE_OK;
+        }
+    }
+    if (pFile->bDeleted && (0 == pFile->openCount))
+    {
+        delete pFile;
+    }
+    return SQLITE_OK;
+}
+
+int memRead(sqlite3_file* apFile, void* apBuffer, int aAmount, sqlite3_int64 aOffset)
+{
+    MemFile* pFile = getHandle(apFile)->pFile;
+    char* pOut = static_cast<char*>(apBuffer);
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    const sqlite3_int64 available = pFile->size - aOffset;
+    const int amount = (available < aAmount) ? ((available > 0) ? static_cast<int>(available) : 0) : aAmount;
+    int done = 0;
+    while (done < amount)
+    {
+        const sqlite3_int64 position = aOffset + done;
+        const size_t inChunk = static_cast<size_t>(position % CHUNK_SIZE);
+        const size_t count = std::min(CHUNK_SIZE - inChunk, static_cast<size_t>(amount - done));
+        std::memcpy(pOut + done, pFile->chunks[static_cast<size_t>(position / CHUNK_SIZE)] + inChunk, count);
+        done += static_cast<int>(count);
+    }
+    if (amount < aAmount)
+    {
+        std::memset(pOut + amount, 0, static_cast<size_t>(aAmount - amount));
+        return SQLITE_IOERR_SHORT_READ;
+    }
+    return SQLITE_OK;
+}
+
+int memWrite(sqlite3_file* apFile, const void* apBuffer, int aAmount, sqlite3_int64 aOffset)
+{
+    MemFile* pFile = getHandle(apFile)->pFile;
+    const char* pIn = static_cast<const char*>(apBuffer);
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    const sqlite3_int64 end = aOffset + aAmount;
+    while (static_cast<sqlite3_int64>(pFile->chunks.size() * CHUNK_SIZE) < end)
+    {
+        char* pChunk = static_cast<char*>(std::calloc(1, CHUNK_SIZE));
+        if (nullptr == pChunk)
+        {
+            return SQLITE_IOERR_NOMEM;
+        }
+        pFile->chunks.push_back(pChunk);
+    }
+    int done = 0;
+    while (done < aAmount)
+    {
+        const sqlite3_int64 position = aOffset + done;
+        const size_t inChunk = static_cast<size_t>(position % CHUNK_SIZE);
+        const size_t count = std::min(CHUNK_SIZE - inChunk, static_cast<size_t>(aAmount - done));
+        std::memcpy(pFile->chunks[static_cast<size_t>(position / CHUNK_SIZE)] + inChunk, pIn + done, count);
+        done += static_cast<int>(count);
+    }
+    if (end > pFile->size)
+    {
+        pFile->size = end;
+    }
+    return SQLITE_OK;
+}
+
+int memTruncate(sqlite3_file* apFile, sqlite3_int64 aSize)
+{
+    MemFile* pFile = getHandle(apFile)->pFile;
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    if (aSize < pFile->size)
+    {
+        const size_t chunkCount = static_cast<size_t>((aSize + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        for (size_t i = chunkCount; i < pFile->chunks.size(); ++i)
+        {
+            std::free(pFile->chunks[i]);
+        }
+        pFile->chunks.resize(chunkCount);
+        // Zero the tail of the last chunk, so that growing the file again reads zeros
+        if (aSize % CHUNK_SIZE)
+        {
+            const size_t inChunk = static_cast<size_t>(aSize % CHUNK_SIZE);
+            std::memset(pFile->chunks.back() + inChunk, 0, CHUNK_SIZE - inChunk);
+        }
+        pFile->size = aSize;
+    }
+    return SQLITE_OK;
+}
+
+int memSync(sqlite3_file*, int)
+{
+    return SQLITE_OK;
+}
+
+int memFileSize(sqlite3_file* apFile, sqlite3_int64* apSize)
+{
+    MemFile* pFile = getHandle(apFile)->pFile;
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    *apSize = pFile->size;
+    return SQLITE_OK;
+}
+
+// Same lock levels as the unix VFS: SHARED locks are counted, the others are held by one handle at most
+int memLock(sqlite3_file* apFile, int aLock)
+{
+    MemHandle* pHandle = getHandle(apFile);
+    MemFile* pFile = pHandle->pFile;
+    if (pHandle->lock >= aLock)
+    {
+        return SQLITE_OK;
+    }
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    if (SQLITE_LOCK_SHARED == aLock)
+    {
+        if (pFile->bPending || pFile->bExclusive)
+        {
+            return SQLITE_BUSY;
+        }
+        ++pFile->sharedCount;
+        pHandle->lock = SQLITE_LOCK_SHARED;
+        return SQLITE_OK;
+    }
+    if (SQLITE_LOCK_RESERVED == aLock)
+    {
+        if (pFile->bReserved)
+        {
+            return SQLITE_BUSY;
+        }
+        pFile->bReserved = true;
+        pHandle->bReserved = true;
+        pHandle->lock = SQLITE_LOCK_RESERVED;
+        return SQLITE_OK;
+    }
+    // EXCLUSIVE, through PENDING to keep new readers out while the current ones finish
+    if (pHandle->lock < SQLITE_LOCK_PENDING)
+    {
+        if (pFile->bPending)
+        {
+            return SQLITE_BUSY;
+        }
+        pFile->bPending = true;
+        pHandle->lock = SQLITE_LOCK_PENDING;
+    }
+    if (pFile->sharedCount > 1)
+    {
+        return SQLITE_BUSY;
+    }
+    pFile->bExclusive = true;
+    pHandle->lock = SQLITE_LOCK_EXCLUSIVE;
+    return SQLITE_OK;
+}
+
+int memUnlock(sqlite3_file* apFile, int aLock)
+{
+    MemHandle* pHandle = getHandle(apFile);
+    MemFile* pFile = pHandle->pFile;
+    if (pHandle->lock <= aLock)
+    {
+        return SQLITE_OK;
+    }
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    if (pHandle->lock >= SQLITE_LOCK_PENDING)
+    {
+        pFile->bPending = false;
+        pFile->bExclusive = false;
+    }
+    if (pHandle->bReserved)
+    {
+        pFile->bReserved = false;
+        pHandle->bReserved = false;
+    }
+    if (SQLITE_LOCK_NONE == aLock)
+    {
+        --pFile->sharedCount;
+    }
+    pHandle->lock = aLock;
+    return SQLITE_OK;
+}
+
+int memCheckReservedLock(sqlite3_file* apFile, int* apResOut)
+{
+    MemFile* pFile = getHandle(apFile)->pFile;
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    *apResOut = (pFile->bReserved || pFile->bPending || pFile->bExclusive) ? 1 : 0;
+    return SQLITE_OK;
+}
+
+int memFileControl(sqlite3_file*, int, void*)
+{
+    return SQLITE_NOTFOUND;
+}
+
+int memSectorSize(sqlite3_file*)
+{
+    return 4096;
+}
+
+int memDeviceCharacteristics(sqlite3_file*)
+{
+    return SQLITE_IOCAP_SAFE_APPEND | SQLITE_IOCAP_SEQUENTIAL | SQLITE_IOCAP_POWERSAFE_OVERWRITE;
+}
+
+int memShmMap(sqlite3_file* apFile, int aRegion, int aRegionSize, int abExtend, void volatile** appMemory)
+{
+    MemHandle* pHandle = getHandle(apFile);
+    MemFile* pFile = pHandle->pFile;
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    if (!pHandle->bShmMapped)
+    {
+        pHandle->bShmMapped = true;
+        ++pFile->shmRefs;
+    }
+    *appMemory = nullptr;
+    while (pFile->shmRegions.size() <= static_cast<size_t>(aRegion))
+    {
+        if (!abExtend)
+        {
+            return SQLITE_OK;
+        }
+        char* pRegion = static_cast<char*>(std::calloc(1, static_cast<size_t>(aRegionSize)));
+        if (nullptr == pRegion)
+        {
+            return SQLITE_IOERR_NOMEM;
+        }
+        pFile->shmRegions.push_back(pRegion);
+    }
+    *appMemory = pFile->shmRegions[static_cast<size_t>(aRegion)];
+    return SQLITE_OK;
+}
+
+int memShmLock(sqlite3_file* apFile, int aOffset, int aCount, int aFlags)
+{
+    MemHandle* pHandle = getHandle(apFile);
+    MemFile* pFile = pHandle->pFile;
+    const unsigned mask = ((1u << aCount) - 1) << aOffset;
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    if (aFlags & SQLITE_SHM_UNLOCK)
+    {
+        for (int i = aOffset; i < aOffset + aCount; ++i)
+        {
+            if (pHandle->shmSharedMask & (1u << i))
+            {
+                --pFile->shmShared[i];
+            }
+            if (pHandle->shmExclusiveMask & (1u << i))
+            {
+                pFile->shmExclusive[i] = false;
+            }
+        }
+        pHandle->shmSharedMask &= ~mask;
+        pHandle->shmExclusiveMask &= ~mask;
+        return SQLITE_OK;
+    }
+    if (aFlags & SQLITE_SHM_SHARED)
+    {
+        for (int i = aOffset; i < aOffset + aCount; ++i)
+        {
+            if (pFile->shmExclusive[i] && !(pHandle->shmExclusiveMask & (1u << i)))
+            {
+                return SQLITE_BUSY;
+            }
+        }
+        for (int i = aOffset; i < aOffset + aCount; ++i)
+        {
+            if (!(pHandle->shmSharedMask & (1u << i)))
+            {
+                ++pFile->shmShared[i];
+            }
+        }
+        pHandle->shmSharedMask |= mask;
+        return SQLITE_OK;
+    }
+    // SQLITE_SHM_EXCLUSIVE
+    for (int i = aOffset; i < aOffset + aCount; ++i)
+    {
+        const int otherShared = pFile->shmShared[i] - ((pHandle->shmSharedMask & (1u << i)) ? 1 : 0);
+        if ((otherShared > 0) || (pFile->shmExclusive[i] && !(pHandle->shmExclusiveMask & (1u << i))))
+        {
+            return SQLITE_BUSY;
+        }
+    }
+    for (int i = aOffset; i < aOffset + aCount; ++i)
+    {
+        pFile->shmExclusive[i] = true;
+    }
+    pHandle->shmExclusiveMask |= mask;
+    return SQLITE_OK;
+}
+
+void memShmBarrier(sqlite3_file*)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+int memShmUnmap(sqlite3_file* apFile, int abDelete)
+{
+    MemHandle* pHandle = getHandle(apFile);
+    MemFile* pFile = pHandle->pFile;
+    std::lock_guard<std::mutex> lock(pFile->mutex);
+    if (pHandle->bShmMapped)
+    {
+        pHandle->bShmMapped = false;
+        if ((0 == --pFile->shmRefs) && abDelete)
+        {
+            pFile->freeShm();
+        }
+    }
+    return SQLITE_OK;
+}
+
+const sqlite3_io_methods sMemMethods = {
+    2, memClose, memRead, memWrite, memTruncate, memSync, memFileSize, memLock, memUnlock,
+    memCheckReservedLock, memFileControl, memSectorSize, memDeviceCharacteristics,
+    memShmMap, memShmLock, memShmBarrier, memShmUnmap, nullptr, nullptr
+};
+
+int memOpen(sqlite3_vfs*, const char* apName, sqlite3_file* apFile, int aFlags, int* apOutFlags)
+{
+    MemHandle* pHandle = getHandle(apFile);
+    std::memset(pHandle, 0, sizeof(MemHandle));
+    std::string name;
+    if (nullptr != apName)
+    {
+        name = apName;
+    }
+    else
+    {
+        // Temporary files have no name
+        name = "<temp-" + std::to_string(gTempCount.fetch_add(1)) + ">";
+        aFlags |= SQLITE_OPEN_DELETEONCLOSE;
+    }
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    Registry::iterator it = gRegistry.find(name);
+    if (gRegistry.end() == it)
+    {
+        if (0 == (aFlags & SQLITE_OPEN_CREATE))
+        {
+            return SQLITE_CANTOPEN;
+        }
+        it = gRegistry.insert(std::make_pair(name, new MemFile)).first;
+    }
+    else if ((aFlags & SQLITE_OPEN_EXCLUSIVE) && (aFlags & SQLITE_OPEN_CREATE))
+    {
+        return SQLITE_CANTOPEN;
+    }
+    ++it->second->openCount;
+    pHandle->pFile = it->second;
+    pHandle->pName = it->first.c_str();
+    pHandle->bDeleteOnClose = (0 != (aFlags & SQLITE_OPEN_DELETEONCLOSE));
+    pHandle->base.pMethods = &sMemMethods;
+    if (nullptr != apOutFlags)
+    {
+        *apOutFlags = aFlags;
+    }
+    return SQLITE_OK;
+}
+
+int memDelete(sqlite3_vfs*, const char* apName, int)
+{
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    Registry::iterator it = gRegistry.find(apName);
+    if (gRegistry.end() == it)
+    {
+        return SQLITE_IOERR_DELETE_NOENT;
+    }
+    removeFile(it);
+    return SQLITE_OK;
+}
+
+int memAccess(sqlite3_vfs*, const char* apName, int, int* apResOut)
+{
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    *apResOut = (gRegistry.end() != gRegistry.find(apName)) ? 1 : 0;
+    return SQLITE_OK;
+}
+
+int memFullPathname(sqlite3_vfs*, const char* apName, int aOutSize, char* apOut)
+{
+    sqlite3_snprintf(aOutSize, apOut, "%s", apName);
+    return SQLITE_OK;
+}
+
+// Dynamic libraries, randomness, sleep and time are delegated to the default VFS
+void* memDlOpen(sqlite3_vfs* apVfs, const char* apFilename)
+{
+    return getDefaultVfs(apVfs)->xDlOpen(getDefaultVfs(apVfs), apFilename);
+}
+
+void memDlError(sqlite3_vfs* apVfs, int aBytes, char* apErrMsg)
+{
+    getDefaultVfs(apVfs)->xDlError(getDefaultVfs(apVfs), aBytes, apErrMsg);
+}
+
+void (*memDlSym(sqlite3_vfs* apVfs, void* apHandle, const char* apSymbol))(void)
+{
+    return getDefaultVfs(apVfs)->xDlSym(getDefaultVfs(apVfs), apHandle, apSymbol);
+}
+
+void memDlClose(sqlite3_vfs* apVfs, void* apHandle)
+{
+    getDefaultVfs(apVfs)->xDlClose(getDefaultVfs(apVfs), apHandle);
+}
+
+int memRandomness(sqlite3_vfs* apVfs, int aBytes, char* apOut)
+{
+    return getDefaultVfs(apVfs)->xRandomness(getDefaultVfs(apVfs), aBytes, apOut);
+}
+
+int memSleep(sqlite3_vfs* apVfs, int aMicroseconds)
+{
+    return getDefaultVfs(apVfs)->xSleep(getDefaultVfs(apVfs), aMicroseconds);
+}
+
+int memCurrentTime(sqlite3_vfs* apVfs, double* apTime)
+{
+    return getDefaultVfs(apVfs)->xCurrentTime(getDefaultVfs(apVfs), apTime);
+}
+
+int memGetLastError(sqlite3_vfs* apVfs, int aBytes, char* apOut)
+{
+    return getDefaultVfs(apVfs)->xGetLastError(getDefaultVfs(apVfs), aBytes, apOut);
+}
+
+int memCurrentTimeInt64(sqlite3_vfs* apVfs, sqlite3_int64* apTime)
+{
+    sqlite3_vfs* pDefault = getDefaultVfs(apVfs);
+    if ((pDefault->iVersion >= 2) && (nullptr != pDefault->xCurrentTimeInt64))
+    {
+        return pDefault->xCurrentTimeInt64(pDefault, apTime);
+    }
+    double time = 0.0;
+    const int ret = pDefault->xCurrentTime(pDefault, &time);
+    *apTime = static_cast<sqlite3_int64>(time * 86400000.0);
+    return ret;
+}
+
+} // namespace
+
+
+// Register the memory VFS with SQLite, under the name MEMORY_VFS_NAME.
+void registerMemoryVfs(const bool abMakeDefault /* = false */)
+{
+    std::lock_guard<std::mutex> lock(gRegisterMutex);
+    if (gbRegistered)
+    {
+        return;
+    }
+    sqlite3_vfs* pDefault = sqlite3_vfs_find(nullptr);
+    if (nullptr == pDefault)
+    {
+        throw SQLite::Exception("No default VFS to delegate to", SQLITE_ERROR);
+    }
+    std::memset(&gVfs, 0, sizeof(gVfs));
+    gVfs.iVersion = 2;
+    gVfs.szOsFile = static_cast<int>(sizeof(MemHandle));
+    gVfs.mxPathname = 512;
+    gVfs.zName = MEMORY_VFS_NAME;
+    gVfs.pAppData = pDefault;
+    gVfs.xOpen = memOpen;
+    gVfs.xDelete = memDelete;
+    gVfs.xAccess = memAccess;
+    gVfs.xFullPathname = memFullPathname;
+    gVfs.xDlOpen = memDlOpen;
+    gVfs.xDlError = memDlError;
+    gVfs.xDlSym = memDlSym;
+    gVfs.xDlClose = memDlClose;
+    gVfs.xRandomness = memRandomness;
+    gVfs.xSleep = memSleep;
+    gVfs.xCurrentTime = memCurrentTime;
+    gVfs.xGetLastError = memGetLastError;
+    gVfs.xCurrentTimeInt64 = memCurrentTimeInt64;
+    const int ret = sqlite3_vfs_register(&gVfs, abMakeDefault ? 1 : 0);
+    if (SQLITE_OK != ret)
+    {
+        throw SQLite::Exception("Cannot register the memory VFS", ret);
+    }
+    gbRegistered = true;
+}
+
+// Delete a file of the memory VFS, freeing its memory once no connection uses it anymore.
+bool deleteMemoryFile(const std::string& aName)
+{
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    Registry::iterator it = gRegistry.find(aName);
+    if (gRegistry.end() == it)
+    {
+        return false;
+    }
+    removeFile(it);
+    return true;
+}
+
+// Return true if a file of the memory VFS exists.
+bool memoryFileExists(const std::string& aName)
+{
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    return (gRegistry.end() != gRegistry.find(aName));
+}
+
+
+}  // namespace SQLite
@@ -0,0 +1,462 @@
+/**
+ * @file    PageCache.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Pluggable page cache for SQLite, sharing a global memory budget between all connections.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/PageCache.h>
+
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace SQLite
+{
+
+namespace
+{
+
+const size_t SHARD_COUNT = 16;                      // Number of independently locked shards
+const size_t NOT_IN_RING = static_cast<size_t>(-1); // Ring index of the pages of non-purgeable caches
+
+struct Cache;
+
+// A page and its extra data are allocated in a single block, after this header
+struct Page
+{
+    sqlite3_pcache_page base;       // Must be first: the pointer given to SQLite
+    Cache*              pCache;     // Cache the page belongs to
+    unsigned            key;        // Page number
+    bool                bPinned;    // In use by SQLite, cannot be evicted
+    bool                bReferenced;// Accessed since the CLOCK hand last passed over it
+    size_t              ringIndex;  // Position in the CLOCK ring of its shard
+    size_t              blockSize;  // Size of the whole allocation
+};
+
+const size_t HEADER_SIZE = (sizeof(Page) + 7) & ~static_cast<size_t>(7);
+
+// One page cache, created by SQLite for each database file of each connection
+struct Cache
+{
+    uint64_t                id;         // Unique identifier, in the high bits of the keys of the shard maps
+    int                     pageSize;
+    int                     extraSize;
+    bool                    bPurgeable;
+    unsigned                maxKey;     // Largest key ever fetched, to bound the work of xTruncate()
+    std::atomic<unsigned>   pageCount;  // Decremented by other connections when they evict pages of this cache
+};
+
+// One lock stripe: the pages whose key hashes to it, with their CLOCK ring
+struct alignas(64) Shard
+{
+    std::mutex                              mutex;
+    std::unordered_map<uint64_t, Page*>     pages;      // Pages by cache id and key
+    std::vector<Page*>                      ring;       // Pages of the purgeable caches
+    size_t                                  hand;       // Position of the CLOCK hand in the ring
+    std::atomic<uint64_t>                   hits;
+    std::atomic<uint64_t>                   misses;
+    std::atomic<uint64_t>                   evictions;
+};
+
+Shard                   gShards[SHARD_COUNT];
+std::atomic<uint64_t>   gBudget(DEFAULT_PAGE_CACHE_BUDGET);
+std::atomic<uint64_t>   gBytes(0);      // Memory used by the pages of the purgeable caches
+std::atomic<uint64_t>   gPages(0);
+std::atomic<uint64_t>   gCaches(0);
+std::atomic<uint64_t>   gNextCacheId(1);
+
+// Key of a page in the map of its shard
+inline uint64_t getMapKey(const Cache* apCache, const unsigned aKey) noexcept // nothrow
+{
+    return (apCache->id << 32) | aKey;
+}
+
+// Shard of a page: consecutive pages of a cache are spread over the shards
+inline Shard& getShard(const Cache* apCache, const unsigned aKey) noexcept // nothrow
+{
+    const uint64_t hash = getMapKey(apCache, aKey) * 0x9E3779B97F4A7C15ULL;
+    return gShards[(hash >> 32) % SHARD_COUNT];
+}
+
+// Remove a page from its shard, with the lock of the shard held
+void detach(Shard& aShard, Page* apPage) noexcept // nothrow
+{
+    aShard.pages.erase(getMapKey(apPage->pCache, apPage->key));
+    if (NOT_IN_RING != apPage->ringIndex)
+    {
+        Page* pLast = aShard.ring.back();
+        aShard.ring[apPage->ringIndex] = pLast;
+        pLast->ringIndex = apPage->ringIndex;
+        aShard.ring.pop_back();
+        apPage->ringIndex = NOT_IN_RING;
+        if (aShard.hand >= aShard.ring.size())
+        {
+            aShard.hand = 0;
+        }
+        gBytes.fetch_sub(apPage->blockSize, std::memory_order_relaxed);
+    }
+    apPage->pCache->pageCount.fetch_sub(1, std::memory_order_relaxed);
+    gPages.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Insert a page in its shard, with the lock of the shard held
+void attach(Shard& aShard, Page* apPage)
+{
+    aShard.pages[getMapKey(apPage->pCache, apPage->key)] = apPage;
+    if (apPage->pCache->bPurgeable)
+    {
+        apPage->ringIndex = aShard.ring.size();
+        aShard.ring.push_back(apPage);
+        gBytes.fetch_add(apPage->blockSize, std::memory_order_relaxed);
+    }
+    apPage->pCache->pageCount.fetch_add(1, std::memory_order_relaxed);
+    gPages.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Evict an unpinned page of the shard with the CLOCK algorithm, with the lock of the shard held
+Page* evict(Shard& aShard) noexcept // nothrow
+{
+    for (size_t steps = 2 * aShard.ring.size(); steps > 0; --steps)
+    {
+        if (aShard.hand >= aShard.ring.size())
+        {
+            aShard.hand = 0;
+        }
+        Page* pPage = aShard.ring[aShard.hand];
+        if (!pPage->bPinned)
+        {
+            if (!pPage->bReferenced)
+            {
+                detach(aShard, pPage);
+                aShard.evictions.fetch_add(1, std::memory_order_relaxed);
+                return pPage;
+            }
+            pPage->bReferenced = false; // Second chance
+        }
+        ++aShard.hand;
+    }
+    return nullptr;
+}
+
+// Discard the pages of a cache matching a predicate, in all the shards
+template<typename Predicate>
+void discard(Cache* apCache, Predicate aPredicate)
+{
+    for (size_t s = 0; (s < SHARD_COUNT) && (apCache->pageCount.load() > 0); ++s)
+    {
+        Shard& shard = gShards[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (std::unordered_map<uint64_t, Page*>::iterator it = shard.pages.begin(); it != shard.pages.end();)
+        {
+            Page* pPage = it->second;
+            ++it;
+            if ((apCache == pPage->pCache) && aPredicate(pPage))
+            {
+                detach(shard, pPage);
+                sqlite3_free(pPage);
+            }
+        }
+    }
+}
+
+// sqlite3_pcache_methods2::xInit
+int pcacheInit(void*)
+{
+    return SQLITE_OK;
+}
+
+// sqlite3_pcache_methods2::xShutdown
+void pcacheShutdown(void*)
+{
+}
+
+// sqlite3_pcache_methods2::xCreate
+sqlite3_pcache* pcacheCreate(int aPageSize, int aExtraSize, int abPurgeable)
+{
+    Cache* pCache = new (std::nothrow) Cache;
+    if (nullptr != pCache)
+    {
+        pCache->id = gNextCacheId.fetch_add(1, std::memory_order_relaxed);
+        pCache->pageSize = aPageSize;
+        pCache->extraSize = aExtraSize;
+        pCache->bPurgeable = (0 != abPurgeable);
+        pCache->maxKey = 0;
+        pCache->pageCount = 0;
+        gCaches.fetch_add(1, std::memory_order_relaxed);
+    }
+    return reinterpret_cast<sqlite3_pcache*>(pCache);
+}
+
+// sqlite3_pcache_methods2::xCachesize: the global budget applies instead
+void pcacheCachesize(sqlite3_pcache*, int)
+{
+}
+
+// sqlite3_pcache_methods2::xPagecount
+int pcachePagecount(sqlite3_pcache* apCache)
+{
+    return static_cast<int>(reinterpret_cast<Cache*>(apCache)->pageCount.load(std::memory_order_relaxed));
+}
+
+// sqlite3_pcache_methods2::xFetch
+sqlite3_pcache_page* pcacheFetch(sqlite3_pcache* apCache, unsigned aKey, int aCreateFlag)
+{
+    Cache* pCache = reinterpret_cast<Cache*>(apCache);
+    Shard& shard = getShard(pCache, aKey);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::unordered_map<uint64_t, Page*>::const_iterator found = shard.pages.find(getMapKey(pCache, aKey));
+    if (shard.pages.end() != found)
+    {
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        found->second->bPinned = true;
+        found->second->bReferenced = true;
+        return &found->second->base;
+    }
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    if (0 == aCreateFlag)
+    {
+        return nullptr;
+    }
+
+    const size_t blockSize = HEADER_SIZE + pCache->pageSize + pCache->extraSize;
+    Page* pPage = nullptr;
+    if (pCache->bPurgeable)
+    {
+        // Over budget: evict unpinned pages of the shard (recycling one of them), or only allocate if SQLite insists
+        while (gBytes.load(std::memory_order_relaxed) + blockSize > gBudget.load(std::memory_order_relaxed))
+        {
+            Page* pVictim = evict(shard);
+            if (nullptr == pVictim)
+            {
+                break;
+            }
+            if ((nullptr == pPage) && (pVictim->blockSize == blockSize))
+            {
+                pPage = pVictim;
+            }
+            else
+            {
+                sqlite3_free(pVictim);
+            }
+        }
+        if ((nullptr == pPage) && (1 == aCreateFlag)
+         && (gBytes.load(std::memory_order_relaxed) + blockSize > gBudget.load(std::memory_order_relaxed)))
+        {
+            return nullptr;
+        }
+    }
+    if (nullptr == pPage)
+    {
+        pPage = static_cast<Page*>(sqlite3_malloc64(blockSize));
+        if (nullptr == pPage)
+        {
+            return nullptr;
+        }
+    }
+    pPage->base.pBuf = reinterpret_cast<char*>(pPage) + HEADER_SIZE;
+    pPage->base.pExtra = static_cast<char*>(pPage->base.pBuf) + pCache->pageSize;
+    std::memset(pPage->base.pExtra, 0, static_cast<size_t>(pCache->extraSize));
+    pPage->pCache = pCache;
+    pPage->key = aKey;
+    pPage->bPinned = true;
+    pPage->bReferenced = true;
+    pPage->ringIndex = NOT_IN_RING;
+    pPage->blockSize = blockSize;
+    try
+    {
+        attach(shard, pPage);
+    }
+    catch (std::bad_alloc&)
+    {
+        sqlite3_free(pPage);
+        return nullptr;
+    }
+    if (aKey > pCache->maxKey)
+    {
+        pCache->maxKey = aKey;
+    }
+    return &pPage->base;
+}
+
+// sqlite3_pcache_methods2::xUnpin
+void pcacheUnpin(sqlite3_pcache* apCache, sqlite3_pcache_page* apPage, int abDiscard)
+{
+    Page* pPage = reinterpret_cast<Page*>(apPage);
+    Shard& shard = getShard(reinterpret_cast<Cache*>(apCache), pPage->key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (abDiscard)
+    {
+        detach(shard, pPage);
+        sqlite3_free(pPage);
+    }
+    else
+    {
+        pPage->bPinned = false;
+    }
+}
+
+// sqlite3_pcache_methods2::xRekey
+void pcacheRekey(sqlite3_pcache* apCache, sqlite3_pcache_page* apPage, unsigned aOldKey, unsigned aNewKey)
+{
+    Cache* pCache = reinterpret_cast<Cache*>(apCache);
+    Page* pPage = reinterpret_cast<Page*>(apPage);
+    {
+        Shard& shard = getShard(pCache, aOldKey);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        detach(shard, pPage);
+    }
+    Shard& shard = getShard(pCache, aNewKey);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // Any unpinned page already at the new key is discarded
+    std::unordered_map<uint64_t, Page*>::iterator existing = shard.pages.find(getMapKey(pCache, aNewKey));
+    if (shard.pages.end() != existing)
+    {
+        Page* pExisting = existing->second;
+        detach(shard, pExisting);
+        sqlite3_free(pExisting);
+    }
+    pPage->key = aNewKey;
+    try
+    {
+        attach(shard, pPage);
+    }
+    catch (std::bad_alloc&)
+    {
+        // Losing the page is not an option: SQLite holds it pinned, keep it out of the cache until unpinned
+        pPage->pCache->pageCount.fetch_add(1, std::memory_order_relaxed);
+        gPages.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (aNewKey > pCache->maxKey)
+    {
+        pCache->maxKey = aNewKey;
+    }
+}
+
+// sqlite3_pcache_methods2::xTruncate
+void pcacheTruncate(sqlite3_pcache* apCache, unsigned aLimit)
+{
+    Cache* pCache = reinterpret_cast<Cache*>(apCache);
+    if (aLimit > pCache->maxKey)
+    {
+        return;
+    }
+    if (pCache->maxKey - aLimit < pCache->pageCount.load())
+    {
+        // Few keys to discard: look them up one by one
+        for (unsigned key = aLimit; key <= pCache->maxKey; ++key)
+        {
+            Shard& shard = getShard(pCache, key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            std::unordered_map<uint64_t, Page*>::iterator found = shard.pages.find(getMapKey(pCache, key));
+            if (shard.pages.end() != found)
+            {
+                Page* pPage = found->second;
+                detach(shard, pPage);
+                sqlite3_free(pPage);
+            }
+        }
+    }
+    else
+    {
+        discard(pCache, [aLimit](const Page* apPage) { return apPage->key >= aLimit; });
+    }
+    pCache->maxKey = (aLimit > 0) ? (aLimit - 1) : 0;
+}
+
+// sqlite3_pcache_methods2::xDestroy
+void pcacheDestroy(sqlite3_pcache* apCache)
+{
+    Cache* pCache = reinterpret_cast<Cache*>(apCache);
+    discard(pCache, [](const Page*) { return true; });
+    gCaches.fetch_sub(1, std::memory_order_relaxed);
+    delete pCache;
+}
+
+// sqlite3_pcache_methods2::xShrink
+void pcacheShrink(sqlite3_pcache* apCache)
+{
+    discard(reinterpret_cast<Cache*>(apCache), [](const Page* apPage) { return !apPage->bPinned; });
+}
+
+const sqlite3_pcache_methods2 sShardedMethods = {
+    1, nullptr, pcacheInit, pcacheShutdown, pcacheCreate, pcacheCachesize, pcachePagecount,
+    pcacheFetch, pcacheUnpin, pcacheRekey, pcacheTruncate, pcacheDestroy, pcacheShrink
+};
+
+std::mutex              gConfigMutex;       // Serialize the calls to configurePageCache()
+sqlite3_pcache_methods2 gDefaultMethods;    // Page cache of SQLite before the first configuration
+bool                    gbDefaultSaved = false;
+
+} // namespace
+
+
+// Install the page cache used by all SQLite connections, with SQLITE_CONFIG_PCACHE2.
+void configurePageCache(const PageCache aPageCache, const size_t aBudgetBytes /* = DEFAULT_PAGE_CACHE_BUDGET */)
+{
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    int ret = SQLITE_OK;
+    if (!gbDefaultSaved)
+    {
+        ret = sqlite3_config(SQLITE_CONFIG_GETPCACHE2, &gDefaultMethods);
+        if (SQLITE_OK != ret)
+        {
+            throw SQLite::Exception("Cannot configure the page cache once SQLite is initialized", ret);
+        }
+        gbDefaultSaved = true;
+    }
+    ret = sqlite3_config(SQLITE_CONFIG_PCACHE2, (PageCache::Sharded == aPageCache) ? &sShardedMethods
+                                                                                    : &gDefaultMethods);
+    if (SQLITE_OK != ret)
+    {
+        throw SQLite::Exception("Cannot configure the page cache once SQLite is initialized", ret);
+    }
+    gBudget = aBudgetBytes;
+}
+
+// Change the memory budget of the Sharded page cache.
+void setPageCacheBudget(const size_t aBudgetBytes) noexcept // nothrow
+{
+    gBudget = aBudgetBytes;
+}
+
+// Return the statistics of the Sharded page cache.
+PageCacheStats getPageCacheStats() noexcept // nothrow
+{
+    PageCacheStats stats = PageCacheStats();
+    for (size_t s = 0; s < SHARD_COUNT; ++s)
+    {
+        stats.hits += gShards[s].hits.load(std::memory_order_relaxed);
+        stats.misses += gShards[s].misses.load(std::memory_order_relaxed);
+        stats.evictions += gShards[s].evictions.load(std::memory_order_relaxed);
+    }
+    stats.pages = gPages.load(std::memory_order_relaxed);
+    stats.bytes = gBytes.load(std::memory_order_relaxed);
+    stats.budget = gBudget.load(std::memory_order_relaxed);
+    stats.caches = gCaches.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Reset the hits, misses and evictions counters of the Sharded page cache.
+void resetPageCacheStats() noexcept // nothrow
+{
+    for (size_t s = 0; s < SHARD_COUNT; ++s)
+    {
+        gShards[s].hits = 0;
+        gShards[s].misses = 0;
+        gShards[s].evictions = 0;
+    }
+}
+
+
+}  // namespace SQLite
@@ -0,0 +1,160 @@
+/**
+ * @file    ParallelScan.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Scan of a table split into rowid ranges, read concurrently by several connections.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/ParallelScan.h>
+
+#include <SQLiteCpp/Snapshot.h>
+#include <SQLiteCpp/Transaction.h>
+#include <SQLiteCpp/Utils.h>
+
+#include <exception>
+#include <thread>
+
+
+namespace SQLite
+{
+
+
+// Open the read-only connections of the partitions
+ParallelScan::ParallelScan(const std::string& aFilename,
+                           const std::string& aTable,
+                           const size_t       aPartitions /* = 0 */,
+                           const int          aFlags /* = 0 */,
+                           const std::string& aVfs /* = "" */) :
+    mReaders(),
+    // one subquery each, as SQLite optimizes a lone min() or max() of the rowid into a seek, but not the two together
+    mRangeQuery("SELECT (SELECT min(rowid) FROM " + quoteIdentifier(aTable) + "), "
+                "(SELECT max(rowid) FROM " + quoteIdentifier(aTable) + ")"),
+    mpSnapshot(nullptr)
+{
+    size_t partitions = (aPartitions > 0) ? aPartitions : std::thread::hardware_concurrency();
+    if (0 == partitions)
+    {
+        partitions = 1; // number of hardware threads not computable
+    }
+    mReaders.reserve(partitions);
+    for (size_t i = 0; i < partitions; ++i)
+    {
+        mReaders.emplace_back(aFilename, SQLite::OPEN_READONLY | SQLite::OPEN_NOMUTEX | aFlags, 0, aVfs);
+    }
+}
+
+// Split the rowids of the table into ranges of the same width, one for each partition at most
+std::vector<RowidRange> ParallelScan::getRanges()
+{
+    std::vector<RowidRange> ranges;
+    Database& reader = mReaders[0];
+    reader.acquireOwnership();
+    Transaction transaction(reader); // rolled back at the end of the read
+    beginRead(reader);
+    Statement query(reader, mRangeQuery);
+    if (!query.executeStep() || query.isColumnNull(0))
+    {
+        return ranges; // empty table
+    }
+    const long long min = query.getColumn(0).getInt64();
+    const long long max = query.getColumn(1).getInt64();
+
+    // in unsigned arithmetic, as the number of rowids can overflow a long long: span + 1 = count * width + rest + 1
+    const unsigned long long span = static_cast<unsigned long long>(max) - static_cast<unsigned long long>(min);
+    unsigned long long count = mReaders.size();
+    if (span < count - 1)
+    {
+        count = span + 1;
+    }
+    const unsigned long long width = span / count;
+    const unsigned long long rest = span % count;
+    unsigned long long first = static_cast<unsigned long long>(min);
+    for (unsigned long long i = 0; i < count; ++i)
+    {
+        const unsigned long long last = first + width - ((i <= rest) ? 0 : 1);
+        const RowidRange range = { static_cast<long long>(first), static_cast<long long>(last) };
+        ranges.push_back(range);
+        first = last + 1;
+    }
+    return ranges;
+}
+
+// Call a function with each row of the query run on each partition, concurrently on one thread per partition
+void ParallelScan::forEachRow(const std::string& aQuery, const std::function<void(Statement&, size_t)>& aFunction)
+{
+    const std::vector<RowidRange> ranges = getRanges();
+    std::vector<std::exception_ptr> errors(ranges.size());
+    const auto scanRange = [this, &aQuery, &aFunction, &ranges, &errors](const size_t aPartition)
+    {
+        try
+        {
+            Database& reader = mReaders[aPartition];
+            reader.acquireOwnership();
+            Transaction transaction(reader); // rolled back at the end of the read
+            beginRead(reader);
+            Statement query(reader, aQuery);
+            query.bind(1, ranges[aPartition].first);
+            query.bind(2, ranges[aPartition].last);
+            while (query.executeStep())
+            {
+                aFunction(query, aPartition);
+            }
+        }
+        catch (...)
+        {
+            errors[aPartition] = std::current_exception();
+        }
+    };
+    // the first partition is read by the calling thread
+    std::vector<std::thread> threads;
+    try
+    {
+        for (size_t partition = 1; partition < ranges.size(); ++partition)
+        {
+            threads.emplace_back(scanRange, partition);
+        }
+    }
+    catch (...)
+    {
+        // a thread could not be started (std::system_error): wait for those already running before throwing
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        throw;
+    }
+    if (!ranges.empty())
+    {
+        scanRange(0);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (const std::exception_ptr& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Start a read transaction on a connection, at the Snapshot if any
+void ParallelScan::beginRead(Database& aReader)
+{
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    if (nullptr != mpSnapshot)
+    {
+        mpSnapshot->open(aReader, mpSnapshot->getSchema().c_str());
+    }
+#else
+    (void)aReader; // without snapshot, the transaction starts on the first read
+#endif // SQLITE_ENABLE_SNAPSHOT
+}
+
+
+}  // namespace SQLite
@@ -0,0 +1,437 @@
+/**
+ * @file    Profiler.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Statement level profiling of a Database Connection, aggregated in latency histograms.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/Profiler.h>
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <string.h>
+
+
+namespace SQLite
+{
+
+// Create an empty histogram
+LatencyHistogram::LatencyHistogram() noexcept :
+    mCount(0),
+    mTotal(0),
+    mMax(0)
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        mBuckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Copy a snapshot of the histogram
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& aOther) noexcept :
+    mCount(0),
+    mTotal(0),
+    mMax(0)
+{
+    *this = aOther;
+}
+
+// Copy a snapshot of the histogram
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& aOther) noexcept
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        mBuckets[i].store(aOther.mBuckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    mCount.store(aOther.mCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mTotal.store(aOther.mTotal.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mMax.store(aOther.mMax.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
+
+// Index of the sub-bucket a value is recorded in:
+// values below SUB_BUCKET_COUNT have their own sub-bucket, then each power of two is split in SUB_BUCKET_COUNT.
+int LatencyHistogram::getBucketIndex(uint64_t aValueNs) noexcept // nothrow
+{
+    const uint64_t maxValue = (static_cast<uint64_t>(1) << MAX_VALUE_BITS) - 1;
+    if (aValueNs > maxValue)
+    {
+        aValueNs = maxValue;
+    }
+    if (aValueNs < static_cast<uint64_t>(SUB_BUCKET_COUNT))
+    {
+        return static_cast<int>(aValueNs);
+    }
+    int msb = 0;
+    for (uint64_t value = aValueNs; value > 1; value >>= 1)
+    {
+        ++msb;
+    }
+    const int shift = msb - SUB_BUCKET_BITS;
+    const int bucket = shift + 1;
+    const int sub = static_cast<int>(aValueNs >> shift) - SUB_BUCKET_COUNT;
+    return bucket * SUB_BUCKET_COUNT + sub;
+}
+
+// Highest value recorded in a sub-bucket.
+uint64_t LatencyHistogram::getBucketUpperBound(const int aIndex) noexcept // nothrow
+{
+    if (aIndex < SUB_BUCKET_COUNT)
+    {
+        return static_cast<uint64_t>(aIndex);
+    }
+    const int shift = aIndex / SUB_BUCKET_COUNT - 1;
+    const uint64_t sub = static_cast<uint64_t>(aIndex % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT);
+    return ((sub + 1) << shift) - 1;
+}
+
+// Record a value, in nanoseconds.
+void LatencyHistogram::record(const uint64_t aValueNs) noexcept // nothrow
+{
+    mBuckets[getBucketIndex(aValueNs)].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mTotal.fetch_add(aValueNs, std::memory_order_relaxed);
+    uint64_t max = mMax.load(std::memory_order_relaxed);
+    while ((aValueNs > max) && !mMax.compare_exchange_weak(max, aValueNs, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Add all the values recorded in another histogram.
+void LatencyHistogram::merge(const LatencyHistogram& aOther) noexcept // nothrow
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        const uint64_t count = aOther.mBuckets[i].load(std::memory_order_relaxed);
+        if (0 != count)
+        {
+            mBuckets[i].fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+    mCount.fetch_add(aOther.mCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mTotal.fetch_add(aOther.mTotal.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    const uint64_t otherMax = aOther.mMax.load(std::memory_order_relaxed);
+    uint64_t max = mMax.load(std::memory_order_relaxed);
+    while ((otherMax > max) && !mMax.compare_exchange_weak(max, otherMax, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Forget all recorded values.
+void LatencyHistogram::reset() noexcept // nothrow
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        mBuckets[i].store(0, std::memory_order_relaxed);
+    }
+    mCount.store(0, std::memory_order_relaxed);
+    mTotal.store(0, std::memory_order_relaxed);
+    mMax.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount() const noexcept // nothrow
+{
+    return mCount.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getTotal() const noexcept // nothrow
+{
+    return mTotal.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getMax() const noexcept // nothrow
+{
+    return mMax.load(std::memory_order_relaxed);
+}
+
+// Return the value at a given percentile of the recorded values (upper bound of its sub-bucket).
+uint64_t LatencyHistogram::getPercentile(const double aPercentile) const noexcept // nothrow
+{
+    // Sum the buckets instead of using mCount, which could be a little ahead while a value is being recorded
+    uint64_t count = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        count += mBuckets[i].load(std::memory_order_relaxed);
+    }
+    if (0 == count)
+    {
+        return 0;
+    }
+    const double percentile = (aPercentile < 0.0) ? 0.0 : ((aPercentile > 100.0) ? 100.0 : aPercentile);
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(count) + 0.5);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    const uint64_t max = getMax();
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += mBuckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            const uint64_t upperBound = getBucketUpperBound(i);
+            return (upperBound < max) ? upperBound : max;
+        }
+    }
+    return max;
+}
+
+
+// FNV-1a hash of a SQL text
+static uint64_t hashSql(const char* apSql) noexcept
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char* pChar = reinterpret_cast<const unsigned char*>(apSql); *pChar != '\0'; ++pChar)
+    {
+        hash ^= *pChar;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+Profiler::Entry::Entry(const uint64_t aHash, const char* apSql) :
+    hash(aHash),
+    sql(apSql),
+    rows(0),
+    slowestNs(0)
+{
+}
+
+// Prepare an empty table of statistics, with a power of two number of slots at least twice the statements tracked
+Profiler::Profiler(const uint64_t aSlowThresholdNs, const size_t aMaxStatements) :
+    mSlowThresholdNs(aSlowThresholdNs),
+    mEntries(),
+    mOverflow(0, "<other>"),
+    mNextRunning(0)
+{
+    size_t slots = 16;
+    while (slots < 2 * aMaxStatements)
+    {
+        slots *= 2;
+    }
+    std::vector<std::atomic<Entry*> > entries(slots);
+    mEntries.swap(entries);
+    for (size_t i = 0; i < mEntries.size(); ++i)
+    {
+        mEntries[i].store(NULL, std::memory_order_relaxed);
+    }
+    memset(mRunning, 0, sizeof(mRunning));
+}
+
+Profiler::~Profiler()
+{
+    for (size_t i = 0; i < mEntries.size(); ++i)
+    {
+        delete mEntries[i].load(std::memory_order_acquire);
+    }
+}
+
+// Find or create the entry of the given statement (lock-free insertion with linear probing).
+Profiler::Entry& Profiler::getEntry(sqlite3_stmt* apStmt)
+{
+    const char* pSql = sqlite3_sql(apStmt);
+    if (NULL == pSql)
+    {
+        return mOverflow;
+    }
+    const uint64_t hash = hashSql(pSql);
+    const size_t mask = mEntries.size() - 1;
+    // Keep the table at most half full to keep probe sequences short
+    const size_t maxProbes = mEntries.size() / 2;
+    for (size_t probe = 0; probe < maxProbes; ++probe)
+    {
+        std::atomic<Entry*>& slot = mEntries[(hash + probe) & mask];
+        Entry* pEntry = slot.load(std::memory_order_acquire);
+        if (NULL == pEntry)
+        {
+            Entry* pNewEntry = new Entry(hash, pSql);
+            if (slot.compare_exchange_strong(pEntry, pNewEntry, std::memory_order_acq_rel))
+            {
+                return *pNewEntry;
+            }
+            // Another thread filled the slot meanwhile: check if it is the same statement
+            delete pNewEntry;
+        }
+        if ((hash == pEntry->hash) && (pEntry->sql == pSql))
+        {
+            return *pEntry;
+        }
+    }
+    return mOverflow;
+}
+
+// Current time of the steady clock, in nanoseconds
+static uint64_t getNowNs() noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Find the slot of a running statement, or nullptr
+Profiler::Running* Profiler::getRunning(sqlite3_stmt* apStmt) noexcept // nothrow
+{
+    for (size_t i = 0; i < RUNNING_COUNT; ++i)
+    {
+        if (apStmt == mRunning[i].pStmt)
+        {
+            return &mRunning[i];
+        }
+    }
+    return nullptr;
+}
+
+// Record the start of an execution of a statement, in its slot, a free one, or the oldest one
+void Profiler::onStmt(sqlite3_stmt* apStmt) noexcept // nothrow
+{
+    Running* pRunning = getRunning(apStmt);
+    if (nullptr == pRunning)
+    {
+        pRunning = getRunning(nullptr);
+    }
+    if (nullptr == pRunning)
+    {
+        // Slots can be left over by statements that never finish (reset without being run to completion):
+        // a statement beyond RUNNING_COUNT interleaved ones uses the time reported by SQLite, without its rows.
+        pRunning = &mRunning[mNextRunning];
+        mNextRunning = (mNextRunning + 1) % RUNNING_COUNT;
+    }
+    pRunning->pStmt = apStmt;
+    pRunning->rows = 0;
+    pRunning->startNs = getNowNs();
+}
+
+// Record a row returned by a statement
+void Profiler::onRow(sqlite3_stmt* apStmt) noexcept // nothrow
+{
+    Running* pRunning = getRunning(apStmt);
+    if (nullptr != pRunning)
+    {
+        ++pRunning->rows;
+    }
+}
+
+// Record the end of an execution of a statement
+void Profiler::onProfile(sqlite3_stmt* apStmt, uint64_t aElapsedNs)
+{
+    Entry& entry = getEntry(apStmt);
+
+    Running* pRunning = getRunning(apStmt);
+    if (nullptr != pRunning)
+    {
+        aElapsedNs = getNowNs() - pRunning->startNs;
+        entry.rows.fetch_add(pRunning->rows, std::memory_order_relaxed);
+        pRunning->pStmt = nullptr;
+    }
+    entry.histogram.record(aElapsedNs);
+
+    const uint64_t slowThresholdNs = mSlowThresholdNs.load(std::memory_order_relaxed);
+    if ((0 != slowThresholdNs) && (aElapsedNs >= slowThresholdNs))
+    {
+        std::lock_guard<std::mutex> lock(entry.slowestMutex);
+        if (aElapsedNs > entry.slowestNs)
+        {
+            char* pExpandedSql = sqlite3_expanded_sql(apStmt);
+            entry.slowestNs = aElapsedNs;
+            entry.slowestSql = (NULL != pExpandedSql) ? pExpandedSql : entry.sql;
+            sqlite3_free(pExpandedSql);
+        }
+    }
+}
+
+// Callback registered with sqlite3_trace_v2(), called from the thread using the Database Connection.
+int Profiler::trace(unsigned aType, void* apProfiler, void* apStmt, void* apData)
+{
+    Profiler* pProfiler = static_cast<Profiler*>(apProfiler);
+    sqlite3_stmt* pStmt = static_cast<sqlite3_stmt*>(apStmt);
+    if (SQLITE_TRACE_STMT == aType)
+    {
+        // Ignore the start of trigger subprograms, described by a "--" SQL comment
+        const char* pSql = static_cast<const char*>(apData);
+        if ((NULL == pSql) || (0 != strncmp(pSql, "--", 2)))
+        {
+            pProfiler->onStmt(pStmt);
+        }
+    }
+    else if (SQLITE_TRACE_ROW == aType)
+    {
+        pProfiler->onRow(pStmt);
+    }
+    else if (SQLITE_TRACE_PROFILE == aType)
+    {
+        const sqlite3_int64 elapsedNs = *static_cast<sqlite3_int64*>(apData);
+        try
+        {
+            pProfiler->onProfile(pStmt, static_cast<uint64_t>(elapsedNs));
+        }
+        catch (std::exception&)
+        {
+            // Never throw an exception thru SQLite: the statistics of this execution are lost.
+        }
+    }
+    return 0;
+}
+
+// Return a copy of the statistics of all statements executed so far, optionally resetting them.
+std::vector<StatementProfile> Profiler::getProfile(const bool abReset)
+{
+    std::vector<StatementProfile> profile;
+    for (size_t i = 0; i <= mEntries.size(); ++i)
+    {
+        Entry* pEntry = (i < mEntries.size()) ? mEntries[i].load(std::memory_order_acquire) : &mOverflow;
+        if ((NULL == pEntry) || (0 == pEntry->histogram.getCount()))
+        {
+            continue;
+        }
+        StatementProfile statement;
+        statement.sql = pEntry->sql;
+        statement.histogram = pEntry->histogram;
+        statement.rows = pEntry->rows.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(pEntry->slowestMutex);
+            statement.slowestNs = pEntry->slowestNs;
+            statement.slowestSql = pEntry->slowestSql;
+            if (abReset)
+            {
+                pEntry->slowestNs = 0;
+                pEntry->slowestSql.clear();
+            }
+        }
+        if (abReset)
+        {
+            pEntry->histogram.reset();
+            pEntry->rows.store(0, std::memory_order_relaxed);
+        }
+        statement.count = statement.histogram.getCount();
+        statement.totalNs = statement.histogram.getTotal();
+        statement.p50Ns = statement.histogram.getPercentile(50.0);
+        statement.p99Ns = statement.histogram.getPercentile(99.0);
+        statement.maxNs = statement.histogram.getMax();
+        profile.push_back(statement);
+    }
+    return profile;
+}
+
+// Forget all statistics.
+void Profiler::reset() noexcept // nothrow
+{
+    for (size_t i = 0; i <= mEntries.size(); ++i)
+    {
+        Entry* pEntry = (i < mEntries.size()) ? mEntries[i].load(std::memory_order_acquire) : &mOverflow;
+        if (NULL != pEntry)
+        {
+            pEntry->histogram.reset();
+            pEntry->rows.store(0, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(pEntry->slowestMutex);
+            pEntry->slowestNs = 0;
+            pEntry->slowestSql.clear();
+        }
+    }
+}
+
+
+}  // namespace SQLite
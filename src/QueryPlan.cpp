@@ -0,0 +1,178 @@
+/**
+ * @file    QueryPlan.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Query plan of a Statement, as a tree of steps, and baselines of plans to catch index regressions.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/QueryPlan.h>
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Exception.h>
+
+#include <fstream>
+#include <set>
+
+
+namespace SQLite
+{
+
+
+// Return the detail with "SCAN TABLE t" and "SEARCH TABLE t" of SQLite before 3.36.0 written "SCAN t"/"SEARCH t"
+std::string QueryPlanStep::getNormalizedDetail() const
+{
+    static const char* const prefixes[] = {"SCAN TABLE ", "SEARCH TABLE "};
+    for (const char* prefix : prefixes)
+    {
+        const std::string oldPrefix(prefix);
+        if (0 == detail.compare(0, oldPrefix.size(), oldPrefix))
+        {
+            return oldPrefix.substr(0, oldPrefix.find(' ') + 1) + detail.substr(oldPrefix.size());
+        }
+    }
+    return detail;
+}
+
+// true if the step reads a whole table or index ("SCAN t", but not "SCAN CONSTANT ROW")
+bool QueryPlanStep::isFullScan() const
+{
+    return (0 == detail.compare(0, 5, "SCAN ")) && (0 != detail.compare(0, 17, "SCAN CONSTANT ROW"));
+}
+
+// true if the step sorts or deduplicates rows in a temporary b-tree ("USE TEMP B-TREE FOR ORDER BY")
+bool QueryPlanStep::usesTempBTree() const
+{
+    return (0 == detail.compare(0, 15, "USE TEMP B-TREE"));
+}
+
+// Append the steps to the text of a plan, indented by two spaces for each level of the tree
+static void appendSteps(const std::vector<QueryPlanStep>& aSteps, const size_t aDepth, std::string& aText)
+{
+    for (const QueryPlanStep& step : aSteps)
+    {
+        aText.append(aDepth * 2, ' ');
+        aText += step.detail;
+        aText += '\n';
+        appendSteps(step.children, aDepth + 1, aText);
+    }
+}
+
+// Append the full scans and temporary b-trees of the steps and their sub-steps
+static void appendCostlySteps(const std::vector<QueryPlanStep>& aSteps, std::vector<std::string>& aCostlySteps)
+{
+    for (const QueryPlanStep& step : aSteps)
+    {
+        if (step.isFullScan())
+        {
+            // "SCAN t" of "SCAN t USING COVERING INDEX idx", the same full scan whatever the index
+            const std::string detail = step.getNormalizedDetail();
+            aCostlySteps.push_back(detail.substr(0, detail.find(' ', 5)));
+        }
+        else if (step.usesTempBTree())
+        {
+            aCostlySteps.push_back(step.detail);
+        }
+        appendCostlySteps(step.children, aCostlySteps);
+    }
+}
+
+// Return the plan as text, one step detail per line, indented by two spaces for each level of the tree.
+std::string QueryPlan::toString() const
+{
+    std::string text;
+    appendSteps(steps, 0, text);
+    return text;
+}
+
+// Return the full scans ("SCAN t") and temporary b-trees ("USE TEMP B-TREE FOR ORDER BY") of the plan, in order.
+std::vector<std::string> QueryPlan::getCostlySteps() const
+{
+    std::vector<std::string> costlySteps;
+    appendCostlySteps(steps, costlySteps);
+    return costlySteps;
+}
+
+
+// Create an empty set of queries, with baselines in the given directory.
+QueryPlanBaseline::QueryPlanBaseline(const std::string& aDirectory) :
+    mDirectory(aDirectory)
+{
+}
+
+// Register a query to check.
+void QueryPlanBaseline::add(const std::string& aName, const std::string& aQuery)
+{
+    mQueries.push_back(std::make_pair(aName, aQuery));
+}
+
+// Return the path of the baseline file of a query.
+std::string QueryPlanBaseline::getFilename(const std::string& aName) const
+{
+    return mDirectory + "/" + aName + ".plan";
+}
+
+// Compare the current plans of the queries against their baselines.
+std::vector<QueryPlanBaseline::Regression> QueryPlanBaseline::check(Database& aDatabase) const
+{
+    std::vector<Regression> regressions;
+    for (const std::pair<std::string, std::string>& query : mQueries)
+    {
+        // The baseline file is a plan written by toString(): read it back as flat steps, without the indentation
+        QueryPlan baseline;
+        std::ifstream file(getFilename(query.first).c_str());
+        std::string line;
+        while (std::getline(file, line))
+        {
+            const size_t first = line.find_first_not_of(' ');
+            if (first != std::string::npos)
+            {
+                baseline.steps.push_back(QueryPlanStep{0, 0, line.substr(first), std::vector<QueryPlanStep>()});
+            }
+        }
+        if (file.bad())
+        {
+            throw SQLite::Exception("Cannot read query plan baseline " + getFilename(query.first));
+        }
+        const std::vector<std::string> baselineSteps = baseline.getCostlySteps();
+        std::multiset<std::string> expected(baselineSteps.begin(), baselineSteps.end());
+
+        // Each costly step of the current plan must match one of the baseline
+        const QueryPlan plan = Statement(aDatabase, query.second).explainQueryPlan();
+        for (const std::string& step : plan.getCostlySteps())
+        {
+            const std::multiset<std::string>::iterator found = expected.find(step);
+            if (found != expected.end())
+            {
+                expected.erase(found);
+            }
+            else
+            {
+                regressions.push_back(Regression{query.first, step, plan.toString()});
+            }
+        }
+    }
+    return regressions;
+}
+
+// Write the current plans of all the queries as their new baselines.
+void QueryPlanBaseline::update(Database& aDatabase) const
+{
+    for (const std::pair<std::string, std::string>& query : mQueries)
+    {
+        const QueryPlan plan = Statement(aDatabase, query.second).explainQueryPlan();
+        std::ofstream file(getFilename(query.first).c_str(), std::ios::trunc);
+        file << plan.toString();
+        file.close();
+        if (file.fail())
+        {
+            throw SQLite::Exception("Cannot write query plan baseline " + getFilename(query.first));
+        }
+    }
+}
+
+
+}  // namespace SQLite
@@ -0,0 +1,213 @@
+/**
+ * @file    Schema.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Catalog of the tables, columns and indexes of a database, cached until its schema changes.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/Schema.h>
+
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+#include <algorithm>
+
+
+namespace SQLite
+{
+
+
+namespace
+{
+
+/// A raw statement finalized at the end of the scope, for the queries of the catalog
+class RawStatement
+{
+public:
+    RawStatement(sqlite3* apSQLite, const char* apQuery) :
+        mpStmt(nullptr)
+    {
+        const int ret = sqlite3_prepare_v2(apSQLite, apQuery, -1, &mpStmt, nullptr);
+        if (SQLITE_OK != ret)
+        {
+            throw SQLite::Exception(apSQLite, ret);
+        }
+    }
+    ~RawStatement()
+    {
+        sqlite3_finalize(mpStmt);
+    }
+    operator sqlite3_stmt*() const noexcept
+    {
+        return mpStmt;
+    }
+
+private:
+    RawStatement(const RawStatement&);
+    RawStatement& operator=(const RawStatement&);
+
+private:
+    sqlite3_stmt* mpStmt;
+};
+
+/// Return the text of a column, or an empty string for NULL
+std::string getText(sqlite3_stmt* apStmt, const int aColumn)
+{
+    const char* pText = reinterpret_cast<const char*>(sqlite3_column_text(apStmt, aColumn));
+    return (nullptr != pText) ? std::string(pText, static_cast<size_t>(sqlite3_column_bytes(apStmt, aColumn)))
+                              : std::string();
+}
+
+}  // namespace
+
+
+// Return the column of the given name, or nullptr
+const SchemaColumn* SchemaTable::getColumn(const std::string& aName) const noexcept // nothrow
+{
+    for (const SchemaColumn& column : columns)
+    {
+        if (column.name == aName)
+        {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+
+// Prepare the statement reading the version of the schema, the catalog being loaded on the first lookup
+Schema::Schema(sqlite3* apSQLite) :
+    mpSQLite(apSQLite),
+    mpVersionStmt(nullptr),
+    mVersion(-1)
+{
+    const int ret = sqlite3_prepare_v2(mpSQLite, "PRAGMA main.schema_version", -1, &mpVersionStmt, nullptr);
+    if (SQLITE_OK != ret)
+    {
+        throw SQLite::Exception(mpSQLite, ret);
+    }
+}
+
+// Finalize the statement reading the version of the schema
+Schema::~Schema()
+{
+    sqlite3_finalize(mpVersionStmt);
+}
+
+// Compare the version of the schema to the one of the catalog, and load it again if it changed
+bool Schema::refresh()
+{
+    const int ret = sqlite3_step(mpVersionStmt);
+    if (SQLITE_ROW != ret)
+    {
+        sqlite3_reset(mpVersionStmt);
+        throw SQLite::Exception(mpSQLite, ret);
+    }
+    const int version = sqlite3_column_int(mpVersionStmt, 0);
+    sqlite3_reset(mpVersionStmt);
+    if (version == mVersion)
+    {
+        return false;
+    }
+    load();
+    // a rollback can bring back the version of a catalog loaded in a transaction: load it again on the next lookup
+    mVersion = sqlite3_get_autocommit(mpSQLite) ? version : -1;
+    return true;
+}
+
+// Return the table or view of the given name, or nullptr
+const SchemaTable* Schema::getTable(const std::string& aName)
+{
+    refresh();
+    const std::unordered_map<std::string, SchemaTable>::const_iterator table = mTables.find(aName);
+    return (table != mTables.end()) ? &table->second : nullptr;
+}
+
+// Return the index of the given name, or nullptr
+const SchemaIndex* Schema::getIndex(const std::string& aName)
+{
+    refresh();
+    const std::unordered_map<std::string, SchemaIndex>::const_iterator index = mIndexes.find(aName);
+    return (index != mIndexes.end()) ? &index->second : nullptr;
+}
+
+// Return the names of all the tables and views, sorted
+std::vector<std::string> Schema::getTableNames()
+{
+    refresh();
+    std::vector<std::string> names;
+    names.reserve(mTables.size());
+    for (const std::pair<const std::string, SchemaTable>& table : mTables)
+    {
+        names.push_back(table.first);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// Load the tables with their columns, then the indexes of each table
+void Schema::load()
+{
+    mTables.clear();
+    mIndexes.clear();
+
+    RawStatement tables(mpSQLite, "SELECT name, type FROM main.sqlite_master WHERE type IN ('table', 'view')");
+    RawStatement columns(mpSQLite, "SELECT name, type, \"notnull\", dflt_value, pk "
+                                   "FROM pragma_table_info(?1, 'main') ORDER BY cid");
+    RawStatement indexes(mpSQLite, "SELECT il.name, il.\"unique\", ii.name "
+                                   "FROM pragma_index_list(?1, 'main') AS il, pragma_index_info(il.name, 'main') AS ii "
+                                   "ORDER BY il.name, ii.seqno");
+    int ret;
+    while (SQLITE_ROW == (ret = sqlite3_step(tables)))
+    {
+        SchemaTable table;
+        table.name = getText(tables, 0);
+        table.bView = (getText(tables, 1) == "view");
+
+        sqlite3_bind_text(columns, 1, table.name.c_str(), static_cast<int>(table.name.size()), SQLITE_STATIC);
+        while (SQLITE_ROW == sqlite3_step(columns))
+        {
+            SchemaColumn column;
+            column.name = getText(columns, 0);
+            column.type = getText(columns, 1);
+            column.bNotNull = (0 != sqlite3_column_int(columns, 2));
+            column.bHasDefault = (SQLITE_NULL != sqlite3_column_type(columns, 3));
+            column.defaultValue = getText(columns, 3);
+            column.primaryKey = sqlite3_column_int(columns, 4);
+            table.columns.push_back(std::move(column));
+        }
+        // a virtual table whose module is not registered on this connection has no known column
+        sqlite3_reset(columns);
+
+        sqlite3_bind_text(indexes, 1, table.name.c_str(), static_cast<int>(table.name.size()), SQLITE_STATIC);
+        while (SQLITE_ROW == sqlite3_step(indexes))
+        {
+            const std::string name = getText(indexes, 0);
+            SchemaIndex& index = mIndexes[name];
+            if (index.name.empty())
+            {
+                index.name = name;
+                index.table = table.name;
+                index.bUnique = (0 != sqlite3_column_int(indexes, 1));
+                table.indexes.push_back(name);
+            }
+            index.columns.push_back(getText(indexes, 2));
+        }
+        sqlite3_reset(indexes);
+
+        const std::string name = table.name;
+        mTables[name] = std::move(table);
+    }
+    if (SQLITE_DONE != ret)
+    {
+        mTables.clear();
+        mIndexes.clear();
+        throw SQLite::Exception(mpSQLite, ret);
+    }
+}
+
+
+}  // namespace SQLite
@@ -0,0 +1,168 @@
+/**
+ * @file    ShardedDatabase.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Database split across several files, with keys placed by consistent hashing.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/ShardedDatabase.h>
+
+#include <SQLiteCpp/Exception.h>
+
+#include <exception>
+#include <thread>
+
+
+namespace SQLite
+{
+
+
+namespace
+{
+
+// Hash bytes with 64 bits FNV-1a, then mix the result so that close inputs spread over the whole ring
+uint64_t hashBytes(const unsigned char* apData, const size_t aSize) noexcept
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < aSize; ++i)
+    {
+        hash ^= apData[i];
+        hash *= 1099511628211ULL;
+    }
+    // finalizer of MurmurHash3
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Hash an integer from its little-endian bytes, the same on all platforms
+uint64_t hashInteger(const long long aValue) noexcept
+{
+    unsigned char bytes[8];
+    const uint64_t value = static_cast<uint64_t>(aValue);
+    for (size_t i = 0; i < 8; ++i)
+    {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    return hashBytes(bytes, sizeof(bytes));
+}
+
+} // namespace
+
+
+const int ShardedDatabase::DEFAULT_VIRTUAL_NODES;
+
+// Open the database file of each shard, and place the points of each shard on the ring
+ShardedDatabase::ShardedDatabase(const std::vector<std::string>& aFilenames,
+                                 const int aFlags /* = SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE */,
+                                 const int aBusyTimeoutMs /* = 0 */,
+                                 const int aVirtualNodes /* = DEFAULT_VIRTUAL_NODES */) :
+    mShards(),
+    mMutexes(aFilenames.size()),
+    mRing()
+{
+    if (aFilenames.empty() || (aVirtualNodes <= 0))
+    {
+        throw SQLite::Exception("a ShardedDatabase needs at least one shard, with a positive number of points");
+    }
+    mShards.reserve(aFilenames.size());
+    for (const std::string& filename : aFilenames)
+    {
+        mShards.emplace_back(filename, aFlags, aBusyTimeoutMs);
+    }
+    // the points of a shard depend only on its index: "<index>#<point>"
+    mRing.reserve(aFilenames.size() * static_cast<size_t>(aVirtualNodes));
+    for (size_t shard = 0; shard < aFilenames.size(); ++shard)
+    {
+        for (int point = 0; point < aVirtualNodes; ++point)
+        {
+            const std::string name = std::to_string(shard) + "#" + std::to_string(point);
+            const uint64_t hash = hashBytes(reinterpret_cast<const unsigned char*>(name.data()), name.size());
+            mRing.push_back(std::make_pair(hash, shard));
+        }
+    }
+    std::sort(mRing.begin(), mRing.end());
+}
+
+// Return the index of the shard of a text key
+size_t ShardedDatabase::getShardIndex(const std::string& aKey) const noexcept // nothrow
+{
+    return getShardOfHash(hashBytes(reinterpret_cast<const unsigned char*>(aKey.data()), aKey.size()));
+}
+
+// Return the index of the shard of an integer key
+size_t ShardedDatabase::getShardIndex(const long long aKey) const noexcept // nothrow
+{
+    return getShardOfHash(hashInteger(aKey));
+}
+
+// Return the index of the shard of the first point of the ring following a hash, wrapping around the ring
+size_t ShardedDatabase::getShardOfHash(const uint64_t aHash) const noexcept // nothrow
+{
+    std::vector<std::pair<uint64_t, size_t> >::const_iterator point =
+        std::lower_bound(mRing.begin(), mRing.end(), std::make_pair(aHash, static_cast<size_t>(0)));
+    if (point == mRing.end())
+    {
+        point = mRing.begin();
+    }
+    return point->second;
+}
+
+// Call a function with the connection of each shard, concurrently on one thread per shard
+void ShardedDatabase::forEachShard(const std::function<void(Database&, size_t)>& aFunction)
+{
+    std::vector<std::exception_ptr> errors(mShards.size());
+    const auto runShard = [this, &aFunction, &errors](const size_t aIndex)
+    {
+        try
+        {
+            std::lock_guard<std::mutex> lock(mMutexes[aIndex]);
+            mShards[aIndex].acquireOwnership();
+            aFunction(mShards[aIndex], aIndex);
+        }
+        catch (...)
+        {
+            errors[aIndex] = std::current_exception();
+        }
+    };
+    // the first shard runs on the calling thread
+    std::vector<std::thread> threads;
+    threads.reserve(mShards.size() - 1);
+    try
+    {
+        for (size_t index = 1; index < mShards.size(); ++index)
+        {
+            threads.emplace_back(runShard, index);
+        }
+    }
+    catch (...)
+    {
+        // a thread could not be started (std::system_error): wait for those already running before throwing
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        throw;
+    }
+    runShard(0);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (const std::exception_ptr& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+
+}  // namespace SQLite
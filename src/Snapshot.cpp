@@ -0,0 +1,61 @@
+/**
+ * @file    Snapshot.cpp
+ * @ingroup SQLiteCpp
+ * @brief   A Snapshot records the state of a WAL database to open read transactions on it from other connections.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/Snapshot.h>
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+
+namespace SQLite
+{
+
+// Record the current state of the given schema of the database connection.
+Snapshot::Snapshot(Database& aDatabase, const char* apSchema /* = "main" */) :
+    mpSnapshot(NULL),
+    mSchema(apSchema)
+{
+    const int ret = sqlite3_snapshot_get(aDatabase.getHandle(), apSchema, &mpSnapshot);
+    if (SQLITE_OK != ret)
+    {
+        throw SQLite::Exception(aDatabase.getHandle(), ret);
+    }
+}
+
+// Free the SQLite Snapshot object.
+Snapshot::~Snapshot()
+{
+    if (NULL != mpSnapshot)
+    {
+        sqlite3_snapshot_free(mpSnapshot);
+    }
+}
+
+// Start a read transaction on the given connection that sees the database as recorded by this Snapshot.
+void Snapshot::open(Database& aDatabase, const char* apSchema /* = "main" */) const
+{
+    const int ret = sqlite3_snapshot_open(aDatabase.getHandle(), apSchema, mpSnapshot);
+    if (SQLITE_OK != ret)
+    {
+        throw SQLite::Exception(aDatabase.getHandle(), ret);
+    }
+}
+
+// Compare the age of two snapshots of the same database file.
+int Snapshot::compare(const Snapshot& aOther) const noexcept // nothrow
+{
+    return sqlite3_snapshot_cmp(mpSnapshot, aOther.mpSnapshot);
+}
+
+}  // namespace SQLite
+
+#endif // SQLITE_ENABLE_SNAPSHOT
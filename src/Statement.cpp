@@ -13,21 +13,49 @@
 #include <SQLiteCpp/Database.h>
 #include <SQLiteCpp/Column.h>
 #include <SQLiteCpp/Assertion.h>
+#include <SQLiteCpp/Errors.h>
 #include <SQLiteCpp/Exception.h>
 
 #include <sqlite3.h>
 
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace SQLite
 {
 
+// Default full scan handler, writing to the standard error output
+static void logFullScan(const Statement& aStatement, const StatementStatus& aStatus)
+{
+    std::cerr << "SQLiteCpp: full scan (" << aStatus.fullscanSteps << " steps, "
+              << aStatus.autoIndexes << " automatic index rows): " << aStatement.getQuery() << std::endl;
+}
+
+// Handler called when a Statement with the FullScanPolicy::Log policy performs a full scan
+static std::atomic<FullScanHandler> sFullScanHandler(&logFullScan);
+
+// Set the handler called when a Statement with the FullScanPolicy::Log policy performs a full scan.
+void setFullScanHandler(FullScanHandler apHandler) noexcept // nothrow
+{
+    sFullScanHandler.store((nullptr != apHandler) ? apHandler : &logFullScan);
+}
+
 // Compile and register the SQL query for the provided SQLite Database Connection
 Statement::Statement(Database &aDatabase, const char* apQuery) :
     mQuery(apQuery),
     mStmtPtr(aDatabase.mpSQLite, mQuery), // prepare the SQL query, and ref count (needs Database friendship)
     mColumnCount(0),
     mbHasRow(false),
-    mbDone(false)
+    mbDone(false),
+    mFullScanPolicy(FullScanPolicy::Ignore),
+    mFullscanSteps(0),
+    mAutoIndexes(0)
 {
+    aDatabase.checkOwnership();
     mColumnCount = sqlite3_column_count(mStmtPtr);
 }
 
@@ -37,12 +65,84 @@ Statement::Statement(Database &aDatabase, const std::string& aQuery) :
     mStmtPtr(aDatabase.mpSQLite, mQuery), // prepare the SQL query, and ref count (needs Database friendship)
     mColumnCount(0),
     mbHasRow(false),
-    mbDone(false)
+    mbDone(false),
+    mFullScanPolicy(FullScanPolicy::Ignore),
+    mFullscanSteps(0),
+    mAutoIndexes(0)
+{
+    aDatabase.checkOwnership();
+    mColumnCount = sqlite3_column_count(mStmtPtr);
+}
+
+// Compile and register the SQL query, setting an error code instead of throwing an exception on error
+Statement::Statement(Database &aDatabase, const char* apQuery, std::error_code& aError) :
+    mQuery(apQuery),
+    mStmtPtr(aDatabase.mpSQLite, mQuery, aError),
+    mColumnCount(0),
+    mbHasRow(false),
+    mbDone(false),
+    mFullScanPolicy(FullScanPolicy::Ignore),
+    mFullscanSteps(0),
+    mAutoIndexes(0)
+{
+    aDatabase.checkOwnership();
+    mColumnCount = sqlite3_column_count(mStmtPtr);
+}
+
+// Compile and register the SQL query, setting an error code instead of throwing an exception on error
+Statement::Statement(Database &aDatabase, const std::string& aQuery, std::error_code& aError) :
+    mQuery(aQuery),
+    mStmtPtr(aDatabase.mpSQLite, mQuery, aError),
+    mColumnCount(0),
+    mbHasRow(false),
+    mbDone(false),
+    mFullScanPolicy(FullScanPolicy::Ignore),
+    mFullscanSteps(0),
+    mAutoIndexes(0)
 {
+    aDatabase.checkOwnership();
     mColumnCount = sqlite3_column_count(mStmtPtr);
 }
 
 
+// Move the prepared statement, its bindings and its current row to a new Statement object
+Statement::Statement(Statement&& aStatement) noexcept : // nothrow
+    mQuery(std::move(aStatement.mQuery)),
+    mStmtPtr(std::move(aStatement.mStmtPtr)),
+    mColumnCount(aStatement.mColumnCount),
+    mColumnNames(std::move(aStatement.mColumnNames)),
+    mbHasRow(aStatement.mbHasRow),
+    mbDone(aStatement.mbDone),
+    mFullScanPolicy(aStatement.mFullScanPolicy),
+    mFullscanSteps(aStatement.mFullscanSteps),
+    mAutoIndexes(aStatement.mAutoIndexes)
+{
+    aStatement.mColumnCount = 0;
+    aStatement.mbHasRow = false;
+    aStatement.mbDone = false;
+}
+
+// Release the prepared statement, then move the other one here
+Statement& Statement::operator=(Statement&& aStatement) noexcept // nothrow
+{
+    if (this != &aStatement)
+    {
+        mQuery = std::move(aStatement.mQuery);
+        mStmtPtr = std::move(aStatement.mStmtPtr);
+        mColumnCount = aStatement.mColumnCount;
+        mColumnNames = std::move(aStatement.mColumnNames);
+        mbHasRow = aStatement.mbHasRow;
+        mbDone = aStatement.mbDone;
+        mFullScanPolicy = aStatement.mFullScanPolicy;
+        mFullscanSteps = aStatement.mFullscanSteps;
+        mAutoIndexes = aStatement.mAutoIndexes;
+        aStatement.mColumnCount = 0;
+        aStatement.mbHasRow = false;
+        aStatement.mbDone = false;
+    }
+    return *this;
+}
+
 // Finalize and unregister the SQL query from the SQLite Database Connection.
 Statement::~Statement()
 {
@@ -60,9 +160,20 @@ int Statement::tryReset() noexcept
 {
     mbHasRow = false;
     mbDone = false;
+    // sqlite3_reset() reports a success for a statement that failed to compile
+    if (nullptr == static_cast<sqlite3_stmt*>(mStmtPtr))
+    {
+        return SQLITE_MISUSE;
+    }
     return sqlite3_reset(mStmtPtr);
 }
 
+// Reset the statement, setting an error code instead of throwing an exception on error
+void Statement::reset(std::error_code& aError) noexcept
+{
+    aError = to_error_code(tryReset());
+}
+
 // Clears away all the bindings of a prepared statement (can be associated with #reset() above).
 void Statement::clearBindings()
 {
@@ -70,6 +181,17 @@ void Statement::clearBindings()
     check(ret);
 }
 
+// Clears away all the bindings, setting an error code instead of throwing an exception on error
+void Statement::clearBindings(std::error_code& aError) noexcept
+{
+    if (nullptr == static_cast<sqlite3_stmt*>(mStmtPtr))
+    {
+        aError = make_error_code(Error::misuse);
+        return;
+    }
+    aError = to_error_code(sqlite3_clear_bindings(mStmtPtr));
+}
+
 // Bind an int value to a parameter "?", "?NNN", ":VVV", "@VVV" or "$VVV" in the SQL prepared statement
 void Statement::bind(const int aIndex, const int aValue)
 {
@@ -241,13 +363,154 @@ void Statement::bind(const char* apName)
 }
 
 
+// Bind an int value to a parameter, setting an error code instead of throwing an exception on error
+void Statement::bind(const int aIndex, const int aValue, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_int(mStmtPtr, aIndex, aValue));
+}
+
+// Bind a 32bits unsigned int value to a parameter, setting an error code instead of throwing
+void Statement::bind(const int aIndex, const unsigned aValue, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_int64(mStmtPtr, aIndex, aValue));
+}
+
+// Bind a 64bits int value to a parameter, setting an error code instead of throwing
+void Statement::bind(const int aIndex, const long long aValue, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_int64(mStmtPtr, aIndex, aValue));
+}
+
+// Bind a double (64bits float) value to a parameter, setting an error code instead of throwing
+void Statement::bind(const int aIndex, const double aValue, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_double(mStmtPtr, aIndex, aValue));
+}
+
+// Bind a string value to a parameter, setting an error code instead of throwing
+void Statement::bind(const int aIndex, const std::string& aValue, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_text(mStmtPtr, aIndex, aValue.c_str(),
+                                             static_cast<int>(aValue.size()), SQLITE_TRANSIENT));
+}
+
+// Bind a text value to a parameter, setting an error code instead of throwing
+void Statement::bind(const int aIndex, const char* apValue, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_text(mStmtPtr, aIndex, apValue, -1, SQLITE_TRANSIENT));
+}
+
+// Bind a binary blob value to a parameter, setting an error code instead of throwing
+void Statement::bind(const int aIndex, const void* apValue, const int aSize, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_blob(mStmtPtr, aIndex, apValue, aSize, SQLITE_TRANSIENT));
+}
+
+// Bind a string value to a parameter without copy, setting an error code instead of throwing
+void Statement::bindNoCopy(const int aIndex, const std::string& aValue, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_text(mStmtPtr, aIndex, aValue.c_str(),
+                                             static_cast<int>(aValue.size()), SQLITE_STATIC));
+}
+
+// Bind a text value to a parameter without copy, setting an error code instead of throwing
+void Statement::bindNoCopy(const int aIndex, const char* apValue, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_text(mStmtPtr, aIndex, apValue, -1, SQLITE_STATIC));
+}
+
+// Bind a binary blob value to a parameter without copy, setting an error code instead of throwing
+void Statement::bindNoCopy(const int aIndex, const void* apValue, const int aSize, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_blob(mStmtPtr, aIndex, apValue, aSize, SQLITE_STATIC));
+}
+
+// Bind a NULL value to a parameter, setting an error code instead of throwing
+void Statement::bind(const int aIndex, std::error_code& aError) noexcept
+{
+    aError = to_error_code(sqlite3_bind_null(mStmtPtr, aIndex));
+}
+
+
+// Bind an int value to a named parameter, setting an error code instead of throwing (SQLITE_RANGE if unknown)
+void Statement::bind(const char* apName, const int aValue, std::error_code& aError) noexcept
+{
+    bind(sqlite3_bind_parameter_index(mStmtPtr, apName), aValue, aError);
+}
+
+// Bind a 32bits unsigned int value to a named parameter, setting an error code instead of throwing
+void Statement::bind(const char* apName, const unsigned aValue, std::error_code& aError) noexcept
+{
+    bind(sqlite3_bind_parameter_index(mStmtPtr, apName), aValue, aError);
+}
+
+// Bind a 64bits int value to a named parameter, setting an error code instead of throwing
+void Statement::bind(const char* apName, const long long aValue, std::error_code& aError) noexcept
+{
+    bind(sqlite3_bind_parameter_index(mStmtPtr, apName), aValue, aError);
+}
+
+// Bind a double (64bits float) value to a named parameter, setting an error code instead of throwing
+void Statement::bind(const char* apName, const double aValue, std::error_code& aError) noexcept
+{
+    bind(sqlite3_bind_parameter_index(mStmtPtr, apName), aValue, aError);
+}
+
+// Bind a string value to a named parameter, setting an error code instead of throwing
+void Statement::bind(const char* apName, const std::string& aValue, std::error_code& aError) noexcept
+{
+    bind(sqlite3_bind_parameter_index(mStmtPtr, apName), aValue, aError);
+}
+
+// Bind a text value to a named parameter, setting an error code instead of throwing
+void Statement::bind(const char* apName, const char* apValue, std::error_code& aError) noexcept
+{
+    bind(sqlite3_bind_parameter_index(mStmtPtr, apName), apValue, aError);
+}
+
+// Bind a binary blob value to a named parameter, setting an error code instead of throwing
+void Statement::bind(const char* apName, const void* apValue, const int aSize, std::error_code& aError) noexcept
+{
+    bind(sqlite3_bind_parameter_index(mStmtPtr, apName), apValue, aSize, aError);
+}
+
+// Bind a string value to a named parameter without copy, setting an error code instead of throwing
+void Statement::bindNoCopy(const char* apName, const std::string& aValue, std::error_code& aError) noexcept
+{
+    bindNoCopy(sqlite3_bind_parameter_index(mStmtPtr, apName), aValue, aError);
+}
+
+// Bind a text value to a named parameter without copy, setting an error code instead of throwing
+void Statement::bindNoCopy(const char* apName, const char* apValue, std::error_code& aError) noexcept
+{
+    bindNoCopy(sqlite3_bind_parameter_index(mStmtPtr, apName), apValue, aError);
+}
+
+// Bind a binary blob value to a named parameter without copy, setting an error code instead of throwing
+void Statement::bindNoCopy(const char* apName, const void* apValue, const int aSize,
+                           std::error_code& aError) noexcept
+{
+    bindNoCopy(sqlite3_bind_parameter_index(mStmtPtr, apName), apValue, aSize, aError);
+}
+
+// Bind a NULL value to a named parameter, setting an error code instead of throwing
+void Statement::bind(const char* apName, std::error_code& aError) noexcept
+{
+    bind(sqlite3_bind_parameter_index(mStmtPtr, apName), aError);
+}
+
+
 // Execute a step of the query to fetch one row of results
 bool Statement::executeStep()
 {
     const int ret = tryExecuteStep();
     if ((SQLITE_ROW != ret) && (SQLITE_DONE != ret)) // on row or no (more) row ready, else it's a problem
     {
-        throw SQLite::Exception(mStmtPtr, ret);
+        SQLite::throwException(mStmtPtr, ret);
+    }
+    if (mbDone)
+    {
+        checkFullScan();
     }
 
     return mbHasRow; // true only if one row is accessible by getColumn(N)
@@ -265,14 +528,49 @@ int Statement::exec()
         }
         else
         {
-            throw SQLite::Exception(mStmtPtr, ret);
+            SQLite::throwException(mStmtPtr, ret);
         }
     }
 
+    checkFullScan();
+
     // Return the number of rows modified by those SQL statements (INSERT, UPDATE or DELETE)
     return sqlite3_changes(mStmtPtr);
 }
 
+// Execute a step of the query, setting an error code instead of throwing an exception on error
+bool Statement::executeStep(std::error_code& aError) noexcept
+{
+    const int ret = tryExecuteStep();
+    if ((SQLITE_ROW != ret) && (SQLITE_DONE != ret))
+    {
+        aError = to_error_code(ret);
+        return false;
+    }
+    aError = (mbDone && !tryApplyFullScanPolicy()) ? make_error_code(Error::error) : std::error_code();
+
+    return mbHasRow;
+}
+
+// Execute a one-step query with no expected result, setting an error code instead of throwing
+int Statement::exec(std::error_code& aError) noexcept
+{
+    const int ret = tryExecuteStep();
+    if (SQLITE_DONE != ret)
+    {
+        aError = (SQLITE_ROW == ret) ? make_error_code(Error::misuse) : to_error_code(ret);
+        return 0;
+    }
+    if (!tryApplyFullScanPolicy())
+    {
+        aError = make_error_code(Error::error);
+        return 0;
+    }
+
+    aError.clear();
+    return sqlite3_changes(mStmtPtr);
+}
+
 int Statement::tryExecuteStep() noexcept
 {
     if (false == mbDone)
@@ -394,6 +692,136 @@ const char* Statement::getErrorMsg() const noexcept // nothrow
     return sqlite3_errmsg(mStmtPtr);
 }
 
+// Return the counters of the operations performed by the SQLite virtual machine for this Statement.
+StatementStatus Statement::getStatus(const bool abReset /* = false */) noexcept // nothrow
+{
+    const int reset = abReset ? 1 : 0;
+    StatementStatus status = {0, 0, 0, 0, 0};
+    if (nullptr == static_cast<sqlite3_stmt*>(mStmtPtr))
+    {
+        return status; // no operation for a statement that failed to compile
+    }
+    status.fullscanSteps = sqlite3_stmt_status(mStmtPtr, SQLITE_STMTSTATUS_FULLSCAN_STEP, reset);
+    status.sorts = sqlite3_stmt_status(mStmtPtr, SQLITE_STMTSTATUS_SORT, reset);
+    status.autoIndexes = sqlite3_stmt_status(mStmtPtr, SQLITE_STMTSTATUS_AUTOINDEX, reset);
+    status.vmSteps = sqlite3_stmt_status(mStmtPtr, SQLITE_STMTSTATUS_VM_STEP, reset);
+    status.memUsed = sqlite3_stmt_status(mStmtPtr, SQLITE_STMTSTATUS_MEMUSED, 0);
+    if (abReset)
+    {
+        mFullscanSteps = 0;
+        mAutoIndexes = 0;
+    }
+    return status;
+}
+
+// Flag this Statement as expected to use indexes only, and check it after each complete execution.
+void Statement::setFullScanPolicy(const FullScanPolicy aPolicy) noexcept // nothrow
+{
+    mFullScanPolicy = aPolicy;
+    const StatementStatus status = getStatus();
+    mFullscanSteps = status.fullscanSteps;
+    mAutoIndexes = status.autoIndexes;
+}
+
+// Apply the full scan policy at the end of an execution of the Statement,
+// on the counters accumulated since the previous check (they are not reset, to leave them to getStatus())
+void Statement::checkFullScan()
+{
+    if (!applyFullScanPolicy())
+    {
+        throw SQLite::Exception("Full scan in a statement expected to use indexes: " + mQuery);
+    }
+}
+
+// Apply the full scan policy, returning false for a full scan forbidden by FullScanPolicy::Throw
+bool Statement::applyFullScanPolicy()
+{
+    if (FullScanPolicy::Ignore == mFullScanPolicy)
+    {
+        return true;
+    }
+    StatementStatus status = getStatus();
+    status.fullscanSteps -= mFullscanSteps;
+    status.autoIndexes -= mAutoIndexes;
+    mFullscanSteps += status.fullscanSteps;
+    mAutoIndexes += status.autoIndexes;
+    if ((status.fullscanSteps > 0) || (status.autoIndexes > 0))
+    {
+        if (FullScanPolicy::Throw == mFullScanPolicy)
+        {
+            return false;
+        }
+        sFullScanHandler.load()(*this, status);
+    }
+    return true;
+}
+
+// Apply the full scan policy, returning false for a forbidden full scan or an exception of the handler
+bool Statement::tryApplyFullScanPolicy() noexcept // nothrow
+{
+    try
+    {
+        return applyFullScanPolicy();
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+// Move the steps of the given parent from the flat list of rows of "EXPLAIN QUERY PLAN" to the tree
+static void attachSteps(std::vector<QueryPlanStep>& aRows, const int aParent, std::vector<QueryPlanStep>& aSteps)
+{
+    for (QueryPlanStep& row : aRows)
+    {
+        if ((row.parent == aParent) && (row.id != 0))
+        {
+            aSteps.push_back(std::move(row));
+            row.id = 0; // moved to the tree
+        }
+    }
+    for (QueryPlanStep& step : aSteps)
+    {
+        attachSteps(aRows, step.id, step.children);
+    }
+}
+
+// Return the plan chosen by SQLite to execute this Statement, from "EXPLAIN QUERY PLAN".
+QueryPlan Statement::explainQueryPlan() const
+{
+    sqlite3_stmt* pStmt = nullptr;
+    const std::string explain = "EXPLAIN QUERY PLAN " + mQuery;
+    const int ret = sqlite3_prepare_v2(mStmtPtr, explain.c_str(), static_cast<int>(explain.size()), &pStmt, nullptr);
+    if (SQLITE_OK != ret)
+    {
+        SQLite::throwException(mStmtPtr, ret);
+    }
+
+    // Since SQLite 3.24.0 the columns are "id, parent, notused, detail",
+    // before they were "selectid, order, from, detail" without any tree structure
+    const bool bTree = (0 == std::strcmp(sqlite3_column_name(pStmt, 0), "id"));
+    std::vector<QueryPlanStep> rows;
+    int res;
+    while (SQLITE_ROW == (res = sqlite3_step(pStmt)))
+    {
+        QueryPlanStep step;
+        step.id = bTree ? sqlite3_column_int(pStmt, 0) : static_cast<int>(rows.size() + 1);
+        step.parent = bTree ? sqlite3_column_int(pStmt, 1) : 0;
+        const char* pDetail = reinterpret_cast<const char*>(sqlite3_column_text(pStmt, 3));
+        step.detail = pDetail ? pDetail : "";
+        rows.push_back(std::move(step));
+    }
+    sqlite3_finalize(pStmt);
+    if (SQLITE_DONE != res)
+    {
+        SQLite::throwException(mStmtPtr, res);
+    }
+
+    QueryPlan plan;
+    attachSteps(rows, 0, plan.steps);
+    return plan;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Internal class : shared pointer to the sqlite3_stmt SQLite Statement Object
 ////////////////////////////////////////////////////////////////////////////////
@@ -412,7 +840,7 @@ Statement::Ptr::Ptr(sqlite3* apSQLite, std::string& aQuery) :
     const int ret = sqlite3_prepare_v2(apSQLite, aQuery.c_str(), static_cast<int>(aQuery.size()), &mpStmt, NULL);
     if (SQLITE_OK != ret)
     {
-        throw SQLite::Exception(apSQLite, ret);
+        SQLite::throwException(apSQLite, ret);
     }
     // Initialize the reference counter of the sqlite3_stmt :
     // used to share the mStmtPtr between Statement and Column objects;
@@ -420,6 +848,25 @@ Statement::Ptr::Ptr(sqlite3* apSQLite, std::string& aQuery) :
     mpRefCount = new unsigned int(1);  // NOLINT(readability/casting)
 }
 
+/**
+ * @brief Prepare the statement and initialize its reference counter, setting an error code instead of throwing.
+ *
+ *  On error, the pointer to the sqlite3_stmt is NULL, which the sqlite3_* functions reject with SQLITE_MISUSE.
+ *
+ * @param[in]  apSQLite Pointer to the SQLite Database Connection Handle
+ * @param[in]  aQuery   SQL query
+ * @param[out] aError   the error of the preparation, or an empty error code
+ */
+Statement::Ptr::Ptr(sqlite3* apSQLite, std::string& aQuery, std::error_code& aError) :
+    mpSQLite(apSQLite),
+    mpStmt(NULL),
+    mpRefCount(NULL)
+{
+    aError = to_error_code(sqlite3_prepare_v2(apSQLite, aQuery.c_str(), static_cast<int>(aQuery.size()),
+                                              &mpStmt, NULL));
+    mpRefCount = new unsigned int(1);  // NOLINT(readability/casting)
+}
+
 /**
  * @brief Copy constructor increments the ref counter
  *
@@ -443,7 +890,53 @@ Statement::Ptr::Ptr(const Statement::Ptr& aPtr) :
  */
 Statement::Ptr::~Ptr()
 {
-    assert(NULL != mpRefCount);
+    release();
+}
+
+/**
+ * @brief Move constructor takes the reference of the other pointer, leaving it empty
+ *
+ * @param[in] aPtr Pointer to move
+ */
+Statement::Ptr::Ptr(Statement::Ptr&& aPtr) noexcept :
+    mpSQLite(aPtr.mpSQLite),
+    mpStmt(aPtr.mpStmt),
+    mpRefCount(aPtr.mpRefCount)
+{
+    aPtr.mpSQLite = NULL;
+    aPtr.mpStmt = NULL;
+    aPtr.mpRefCount = NULL;
+}
+
+/**
+ * @brief Release the reference of this pointer, then take the one of the other pointer
+ *
+ * @param[in] aPtr Pointer to move
+ */
+Statement::Ptr& Statement::Ptr::operator=(Statement::Ptr&& aPtr) noexcept
+{
+    if (this != &aPtr)
+    {
+        release();
+        mpSQLite = aPtr.mpSQLite;
+        mpStmt = aPtr.mpStmt;
+        mpRefCount = aPtr.mpRefCount;
+        aPtr.mpSQLite = NULL;
+        aPtr.mpStmt = NULL;
+        aPtr.mpRefCount = NULL;
+    }
+    return *this;
+}
+
+/**
+ * @brief Decrement the ref counter and finalize the sqlite3_stmt when it reaches 0, unless moved from
+ */
+void Statement::Ptr::release() noexcept
+{
+    if (NULL == mpRefCount)
+    {
+        return; // moved to another pointer
+    }
     assert(0 != *mpRefCount);
 
     // Decrement and check the reference counter of the sqlite3_stmt
@@ -0,0 +1,367 @@
+/**
+ * @file    TableFunction.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Table-valued SQL functions streaming the rows of C++ generators.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/TableFunction.h>
+
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Utils.h>
+
+#include <sqlite3.h>
+#include <memory>
+#include <new>
+#include <string.h>
+
+
+namespace SQLite
+{
+namespace detail
+{
+
+
+namespace
+{
+
+/// The virtual table of a table-valued function for a connection
+struct Vtab : public sqlite3_vtab
+{
+    TableFunctionBase* pFunction;   ///< The function, given as client data of the module
+};
+
+/// A cursor reading the rows of one call of the function
+struct Cursor : public sqlite3_vtab_cursor
+{
+    std::vector<sqlite3_value*> args;       ///< Copies of the arguments, valid as long as the rows
+    std::unique_ptr<RowSource>  pRows;      ///< Rows generated by the function
+    sqlite3_int64               rowid;      ///< Number of the current row, from 1
+    bool                        bEof;       ///< true once the rows are exhausted
+
+    ~Cursor()
+    {
+        clear();
+    }
+
+    /// Release the rows, then the arguments they may refer to
+    void clear() noexcept // nothrow
+    {
+        pRows.reset();
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            sqlite3_value_free(args[i]);
+        }
+        args.clear();
+    }
+};
+
+/// Return the function of a virtual table
+TableFunctionBase& getFunction(sqlite3_vtab* apVtab) noexcept // nothrow
+{
+    return *static_cast<Vtab*>(apVtab)->pFunction;
+}
+
+/// Set the error message of a virtual table, returning the error code
+int setVtabError(sqlite3_vtab* apVtab, const char* apMessage) noexcept // nothrow
+{
+    sqlite3_free(apVtab->zErrMsg);
+    apVtab->zErrMsg = sqlite3_mprintf("%s", apMessage);
+    return SQLITE_ERROR;
+}
+
+// xConnect: declare the columns of the rows, and the arguments as hidden columns
+int connect(sqlite3* apSQLite, void* apAux, int, const char* const*, sqlite3_vtab** appVtab, char**) noexcept
+{
+    TableFunctionBase* pFunction = static_cast<TableFunctionBase*>(apAux);
+    const int ret = sqlite3_declare_vtab(apSQLite, pFunction->getDeclaration().c_str());
+    if (SQLITE_OK != ret)
+    {
+        return ret;
+    }
+    Vtab* pVtab = new (std::nothrow) Vtab();
+    if (nullptr == pVtab)
+    {
+        return SQLITE_NOMEM;
+    }
+    pVtab->pFunction = pFunction;
+    *appVtab = pVtab;
+    return SQLITE_OK;
+}
+
+// xDisconnect and xDestroy: release the virtual table of the connection, not the function
+int disconnect(sqlite3_vtab* apVtab) noexcept // nothrow
+{
+    delete static_cast<Vtab*>(apVtab);
+    return SQLITE_OK;
+}
+
+// xBestIndex: require an equality constraint on each argument, given to xFilter in the order of the arguments
+int bestIndex(sqlite3_vtab* apVtab, sqlite3_index_info* apInfo) noexcept // nothrow
+{
+    const TableFunctionBase& function = getFunction(apVtab);
+    const int nbColumns = function.getColumnCount();
+    const int nbArgs = function.getArgCount();
+    std::vector<int> constraints(static_cast<size_t>(nbArgs), -1);
+    bool bUnusable = false;
+    for (int i = 0; i < apInfo->nConstraint; ++i)
+    {
+        const sqlite3_index_info::sqlite3_index_constraint& constraint = apInfo->aConstraint[i];
+        const int arg = constraint.iColumn - nbColumns;
+        if ((arg < 0) || (SQLITE_INDEX_CONSTRAINT_EQ != constraint.op))
+        {
+            continue;
+        }
+        if (!constraint.usable)
+        {
+            bUnusable = true;
+        }
+        else if (constraints[static_cast<size_t>(arg)] < 0)
+        {
+            constraints[static_cast<size_t>(arg)] = i;
+        }
+    }
+    for (int arg = 0; arg < nbArgs; ++arg)
+    {
+        const int constraint = constraints[static_cast<size_t>(arg)];
+        if (constraint < 0)
+        {
+            if (!bUnusable)
+            {
+                return setVtabError(apVtab, "missing argument of a table-valued function");
+            }
+            // An argument given by a table not joined yet asks SQLite for another order of the joins
+#if SQLITE_VERSION_NUMBER >= 3026000
+            return SQLITE_CONSTRAINT;
+#else
+            // SQLITE_CONSTRAINT only means "unusable plan" since SQLite 3.26: make the plan too costly instead
+            for (int i = 0; i < apInfo->nConstraint; ++i)
+            {
+                apInfo->aConstraintUsage[i].argvIndex = 0;
+                apInfo->aConstraintUsage[i].omit = 0;
+            }
+            apInfo->estimatedCost = 2147483647.0;
+#if SQLITE_VERSION_NUMBER >= 3008002
+            apInfo->estimatedRows = 2147483647;
+#endif
+            return SQLITE_OK;
+#endif
+        }
+        apInfo->aConstraintUsage[constraint].argvIndex = arg + 1;
+        apInfo->aConstraintUsage[constraint].omit = 1;
+    }
+    apInfo->estimatedCost = 1000.0;
+#if SQLITE_VERSION_NUMBER >= 3008002
+    apInfo->estimatedRows = 1000;
+#endif
+    return SQLITE_OK;
+}
+
+// xOpen: create a cursor, the function being called by xFilter
+int open(sqlite3_vtab*, sqlite3_vtab_cursor** appCursor) noexcept // nothrow
+{
+    Cursor* pCursor = new (std::nothrow) Cursor();
+    if (nullptr == pCursor)
+    {
+        return SQLITE_NOMEM;
+    }
+    pCursor->bEof = true;
+    *appCursor = pCursor;
+    return SQLITE_OK;
+}
+
+// xClose
+int close(sqlite3_vtab_cursor* apCursor) noexcept // nothrow
+{
+    delete static_cast<Cursor*>(apCursor);
+    return SQLITE_OK;
+}
+
+// xFilter: call the function with copies of its arguments, and generate the first row
+int filter(sqlite3_vtab_cursor* apCursor, int, const char*, int aNbArgs, sqlite3_value** apArgs) noexcept
+{
+    Cursor& cursor = *static_cast<Cursor*>(apCursor);
+    cursor.clear();
+    cursor.bEof = true;
+    if (aNbArgs != getFunction(apCursor->pVtab).getArgCount())
+    {
+        // only with the costly plan of unusable arguments, chosen when there is no other one
+        return setVtabError(apCursor->pVtab, "missing argument of a table-valued function");
+    }
+    try
+    {
+        for (int i = 0; i < aNbArgs; ++i)
+        {
+            sqlite3_value* pValue = sqlite3_value_dup(apArgs[i]);
+            if (nullptr == pValue)
+            {
+                return SQLITE_NOMEM;
+            }
+            cursor.args.push_back(pValue);
+        }
+        cursor.pRows.reset(getFunction(apCursor->pVtab).call(cursor.args.data()));
+        cursor.rowid = 1;
+        cursor.bEof = !cursor.pRows->next();
+        return SQLITE_OK;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return SQLITE_NOMEM;
+    }
+    catch (const std::exception& e)
+    {
+        return setVtabError(apCursor->pVtab, e.what());
+    }
+    catch (...)
+    {
+        return setVtabError(apCursor->pVtab, "unknown exception in a table-valued function");
+    }
+}
+
+// xNext: generate the next row
+int next(sqlite3_vtab_cursor* apCursor) noexcept // nothrow
+{
+    Cursor& cursor = *static_cast<Cursor*>(apCursor);
+    try
+    {
+        ++cursor.rowid;
+        cursor.bEof = !cursor.pRows->next();
+        return SQLITE_OK;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return SQLITE_NOMEM;
+    }
+    catch (const std::exception& e)
+    {
+        return setVtabError(apCursor->pVtab, e.what());
+    }
+    catch (...)
+    {
+        return setVtabError(apCursor->pVtab, "unknown exception in a table-valued function");
+    }
+}
+
+// xEof
+int eof(sqlite3_vtab_cursor* apCursor) noexcept // nothrow
+{
+    return static_cast<Cursor*>(apCursor)->bEof ? 1 : 0;
+}
+
+// xColumn: a value of the current row, or an argument for the hidden columns
+int column(sqlite3_vtab_cursor* apCursor, sqlite3_context* apContext, int aColumn) noexcept // nothrow
+{
+    const Cursor& cursor = *static_cast<Cursor*>(apCursor);
+    const int nbColumns = getFunction(apCursor->pVtab).getColumnCount();
+    if (aColumn >= nbColumns)
+    {
+        sqlite3_result_value(apContext, cursor.args[static_cast<size_t>(aColumn - nbColumns)]);
+        return SQLITE_OK;
+    }
+    try
+    {
+        cursor.pRows->setResult(apContext, aColumn);
+        return SQLITE_OK;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return SQLITE_NOMEM;
+    }
+    catch (...)
+    {
+        return SQLITE_ERROR;
+    }
+}
+
+// xRowid: the number of the row in the rows of the call
+int rowid(sqlite3_vtab_cursor* apCursor, sqlite3_int64* apRowid) noexcept // nothrow
+{
+    *apRowid = static_cast<Cursor*>(apCursor)->rowid;
+    return SQLITE_OK;
+}
+
+/// Fill the module, zeroing the callbacks of the SQLite versions more recent than the headers
+sqlite3_module createModule() noexcept // nothrow
+{
+    sqlite3_module module;
+    memset(&module, 0, sizeof(module));
+    module.iVersion = 1;
+    module.xCreate = nullptr; // eponymous-only: the function exists in every schema without CREATE VIRTUAL TABLE
+    module.xConnect = &connect;
+    module.xBestIndex = &bestIndex;
+    module.xDisconnect = &disconnect;
+    module.xDestroy = &disconnect;
+    module.xOpen = &open;
+    module.xClose = &close;
+    module.xFilter = &filter;
+    module.xNext = &next;
+    module.xEof = &eof;
+    module.xColumn = &column;
+    module.xRowid = &rowid;
+    return module;
+}
+
+}  // namespace
+
+
+// Declare the columns of the rows, then the arguments as hidden columns
+TableFunctionBase::TableFunctionBase(const std::vector<std::string>& aNames, const int aNbColumns, const int aNbArgs) :
+    mNbColumns(aNbColumns),
+    mNbArgs(aNbArgs)
+{
+    const size_t nbNames = static_cast<size_t>(aNbColumns + aNbArgs);
+    if (!aNames.empty() && (aNames.size() != nbNames))
+    {
+        throw SQLite::Exception("a table-valued function needs a name for each column and each argument");
+    }
+    mDeclaration = "CREATE TABLE x(";
+    for (int i = 0; i < aNbColumns + aNbArgs; ++i)
+    {
+        if (i > 0)
+        {
+            mDeclaration += ", ";
+        }
+        if (!aNames.empty())
+        {
+            mDeclaration += quoteIdentifier(aNames[static_cast<size_t>(i)]);
+        }
+        else if (i >= aNbColumns)
+        {
+            mDeclaration += "arg" + std::to_string(i - aNbColumns + 1);
+        }
+        else
+        {
+            mDeclaration += (1 == aNbColumns) ? std::string("value") : "value" + std::to_string(i + 1);
+        }
+        if (i >= aNbColumns)
+        {
+            mDeclaration += " HIDDEN";
+        }
+    }
+    mDeclaration += ")";
+}
+
+// Destroy the function
+TableFunctionBase::~TableFunctionBase()
+{
+}
+
+// Return the sqlite3_module of the table-valued functions
+const sqlite3_module* TableFunctionBase::getModule() noexcept // nothrow
+{
+    static const sqlite3_module sModule = createModule();
+    return &sModule;
+}
+
+// xDestroy callback of the module, deleting the function
+void TableFunctionBase::destroy(void* apFunction) noexcept // nothrow
+{
+    delete static_cast<TableFunctionBase*>(apFunction);
+}
+
+
+}  // namespace detail
+}  // namespace SQLite
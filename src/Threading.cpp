@@ -0,0 +1,78 @@
+/**
+ * @file    Threading.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Threading mode of SQLite, chosen at startup.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/Threading.h>
+
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+#include <mutex>
+
+
+namespace SQLite
+{
+
+
+namespace
+{
+
+// Return the default threading mode of the SQLite library, from its SQLITE_THREADSAFE compile-time option
+ThreadingMode getDefaultMode() noexcept
+{
+    switch (sqlite3_threadsafe())
+    {
+    case 0:  return ThreadingMode::SingleThread;
+    case 2:  return ThreadingMode::MultiThread;
+    default: return ThreadingMode::Serialized;
+    }
+}
+
+std::mutex      gConfigMutex;                       // Serialize the calls to initialize()
+ThreadingMode   gMode = getDefaultMode();           // Threading mode SQLite is configured with
+
+} // namespace
+
+
+// Choose the threading mode of SQLite, with sqlite3_config(), then initialize it.
+void initialize(const ThreadingMode aMode)
+{
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    if (aMode != gMode)
+    {
+        int ret = SQLITE_OK;
+        switch (aMode)
+        {
+        case ThreadingMode::SingleThread:   ret = sqlite3_config(SQLITE_CONFIG_SINGLETHREAD); break;
+        case ThreadingMode::MultiThread:    ret = sqlite3_config(SQLITE_CONFIG_MULTITHREAD); break;
+        case ThreadingMode::Serialized:     ret = sqlite3_config(SQLITE_CONFIG_SERIALIZED); break;
+        }
+        if (SQLITE_OK != ret)
+        {
+            // SQLITE_MISUSE once initialized, SQLITE_ERROR if built without thread support
+            throw SQLite::Exception("Cannot change the threading mode of SQLite", ret);
+        }
+        gMode = aMode;
+    }
+    const int ret = sqlite3_initialize();
+    if (SQLITE_OK != ret)
+    {
+        throw SQLite::Exception("Cannot initialize SQLite", ret);
+    }
+}
+
+// Return the threading mode chosen by initialize(), or else the default mode of the SQLite library.
+ThreadingMode getThreadingMode() noexcept // nothrow
+{
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    return gMode;
+}
+
+
+}  // namespace SQLite
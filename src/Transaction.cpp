@@ -12,6 +12,7 @@
 
 #include <SQLiteCpp/Database.h>
 #include <SQLiteCpp/Assertion.h>
+#include <SQLiteCpp/Errors.h>
 
 
 namespace SQLite
@@ -20,25 +21,57 @@ namespace SQLite
 
 // Begins the SQLite transaction
 Transaction::Transaction(Database& aDatabase) :
-    mDatabase(aDatabase),
+    mpDatabase(&aDatabase),
     mbCommited(false)
 {
-    mDatabase.exec("BEGIN");
+    mpDatabase->exec("BEGIN");
+}
+
+// Begins the SQLite transaction, setting an error code instead of throwing an exception on error
+Transaction::Transaction(Database& aDatabase, std::error_code& aError) noexcept :
+    mpDatabase(&aDatabase),
+    mbCommited(false)
+{
+    mpDatabase->exec("BEGIN", aError);
+    mbCommited = static_cast<bool>(aError); // nothing to rollback
+}
+
+// Move the pending transaction to a new Transaction object
+Transaction::Transaction(Transaction&& aTransaction) noexcept : // nothrow
+    mpDatabase(aTransaction.mpDatabase),
+    mbCommited(aTransaction.mbCommited)
+{
+    aTransaction.mbCommited = true; // nothing to rollback anymore
+}
+
+// Safely rollback the current transaction if it has not been committed, then move the other one here
+Transaction& Transaction::operator=(Transaction&& aTransaction) noexcept // nothrow
+{
+    if (this != &aTransaction)
+    {
+        rollback();
+        mpDatabase = aTransaction.mpDatabase;
+        mbCommited = aTransaction.mbCommited;
+        aTransaction.mbCommited = true; // nothing to rollback anymore
+    }
+    return *this;
 }
 
 // Safely rollback the transaction if it has not been committed.
 Transaction::~Transaction()
+{
+    rollback();
+}
+
+// Rollback the transaction if it has not been committed, ignoring errors
+void Transaction::rollback() noexcept
 {
     if (false == mbCommited)
     {
-        try
-        {
-            mDatabase.exec("ROLLBACK");
-        }
-        catch (SQLite::Exception&)
-        {
-            // Never throw an exception in a destructor: error if already rollbacked, but no harm is caused by this.
-        }
+        mbCommited = true;
+        std::error_code error;
+        // Never throw an exception in a destructor: error if already rollbacked, but no harm is caused by this.
+        mpDatabase->exec("ROLLBACK", error);
     }
 }
 
@@ -47,7 +80,7 @@ void Transaction::commit()
 {
     if (false == mbCommited)
     {
-        mDatabase.exec("COMMIT");
+        mpDatabase->exec("COMMIT");
         mbCommited = true;
     }
     else
@@ -56,5 +89,19 @@ void Transaction::commit()
     }
 }
 
+// Commit the transaction, setting an error code instead of throwing an exception on error
+void Transaction::commit(std::error_code& aError) noexcept
+{
+    if (false == mbCommited)
+    {
+        mpDatabase->exec("COMMIT", aError);
+        mbCommited = !aError;
+    }
+    else
+    {
+        aError = make_error_code(Error::misuse);
+    }
+}
+
 
 }  // namespace SQLite
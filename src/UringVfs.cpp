@@ -0,0 +1,741 @@
+/**
+ * @file    UringVfs.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Linux VFS reading database files through io_uring, with asynchronous read-ahead for sequential scans.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/UringVfs.h>
+
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace SQLite
+{
+
+const char* const URING_VFS_NAME = "unix-uring";
+
+namespace
+{
+
+/**
+ * Minimal io_uring, driven through the raw system calls so that liburing is not required.
+ *
+ * Used by a single database file, that is by a single thread at a time, so it needs no lock:
+ * only the indexes shared with the kernel are accessed with atomic acquire/release operations.
+ */
+class Ring
+{
+public:
+    Ring() :
+        mFd(-1), mpSq(MAP_FAILED), mSqSize(0), mpCq(MAP_FAILED), mCqSize(0), mpSqes(nullptr), mSqesSize(0),
+        mpSqHead(nullptr), mpSqTail(nullptr), mpSqArray(nullptr), mSqMask(0), mSqEntries(0),
+        mpCqHead(nullptr), mpCqTail(nullptr), mpCqes(nullptr), mCqMask(0)
+    {
+    }
+    ~Ring()
+    {
+        close();
+    }
+
+    // Create the ring and map its queues, returning false if io_uring is not available
+    bool open(const unsigned aEntries)
+    {
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        mFd = static_cast<int>(syscall(__NR_io_uring_setup, aEntries, &params));
+        if (mFd < 0)
+        {
+            return false;
+        }
+        mSqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        mCqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool bSingleMmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+        bSingleMmap = (0 != (params.features & IORING_FEAT_SINGLE_MMAP));
+#endif
+        if (bSingleMmap)
+        {
+            mSqSize = (mSqSize > mCqSize) ? mSqSize : mCqSize;
+        }
+        mpSq = mmap(nullptr, mSqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQ_RING);
+        if (MAP_FAILED == mpSq)
+        {
+            close();
+            return false;
+        }
+        if (bSingleMmap)
+        {
+            mCqSize = 0; // shares the mapping of the submission queue
+        }
+        else
+        {
+            mpCq = mmap(nullptr, mCqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_CQ_RING);
+            if (MAP_FAILED == mpCq)
+            {
+                close();
+                return false;
+            }
+        }
+        mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* pSqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQES);
+        if (MAP_FAILED == pSqes)
+        {
+            close();
+            return false;
+        }
+        mpSqes = static_cast<io_uring_sqe*>(pSqes);
+
+        char* pSq = static_cast<char*>(mpSq);
+        char* pCq = bSingleMmap ? pSq : static_cast<char*>(mpCq);
+        mpSqHead = reinterpret_cast<unsigned*>(pSq + params.sq_off.head);
+        mpSqTail = reinterpret_cast<unsigned*>(pSq + params.sq_off.tail);
+        mpSqArray = reinterpret_cast<unsigned*>(pSq + params.sq_off.array);
+        mSqMask = *reinterpret_cast<unsigned*>(pSq + params.sq_off.ring_mask);
+        mSqEntries = params.sq_entries;
+        mpCqHead = reinterpret_cast<unsigned*>(pCq + params.cq_off.head);
+        mpCqTail = reinterpret_cast<unsigned*>(pCq + params.cq_off.tail);
+        mpCqes = reinterpret_cast<io_uring_cqe*>(pCq + params.cq_off.cqes);
+        mCqMask = *reinterpret_cast<unsigned*>(pCq + params.cq_off.ring_mask);
+        return true;
+#else
+        (void)aEntries;
+        return false;
+#endif
+    }
+
+    // Unmap the queues and close the ring
+    void close()
+    {
+        if (nullptr != mpSqes)
+        {
+            munmap(mpSqes, mSqesSize);
+            mpSqes = nullptr;
+        }
+        if ((MAP_FAILED != mpCq) && (mCqSize > 0))
+        {
+            munmap(mpCq, mCqSize);
+        }
+        mpCq = MAP_FAILED;
+        if (MAP_FAILED != mpSq)
+        {
+            munmap(mpSq, mSqSize);
+            mpSq = MAP_FAILED;
+        }
+        if (mFd >= 0)
+        {
+            ::close(mFd);
+            mFd = -1;
+        }
+    }
+
+    // Submit the read of a file into a buffer, identified by aUserData in its completion
+    bool submitRead(const int aFd, const iovec* apIov, const sqlite3_int64 aOffset, const uint64_t aUserData)
+    {
+#ifdef __NR_io_uring_enter
+        const unsigned tail = *mpSqTail;
+        if (tail - __atomic_load_n(mpSqHead, __ATOMIC_ACQUIRE) >= mSqEntries)
+        {
+            return false;
+        }
+        const unsigned index = tail & mSqMask;
+        io_uring_sqe& sqe = mpSqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = aFd;
+        sqe.addr = reinterpret_cast<uint64_t>(apIov);
+        sqe.len = 1;
+        sqe.off = static_cast<uint64_t>(aOffset);
+        sqe.user_data = aUserData;
+        mpSqArray[index] = index;
+        __atomic_store_n(mpSqTail, tail + 1, __ATOMIC_RELEASE);
+        long ret;
+        do
+        {
+            ret = syscall(__NR_io_uring_enter, mFd, 1, 0, 0, nullptr, 0);
+        } while ((ret < 0) && (EINTR == errno));
+        if (ret != 1)
+        {
+            __atomic_store_n(mpSqTail, tail, __ATOMIC_RELEASE); // not consumed by the kernel
+            return false;
+        }
+        return true;
+#else
+        (void)aFd; (void)apIov; (void)aOffset; (void)aUserData;
+        return false;
+#endif
+    }
+
+    // Wait for the next completion, returning false if the ring is broken
+    bool waitCompletion(uint64_t& aUserData, int& aResult)
+    {
+#ifdef __NR_io_uring_enter
+        for (;;)
+        {
+            const unsigned head = *mpCqHead;
+            if (head != __atomic_load_n(mpCqTail, __ATOMIC_ACQUIRE))
+            {
+                const io_uring_cqe& cqe = mpCqes[head & mCqMask];
+                aUserData = cqe.user_data;
+                aResult = cqe.res;
+                __atomic_store_n(mpCqHead, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            const long ret = syscall(__NR_io_uring_enter, mFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if ((ret < 0) && (EINTR != errno))
+            {
+                return false;
+            }
+        }
+#else
+        (void)aUserData; (void)aResult;
+        return false;
+#endif
+    }
+
+private:
+    /// @{ Ring must be non-copyable
+    Ring(const Ring&);
+    Ring& operator=(const Ring&);
+    /// @}
+
+    int             mFd;
+    void*           mpSq;
+    size_t          mSqSize;
+    void*           mpCq;
+    size_t          mCqSize;
+    io_uring_sqe*   mpSqes;
+    size_t          mSqesSize;
+    unsigned*       mpSqHead;
+    unsigned*       mpSqTail;
+    unsigned*       mpSqArray;
+    unsigned        mSqMask;
+    unsigned        mSqEntries;
+    unsigned*       mpCqHead;
+    unsigned*       mpCqTail;
+    io_uring_cqe*   mpCqes;
+    unsigned        mCqMask;
+};
+
+const unsigned  RING_ENTRIES    = 4;    // Two read-ahead requests and one synchronous read at most
+const int       READ_AHEAD_SLOTS = 2;   // Read-ahead buffers of a file, alternating
+const uint64_t  SYNC_READ       = READ_AHEAD_SLOTS; // User data of the synchronous reads
+
+// A read-ahead buffer and the range of the file it holds (or is being read into)
+struct ReadAhead
+{
+    char*           pBuffer;
+    sqlite3_int64   offset;     // -1 if empty
+    int             length;     // Bytes available once the read completed (less than the buffer at end of file)
+    bool            bInFlight;
+    iovec           iov;
+};
+
+// The sqlite3_file of the VFS, followed in memory by the one of the unix VFS
+struct UringFile
+{
+    sqlite3_file    base;
+    sqlite3_file*   pReal;                      // File of the unix VFS
+    int             fd;                         // Descriptor of a main database file, owned by pReal, else -1
+    Ring*           pRing;                      // nullptr if io_uring is not available
+    int             readAheadSize;              // Size of each read-ahead buffer, 0 if disabled
+    ReadAhead       slots[READ_AHEAD_SLOTS];
+    sqlite3_int64   lastEnd;                    // End of the last read, to detect sequential reads
+    int             sequential;                 // Number of consecutive sequential reads
+    iovec           syncIov;
+};
+
+const int FILE_SIZE = static_cast<int>((sizeof(UringFile) + 7) & ~static_cast<size_t>(7));
+
+// Leading members of the unixFile of the unix VFS (os_unix.c), unchanged since SQLite 3.7,
+// only copied out of the file (see getUnixDescriptor()) and checked before use
+struct UnixFileHeader
+{
+    const sqlite3_io_methods*   pMethod;
+    sqlite3_vfs*                pVfs;
+    void*                       pInode;
+    int                         h;      // Descriptor of the file
+};
+
+sqlite3_vfs         gVfs;
+std::mutex          gMutex;                 // Serialize the calls to registerUringVfs()
+std::atomic<bool>   gbRegistered(false);
+std::atomic<int>    gReadAheadSize(DEFAULT_URING_READ_AHEAD);
+std::atomic<bool>   gbUringFailed(false);   // io_uring_setup() failed once: do not try again
+std::atomic<uint64_t> gReads(0);
+std::atomic<uint64_t> gReadAheadHits(0);
+std::atomic<uint64_t> gReadAheadRequests(0);
+std::atomic<uint64_t> gReadAheadBytes(0);
+
+// Record the completion of a read-ahead request
+void complete(UringFile* apFile, const uint64_t aUserData, const int aResult)
+{
+    if (aUserData < static_cast<uint64_t>(READ_AHEAD_SLOTS))
+    {
+        ReadAhead& slot = apFile->slots[aUserData];
+        slot.bInFlight = false;
+        slot.length = (aResult > 0) ? aResult : 0;
+        gReadAheadBytes.fetch_add(static_cast<uint64_t>(slot.length), std::memory_order_relaxed);
+    }
+}
+
+// Wait for the completion of a read-ahead request
+void waitSlot(UringFile* apFile, ReadAhead& aSlot)
+{
+    while (aSlot.bInFlight)
+    {
+        uint64_t userData = 0;
+        int result = 0;
+        if (!apFile->pRing->waitCompletion(userData, result))
+        {
+            aSlot.bInFlight = false;
+            aSlot.offset = -1;
+            return;
+        }
+        complete(apFile, userData, result);
+    }
+}
+
+// Discard the read-ahead buffers, since the file may have been modified
+void invalidate(UringFile* apFile)
+{
+    for (int i = 0; i < READ_AHEAD_SLOTS; ++i)
+    {
+        waitSlot(apFile, apFile->slots[i]);
+        apFile->slots[i].offset = -1;
+        apFile->slots[i].length = 0;
+    }
+    apFile->lastEnd = -1;
+    apFile->sequential = 0;
+}
+
+// Read up to aAmount bytes at aOffset, returning the number of bytes read (less at end of file), or -1 on error
+int readSync(UringFile* apFile, void* apBuffer, const int aAmount, const sqlite3_int64 aOffset)
+{
+    int total = 0;
+    while (total < aAmount)
+    {
+        int result = -1;
+        apFile->syncIov.iov_base = static_cast<char*>(apBuffer) + total;
+        apFile->syncIov.iov_len = static_cast<size_t>(aAmount - total);
+        if ((nullptr != apFile->pRing) && apFile->pRing->submitRead(apFile->fd, &apFile->syncIov, aOffset + total,
+                                                                     SYNC_READ))
+        {
+            for (;;)
+            {
+                uint64_t userData = 0;
+                if (!apFile->pRing->waitCompletion(userData, result))
+                {
+                    return -1;
+                }
+                if (SYNC_READ == userData)
+                {
+                    break;
+                }
+                complete(apFile, userData, result);
+            }
+            if (-EINTR == result || -EAGAIN == result)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            do
+            {
+                result = static_cast<int>(pread(apFile->fd, apFile->syncIov.iov_base, apFile->syncIov.iov_len,
+                                                aOffset + total));
+            } while ((result < 0) && (EINTR == errno));
+        }
+        if (result < 0)
+        {
+            return -1;
+        }
+        if (0 == result)
+        {
+            break; // end of file
+        }
+        total += result;
+    }
+    return total;
+}
+
+// Start reading ahead a range of the file into a buffer
+void issueReadAhead(UringFile* apFile, ReadAhead& aSlot, const sqlite3_int64 aOffset)
+{
+    if (nullptr == aSlot.pBuffer)
+    {
+        aSlot.pBuffer = static_cast<char*>(std::malloc(static_cast<size_t>(apFile->readAheadSize)));
+        if (nullptr == aSlot.pBuffer)
+        {
+            return;
+        }
+    }
+    aSlot.offset = aOffset;
+    aSlot.length = 0;
+    aSlot.iov.iov_base = aSlot.pBuffer;
+    aSlot.iov.iov_len = static_cast<size_t>(apFile->readAheadSize);
+    gReadAheadRequests.fetch_add(1, std::memory_order_relaxed);
+    if ((nullptr != apFile->pRing)
+     && apFile->pRing->submitRead(apFile->fd, &aSlot.iov, aOffset, static_cast<uint64_t>(&aSlot - apFile->slots)))
+    {
+        aSlot.bInFlight = true;
+    }
+    else
+    {
+        // Without io_uring, read ahead synchronously: still fewer and larger system calls
+        const int result = readSync(apFile, aSlot.pBuffer, apFile->readAheadSize, aOffset);
+        aSlot.length = (result > 0) ? result : 0;
+        gReadAheadBytes.fetch_add(static_cast<uint64_t>(aSlot.length), std::memory_order_relaxed);
+    }
+}
+
+// Return true if the buffer holds (or will hold) the given offset of the file
+inline bool covers(const UringFile* apFile, const ReadAhead& aSlot, const sqlite3_int64 aOffset)
+{
+    return (aSlot.offset >= 0) && (aOffset >= aSlot.offset) && (aOffset < aSlot.offset + apFile->readAheadSize);
+}
+
+// Keep the buffers one step ahead of sequential reads
+void scheduleReadAhead(UringFile* apFile)
+{
+    int current = -1;
+    for (int i = 0; i < READ_AHEAD_SLOTS; ++i)
+    {
+        if (covers(apFile, apFile->slots[i], apFile->lastEnd))
+        {
+            current = i;
+        }
+    }
+    if (current < 0)
+    {
+        ReadAhead& slot = apFile->slots[apFile->slots[0].bInFlight ? 1 : 0];
+        waitSlot(apFile, slot);
+        issueReadAhead(apFile, slot, apFile->lastEnd);
+        return;
+    }
+    const ReadAhead& currentSlot = apFile->slots[current];
+    if (!currentSlot.bInFlight && (currentSlot.length < apFile->readAheadSize))
+    {
+        return; // end of file reached
+    }
+    const sqlite3_int64 next = currentSlot.offset + apFile->readAheadSize;
+    ReadAhead& other = apFile->slots[1 - current];
+    if (!covers(apFile, other, next))
+    {
+        waitSlot(apFile, other);
+        issueReadAhead(apFile, other, next);
+    }
+}
+
+inline UringFile* getFile(sqlite3_file* apFile)
+{
+    return reinterpret_cast<UringFile*>(apFile);
+}
+inline sqlite3_file* getReal(sqlite3_file* apFile)
+{
+    return reinterpret_cast<UringFile*>(apFile)->pReal;
+}
+
+int uringClose(sqlite3_file* apFile)
+{
+    UringFile* pFile = getFile(apFile);
+    if (pFile->fd >= 0)
+    {
+        if (nullptr != pFile->pRing)
+        {
+            invalidate(pFile);
+            delete pFile->pRing;
+            pFile->pRing = nullptr;
+        }
+        for (int i = 0; i < READ_AHEAD_SLOTS; ++i)
+        {
+            std::free(pFile->slots[i].pBuffer);
+            pFile->slots[i].pBuffer = nullptr;
+        }
+        pFile->fd = -1; // closed by the unix VFS, once no other connection holds a lock on the file
+    }
+    return pFile->pReal->pMethods->xClose(pFile->pReal);
+}
+
+int uringRead(sqlite3_file* apFile, void* apBuffer, int aAmount, sqlite3_int64 aOffset)
+{
+    UringFile* pFile = getFile(apFile);
+    if (pFile->fd < 0)
+    {
+        return pFile->pReal->pMethods->xRead(pFile->pReal, apBuffer, aAmount, aOffset);
+    }
+    gReads.fetch_add(1, std::memory_order_relaxed);
+    int ret = SQLITE_OK;
+    bool bServed = false;
+    for (int i = 0; (i < READ_AHEAD_SLOTS) && !bServed; ++i)
+    {
+        ReadAhead& slot = pFile->slots[i];
+        if (covers(pFile, slot, aOffset) && (aOffset + aAmount <= slot.offset + pFile->readAheadSize))
+        {
+            waitSlot(pFile, slot);
+            if ((slot.offset >= 0) && (aOffset + aAmount <= slot.offset + slot.length))
+            {
+                std::memcpy(apBuffer, slot.pBuffer + (aOffset - slot.offset), static_cast<size_t>(aAmount));
+                gReadAheadHits.fetch_add(1, std::memory_order_relaxed);
+                bServed = true;
+            }
+        }
+    }
+    if (!bServed)
+    {
+        const int result = readSync(pFile, apBuffer, aAmount, aOffset);
+        if (result < 0)
+        {
+            return SQLITE_IOERR_READ;
+        }
+        if (result < aAmount)
+        {
+            // SQLite requires the rest of the buffer to be zeroed on a short read
+            std::memset(static_cast<char*>(apBuffer) + result, 0, static_cast<size_t>(aAmount - result));
+            ret = SQLITE_IOERR_SHORT_READ;
+        }
+    }
+    pFile->sequential = (aOffset == pFile->lastEnd) ? (pFile->sequential + 1) : 0;
+    pFile->lastEnd = aOffset + aAmount;
+    if ((pFile->readAheadSize > 0) && (pFile->sequential >= 2) && (SQLITE_OK == ret))
+    {
+        scheduleReadAhead(pFile);
+    }
+    return ret;
+}
+
+int uringWrite(sqlite3_file* apFile, const void* apBuffer, int aAmount, sqlite3_int64 aOffset)
+{
+    UringFile* pFile = getFile(apFile);
+    if (pFile->fd >= 0)
+    {
+        invalidate(pFile);
+    }
+    return pFile->pReal->pMethods->xWrite(pFile->pReal, apBuffer, aAmount, aOffset);
+}
+
+int uringTruncate(sqlite3_file* apFile, sqlite3_int64 aSize)
+{
+    UringFile* pFile = getFile(apFile);
+    if (pFile->fd >= 0)
+    {
+        invalidate(pFile);
+    }
+    return pFile->pReal->pMethods->xTruncate(pFile->pReal, aSize);
+}
+
+int uringSync(sqlite3_file* apFile, int aFlags)
+{
+    return getReal(apFile)->pMethods->xSync(getReal(apFile), aFlags);
+}
+
+int uringFileSize(sqlite3_file* apFile, sqlite3_int64* apSize)
+{
+    return getReal(apFile)->pMethods->xFileSize(getReal(apFile), apSize);
+}
+
+int uringLock(sqlite3_file* apFile, int aLock)
+{
+    UringFile* pFile = getFile(apFile);
+    if (pFile->fd >= 0)
+    {
+        invalidate(pFile);
+    }
+    return pFile->pReal->pMethods->xLock(pFile->pReal, aLock);
+}
+
+int uringUnlock(sqlite3_file* apFile, int aLock)
+{
+    UringFile* pFile = getFile(apFile);
+    if (pFile->fd >= 0)
+    {
+        invalidate(pFile);
+    }
+    return pFile->pReal->pMethods->xUnlock(pFile->pReal, aLock);
+}
+
+int uringCheckReservedLock(sqlite3_file* apFile, int* apResOut)
+{
+    return getReal(apFile)->pMethods->xCheckReservedLock(getReal(apFile), apResOut);
+}
+
+int uringFileControl(sqlite3_file* apFile, int aOp, void* apArg)
+{
+    return getReal(apFile)->pMethods->xFileControl(getReal(apFile), aOp, apArg);
+}
+
+int uringSectorSize(sqlite3_file* apFile)
+{
+    return getReal(apFile)->pMethods->xSectorSize(getReal(apFile));
+}
+
+int uringDeviceCharacteristics(sqlite3_file* apFile)
+{
+    return getReal(apFile)->pMethods->xDeviceCharacteristics(getReal(apFile));
+}
+
+int uringShmMap(sqlite3_file* apFile, int aRegion, int aSize, int abExtend, void volatile** appMemory)
+{
+    return getReal(apFile)->pMethods->xShmMap(getReal(apFile), aRegion, aSize, abExtend, appMemory);
+}
+
+int uringShmLock(sqlite3_file* apFile, int aOffset, int aCount, int aFlags)
+{
+    UringFile* pFile = getFile(apFile);
+    if (pFile->fd >= 0)
+    {
+        invalidate(pFile);
+    }
+    return pFile->pReal->pMethods->xShmLock(pFile->pReal, aOffset, aCount, aFlags);
+}
+
+void uringShmBarrier(sqlite3_file* apFile)
+{
+    getReal(apFile)->pMethods->xShmBarrier(getReal(apFile));
+}
+
+int uringShmUnmap(sqlite3_file* apFile, int abDelete)
+{
+    return getReal(apFile)->pMethods->xShmUnmap(getReal(apFile), abDelete);
+}
+
+int uringFetch(sqlite3_file* apFile, sqlite3_int64 aOffset, int aAmount, void** appMemory)
+{
+    return getReal(apFile)->pMethods->xFetch(getReal(apFile), aOffset, aAmount, appMemory);
+}
+
+int uringUnfetch(sqlite3_file* apFile, sqlite3_int64 aOffset, void* apMemory)
+{
+    return getReal(apFile)->pMethods->xUnfetch(getReal(apFile), aOffset, apMemory);
+}
+
+const sqlite3_io_methods sUringMethods = {
+    3, uringClose, uringRead, uringWrite, uringTruncate, uringSync, uringFileSize, uringLock, uringUnlock,
+    uringCheckReservedLock, uringFileControl, uringSectorSize, uringDeviceCharacteristics,
+    uringShmMap, uringShmLock, uringShmBarrier, uringShmUnmap, uringFetch, uringUnfetch
+};
+
+// Return the descriptor of a file opened by the unix VFS, or -1 if its layout is not the expected one
+int getUnixDescriptor(const sqlite3_file* apReal, const sqlite3_vfs* apBase, const char* apName)
+{
+    UnixFileHeader header;
+    std::memcpy(&header, apReal, sizeof(header)); // szOsFile checked by registerUringVfs()
+    struct stat opened;
+    struct stat named;
+    if ((header.pMethod != apReal->pMethods) || (header.pVfs != apBase) || (header.h < 0)
+     || (0 != fstat(header.h, &opened)) || (0 != stat(apName, &named))
+     || (opened.st_dev != named.st_dev) || (opened.st_ino != named.st_ino))
+    {
+        return -1; // the reads go through the unix VFS
+    }
+    return header.h;
+}
+
+// sqlite3_vfs::xOpen: open the file with the unix VFS, and read the main database files through its descriptor
+int uringOpen(sqlite3_vfs* apVfs, const char* apName, sqlite3_file* apFile, int aFlags, int* apOutFlags)
+{
+    UringFile* pFile = getFile(apFile);
+    std::memset(pFile, 0, sizeof(UringFile));
+    pFile->pReal = reinterpret_cast<sqlite3_file*>(reinterpret_cast<char*>(apFile) + FILE_SIZE);
+    pFile->fd = -1;
+    pFile->lastEnd = -1;
+    for (int i = 0; i < READ_AHEAD_SLOTS; ++i)
+    {
+        pFile->slots[i].offset = -1;
+    }
+    sqlite3_vfs* pBase = static_cast<sqlite3_vfs*>(apVfs->pAppData);
+    const int ret = pBase->xOpen(pBase, apName, pFile->pReal, aFlags, apOutFlags);
+    if (nullptr == pFile->pReal->pMethods)
+    {
+        return ret;
+    }
+    pFile->base.pMethods = &sUringMethods;
+    if ((SQLITE_OK == ret) && (0 != (aFlags & SQLITE_OPEN_MAIN_DB)) && (nullptr != apName))
+    {
+        // Never open nor close an other descriptor on the file: closing any descriptor of a file releases
+        // all the POSIX advisory locks of the process on it, those of the other connections included
+        pFile->fd = getUnixDescriptor(pFile->pReal, pBase, apName);
+        if (pFile->fd >= 0)
+        {
+            pFile->readAheadSize = gReadAheadSize.load(std::memory_order_relaxed);
+            if (!gbUringFailed.load(std::memory_order_relaxed))
+            {
+                pFile->pRing = new (std::nothrow) Ring;
+                if ((nullptr != pFile->pRing) && !pFile->pRing->open(RING_ENTRIES))
+                {
+                    delete pFile->pRing;
+                    pFile->pRing = nullptr;
+                    gbUringFailed = true;
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+} // namespace
+
+
+// Register the io_uring VFS with SQLite, under the name URING_VFS_NAME.
+void registerUringVfs(const int aReadAheadBytes /* = DEFAULT_URING_READ_AHEAD */,
+                      const bool abMakeDefault /* = false */)
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    gReadAheadSize = (aReadAheadBytes > 0) ? aReadAheadBytes : 0;
+    if (!gbRegistered)
+    {
+        sqlite3_vfs* pBase = sqlite3_vfs_find("unix");
+        if ((nullptr == pBase) || (pBase->szOsFile < static_cast<int>(sizeof(UnixFileHeader))))
+        {
+            throw SQLite::Exception("The unix VFS is not available", SQLITE_ERROR);
+        }
+        // Inherit all the methods of the unix VFS except xOpen
+        gVfs = *pBase;
+        gVfs.pNext = nullptr;
+        gVfs.zName = URING_VFS_NAME;
+        gVfs.szOsFile = FILE_SIZE + pBase->szOsFile;
+        gVfs.pAppData = pBase;
+        gVfs.xOpen = uringOpen;
+    }
+    const int ret = sqlite3_vfs_register(&gVfs, abMakeDefault ? 1 : 0);
+    if (SQLITE_OK != ret)
+    {
+        throw SQLite::Exception("Cannot register the io_uring VFS", ret);
+    }
+    gbRegistered = true;
+}
+
+// Return the statistics of the io_uring VFS.
+UringVfsStats getUringVfsStats() noexcept // nothrow
+{
+    UringVfsStats stats;
+    stats.reads = gReads.load(std::memory_order_relaxed);
+    stats.readAheadHits = gReadAheadHits.load(std::memory_order_relaxed);
+    stats.readAheadRequests = gReadAheadRequests.load(std::memory_order_relaxed);
+    stats.readAheadBytes = gReadAheadBytes.load(std::memory_order_relaxed);
+    stats.bUring = gbRegistered && !gbUringFailed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+
+}  // namespace SQLite
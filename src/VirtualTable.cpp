@@ -0,0 +1,579 @@
+/**
+ * @file    VirtualTable.cpp
+ * @ingroup SQLiteCpp
+ * @brief   Virtual tables exposing C++ containers to SQL, with sorted indexes to push down filters.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#include <SQLiteCpp/VirtualTable.h>
+
+#include <SQLiteCpp/Utils.h>
+
+#include <sqlite3.h>
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <string.h>
+
+
+namespace SQLite
+{
+
+
+/// Operators of the constraints pushed down to an index, as bits of the idxNum given by xBestIndex to xFilter
+enum IndexOperator
+{
+    OPERATOR_EQ = 1,    ///< column = value
+    OPERATOR_GT = 2,    ///< column > value
+    OPERATOR_GE = 4,    ///< column >= value
+    OPERATOR_LT = 8,    ///< column < value
+    OPERATOR_LE = 16,   ///< column <= value
+    OPERATOR_BITS = 5   ///< Number of bits of the operators, the column being in the bits above them
+};
+
+/// Callbacks of the sqlite3_module of the virtual tables, with access to the internals of VirtualTableBase
+struct VirtualTableBase::Callbacks
+{
+    /// A virtual table of a connection
+    struct Vtab : public sqlite3_vtab
+    {
+        VirtualTableBase* pTable;   ///< The C++ table, given as client data of the module
+    };
+
+    /// A cursor reading rows by position in the table, or in the index of a column
+    struct Cursor : public sqlite3_vtab_cursor
+    {
+        const std::vector<size_t>*  pIndex;     ///< Index of the rows read, nullptr to read rows in order
+        size_t                      position;   ///< Current position, in the table or in the index
+        size_t                      end;        ///< Position after the last row to read
+    };
+
+    /// Return the table of a cursor
+    static const VirtualTableBase& getTable(sqlite3_vtab_cursor* apCursor) noexcept // nothrow
+    {
+        return *static_cast<Vtab*>(apCursor->pVtab)->pTable;
+    }
+
+    /// Return the row of the current position of a cursor
+    static size_t getRow(const Cursor& aCursor) noexcept // nothrow
+    {
+        return (nullptr != aCursor.pIndex) ? (*aCursor.pIndex)[aCursor.position] : aCursor.position;
+    }
+
+    // xConnect: declare the columns of the table given as client data of the module
+    static int connect(sqlite3* apSQLite, void* apAux, int, const char* const*, sqlite3_vtab** appVtab,
+                       char** apErrMsg) noexcept // nothrow
+    {
+        try
+        {
+            VirtualTableBase* pTable = static_cast<VirtualTableBase*>(apAux);
+            const int ret = sqlite3_declare_vtab(apSQLite, pTable->getDeclaration().c_str());
+            if (SQLITE_OK != ret)
+            {
+                return ret;
+            }
+            Vtab* pVtab = new Vtab();
+            pVtab->pTable = pTable;
+            *appVtab = pVtab;
+            return SQLITE_OK;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return SQLITE_NOMEM;
+        }
+        catch (const std::exception& e)
+        {
+            *apErrMsg = sqlite3_mprintf("%s", e.what());
+            return SQLITE_ERROR;
+        }
+    }
+
+    // xDisconnect and xDestroy: release the virtual table of the connection, not the C++ table
+    static int disconnect(sqlite3_vtab* apVtab) noexcept // nothrow
+    {
+        delete static_cast<Vtab*>(apVtab);
+        return SQLITE_OK;
+    }
+
+    // xBestIndex: use the index of the column with the most selective usable constraints, if any
+    static int bestIndex(sqlite3_vtab* apVtab, sqlite3_index_info* apInfo) noexcept // nothrow
+    {
+        const VirtualTableBase& table = *static_cast<Vtab*>(apVtab)->pTable;
+        const double nbRows = static_cast<double>(std::max(table.getRowCount(), static_cast<size_t>(1)));
+        const double lookupCost = std::log2(nbRows) + 1.0;
+
+        int     bestNum = -1;
+        double  bestCost = nbRows;
+        double  bestRows = nbRows;
+        int     bestConstraints[3] = { -1, -1, -1 }; // equality, lower bound and upper bound
+
+        for (int column = 0; column < static_cast<int>(table.mColumns.size()); ++column)
+        {
+            const ColumnInfo& info = table.mColumns[static_cast<size_t>(column)];
+            if (!info.bIndexed)
+            {
+                continue;
+            }
+            int operators = 0;
+            int constraints[3] = { -1, -1, -1 };
+            for (int i = 0; i < apInfo->nConstraint; ++i)
+            {
+                const sqlite3_index_info::sqlite3_index_constraint& constraint = apInfo->aConstraint[i];
+                if (!constraint.usable || (constraint.iColumn != column) || !isBinaryCollation(apInfo, i, info))
+                {
+                    continue;
+                }
+                // Only the first constraint of each kind is pushed down, SQLite checking all of them on each row
+                if ((SQLITE_INDEX_CONSTRAINT_EQ == constraint.op) && (constraints[0] < 0))
+                {
+                    constraints[0] = i;
+                    operators |= OPERATOR_EQ;
+                }
+                else if ((constraints[1] < 0) && ((SQLITE_INDEX_CONSTRAINT_GT == constraint.op) ||
+                                                  (SQLITE_INDEX_CONSTRAINT_GE == constraint.op)))
+                {
+                    constraints[1] = i;
+                    operators |= (SQLITE_INDEX_CONSTRAINT_GT == constraint.op) ? OPERATOR_GT : OPERATOR_GE;
+                }
+                else if ((constraints[2] < 0) && ((SQLITE_INDEX_CONSTRAINT_LT == constraint.op) ||
+                                                  (SQLITE_INDEX_CONSTRAINT_LE == constraint.op)))
+                {
+                    constraints[2] = i;
+                    operators |= (SQLITE_INDEX_CONSTRAINT_LT == constraint.op) ? OPERATOR_LT : OPERATOR_LE;
+                }
+            }
+
+            double rows = nbRows;
+            if (constraints[0] >= 0)
+            {
+                rows = 1.0;
+            }
+            else if ((constraints[1] >= 0) && (constraints[2] >= 0))
+            {
+                rows = nbRows / 4.0;
+            }
+            else if ((constraints[1] >= 0) || (constraints[2] >= 0))
+            {
+                rows = nbRows / 2.0;
+            }
+            else
+            {
+                continue;
+            }
+            if (lookupCost + rows < bestCost)
+            {
+                bestNum = (column << OPERATOR_BITS) | operators;
+                bestCost = lookupCost + rows;
+                bestRows = rows;
+                std::copy(constraints, constraints + 3, bestConstraints);
+            }
+        }
+
+        // Arguments of xFilter in the order of the operators bits; SQLite still checks the constraints on each row,
+        // as values of another type than the column are not pushed down
+        int argvIndex = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (bestConstraints[i] >= 0)
+            {
+                apInfo->aConstraintUsage[bestConstraints[i]].argvIndex = ++argvIndex;
+            }
+        }
+
+        // A scan of an index of numbers gives the rows in the ascending order of the column
+        // (the collation of an ORDER BY on a text column is not known)
+        if (1 == apInfo->nOrderBy && !apInfo->aOrderBy[0].desc && (apInfo->aOrderBy[0].iColumn >= 0))
+        {
+            const int column = apInfo->aOrderBy[0].iColumn;
+            const ColumnInfo& info = table.mColumns[static_cast<size_t>(column)];
+            if (info.bIndexed && (0 != strcmp(info.pType, "TEXT")))
+            {
+                if (bestNum < 0)
+                {
+                    bestNum = (column << OPERATOR_BITS);
+                }
+                if ((bestNum >> OPERATOR_BITS) == column)
+                {
+                    apInfo->orderByConsumed = 1;
+                }
+            }
+        }
+
+        apInfo->idxNum = bestNum;
+        apInfo->estimatedCost = bestCost;
+#if SQLITE_VERSION_NUMBER >= 3008002
+        apInfo->estimatedRows = static_cast<sqlite3_int64>(bestRows);
+#else
+        (void)bestRows;
+#endif
+        return SQLITE_OK;
+    }
+
+    /// Return true if a constraint on a column compares its values bytewise, as done by its index
+    static bool isBinaryCollation(sqlite3_index_info* apInfo, const int aConstraint, const ColumnInfo& aInfo) noexcept
+    {
+        if (0 != strcmp(aInfo.pType, "TEXT"))
+        {
+            return true;
+        }
+#if SQLITE_VERSION_NUMBER >= 3022000
+        const char* pCollation = sqlite3_vtab_collation(apInfo, aConstraint);
+        return (nullptr == pCollation) || (0 == sqlite3_stricmp(pCollation, "BINARY"));
+#else
+        (void)apInfo;
+        (void)aConstraint;
+        return false;
+#endif
+    }
+
+    // xOpen: create a cursor, positioned by xFilter
+    static int open(sqlite3_vtab*, sqlite3_vtab_cursor** appCursor) noexcept // nothrow
+    {
+        Cursor* pCursor = new (std::nothrow) Cursor();
+        if (nullptr == pCursor)
+        {
+            return SQLITE_NOMEM;
+        }
+        *appCursor = pCursor;
+        return SQLITE_OK;
+    }
+
+    // xClose
+    static int close(sqlite3_vtab_cursor* apCursor) noexcept // nothrow
+    {
+        delete static_cast<Cursor*>(apCursor);
+        return SQLITE_OK;
+    }
+
+    // xFilter: select the range of the index matching the constraints chosen by xBestIndex, or all the rows
+    static int filter(sqlite3_vtab_cursor* apCursor, int aIdxNum, const char*, int, sqlite3_value** apArgs) noexcept
+    {
+        Cursor& cursor = *static_cast<Cursor*>(apCursor);
+        const VirtualTableBase& table = getTable(apCursor);
+        cursor.pIndex = nullptr;
+        cursor.position = 0;
+        cursor.end = table.getRowCount();
+        if (aIdxNum < 0)
+        {
+            return SQLITE_OK;
+        }
+        const int column = aIdxNum >> OPERATOR_BITS;
+        const std::vector<size_t>& index = table.mColumns[static_cast<size_t>(column)].index;
+        if (index.size() != cursor.end)
+        {
+            sqlite3_free(apCursor->pVtab->zErrMsg);
+            apCursor->pVtab->zErrMsg = sqlite3_mprintf("rows added or removed without VirtualTableBase::refresh()");
+            return SQLITE_ERROR;
+        }
+        cursor.pIndex = &index;
+        try
+        {
+            int arg = 0;
+            for (int op = OPERATOR_EQ; op <= OPERATOR_LE; op <<= 1)
+            {
+                if (0 == (aIdxNum & op))
+                {
+                    continue;
+                }
+                sqlite3_value* pValue = apArgs[arg++];
+                if (!table.isComparable(column, pValue))
+                {
+                    continue; // no narrowing, SQLite checks the constraint on each row
+                }
+                if (op & (OPERATOR_EQ | OPERATOR_GE))
+                {
+                    cursor.position = std::max(cursor.position, table.search(column, pValue, false));
+                }
+                if (op & OPERATOR_GT)
+                {
+                    cursor.position = std::max(cursor.position, table.search(column, pValue, true));
+                }
+                if (op & (OPERATOR_EQ | OPERATOR_LE))
+                {
+                    cursor.end = std::min(cursor.end, table.search(column, pValue, true));
+                }
+                if (op & OPERATOR_LT)
+                {
+                    cursor.end = std::min(cursor.end, table.search(column, pValue, false));
+                }
+            }
+        }
+        catch (const std::bad_alloc&)
+        {
+            return SQLITE_NOMEM;
+        }
+        catch (...)
+        {
+            return SQLITE_ERROR;
+        }
+        cursor.end = std::max(cursor.position, cursor.end);
+        return SQLITE_OK;
+    }
+
+    // xNext
+    static int next(sqlite3_vtab_cursor* apCursor) noexcept // nothrow
+    {
+        ++static_cast<Cursor*>(apCursor)->position;
+        return SQLITE_OK;
+    }
+
+    // xEof
+    static int eof(sqlite3_vtab_cursor* apCursor) noexcept // nothrow
+    {
+        const Cursor& cursor = *static_cast<Cursor*>(apCursor);
+        return (cursor.position >= cursor.end) ? 1 : 0;
+    }
+
+    // xColumn: convert the value of the column of the current row to a SQL value
+    static int column(sqlite3_vtab_cursor* apCursor, sqlite3_context* apContext, int aColumn) noexcept // nothrow
+    {
+        try
+        {
+            getTable(apCursor).setResult(apContext, getRow(*static_cast<Cursor*>(apCursor)), aColumn);
+            return SQLITE_OK;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return SQLITE_NOMEM;
+        }
+        catch (...)
+        {
+            return SQLITE_ERROR;
+        }
+    }
+
+    // xRowid: the position of the row in the container
+    static int rowid(sqlite3_vtab_cursor* apCursor, sqlite3_int64* apRowid) noexcept // nothrow
+    {
+        *apRowid = static_cast<sqlite3_int64>(getRow(*static_cast<Cursor*>(apCursor)));
+        return SQLITE_OK;
+    }
+
+    /// Fill the module, zeroing the callbacks of the SQLite versions more recent than the headers
+    static sqlite3_module createModule() noexcept // nothrow
+    {
+        sqlite3_module module;
+        memset(&module, 0, sizeof(module));
+        module.iVersion = 1;
+        module.xCreate = nullptr; // eponymous-only: the table exists in every schema without CREATE VIRTUAL TABLE
+        module.xConnect = &connect;
+        module.xBestIndex = &bestIndex;
+        module.xDisconnect = &disconnect;
+        module.xDestroy = &disconnect;
+        module.xOpen = &open;
+        module.xClose = &close;
+        module.xFilter = &filter;
+        module.xNext = &next;
+        module.xEof = &eof;
+        module.xColumn = &column;
+        module.xRowid = &rowid;
+        return module;
+    }
+};
+
+
+// Create a table without any column
+VirtualTableBase::VirtualTableBase()
+{
+}
+
+// Destroy the table
+VirtualTableBase::~VirtualTableBase()
+{
+}
+
+// Declare a column, with the SQL type of its values
+void VirtualTableBase::declareColumn(const std::string& aName, const char* apType, const ColumnIndex aIndex)
+{
+    ColumnInfo info;
+    info.name = aName;
+    info.pType = apType;
+    info.bIndexed = (Indexed == aIndex);
+    mColumns.push_back(info);
+}
+
+// Sort again the indexes of the table, after a change of its rows
+void VirtualTableBase::refresh()
+{
+    const size_t nbRows = getRowCount();
+    for (size_t column = 0; column < mColumns.size(); ++column)
+    {
+        ColumnInfo& info = mColumns[column];
+        if (!info.bIndexed)
+        {
+            continue;
+        }
+        info.index.resize(nbRows);
+        for (size_t row = 0; row < nbRows; ++row)
+        {
+            info.index[row] = row;
+        }
+        const int col = static_cast<int>(column);
+        std::stable_sort(info.index.begin(), info.index.end(), [this, col](size_t aLeft, size_t aRight) {
+            return isLess(aLeft, aRight, col);
+        });
+    }
+}
+
+// Return the "CREATE TABLE x(...)" declaration of the columns, with quoted names
+std::string VirtualTableBase::getDeclaration() const
+{
+    std::string declaration = "CREATE TABLE x(";
+    for (size_t column = 0; column < mColumns.size(); ++column)
+    {
+        if (column > 0)
+        {
+            declaration += ", ";
+        }
+        declaration += quoteIdentifier(mColumns[column].name) + " ";
+        declaration += mColumns[column].pType;
+    }
+    declaration += ")";
+    return declaration;
+}
+
+// Return the sqlite3_module of the virtual tables
+const sqlite3_module* VirtualTableBase::getModule() noexcept // nothrow
+{
+    static const sqlite3_module sModule = Callbacks::createModule();
+    return &sModule;
+}
+
+// Binary search of the first position in the index of the column with a value not less (or greater) than apValue
+size_t VirtualTableBase::search(const int aColumn, sqlite3_value* apValue, const bool abUpper) const
+{
+    const std::vector<size_t>& index = mColumns[static_cast<size_t>(aColumn)].index;
+    size_t first = 0;
+    size_t count = index.size();
+    while (count > 0)
+    {
+        const size_t half = count / 2;
+        const int comparison = compare(index[first + half], aColumn, apValue);
+        if ((comparison < 0) || (abUpper && (0 == comparison)))
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return first;
+}
+
+
+namespace detail
+{
+
+// SQL type of the integer columns
+const char* getSqlType(Type<int>) noexcept // nothrow
+{
+    return "INTEGER";
+}
+const char* getSqlType(Type<unsigned int>) noexcept // nothrow
+{
+    return "INTEGER";
+}
+const char* getSqlType(Type<long>) noexcept // nothrow
+{
+    return "INTEGER";
+}
+const char* getSqlType(Type<long long>) noexcept // nothrow
+{
+    return "INTEGER";
+}
+const char* getSqlType(Type<bool>) noexcept // nothrow
+{
+    return "INTEGER";
+}
+
+// SQL type of the floating point columns
+const char* getSqlType(Type<double>) noexcept // nothrow
+{
+    return "REAL";
+}
+
+// SQL type of the text columns
+const char* getSqlType(Type<std::string>) noexcept // nothrow
+{
+    return "TEXT";
+}
+
+// Return true for an integer or floating point SQL value
+static bool isNumeric(sqlite3_value* apValue) noexcept // nothrow
+{
+    const int type = sqlite3_value_type(apValue);
+    return (SQLITE_INTEGER == type) || (SQLITE_FLOAT == type);
+}
+
+// Numbers are compared to the numeric columns
+bool isComparable(Type<int>, sqlite3_value* apValue) noexcept // nothrow
+{
+    return isNumeric(apValue);
+}
+bool isComparable(Type<unsigned int>, sqlite3_value* apValue) noexcept // nothrow
+{
+    return isNumeric(apValue);
+}
+bool isComparable(Type<long>, sqlite3_value* apValue) noexcept // nothrow
+{
+    return isNumeric(apValue);
+}
+bool isComparable(Type<long long>, sqlite3_value* apValue) noexcept // nothrow
+{
+    return isNumeric(apValue);
+}
+bool isComparable(Type<bool>, sqlite3_value* apValue) noexcept // nothrow
+{
+    return isNumeric(apValue);
+}
+bool isComparable(Type<double>, sqlite3_value* apValue) noexcept // nothrow
+{
+    return isNumeric(apValue);
+}
+
+// Texts are compared to the text columns, others being converted by the affinity of the column
+bool isComparable(Type<std::string>, sqlite3_value* apValue) noexcept // nothrow
+{
+    return (SQLITE_TEXT == sqlite3_value_type(apValue));
+}
+
+// Compare an integer to a numeric SQL value
+int compareValue(long long aValue, sqlite3_value* apValue) noexcept // nothrow
+{
+    if (SQLITE_INTEGER != sqlite3_value_type(apValue))
+    {
+        return compareValue(static_cast<double>(aValue), apValue);
+    }
+    const long long value = sqlite3_value_int64(apValue);
+    return (aValue < value) ? -1 : ((aValue > value) ? 1 : 0);
+}
+
+// Compare a floating point number to a numeric SQL value
+int compareValue(double aValue, sqlite3_value* apValue) noexcept // nothrow
+{
+    const double value = sqlite3_value_double(apValue);
+    return (aValue < value) ? -1 : ((aValue > value) ? 1 : 0);
+}
+
+// Compare a text to a SQL text bytewise, as the BINARY collation
+int compareValue(const std::string& aValue, sqlite3_value* apValue) noexcept // nothrow
+{
+    const char* pText = reinterpret_cast<const char*>(sqlite3_value_text(apValue));
+    const size_t size = static_cast<size_t>(sqlite3_value_bytes(apValue));
+    const int comparison = memcmp(aValue.data(), pText, std::min(aValue.size(), size));
+    if (0 != comparison)
+    {
+        return comparison;
+    }
+    return (aValue.size() < size) ? -1 : ((aValue.size() > size) ? 1 : 0);
+}
+
+}  // namespace detail
+
+
+}  // namespace SQLite
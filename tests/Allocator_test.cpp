@@ -0,0 +1,90 @@
+/**
+ * @file    Allocator_test.cpp
+ * @ingroup tests
+ * @brief   Test of the pluggable memory allocator for SQLite.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Allocator.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <sqlite3.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+TEST(Allocator, pool) {
+    // The allocator can only be changed while SQLite is not initialized
+    sqlite3_shutdown();
+    SQLite::configureAllocator(SQLite::Allocator::Pool);
+    EXPECT_EQ(SQLite::Allocator::Pool, SQLite::getAllocator());
+    {
+        SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+        EXPECT_THROW(SQLite::configureAllocator(SQLite::Allocator::Default), SQLite::Exception);
+
+        db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        SQLite::Statement insert(db, "INSERT INTO test VALUES (NULL, ?)");
+        for (int i = 0; i < 1000; ++i)
+        {
+            insert.bind(1, std::string(static_cast<size_t>(i % 100), 'x'));
+            insert.exec();
+            insert.reset();
+        }
+        // Other threads allocate and free through their own caches
+        std::thread reader([&db]()
+        {
+            EXPECT_EQ(1000, db.execAndGet("SELECT count(*) FROM test").getInt());
+        });
+        reader.join();
+
+        const SQLite::AllocatorStats stats = SQLite::getAllocatorStats();
+        ASSERT_FALSE(stats.sizeClasses.empty());
+        uint64_t bytesInUse = stats.largeBytesInUse;
+        uint64_t allocations = 0;
+        for (size_t i = 0; i < stats.sizeClasses.size(); ++i)
+        {
+            const SQLite::AllocatorStats::SizeClass& sizeClass = stats.sizeClasses[i];
+            EXPECT_EQ(sizeClass.blocksInUse * sizeClass.size, sizeClass.bytesInUse);
+            EXPECT_LE(sizeClass.bytesInUse, sizeClass.bytesReserved);
+            bytesInUse += sizeClass.bytesInUse;
+            allocations += sizeClass.allocations;
+        }
+        EXPECT_EQ(stats.bytesInUse, bytesInUse);
+        EXPECT_GT(stats.bytesInUse, 0u);
+        EXPECT_GE(stats.peakBytesInUse, stats.bytesInUse);
+        EXPECT_GT(allocations, 1000u);
+
+        // Usable size and reallocation
+        void* pMemory = sqlite3_malloc(20);
+        ASSERT_NE(nullptr, pMemory);
+        EXPECT_EQ(32, sqlite3_msize(pMemory));
+        pMemory = sqlite3_realloc(pMemory, 30);
+        EXPECT_EQ(32, sqlite3_msize(pMemory));
+        pMemory = sqlite3_realloc(pMemory, 100000);
+        ASSERT_NE(nullptr, pMemory);
+        EXPECT_EQ(100000, sqlite3_msize(pMemory));
+        sqlite3_free(pMemory);
+    }
+    const uint64_t peak = SQLite::getAllocatorStats().peakBytesInUse;
+    SQLite::resetAllocatorPeak();
+    EXPECT_LT(SQLite::getAllocatorStats().peakBytesInUse, peak);
+
+    // Back to the default allocator once SQLite has freed all its memory
+    sqlite3_shutdown();
+    EXPECT_EQ(0u, SQLite::getAllocatorStats().bytesInUse);
+    SQLite::configureAllocator(SQLite::Allocator::Default);
+    EXPECT_EQ(SQLite::Allocator::Default, SQLite::getAllocator());
+    EXPECT_EQ(0u, SQLite::getAllocatorStats().sizeClasses[0].bytesReserved);
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    EXPECT_EQ(0u, SQLite::getAllocatorStats().bytesInUse);
+
+    // Not while SQLite is initialized
+    EXPECT_THROW(SQLite::configureAllocator(SQLite::Allocator::Pool), SQLite::Exception);
+}
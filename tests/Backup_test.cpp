@@ -113,3 +113,20 @@ TEST(Backup, executeStepException) {
     remove("backup_test.db3");
     remove("backup_test.db3.backup");
 }
+
+TEST(Backup, move) {
+    SQLite::Database srcDB(":memory:", SQLite::OPEN_READWRITE);
+    srcDB.exec("CREATE TABLE backup_test (id INTEGER PRIMARY KEY, value TEXT)");
+    ASSERT_EQ(1, srcDB.exec("INSERT INTO backup_test VALUES (1, \"first\")"));
+    SQLite::Database destDB(":memory:", SQLite::OPEN_READWRITE);
+    SQLite::Database otherDB(":memory:", SQLite::OPEN_READWRITE);
+
+    SQLite::Backup backup(otherDB, srcDB);
+    SQLite::Backup moved(std::move(backup));
+    moved = SQLite::Backup(destDB, srcDB); // finish the backup to otherDB, without any step
+    ASSERT_EQ(SQLITE_DONE, moved.executeStep());
+    EXPECT_EQ(0, moved.getRemainingPageCount());
+
+    EXPECT_EQ(1, destDB.execAndGet("SELECT count(*) FROM backup_test").getInt());
+    EXPECT_FALSE(otherDB.tableExists("backup_test"));
+}
@@ -0,0 +1,159 @@
+/**
+ * @file    BulkImporter_test.cpp
+ * @ingroup tests
+ * @brief   Test of the import of CSV and delimited files into a table.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/BulkImporter.h>
+#include <SQLiteCpp/Database.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+TEST(BulkImporter, csv) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.exec("CREATE TABLE person (id INTEGER PRIMARY KEY, name TEXT, comment TEXT)");
+
+    SQLite::BulkImportOptions options;
+    options.bHeader = true;
+    options.bEmptyAsNull = true;
+    options.parsers = 2;
+    SQLite::BulkImporter importer(db, "person", std::vector<std::string>(), options);
+    EXPECT_EQ(3u, importer.getColumnCount());
+
+    std::istringstream input("id,name,comment\r\n"
+                             "1,first,plain\r\n"
+                             "\r\n"
+                             "2,\"second, with a comma\",\"a \"\"quoted\"\" word\"\n"
+                             "3,\"multi\nline\",\n"
+                             "4,\"\",last");
+    const SQLite::BulkImportStats stats = importer.importStream(input);
+    EXPECT_EQ(4u, stats.rows);
+    EXPECT_EQ(input.str().size(), stats.bytes);
+    EXPECT_EQ(1u, stats.chunks);
+
+    EXPECT_EQ(4, db.execAndGet("SELECT count(*) FROM person").getInt());
+    EXPECT_EQ("plain", db.execAndGet("SELECT comment FROM person WHERE id=1").getString());
+    EXPECT_EQ("second, with a comma", db.execAndGet("SELECT name FROM person WHERE id=2").getString());
+    EXPECT_EQ("a \"quoted\" word", db.execAndGet("SELECT comment FROM person WHERE id=2").getString());
+    EXPECT_EQ("multi\nline", db.execAndGet("SELECT name FROM person WHERE id=3").getString());
+    EXPECT_TRUE(db.execAndGet("SELECT comment FROM person WHERE id=3").isNull());
+    EXPECT_EQ("", db.execAndGet("SELECT name FROM person WHERE id=4").getString());
+    EXPECT_FALSE(db.execAndGet("SELECT name FROM person WHERE id=4").isNull());
+    EXPECT_EQ("last", db.execAndGet("SELECT comment FROM person WHERE id=4").getString());
+
+    // The same statement imports another stream, into the given columns only
+    SQLite::BulkImportOptions tsv;
+    tsv.delimiter = '\t';
+    tsv.bBulkPragmas = false;
+    SQLite::BulkImporter names(db, "person", {"name", "id"}, tsv);
+    std::istringstream tabs("fifth\t5\nsixth, with a comma\t6\n");
+    EXPECT_EQ(2u, names.importStream(tabs).rows);
+    EXPECT_EQ("sixth, with a comma", db.execAndGet("SELECT name FROM person WHERE id=6").getString());
+    EXPECT_TRUE(db.execAndGet("SELECT comment FROM person WHERE id=6").isNull());
+
+    // Names with double quotes
+    db.exec("CREATE TABLE \"odd \"\"name\"\"\" (\"a\"\"b\" TEXT)");
+    SQLite::BulkImporter odd(db, "odd \"name\"");
+    std::istringstream values("x\ny\n");
+    EXPECT_EQ(2u, odd.importStream(values).rows);
+    EXPECT_EQ("y", db.execAndGet("SELECT max(\"a\"\"b\") FROM \"odd \"\"name\"\"\"").getString());
+
+    EXPECT_THROW(SQLite::BulkImporter(db, "missing"), SQLite::Exception);
+    EXPECT_THROW(SQLite::BulkImporter(db, "person", {"missing"}), SQLite::Exception);
+}
+
+TEST(BulkImporter, chunks) {
+    const char* const csvFilename = "test_bulk_import.csv";
+    {
+        std::ofstream csv(csvFilename, std::ios::out | std::ios::binary);
+        for (int i = 0; i < 1000; ++i)
+        {
+            // records spread over many small chunks, some of them with quoted newlines
+            csv << i << ",\"value " << i << ((i % 7) ? "" : "\non two lines") << "\"\n";
+        }
+        csv << "1000,\"" << std::string(500, 'x') << "\"\n"; // a record larger than a chunk
+    }
+
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    const int synchronous = db.execAndGet("PRAGMA synchronous").getInt();
+    const int cacheSize = db.execAndGet("PRAGMA cache_size").getInt();
+
+    SQLite::BulkImportOptions options;
+    options.chunkSize = 64;
+    options.chunksInFlight = 3;
+    options.parsers = 3;
+    options.rowsPerTransaction = 100;
+    SQLite::BulkImporter importer(db, "test", std::vector<std::string>(), options);
+    const SQLite::BulkImportStats stats = importer.importFile(csvFilename);
+    EXPECT_EQ(1001u, stats.rows);
+    EXPECT_LT(100u, stats.chunks);
+    EXPECT_LE(0.0, stats.readerStall);
+    EXPECT_LT(0.0, stats.getRowsPerSecond());
+
+    EXPECT_EQ(1001, db.execAndGet("SELECT count(*) FROM test").getInt());
+    EXPECT_EQ(499500, db.execAndGet("SELECT sum(id) FROM test WHERE id < 1000").getInt());
+    EXPECT_EQ("value 7\non two lines", db.execAndGet("SELECT value FROM test WHERE id=7").getString());
+    EXPECT_EQ("value 999", db.execAndGet("SELECT value FROM test WHERE id=999").getString());
+    EXPECT_EQ(500, db.execAndGet("SELECT length(value) FROM test WHERE id=1000").getInt());
+
+    // The pragmas are restored
+    EXPECT_EQ(synchronous, db.execAndGet("PRAGMA synchronous").getInt());
+    EXPECT_EQ(cacheSize, db.execAndGet("PRAGMA cache_size").getInt());
+
+    EXPECT_THROW(importer.importFile("missing.csv"), SQLite::Exception);
+    std::remove(csvFilename);
+
+    // Only a quote at the start of a field quotes its newlines, as for the parsers
+    db.exec("DELETE FROM test");
+    for (const size_t chunkSize : {SQLite::BulkImportOptions().chunkSize, static_cast<size_t>(8)})
+    {
+        SQLite::BulkImportOptions small;
+        small.chunkSize = chunkSize;
+        SQLite::BulkImporter quotes(db, "test", std::vector<std::string>(), small);
+        std::istringstream input("1,5\" pipe\n2,\"a\nb\"\n3,c\n4,d\n");
+        EXPECT_EQ(4u, quotes.importStream(input).rows);
+        EXPECT_EQ("5\" pipe", db.execAndGet("SELECT value FROM test WHERE id=1").getString());
+        EXPECT_EQ("a\nb", db.execAndGet("SELECT value FROM test WHERE id=2").getString());
+        EXPECT_EQ("d", db.execAndGet("SELECT value FROM test WHERE id=4").getString());
+        db.exec("DELETE FROM test");
+    }
+}
+
+TEST(BulkImporter, errors) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+
+    SQLite::BulkImportOptions options;
+    options.chunkSize = 16;
+    options.rowsPerTransaction = 2;
+    SQLite::BulkImporter importer(db, "test", std::vector<std::string>(), options);
+
+    // The rows of the transactions committed before the error stay in the table
+    std::istringstream fields("1,a\n2,b\n3,c\n4\n5,e\n");
+    EXPECT_THROW(importer.importStream(fields), SQLite::Exception);
+    EXPECT_EQ(2, db.execAndGet("SELECT count(*) FROM test").getInt());
+
+    std::istringstream unterminated("6,\"f\n");
+    EXPECT_THROW(importer.importStream(unterminated), SQLite::Exception);
+    std::istringstream afterQuote("7,\"g\"h\n");
+    EXPECT_THROW(importer.importStream(afterQuote), SQLite::Exception);
+    std::istringstream constraint("1,duplicate\n");
+    EXPECT_THROW(importer.importStream(constraint), SQLite::Exception);
+    EXPECT_EQ(2, db.execAndGet("SELECT count(*) FROM test").getInt());
+    EXPECT_FALSE(db.execAndGet("PRAGMA synchronous").getInt() == 0);
+
+    // The importer is still usable after an error
+    std::istringstream valid("8,h\n9,i");
+    EXPECT_EQ(2u, importer.importStream(valid).rows);
+    EXPECT_EQ(4, db.execAndGet("SELECT count(*) FROM test").getInt());
+}
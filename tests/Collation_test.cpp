@@ -0,0 +1,113 @@
+/**
+ * @file    Collation_test.cpp
+ * @ingroup tests
+ * @brief   Test of the collating sequences implemented by C++ comparators.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+/// Return the sign of the comparison of two texts by a collation
+template<typename C>
+static int compare(const C& aCollation, const std::string& aLeft, const std::string& aRight)
+{
+    const int comparison = aCollation(aLeft.data(), aLeft.size(), aRight.data(), aRight.size());
+    return (comparison < 0) ? -1 : ((comparison > 0) ? 1 : 0);
+}
+
+/// Return the values of the first column of a query, as a text like "a,b,c"
+static std::string getNames(SQLite::Database& aDb, const char* apQuery)
+{
+    std::string names;
+    SQLite::Statement query(aDb, apQuery);
+    while (query.executeStep())
+    {
+        if (!names.empty())
+        {
+            names += ",";
+        }
+        names += query.getColumn(0).getText();
+    }
+    return names;
+}
+
+TEST(Collation, builtins) {
+    const SQLite::AsciiNoCaseCollation nocase;
+    EXPECT_EQ(0, compare(nocase, "Hello", "hELLO"));
+    EXPECT_EQ(-1, compare(nocase, "apple", "Banana"));
+    EXPECT_EQ(-1, compare(nocase, "abc", "ABCD"));
+    EXPECT_EQ(-1, compare(nocase, "_", "A")); // '_' < 'a', while '_' > 'A'
+    EXPECT_NE(0, compare(nocase, "\xC3\x89", "\xC3\xA9")); // non-ASCII letters are not folded
+    EXPECT_EQ(0, compare(nocase, "", ""));
+
+    const SQLite::NaturalCollation natural;
+    EXPECT_EQ(-1, compare(natural, "file2", "file10"));
+    EXPECT_EQ(-1, compare(natural, "v1.9", "v1.10"));
+    EXPECT_EQ(1, compare(natural, "file10", "file9.txt"));
+    EXPECT_EQ(-1, compare(natural, "1", "01"));
+    EXPECT_EQ(-1, compare(natural, "01", "2"));
+    EXPECT_EQ(0, compare(natural, "a007b", "a007b"));
+    EXPECT_EQ(-1, compare(natural, "a", "a1"));
+    EXPECT_EQ(-1, compare(natural, "123456789012345678901234567890", "123456789012345678901234567891"));
+    EXPECT_EQ(1, compare(natural, "b", "a99"));
+
+    const SQLite::Utf8BinaryCollation binary;
+    EXPECT_EQ(-1, compare(binary, "B", "a"));
+    EXPECT_EQ(-1, compare(binary, "z", "\xC3\xA9"));
+    EXPECT_EQ(-1, compare(binary, "ab", "abc"));
+    EXPECT_EQ(0, compare(binary, "", ""));
+}
+
+TEST(Collation, query) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.createCollation("ascii_nocase", SQLite::AsciiNoCaseCollation());
+    db.createCollation(std::string("natsort"), SQLite::NaturalCollation());
+    db.createCollation("utf8", SQLite::Utf8BinaryCollation());
+    db.exec("CREATE TABLE file (name TEXT)");
+    db.exec("INSERT INTO file VALUES ('file10'), ('File2'), ('file1'), ('FILE1')");
+
+    EXPECT_EQ("FILE1,File2,file1,file10", getNames(db, "SELECT name FROM file ORDER BY name COLLATE utf8"));
+    EXPECT_EQ("FILE1,file1,file10,File2", getNames(db, "SELECT name FROM file ORDER BY name COLLATE ascii_nocase, "
+                                                          "name COLLATE utf8"));
+    EXPECT_EQ("FILE1,File2,file1,file10", getNames(db, "SELECT name FROM file ORDER BY name COLLATE natsort"));
+    EXPECT_EQ(3, db.execAndGet("SELECT count(DISTINCT name COLLATE ascii_nocase) FROM file").getInt());
+    EXPECT_EQ(2, db.execAndGet("SELECT count(*) FROM file WHERE name = 'file1' COLLATE ascii_nocase").getInt());
+
+    // An index with the collation is used for the lookups and ORDER BY with the same collation
+    db.exec("CREATE INDEX file_nocase ON file(name COLLATE ascii_nocase)");
+    SQLite::Statement lookup(db, "SELECT name FROM file WHERE name = ? COLLATE ascii_nocase");
+    EXPECT_NE(std::string::npos, lookup.explainQueryPlan().toString().find("USING COVERING INDEX file_nocase"));
+    SQLite::Statement ordered(db, "SELECT name FROM file ORDER BY name COLLATE ascii_nocase");
+    EXPECT_EQ(std::string::npos, ordered.explainQueryPlan().toString().find("TEMP B-TREE"));
+
+    // An unknown collation is an error
+    EXPECT_THROW(db.exec("SELECT name FROM file ORDER BY name COLLATE unknown"), SQLite::Exception);
+}
+
+#if (__cplusplus >= 201402L) || ( defined(_MSC_VER) && (_MSC_VER >= 1900) ) // c++14: Visual Studio 2015
+TEST(Collation, lambda) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    int calls = 0;
+    db.createCollation("reverse", [&calls](const char* apLeft, size_t aLeftSize, const char* apRight, size_t aRightSize) {
+        ++calls;
+        return SQLite::Utf8BinaryCollation()(apRight, aRightSize, apLeft, aLeftSize);
+    });
+    EXPECT_EQ("c,b,a", getNames(db, "SELECT x FROM (SELECT 'a' AS x UNION ALL SELECT 'c' UNION ALL SELECT 'b') "
+                                    "ORDER BY x COLLATE reverse"));
+    EXPECT_LT(0, calls);
+
+    // Redefine the collation
+    db.createCollation("reverse", SQLite::Utf8BinaryCollation());
+    EXPECT_EQ("a,b,c", getNames(db, "SELECT x FROM (SELECT 'a' AS x UNION ALL SELECT 'c' UNION ALL SELECT 'b') "
+                                    "ORDER BY x COLLATE reverse"));
+}
+#endif // c++14
@@ -10,12 +10,15 @@
  */
 
 #include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Errors.h>
+#include <SQLiteCpp/Statement.h>
 
 #include <sqlite3.h> // for SQLITE_ERROR and SQLITE_VERSION_NUMBER
 
 #include <gtest/gtest.h>
 
 #include <cstdio>
+#include <vector>
 
 #ifdef SQLITECPP_ENABLE_ASSERT_HANDLER
 namespace SQLite
@@ -256,6 +259,153 @@ TEST(Database, execException) {
     EXPECT_STREQ("table test has 3 columns but 4 values were supplied", db.getErrorMsg());
 }
 
+TEST(Database, execErrorCode) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    std::error_code error;
+
+    EXPECT_EQ(0, db.exec("INSERT INTO test VALUES (NULL, 'first')", error));
+    EXPECT_EQ(SQLite::Error::error, error);
+    EXPECT_STREQ("no such table: test", db.getErrorMsg());
+
+    EXPECT_EQ(0, db.exec(std::string("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT UNIQUE)"), error));
+    EXPECT_FALSE(error);
+    EXPECT_EQ(2, db.exec("INSERT INTO test VALUES (NULL, 'first'), (NULL, 'second')", error));
+    EXPECT_FALSE(error);
+    EXPECT_EQ(0, db.exec("INSERT INTO test VALUES (NULL, 'first')", error));
+    EXPECT_EQ(SQLite::Error::constraint, error);
+}
+
+TEST(Database, getStats) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    for (int i = 0; i < 100; ++i)
+    {
+        db.exec("INSERT INTO test VALUES (NULL, \"value\")");
+    }
+    const SQLite::DatabaseStats before = db.getStats();
+    EXPECT_GT(before.cacheUsed, 0);
+    EXPECT_GT(before.schemaUsed, 0);
+    EXPECT_EQ(0, before.deferredFks);
+    EXPECT_GE(before.lookasideHighwater, before.lookasideUsed);
+
+    SQLite::Statement query(db, "SELECT * FROM test");
+    int nbRows = 0;
+    while (query.executeStep())
+    {
+        ++nbRows;
+    }
+    EXPECT_EQ(100, nbRows);
+    const SQLite::DatabaseStats after = db.getStats();
+    EXPECT_GT(after.stmtUsed, 0);
+
+    // The delta counts only the page cache lookups of the query, all of them hits for an in-memory database
+    const SQLite::DatabaseStats delta = after - before;
+    EXPECT_GT(delta.cacheHit, 0);
+    EXPECT_EQ(0, delta.cacheMiss);
+    EXPECT_DOUBLE_EQ(1.0, delta.getCacheHitRatio());
+    EXPECT_EQ(after.cacheUsed, delta.cacheUsed);
+
+    // Reset the counters of events
+    db.getStats(true);
+    EXPECT_EQ(0, db.getStats().cacheHit);
+    EXPECT_DOUBLE_EQ(0.0, db.getStats().getCacheHitRatio());
+}
+
+TEST(Database, lookaside) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    // The default configuration of the library is in use, but unknown
+    EXPECT_FALSE(db.getLookaside().isKnown());
+    db.execAndGet("SELECT 1");
+    SQLite::DatabaseStats defaults = db.getStats();
+    if (!sqlite3_compileoption_used("OMIT_LOOKASIDE"))
+    {
+        EXPECT_GT(defaults.lookasideHighwater, 0);
+    }
+    defaults.lookasideMissFull = 100;
+    EXPECT_FALSE(db.adviseLookaside(defaults).isKnown());
+
+    // Few small slots in a caller-provided buffer
+    static uint64_t buffer[64 * 4 / sizeof(uint64_t)];
+    db.setLookaside(64, 4, buffer);
+    EXPECT_TRUE(db.getLookaside().isKnown());
+    EXPECT_EQ(64, db.getLookaside().slotSize);
+    EXPECT_EQ(4, db.getLookaside().slotCount);
+    db.getStats(true);
+
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    for (int i = 0; i < 10; ++i)
+    {
+        db.exec("INSERT INTO test VALUES (NULL, \"value\")");
+    }
+    SQLite::DatabaseStats stats = db.getStats();
+    if (!sqlite3_compileoption_used("OMIT_LOOKASIDE"))
+    {
+        EXPECT_GT(stats.lookasideHit, 0);
+        EXPECT_GT(stats.lookasideMissSize, 0);
+        EXPECT_GT(stats.lookasideMissFull, 0);
+        EXPECT_LE(stats.lookasideHighwater, 4);
+
+        // Cannot be changed while lookaside memory is in use
+        SQLite::Statement query(db, "SELECT * FROM test");
+        EXPECT_THROW(db.setLookaside(128, 100), SQLite::Exception);
+    }
+
+    // Larger and more numerous slots are recommended when there are too many misses
+    stats.lookasideHit = 100;
+    stats.lookasideMissSize = 10;
+    stats.lookasideMissFull = 10;
+    stats.lookasideHighwater = 4;
+    const SQLite::LookasideConfig advice = db.adviseLookaside(stats);
+    EXPECT_EQ(96, advice.slotSize);
+    EXPECT_EQ(8, advice.slotCount);
+
+    // The current configuration is kept when it fits
+    stats.lookasideMissSize = 1;
+    stats.lookasideMissFull = 1;
+    EXPECT_EQ(64, db.adviseLookaside(stats).slotSize);
+    EXPECT_EQ(4, db.adviseLookaside(stats).slotCount);
+
+    // Oversized lookaside is shrunk to its peak usage
+    db.setLookaside(256, 100);
+    stats.lookasideMissSize = 0;
+    stats.lookasideMissFull = 0;
+    stats.lookasideHighwater = 20;
+    EXPECT_EQ(256, db.adviseLookaside(stats).slotSize);
+    EXPECT_EQ(25, db.adviseLookaside(stats).slotCount);
+}
+
+TEST(Database, move) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    std::vector<SQLite::Database> databases; // destroyed after the statement using one of them
+    SQLite::Statement query(db, "SELECT count(*) FROM test");
+
+    // Statements keep working, as they use the underlying connection
+    SQLite::Database moved(std::move(db));
+    EXPECT_EQ(nullptr, db.getHandle());
+    EXPECT_EQ(":memory:", moved.getFilename());
+    EXPECT_TRUE(moved.tableExists("test"));
+    moved.exec("INSERT INTO test VALUES (1, 'first')");
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(1, query.getColumn(0).getInt());
+    query.reset();
+
+    // The moved-from Database can be assigned a new connection
+    db = SQLite::Database(":memory:", SQLite::OPEN_READWRITE);
+    EXPECT_FALSE(db.tableExists("test"));
+    db.exec("CREATE TABLE other (id INTEGER PRIMARY KEY)");
+
+    // Databases can be stored by value in a container
+    databases.push_back(std::move(moved));
+    databases.push_back(std::move(db));
+    databases.emplace_back(":memory:", SQLite::OPEN_READWRITE);
+    EXPECT_TRUE(databases[0].tableExists("test"));
+    EXPECT_TRUE(databases[1].tableExists("other"));
+    EXPECT_FALSE(databases[2].tableExists("test"));
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(1, query.getColumn(0).getInt());
+}
+
 // TODO: test Database::createFunction()
 // TODO: test Database::loadExtension()
 
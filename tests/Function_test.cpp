@@ -0,0 +1,228 @@
+/**
+ * @file    Function_test.cpp
+ * @ingroup tests
+ * @brief   Test of the SQL functions and aggregates created from C++.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <sqlite3.h>
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+#if (__cplusplus >= 201402L) || ( defined(_MSC_VER) && (_MSC_VER >= 1900) ) // c++14: Visual Studio 2015
+
+static long long multiply(int aLeft, long long aRight)
+{
+    return aLeft * aRight;
+}
+
+TEST(Function, scalar) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+
+    // Function pointer, lambdas with text and floating point arguments, without argument and without result
+    db.createFunction("multiply", &multiply, SQLite::Deterministic);
+    db.createFunction("greet", [](const std::string& aName, const char* apPunctuation) {
+        return "hello " + aName + apPunctuation;
+    });
+    db.createFunction(std::string("half"), [](double aValue) { return aValue / 2; }, SQLite::Deterministic);
+    db.createFunction("answer", []() { return 42u; });
+    db.createFunction("is_even", [](long aValue) -> bool { return (aValue % 2) == 0; });
+    int calls = 0;
+    db.createFunction("count_calls", [&calls](int) { ++calls; });
+
+    EXPECT_EQ(6000000000LL, db.execAndGet("SELECT multiply(2, 3000000000)").getInt64());
+    EXPECT_EQ("hello world!", db.execAndGet("SELECT greet('world', '!')").getString());
+    EXPECT_DOUBLE_EQ(1.25, db.execAndGet("SELECT half(2.5)").getDouble());
+    EXPECT_EQ(42, db.execAndGet("SELECT answer()").getInt());
+    EXPECT_EQ(1, db.execAndGet("SELECT is_even(4)").getInt());
+    EXPECT_EQ(0, db.execAndGet("SELECT is_even(5)").getInt());
+    EXPECT_TRUE(db.execAndGet("SELECT count_calls(1)").isNull());
+    EXPECT_EQ(1, calls);
+
+    // The number of arguments is checked by SQLite
+    EXPECT_THROW(db.exec("SELECT multiply(1)"), SQLite::Exception);
+
+    // A function is called for each row, with a mutable state
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, name TEXT)");
+    db.exec("INSERT INTO test VALUES (1, 'one'), (2, 'two'), (3, NULL)");
+    long long total = 0;
+    db.createFunction("accumulate", [&total](long long aValue) mutable { total += aValue; return total; });
+    SQLite::Statement query(db, "SELECT accumulate(id), greet(name, '') FROM test ORDER BY id");
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(1, query.getColumn(0).getInt());
+    EXPECT_EQ("hello one", query.getColumn(1).getString());
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(3, query.getColumn(0).getInt());
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(6, query.getColumn(0).getInt());
+    EXPECT_EQ("hello ", query.getColumn(1).getString()); // NULL text is empty
+    EXPECT_FALSE(query.executeStep());
+
+    // Raw access to the SQL value
+    db.createFunction("type_of", [](sqlite3_value* apValue) { return sqlite3_value_type(apValue); });
+    EXPECT_EQ(SQLITE_BLOB, db.execAndGet("SELECT type_of(x'00')").getInt());
+}
+
+TEST(Function, exception) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.createFunction("check_positive", [](int aValue) {
+        if (aValue < 0)
+        {
+            throw std::invalid_argument("negative value");
+        }
+        return aValue;
+    });
+    EXPECT_EQ(1, db.execAndGet("SELECT check_positive(1)").getInt());
+    try
+    {
+        db.execAndGet("SELECT check_positive(-1)");
+        FAIL() << "an exception in a SQL function must fail the statement";
+    }
+    catch (SQLite::Exception& e)
+    {
+        EXPECT_STREQ("negative value", e.what());
+        EXPECT_EQ(SQLITE_ERROR, e.getErrorCode());
+    }
+    db.createFunction("throw_int", [](int aValue) -> int { throw aValue; });
+    EXPECT_THROW(db.execAndGet("SELECT throw_int(1)"), SQLite::Exception);
+}
+
+TEST(Function, deterministic) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value INTEGER)");
+
+    // Only deterministic functions can be used in index expressions
+    db.createFunction("twice", [](long long aValue) { return 2 * aValue; }, SQLite::Deterministic);
+    db.createFunction("random_twice", [](long long aValue) { return 2 * aValue; });
+    EXPECT_NO_THROW(db.exec("CREATE INDEX test_twice ON test(twice(value))"));
+    EXPECT_THROW(db.exec("CREATE INDEX test_random_twice ON test(random_twice(value))"), SQLite::Exception);
+}
+
+/// Number of aggregate states alive, to check that each one is destroyed
+static int sStates = 0;
+
+/// Concatenation of the texts of a group, with a separator
+struct Concat
+{
+    Concat() { ++sStates; }
+    ~Concat() { --sStates; }
+    void step(const std::string& aText, const char* apSeparator)
+    {
+        if (!result.empty())
+        {
+            result += apSeparator;
+        }
+        result += aText;
+    }
+    const std::string& finalize() const { return result; }
+
+    std::string result;
+};
+
+/// Sum of integers, failing on negative values in step() and on a zero sum in finalize()
+struct CheckedSum
+{
+    CheckedSum() { ++sStates; }
+    ~CheckedSum() { --sStates; }
+    void step(long long aValue)
+    {
+        if (aValue < 0)
+        {
+            throw std::invalid_argument("negative value");
+        }
+        sum += aValue;
+    }
+    long long finalize()
+    {
+        if (0 == sum)
+        {
+            throw std::runtime_error("zero sum");
+        }
+        return sum;
+    }
+
+    long long sum = 0;
+};
+
+TEST(Function, aggregate) {
+    sStates = 0;
+    {
+        SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+        db.createAggregate<Concat>("concat", SQLite::Deterministic);
+        db.createAggregate<CheckedSum>(std::string("checked_sum"));
+        db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, grp INTEGER, name TEXT)");
+        db.exec("INSERT INTO test VALUES (1, 1, 'a'), (2, 2, 'b'), (3, 1, 'c'), (4, 2, 'd'), (5, 3, 'e')");
+
+        // One state per group
+        SQLite::Statement query(db, "SELECT grp, concat(name, '+'), checked_sum(id) FROM test GROUP BY grp");
+        ASSERT_TRUE(query.executeStep());
+        EXPECT_EQ("a+c", query.getColumn(1).getString());
+        EXPECT_EQ(4, query.getColumn(2).getInt());
+        ASSERT_TRUE(query.executeStep());
+        EXPECT_EQ("b+d", query.getColumn(1).getString());
+        EXPECT_EQ(6, query.getColumn(2).getInt());
+        ASSERT_TRUE(query.executeStep());
+        EXPECT_EQ("e", query.getColumn(1).getString());
+        EXPECT_FALSE(query.executeStep());
+        EXPECT_EQ(0, sStates);
+
+        // Empty group
+        EXPECT_EQ("", db.execAndGet("SELECT concat(name, ',') FROM test WHERE id > 10").getString());
+        EXPECT_EQ(0, sStates);
+
+        // Exceptions in step() and finalize()
+        EXPECT_THROW(db.execAndGet("SELECT checked_sum(id - 3) FROM test"), SQLite::Exception);
+        EXPECT_THROW(db.execAndGet("SELECT checked_sum(0) FROM test"), SQLite::Exception);
+        try
+        {
+            db.execAndGet("SELECT checked_sum(id - 3) FROM test");
+        }
+        catch (SQLite::Exception& e)
+        {
+            EXPECT_STREQ("negative value", e.what());
+        }
+        EXPECT_EQ(0, sStates);
+
+        // A statement stopped in the middle of a group destroys its state
+        SQLite::Statement partial(db, "SELECT concat(name, '') FROM test GROUP BY grp");
+        ASSERT_TRUE(partial.executeStep());
+        partial.reset();
+        EXPECT_EQ(0, sStates);
+
+        // The number of arguments is checked by SQLite
+        EXPECT_THROW(db.exec("SELECT concat(name) FROM test"), SQLite::Exception);
+    }
+    EXPECT_EQ(0, sStates);
+}
+
+#ifdef SQLITECPP_HAVE_STD_OPTIONAL
+TEST(Function, optional) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.createFunction("length_or_null", [](std::optional<std::string_view> aText) -> std::optional<long long> {
+        if (!aText)
+        {
+            return std::nullopt;
+        }
+        return static_cast<long long>(aText->size());
+    }, SQLite::Deterministic);
+    db.createFunction("view", [](std::string_view aText) { return aText.substr(1); });
+
+    EXPECT_EQ(5, db.execAndGet("SELECT length_or_null('hello')").getInt());
+    EXPECT_TRUE(db.execAndGet("SELECT length_or_null(NULL)").isNull());
+    EXPECT_EQ("ello", db.execAndGet("SELECT view('hello')").getString());
+    EXPECT_FALSE(db.execAndGet("SELECT view('h')").isNull());
+    EXPECT_EQ("", db.execAndGet("SELECT view('h')").getString());
+}
+#endif
+
+#endif // c++14
@@ -0,0 +1,118 @@
+/**
+ * @file    Interrupt_test.cpp
+ * @ingroup tests
+ * @brief   Test of the deadlines and cancellation of the queries of a Database Connection.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Interrupt.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Errors.h>
+#include <SQLiteCpp/ExceptionsMapper.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/// A query running for minutes, unless interrupted
+static const char* const RUNAWAY_QUERY =
+    "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT count(*) FROM c WHERE x < 0";
+
+TEST(Interrupt, deadline)
+{
+    SQLite::Database db(":memory:");
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+        SQLite::QueryGuard guard(db, std::chrono::milliseconds(50));
+        EXPECT_FALSE(guard.isExpired());
+        EXPECT_FALSE(guard.isCancelled());
+        SQLite::Statement query(db, RUNAWAY_QUERY);
+        EXPECT_THROW(query.executeStep(), SQLite::InterruptedException);
+        EXPECT_TRUE(guard.isExpired());
+        EXPECT_FALSE(guard.isCancelled());
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    // The guard is gone with its deadline
+    SQLite::Statement query(db, "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 100000) "
+                                "SELECT count(*) FROM c");
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(100000, query.getColumn(0).getInt());
+
+    // A deadline already past fails the statements of the scope, without running them
+    {
+        SQLite::QueryGuard guard(db, std::chrono::steady_clock::now(), 1);
+        EXPECT_THROW(db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY)"), SQLite::InterruptedException);
+    }
+    EXPECT_FALSE(db.tableExists("test"));
+    EXPECT_THROW(SQLite::QueryGuard(db, std::chrono::seconds(1), 0), SQLite::Exception);
+}
+
+TEST(Interrupt, cancel)
+{
+    SQLite::Database db(":memory:");
+    SQLite::CancellationToken token;
+    EXPECT_FALSE(token.isCancelled());
+    SQLite::QueryGuard guard(db, std::chrono::seconds(60), token);
+
+    SQLite::CancellationToken copy(token);
+    std::thread canceller([copy]() mutable {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        copy.cancel();
+    });
+    SQLite::Statement query(db, RUNAWAY_QUERY);
+    EXPECT_THROW(query.exec(), SQLite::InterruptedException);
+    canceller.join();
+    EXPECT_TRUE(token.isCancelled());
+    EXPECT_TRUE(guard.isCancelled());
+    EXPECT_FALSE(guard.isExpired());
+
+    // A cancelled token stays cancelled (a query shorter than the steps between two checks still completes)
+    EXPECT_THROW(db.exec(RUNAWAY_QUERY), SQLite::InterruptedException);
+}
+
+TEST(Interrupt, interrupt)
+{
+    SQLite::Database db(":memory:");
+    std::atomic<bool> bDone(false);
+    std::thread interrupter([&db, &bDone]() {
+        while (!bDone) // until the query is running
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            db.interrupt();
+        }
+    });
+    try
+    {
+        SQLite::Statement query(db, RUNAWAY_QUERY);
+        query.executeStep();
+        ADD_FAILURE() << "the query should have been interrupted";
+    }
+    catch (const SQLite::InterruptedException& e)
+    {
+        EXPECT_EQ(9, e.getErrorCode()); // SQLITE_INTERRUPT
+        EXPECT_EQ(SQLite::make_error_code(SQLite::Error::interrupt), SQLite::map_exception_to_error_code(e));
+    }
+    bDone = true;
+    interrupter.join();
+
+    // An interruption stops only the statements running at the time
+    SQLite::Statement next(db, "SELECT 1");
+    ASSERT_TRUE(next.executeStep());
+    EXPECT_EQ(1, next.getColumn(0).getInt());
+
+    // The compilations of the statements started during an interruption are interrupted
+    db.interrupt();
+    EXPECT_THROW(SQLite::Statement(db, "SELECT 2"), SQLite::InterruptedException);
+    EXPECT_THROW(next.explainQueryPlan(), SQLite::InterruptedException);
+    next.reset();
+    SQLite::Statement last(db, "SELECT 2");
+    ASSERT_TRUE(last.executeStep());
+}
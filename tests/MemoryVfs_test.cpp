@@ -0,0 +1,95 @@
+/**
+ * @file    MemoryVfs_test.cpp
+ * @ingroup tests
+ * @brief   Test of the in-process memory VFS.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/MemoryVfs.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+TEST(MemoryVfs, sharedDatabase) {
+    SQLite::registerMemoryVfs();
+    EXPECT_FALSE(SQLite::memoryFileExists("shared.db"));
+    {
+        // The database must be created first
+        EXPECT_THROW(SQLite::Database missing("shared.db", SQLite::OPEN_READONLY, 0, SQLite::MEMORY_VFS_NAME),
+                     SQLite::Exception);
+
+        SQLite::Database writer("shared.db", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE, 1000, SQLite::MEMORY_VFS_NAME);
+        EXPECT_TRUE(SQLite::memoryFileExists("shared.db"));
+        EXPECT_EQ("wal", writer.execAndGet("PRAGMA journal_mode=WAL").getString());
+        writer.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        {
+            SQLite::Transaction transaction(writer);
+            SQLite::Statement insert(writer, "INSERT INTO test VALUES (NULL, ?)");
+            for (int i = 0; i < 1000; ++i)
+            {
+                insert.bind(1, std::string(200, 'x'));
+                insert.exec();
+                insert.reset();
+            }
+            transaction.commit();
+        }
+
+        // Other connections see the same database
+        SQLite::Database reader("shared.db", SQLite::OPEN_READONLY, 1000, SQLite::MEMORY_VFS_NAME);
+        EXPECT_EQ(1000, reader.execAndGet("SELECT count(*) FROM test").getInt());
+
+        // A reader keeps its snapshot while the writer commits
+        reader.exec("BEGIN");
+        EXPECT_EQ(1000, reader.execAndGet("SELECT count(*) FROM test").getInt());
+        writer.exec("DELETE FROM test WHERE id > 500");
+        EXPECT_EQ(1000, reader.execAndGet("SELECT count(*) FROM test").getInt());
+        reader.exec("COMMIT");
+        EXPECT_EQ(500, reader.execAndGet("SELECT count(*) FROM test").getInt());
+
+        // Readers and a writer running concurrently in different threads
+        std::thread writerThread([]()
+        {
+            SQLite::Database db("shared.db", SQLite::OPEN_READWRITE, 10000, SQLite::MEMORY_VFS_NAME);
+            for (int i = 0; i < 100; ++i)
+            {
+                db.exec("INSERT INTO test VALUES (NULL, 'concurrent')");
+            }
+        });
+        std::thread readerThread([]()
+        {
+            SQLite::Database db("shared.db", SQLite::OPEN_READONLY, 10000, SQLite::MEMORY_VFS_NAME);
+            int previous = 0;
+            for (int i = 0; i < 100; ++i)
+            {
+                const int count = db.execAndGet("SELECT count(*) FROM test WHERE value = 'concurrent'").getInt();
+                EXPECT_GE(count, previous);
+                previous = count;
+            }
+        });
+        writerThread.join();
+        readerThread.join();
+        EXPECT_EQ(100, reader.execAndGet("SELECT count(*) FROM test WHERE value = 'concurrent'").getInt());
+        EXPECT_TRUE(SQLite::memoryFileExists("shared.db-wal"));
+    }
+    // The database outlives its connections, but not its WAL
+    EXPECT_TRUE(SQLite::memoryFileExists("shared.db"));
+    EXPECT_FALSE(SQLite::memoryFileExists("shared.db-wal"));
+    {
+        SQLite::Database db("shared.db", SQLite::OPEN_READONLY, 0, SQLite::MEMORY_VFS_NAME);
+        EXPECT_EQ(600, db.execAndGet("SELECT count(*) FROM test").getInt());
+        EXPECT_EQ("ok", db.execAndGet("PRAGMA integrity_check").getString());
+    }
+    EXPECT_TRUE(SQLite::deleteMemoryFile("shared.db"));
+    EXPECT_FALSE(SQLite::deleteMemoryFile("shared.db"));
+    EXPECT_FALSE(SQLite::memoryFileExists("shared.db"));
+}
@@ -0,0 +1,91 @@
+/**
+ * @file    PageCache_test.cpp
+ * @ingroup tests
+ * @brief   Test of the pluggable page cache for SQLite.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/PageCache.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
+
+#include <sqlite3.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+TEST(PageCache, sharded) {
+    remove("pagecache_test.db3");
+
+    // The page cache can only be changed while SQLite is not initialized
+    sqlite3_shutdown();
+    SQLite::configurePageCache(SQLite::PageCache::Sharded, 256 * 1024);
+    {
+        SQLite::Database db("pagecache_test.db3", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+        EXPECT_THROW(SQLite::configurePageCache(SQLite::PageCache::Default), SQLite::Exception);
+        EXPECT_GE(SQLite::getPageCacheStats().caches, 1u);
+
+        // Write about 1MB of data, four times the budget
+        db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        SQLite::Transaction transaction(db);
+        SQLite::Statement insert(db, "INSERT INTO test VALUES (NULL, ?)");
+        for (int i = 0; i < 2000; ++i)
+        {
+            insert.bind(1, std::string(500, static_cast<char>('a' + i % 26)));
+            insert.exec();
+            insert.reset();
+        }
+        transaction.commit();
+        SQLite::resetPageCacheStats();
+
+        // Two readers share the budget
+        SQLite::Database reader1("pagecache_test.db3");
+        SQLite::Database reader2("pagecache_test.db3");
+        for (int i = 0; i < 2; ++i)
+        {
+            EXPECT_EQ(2000, reader1.execAndGet("SELECT count(*) FROM test WHERE length(value) = 500").getInt());
+            EXPECT_EQ(2000, reader2.execAndGet("SELECT count(*) FROM test WHERE length(value) = 500").getInt());
+        }
+        // Hot pages are hit again
+        for (int i = 0; i < 10; ++i)
+        {
+            EXPECT_EQ(1, reader1.execAndGet("SELECT count(*) FROM test WHERE id = 1000").getInt());
+        }
+
+        const SQLite::PageCacheStats stats = SQLite::getPageCacheStats();
+        EXPECT_EQ(256u * 1024, stats.budget);
+        EXPECT_GE(stats.caches, 3u);
+        EXPECT_GT(stats.hits, 0u);
+        EXPECT_GT(stats.misses, 0u);
+        EXPECT_GT(stats.evictions, 0u);
+        EXPECT_GT(stats.pages, 0u);
+        // The budget is only exceeded by the few pages SQLite needs pinned at once
+        EXPECT_LE(stats.bytes, stats.budget + 64 * 1024);
+        EXPECT_GT(stats.getHitRatio(), 0.0);
+        EXPECT_LT(stats.getHitRatio(), 1.0);
+
+        // Pages of a rolled back transaction are discarded
+        SQLite::Transaction rollback(db);
+        db.exec("DELETE FROM test");
+    }
+    EXPECT_EQ(0u, SQLite::getPageCacheStats().caches);
+    EXPECT_EQ(0u, SQLite::getPageCacheStats().pages);
+    EXPECT_EQ(0u, SQLite::getPageCacheStats().bytes);
+
+    // Back to the default page cache
+    sqlite3_shutdown();
+    SQLite::configurePageCache(SQLite::PageCache::Default);
+    {
+        SQLite::Database db("pagecache_test.db3");
+        EXPECT_EQ(2000, db.execAndGet("SELECT count(*) FROM test").getInt());
+        EXPECT_EQ(0u, SQLite::getPageCacheStats().caches);
+    }
+    remove("pagecache_test.db3");
+}
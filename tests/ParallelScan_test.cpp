@@ -0,0 +1,129 @@
+/**
+ * @file    ParallelScan_test.cpp
+ * @ingroup tests
+ * @brief   Test of the scan of a table split into rowid ranges.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/ParallelScan.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Snapshot.h>
+#include <SQLiteCpp/Transaction.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+
+/// Query of the "value" of the rows of a partition
+static const char* const SCAN_QUERY = "SELECT value FROM test WHERE rowid BETWEEN ?1 AND ?2";
+
+/// Add a row to a sum of the values
+static void addValue(long long& aSum, SQLite::Statement& aQuery)
+{
+    aSum += aQuery.getColumn(0).getInt64();
+}
+
+TEST(ParallelScan, ranges) {
+    const char* const filename = "test_parallel_scan.db3";
+    std::remove(filename);
+    {
+        SQLite::Database db(filename, SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+        db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value INTEGER)");
+        SQLite::ParallelScan scan(filename, "test", 4);
+        EXPECT_EQ(4u, scan.getPartitionCount());
+        EXPECT_TRUE(scan.getRanges().empty());
+        EXPECT_EQ(0, scan.reduce(SCAN_QUERY, 0LL, addValue, std::plus<long long>()));
+
+        // Fewer rowids than partitions
+        db.exec("INSERT INTO test VALUES (-1, 1), (1, 2)");
+        std::vector<SQLite::RowidRange> ranges = scan.getRanges();
+        ASSERT_EQ(3u, ranges.size());
+        EXPECT_EQ(-1, ranges[0].first);
+        EXPECT_EQ(-1, ranges[0].last);
+        EXPECT_EQ(1, ranges[2].first);
+        EXPECT_EQ(1, ranges[2].last);
+
+        // The ranges cover all the rowids, with widths differing by one at most
+        db.exec("INSERT INTO test VALUES (9, 3)");
+        ranges = scan.getRanges();
+        ASSERT_EQ(4u, ranges.size());
+        EXPECT_EQ(-1, ranges.front().first);
+        EXPECT_EQ(9, ranges.back().last);
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            const long long width = ranges[i].last - ranges[i].first + 1;
+            EXPECT_TRUE((2 == width) || (3 == width));
+            if (i > 0)
+            {
+                EXPECT_EQ(ranges[i - 1].last + 1, ranges[i].first);
+            }
+        }
+
+        // The whole range of the rowids
+        db.exec("INSERT INTO test VALUES (-9223372036854775807 - 1, 4), (9223372036854775807, 5)");
+        ranges = scan.getRanges();
+        ASSERT_EQ(4u, ranges.size());
+        EXPECT_EQ(-9223372036854775807LL - 1, ranges.front().first);
+        EXPECT_EQ(9223372036854775807LL, ranges.back().last);
+        EXPECT_EQ(15, scan.reduce(SCAN_QUERY, 0LL, addValue, std::plus<long long>()));
+
+        EXPECT_THROW(SQLite::ParallelScan(filename, "missing", 2).getRanges(), SQLite::Exception);
+    }
+    std::remove(filename);
+}
+
+TEST(ParallelScan, reduce) {
+    const char* const filename = "test_parallel_scan.db3";
+    std::remove(filename);
+    {
+        SQLite::Database db(filename, SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+        db.exec("PRAGMA journal_mode=WAL");
+        db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value INTEGER)");
+        db.exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM n WHERE i < 10000) "
+                "INSERT INTO test SELECT i, i * 2 FROM n");
+        db.exec("DELETE FROM test WHERE id BETWEEN 2000 AND 2999"); // a gap in the rowids
+
+        SQLite::ParallelScan scan(filename, "test", 3);
+        const long long expected = db.execAndGet("SELECT sum(value) FROM test").getInt64();
+        EXPECT_EQ(expected, scan.reduce(SCAN_QUERY, 0LL, addValue, std::plus<long long>()));
+
+        std::atomic<int> rows(0);
+        std::atomic<int> partitions(0);
+        scan.forEachRow("SELECT id FROM test WHERE rowid BETWEEN ?1 AND ?2 AND id % 10 = 0",
+                        [&rows, &partitions](SQLite::Statement& aQuery, size_t aPartition)
+        {
+            EXPECT_EQ(0, aQuery.getColumn(0).getInt() % 10);
+            ++rows;
+            partitions |= (1 << aPartition);
+        });
+        EXPECT_EQ(900, rows);
+        EXPECT_EQ(7, partitions);
+
+        // The error of a partition is thrown once all the partitions are done
+        EXPECT_THROW(scan.forEachRow("SELECT missing FROM test WHERE rowid BETWEEN ?1 AND ?2",
+                                     [](SQLite::Statement&, size_t) {}), SQLite::Exception);
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+        // All the partitions read the same snapshot, whatever is written meanwhile
+        SQLite::Database source(filename, SQLite::OPEN_READONLY);
+        SQLite::Transaction transaction(source);
+        (void)source.execAndGet("SELECT count(*) FROM test");
+        const SQLite::Snapshot snapshot(source);
+        db.exec("INSERT INTO test VALUES (20000, 1)");
+        scan.setSnapshot(&snapshot);
+        EXPECT_EQ(expected, scan.reduce(SCAN_QUERY, 0LL, addValue, std::plus<long long>()));
+        scan.setSnapshot(nullptr);
+        EXPECT_EQ(expected + 1, scan.reduce(SCAN_QUERY, 0LL, addValue, std::plus<long long>()));
+#endif // SQLITE_ENABLE_SNAPSHOT
+    }
+    std::remove(filename);
+    std::remove("test_parallel_scan.db3-wal");
+    std::remove("test_parallel_scan.db3-shm");
+}
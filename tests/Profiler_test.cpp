@@ -0,0 +1,142 @@
+/**
+ * @file    Profiler_test.cpp
+ * @ingroup tests
+ * @brief   Test of the statement level profiling of a Database Connection.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Profiler.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(LatencyHistogram, percentiles) {
+    SQLite::LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.getCount());
+    EXPECT_EQ(0u, histogram.getPercentile(50.0));
+
+    // Small values are exact
+    for (uint64_t value = 1; value <= 10; ++value)
+    {
+        histogram.record(value);
+    }
+    EXPECT_EQ(10u, histogram.getCount());
+    EXPECT_EQ(55u, histogram.getTotal());
+    EXPECT_EQ(10u, histogram.getMax());
+    EXPECT_EQ(5u, histogram.getPercentile(50.0));
+    EXPECT_EQ(10u, histogram.getPercentile(100.0));
+
+    // Large values are within the precision of the sub-buckets
+    histogram.reset();
+    for (uint64_t value = 1; value <= 1000; ++value)
+    {
+        histogram.record(value * 1000);
+    }
+    const uint64_t p50 = histogram.getPercentile(50.0);
+    const uint64_t p99 = histogram.getPercentile(99.0);
+    EXPECT_GE(p50, 500000u);
+    EXPECT_LE(p50, 500000u * 17 / 16);
+    EXPECT_GE(p99, 990000u);
+    EXPECT_LE(p99, 1000000u);
+    EXPECT_EQ(1000000u, histogram.getMax());
+
+    // Merge and copy
+    SQLite::LatencyHistogram other;
+    other.record(2000000);
+    histogram.merge(other);
+    const SQLite::LatencyHistogram copy(histogram);
+    EXPECT_EQ(1001u, copy.getCount());
+    EXPECT_EQ(2000000u, copy.getMax());
+}
+
+TEST(Database, profiling) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    EXPECT_TRUE(db.getProfile().empty());
+
+    db.enableProfiling(1); // record the expanded SQL of any execution slower than 1ns
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    SQLite::Statement insert(db, "INSERT INTO test VALUES (NULL, ?)");
+    for (int i = 0; i < 10; ++i)
+    {
+        insert.bind(1, "value");
+        EXPECT_EQ(1, insert.exec());
+        insert.reset();
+    }
+    SQLite::Statement query(db, "SELECT * FROM test");
+    int nbRows = 0;
+    while (query.executeStep())
+    {
+        ++nbRows;
+    }
+    EXPECT_EQ(10, nbRows);
+    query.reset();
+
+    const std::vector<SQLite::StatementProfile> profile = db.getProfile();
+    bool bInsertFound = false;
+    bool bQueryFound = false;
+    for (size_t i = 0; i < profile.size(); ++i)
+    {
+        const SQLite::StatementProfile& statement = profile[i];
+        EXPECT_GE(statement.maxNs, statement.p99Ns);
+        EXPECT_GE(statement.p99Ns, statement.p50Ns);
+        if (statement.sql == "INSERT INTO test VALUES (NULL, ?)")
+        {
+            bInsertFound = true;
+            EXPECT_EQ(10u, statement.count);
+            EXPECT_EQ(0u, statement.rows);
+            EXPECT_EQ("INSERT INTO test VALUES (NULL, 'value')", statement.slowestSql);
+            EXPECT_EQ(statement.maxNs, statement.slowestNs);
+        }
+        else if (statement.sql == "SELECT * FROM test")
+        {
+            bQueryFound = true;
+            EXPECT_EQ(1u, statement.count);
+            EXPECT_EQ(10u, statement.rows);
+        }
+    }
+    EXPECT_TRUE(bInsertFound);
+    EXPECT_TRUE(bQueryFound);
+
+    // Scrape and reset
+    EXPECT_FALSE(db.getProfile(true).empty());
+    EXPECT_TRUE(db.getProfile().empty());
+
+    // Nothing is recorded once disabled
+    db.disableProfiling();
+    db.exec("DELETE FROM test");
+    EXPECT_TRUE(db.getProfile().empty());
+
+    db.enableProfiling();
+    db.exec("DELETE FROM test");
+    EXPECT_EQ(1u, db.getProfile().size());
+    db.resetProfile();
+    EXPECT_TRUE(db.getProfile().empty());
+}
+
+TEST(Database, profilingOverflow) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+
+    // Statements beyond the table capacity are aggregated together
+    db.enableProfiling(0, 1);
+    for (int i = 0; i < 100; ++i)
+    {
+        db.execAndGet("SELECT " + std::to_string(i));
+    }
+    const std::vector<SQLite::StatementProfile> profile = db.getProfile();
+    ASSERT_FALSE(profile.empty());
+    EXPECT_LT(profile.size(), 100u);
+    EXPECT_EQ("<other>", profile.back().sql);
+    uint64_t count = 0;
+    for (size_t i = 0; i < profile.size(); ++i)
+    {
+        count += profile[i].count;
+    }
+    EXPECT_EQ(100u, count);
+}
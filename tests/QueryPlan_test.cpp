@@ -0,0 +1,72 @@
+/**
+ * @file    QueryPlan_test.cpp
+ * @ingroup tests
+ * @brief   Test of the baselines of query plans.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/QueryPlan.h>
+#include <SQLiteCpp/Database.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+TEST(QueryPlanBaseline, check) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.exec("CREATE TABLE user (id INTEGER PRIMARY KEY, email TEXT, name TEXT)");
+    db.exec("CREATE INDEX user_email ON user(email)");
+
+    SQLite::QueryPlanBaseline baseline(".");
+    baseline.add("qp_by_email", "SELECT id FROM user WHERE email = ?");
+    baseline.add("qp_by_name", "SELECT name FROM user ORDER BY name");
+    remove(baseline.getFilename("qp_by_email").c_str());
+    remove(baseline.getFilename("qp_by_name").c_str());
+
+    // Without baselines, only the query with costly steps is reported
+    std::vector<SQLite::QueryPlanBaseline::Regression> regressions = baseline.check(db);
+    ASSERT_FALSE(regressions.empty());
+    for (const SQLite::QueryPlanBaseline::Regression& regression : regressions)
+    {
+        EXPECT_EQ("qp_by_name", regression.name);
+        EXPECT_FALSE(regression.plan.empty());
+    }
+
+    // Once the baselines are written, the current plans are accepted
+    baseline.update(db);
+    std::ifstream file(baseline.getFilename("qp_by_email").c_str());
+    std::string line;
+    EXPECT_TRUE(static_cast<bool>(std::getline(file, line)));
+    EXPECT_EQ(0u, line.find("SEARCH user USING"));
+    EXPECT_TRUE(baseline.check(db).empty());
+
+    // Dropping the index makes the lookup by email a full scan
+    db.exec("DROP INDEX user_email");
+    regressions = baseline.check(db);
+    ASSERT_EQ(1u, regressions.size());
+    EXPECT_EQ("qp_by_email", regressions[0].name);
+    EXPECT_EQ("SCAN user", regressions[0].step);
+
+    // A better plan is not a regression
+    db.exec("CREATE INDEX user_name ON user(name, email)");
+    baseline.add("qp_by_email_again", "SELECT id FROM user WHERE email = ?");
+    regressions = baseline.check(db);
+    ASSERT_EQ(2u, regressions.size());
+    EXPECT_EQ("qp_by_email", regressions[0].name);
+    EXPECT_EQ("SCAN user", regressions[0].step);
+    EXPECT_EQ("qp_by_email_again", regressions[1].name);
+
+    // An invalid query is an error
+    baseline.add("qp_invalid", "SELECT id FROM missing");
+    EXPECT_THROW(baseline.check(db), SQLite::Exception);
+
+    remove(baseline.getFilename("qp_by_email").c_str());
+    remove(baseline.getFilename("qp_by_name").c_str());
+    remove(baseline.getFilename("qp_by_email_again").c_str());
+}
@@ -0,0 +1,129 @@
+/**
+ * @file    Schema_test.cpp
+ * @ingroup tests
+ * @brief   Test of the catalog of the schema of a database.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Schema.h>
+#include <SQLiteCpp/Database.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+TEST(Schema, catalog) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.exec("CREATE TABLE person (id INTEGER PRIMARY KEY, name VARCHAR(20) NOT NULL UNIQUE, "
+            "age INT DEFAULT 18, data)");
+    db.exec("CREATE INDEX person_age ON person(age, id)");
+    db.exec("CREATE INDEX person_lower ON person(lower(name))");
+    db.exec("CREATE VIEW adult AS SELECT name FROM person WHERE age >= 18");
+
+    SQLite::Schema& schema = db.getSchema();
+    EXPECT_EQ(-1, schema.getVersion());
+    const SQLite::SchemaTable* pPerson = schema.getTable("person");
+    ASSERT_NE(nullptr, pPerson);
+    EXPECT_EQ("person", pPerson->name);
+    EXPECT_FALSE(pPerson->bView);
+    ASSERT_EQ(4u, pPerson->columns.size());
+    EXPECT_EQ("id", pPerson->columns[0].name);
+    EXPECT_EQ("INTEGER", pPerson->columns[0].type);
+    EXPECT_EQ(1, pPerson->columns[0].primaryKey);
+    EXPECT_EQ("VARCHAR(20)", pPerson->columns[1].type);
+    EXPECT_TRUE(pPerson->columns[1].bNotNull);
+    EXPECT_EQ(0, pPerson->columns[1].primaryKey);
+    EXPECT_FALSE(pPerson->columns[1].bHasDefault);
+    EXPECT_TRUE(pPerson->columns[2].bHasDefault);
+    EXPECT_EQ("18", pPerson->columns[2].defaultValue);
+    EXPECT_EQ("", pPerson->columns[3].type);
+    ASSERT_NE(nullptr, pPerson->getColumn("age"));
+    EXPECT_EQ("INT", pPerson->getColumn("age")->type);
+    EXPECT_EQ(nullptr, pPerson->getColumn("AGE"));
+    EXPECT_EQ(3u, pPerson->indexes.size());
+
+    const SQLite::SchemaIndex* pAge = schema.getIndex("person_age");
+    ASSERT_NE(nullptr, pAge);
+    EXPECT_EQ("person", pAge->table);
+    EXPECT_FALSE(pAge->bUnique);
+    ASSERT_EQ(2u, pAge->columns.size());
+    EXPECT_EQ("age", pAge->columns[0]);
+    EXPECT_EQ("id", pAge->columns[1]);
+    const SQLite::SchemaIndex* pLower = schema.getIndex("person_lower");
+    ASSERT_NE(nullptr, pLower);
+    ASSERT_EQ(1u, pLower->columns.size());
+    EXPECT_EQ("", pLower->columns[0]);
+    const SQLite::SchemaIndex* pUnique = schema.getIndex("sqlite_autoindex_person_1");
+    ASSERT_NE(nullptr, pUnique);
+    EXPECT_TRUE(pUnique->bUnique);
+    EXPECT_EQ(nullptr, schema.getIndex("missing"));
+
+    const SQLite::SchemaTable* pAdult = schema.getTable("adult");
+    ASSERT_NE(nullptr, pAdult);
+    EXPECT_TRUE(pAdult->bView);
+    ASSERT_EQ(1u, pAdult->columns.size());
+    EXPECT_EQ("name", pAdult->columns[0].name);
+    EXPECT_TRUE(pAdult->indexes.empty());
+    EXPECT_FALSE(db.tableExists("adult"));
+    EXPECT_TRUE(db.tableExists("person"));
+    EXPECT_FALSE(db.tableExists("Person"));
+
+    const std::vector<std::string> names = schema.getTableNames();
+    ASSERT_EQ(2u, names.size());
+    EXPECT_EQ("adult", names[0]);
+    EXPECT_EQ("person", names[1]);
+}
+
+TEST(Schema, invalidation) {
+    const char* const filename = "test_schema.db3";
+    std::remove(filename);
+    {
+        SQLite::Database db(filename, SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+        SQLite::Schema& schema = db.getSchema();
+        EXPECT_FALSE(db.tableExists("test"));
+        const int version = schema.getVersion();
+        EXPECT_FALSE(schema.refresh());
+        EXPECT_EQ(version, schema.getVersion());
+
+        // A change of the schema by the connection, even in a transaction
+        db.exec("BEGIN");
+        db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY)");
+        EXPECT_TRUE(db.tableExists("test"));
+        EXPECT_NE(version, schema.getVersion());
+        db.exec("ROLLBACK");
+        EXPECT_FALSE(db.tableExists("test"));
+
+        // A change of the schema by another connection
+        {
+            SQLite::Database other(filename, SQLite::OPEN_READWRITE);
+            other.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        }
+        EXPECT_TRUE(db.tableExists("test"));
+        EXPECT_EQ(2u, schema.getTable("test")->columns.size());
+        db.exec("ALTER TABLE test ADD COLUMN weight REAL");
+        EXPECT_EQ("REAL", schema.getTable("test")->getColumn("weight")->type);
+        db.exec("DROP TABLE test");
+        EXPECT_EQ(nullptr, schema.getTable("test"));
+
+        // A rollback bringing back the version of a catalog loaded in the transaction
+        db.exec("BEGIN");
+        db.exec("CREATE TABLE x (id INTEGER PRIMARY KEY)");
+        EXPECT_TRUE(db.tableExists("x"));
+        db.exec("ROLLBACK");
+        db.exec("CREATE TABLE y (id INTEGER PRIMARY KEY)");
+        EXPECT_FALSE(db.tableExists("x"));
+        EXPECT_TRUE(db.tableExists("y"));
+        db.exec("DROP TABLE y");
+
+        // Data changes do not reload the catalog
+        db.exec("CREATE TABLE data (id INTEGER PRIMARY KEY)");
+        EXPECT_TRUE(db.tableExists("data"));
+        db.exec("INSERT INTO data VALUES (1)");
+        EXPECT_FALSE(schema.refresh());
+    }
+    std::remove(filename);
+}
@@ -0,0 +1,178 @@
+/**
+ * @file    ShardedDatabase_test.cpp
+ * @ingroup tests
+ * @brief   Test of a database split across several files.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/ShardedDatabase.h>
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Transaction.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(ShardedDatabase, placement) {
+    const std::vector<std::string> four(4, ":memory:");
+    SQLite::ShardedDatabase db(four);
+    EXPECT_EQ(4u, db.getShardCount());
+    EXPECT_THROW(SQLite::ShardedDatabase(std::vector<std::string>()), SQLite::Exception);
+
+    // Keys spread over all the shards, the same way for another set of connections
+    SQLite::ShardedDatabase same(four);
+    std::vector<std::string> keys;
+    std::vector<int> counts(4, 0);
+    for (int i = 0; i < 4000; ++i)
+    {
+        keys.push_back("user" + std::to_string(i));
+        const size_t shard = db.getShardIndex(keys.back());
+        ASSERT_LT(shard, 4u);
+        EXPECT_EQ(shard, same.getShardIndex(keys.back()));
+        ++counts[shard];
+    }
+    for (const int count : counts)
+    {
+        EXPECT_GT(count, 600);
+        EXPECT_LT(count, 1400);
+    }
+    EXPECT_EQ(db.getShardIndex(42LL), same.getShardIndex(42LL));
+
+    // Adding a shard only moves keys to the new shard, about a fifth of them
+    SQLite::ShardedDatabase five(std::vector<std::string>(5, ":memory:"));
+    int moved = 0;
+    for (const std::string& key : keys)
+    {
+        const size_t shard = five.getShardIndex(key);
+        if (shard != db.getShardIndex(key))
+        {
+            EXPECT_EQ(4u, shard);
+            ++moved;
+        }
+    }
+    EXPECT_GT(moved, 400);
+    EXPECT_LT(moved, 1200);
+
+    // A batch of keys grouped by shard
+    const std::vector<std::vector<size_t> > groups = db.partition(keys);
+    ASSERT_EQ(4u, groups.size());
+    for (size_t shard = 0; shard < groups.size(); ++shard)
+    {
+        EXPECT_EQ(static_cast<size_t>(counts[shard]), groups[shard].size());
+        for (const size_t index : groups[shard])
+        {
+            EXPECT_EQ(shard, db.getShardIndex(keys[index]));
+        }
+    }
+}
+
+TEST(ShardedDatabase, writeAndQuery) {
+    SQLite::ShardedDatabase db(std::vector<std::string>(3, ":memory:"));
+    db.forEachShard([](SQLite::Database& aShard, size_t)
+    {
+        aShard.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value INTEGER)");
+    });
+
+    // Keyed writes from several threads, each one in a transaction of its shard
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 4; ++w)
+    {
+        writers.emplace_back([&db, w]()
+        {
+            for (long long id = w * 100; id < (w + 1) * 100; ++id)
+            {
+                db.withShard(id, [id](SQLite::Database& aShard)
+                {
+                    SQLite::Transaction transaction(aShard);
+                    SQLite::Statement insert(aShard, "INSERT INTO test VALUES (?, ?)");
+                    insert.bind(1, id);
+                    insert.bind(2, id * 2);
+                    insert.exec();
+                    transaction.commit();
+                });
+            }
+        });
+    }
+    for (std::thread& writer : writers)
+    {
+        writer.join();
+    }
+    EXPECT_EQ(1, db.withShard(123LL, [](SQLite::Database& aShard)
+    {
+        return aShard.execAndGet("SELECT count(*) FROM test WHERE id = 123").getInt();
+    }));
+
+    // Scatter-gather: concatenated, merged in order and aggregated
+    const std::function<long long(SQLite::Statement&)> getId = [](SQLite::Statement& aQuery)
+    {
+        return aQuery.getColumn(0).getInt64();
+    };
+    std::vector<long long> ids = db.queryAll<long long>("SELECT id FROM test", getId);
+    EXPECT_EQ(400u, ids.size());
+    const std::vector<long long> merged = db.queryMerged<long long>("SELECT id FROM test ORDER BY id DESC", getId,
+                                                                    std::greater<long long>());
+    ASSERT_EQ(400u, merged.size());
+    EXPECT_EQ(399, merged.front());
+    EXPECT_EQ(0, merged.back());
+    EXPECT_TRUE(std::is_sorted(merged.begin(), merged.end(), std::greater<long long>()));
+    std::sort(ids.begin(), ids.end(), std::greater<long long>());
+    EXPECT_EQ(merged, ids);
+    EXPECT_EQ(400, db.queryAggregate("SELECT count(*) FROM test", getId, 0LL, std::plus<long long>()));
+    EXPECT_EQ(2 * 399 * 400 / 2, db.queryAggregate("SELECT sum(value) FROM test", getId, 0LL,
+                                                   std::plus<long long>()));
+    EXPECT_EQ(798, db.queryAggregate("SELECT max(value) FROM test", getId, 0LL,
+                                     [](long long a, long long b) { return std::max(a, b); }));
+
+    // The error of a shard is thrown once all the shards are done
+    std::atomic<int> done(0);
+    EXPECT_THROW(db.forEachShard([&done](SQLite::Database& aShard, size_t aIndex)
+    {
+        if (1 == aIndex)
+        {
+            aShard.exec("SELECT * FROM missing");
+        }
+        ++done;
+    }), SQLite::Exception);
+    EXPECT_EQ(2, done);
+}
+
+TEST(ShardedDatabase, ownership) {
+    // Connections without mutex are handed over from thread to thread
+    SQLite::ShardedDatabase db(std::vector<std::string>(2, ":memory:"),
+                               SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE | SQLite::OPEN_NOMUTEX);
+    db.forEachShard([](SQLite::Database& aShard, size_t)
+    {
+        aShard.exec("CREATE TABLE test (id INTEGER PRIMARY KEY)");
+    });
+    std::thread writer([&db]()
+    {
+        db.withShard(1LL, [](SQLite::Database& aShard)
+        {
+            aShard.exec("INSERT INTO test VALUES (1)");
+        });
+    });
+    writer.join();
+
+    // The calling thread takes the connections back
+    for (size_t i = 0; i < db.getShardCount(); ++i)
+    {
+        SQLite::Database& shard = db.getShard(i);
+        EXPECT_TRUE(shard.isOwnedByCurrentThread());
+        shard.exec("INSERT INTO test VALUES (2)");
+    }
+    EXPECT_EQ(3, db.queryAggregate("SELECT count(*) FROM test", [](SQLite::Statement& aQuery)
+    {
+        return aQuery.getColumn(0).getInt();
+    }, 0, std::plus<int>()));
+    EXPECT_THROW(db.getShard(2), std::out_of_range);
+}
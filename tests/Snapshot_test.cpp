@@ -0,0 +1,70 @@
+/**
+ * @file    Snapshot_test.cpp
+ * @ingroup tests
+ * @brief   Test of a SQLite WAL Snapshot.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Snapshot.h>
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Exception.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+TEST(Snapshot, openOnOtherConnections) {
+    remove("snapshot_test.db3");
+    remove("snapshot_test.db3-wal");
+    remove("snapshot_test.db3-shm");
+    {
+        SQLite::Database writer("snapshot_test.db3", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+        writer.exec("PRAGMA journal_mode=WAL");
+        writer.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        EXPECT_EQ(1, writer.exec("INSERT INTO test VALUES (NULL, \"first\")"));
+
+        // Record a snapshot from a connection with an open read transaction
+        SQLite::Database source("snapshot_test.db3", SQLite::OPEN_READWRITE);
+        source.exec("BEGIN");
+        EXPECT_EQ(1, source.execAndGet("SELECT count(*) FROM test").getInt());
+        const SQLite::Snapshot snapshot(source);
+        EXPECT_EQ("main", snapshot.getSchema());
+        EXPECT_NE(nullptr, snapshot.getHandle());
+        EXPECT_EQ(0, snapshot.compare(snapshot));
+        source.exec("COMMIT");
+
+        // The writer can go on
+        EXPECT_EQ(1, writer.exec("INSERT INTO test VALUES (NULL, \"second\")"));
+
+        // Two readers see the same, older, version of the database
+        SQLite::Database reader1("snapshot_test.db3", SQLite::OPEN_READONLY);
+        SQLite::Database reader2("snapshot_test.db3", SQLite::OPEN_READONLY);
+        reader1.exec("BEGIN");
+        snapshot.open(reader1);
+        reader2.exec("BEGIN");
+        snapshot.open(reader2);
+        EXPECT_EQ(1, reader1.execAndGet("SELECT count(*) FROM test").getInt());
+        EXPECT_EQ(1, reader2.execAndGet("SELECT count(*) FROM test").getInt());
+        reader1.exec("COMMIT");
+        reader2.exec("COMMIT");
+
+        // Outside of the snapshot, the latest version is visible
+        EXPECT_EQ(2, reader1.execAndGet("SELECT count(*) FROM test").getInt());
+
+        // Opening a snapshot requires a transaction that has not read anything yet
+        EXPECT_THROW(snapshot.open(reader1), SQLite::Exception);
+
+        // Recording a snapshot requires an open read transaction
+        EXPECT_THROW(SQLite::Snapshot noTransaction(reader1), SQLite::Exception);
+    }
+    remove("snapshot_test.db3");
+}
+
+#endif // SQLITE_ENABLE_SNAPSHOT
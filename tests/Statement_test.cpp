@@ -10,6 +10,7 @@
  */
 
 #include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Errors.h>
 #include <SQLiteCpp/Statement.h>
 
 #include <sqlite3.h> // for SQLITE_DONE
@@ -17,7 +18,9 @@
 #include <gtest/gtest.h>
 
 #include <cstdio>
+#include <stdexcept>
 #include <stdint.h>
+#include <vector>
 
 #include <climits> // For INT_MAX
 
@@ -775,3 +778,310 @@ TEST(Statement, bind64bitsLong) {
     EXPECT_EQ(4294967297L, query.getColumn(0).getInt64());
 }
 #endif
+
+TEST(Statement, getStatus) {
+    // Create a new database
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    EXPECT_EQ(0, db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)"));
+    EXPECT_EQ(3, db.exec("INSERT INTO test VALUES (1, 'c'), (2, 'b'), (3, 'a')"));
+
+    SQLite::Statement query(db, "SELECT * FROM test ORDER BY value");
+    SQLite::StatementStatus status = query.getStatus();
+    EXPECT_EQ(0, status.fullscanSteps);
+    EXPECT_EQ(0, status.sorts);
+    EXPECT_EQ(0, status.vmSteps);
+    EXPECT_LT(0, status.memUsed);
+    while (query.executeStep())
+    {
+    }
+    status = query.getStatus(true);
+    EXPECT_EQ(2, status.fullscanSteps);
+    EXPECT_EQ(1, status.sorts);
+    EXPECT_EQ(0, status.autoIndexes);
+    EXPECT_LT(0, status.vmSteps);
+    status = query.getStatus();
+    EXPECT_EQ(0, status.fullscanSteps);
+    EXPECT_EQ(0, status.sorts);
+    EXPECT_EQ(0, status.vmSteps);
+}
+
+// Full scans reported to the handler by the FullScanPolicy::Log policy
+static int sFullScanCount = 0;
+static void countFullScan(const SQLite::Statement&, const SQLite::StatementStatus& aStatus)
+{
+    EXPECT_LT(0, aStatus.fullscanSteps);
+    ++sFullScanCount;
+}
+
+// Full scan handler failing, reported as an error code by the non-throwing API
+static void throwFullScan(const SQLite::Statement&, const SQLite::StatementStatus&)
+{
+    throw std::runtime_error("full scan");
+}
+
+TEST(Statement, fullScanPolicy) {
+    // Create a new database
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    EXPECT_EQ(0, db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)"));
+    EXPECT_EQ(3, db.exec("INSERT INTO test VALUES (1, 'c'), (2, 'b'), (3, 'a')"));
+
+    // A lookup by primary key uses the index
+    SQLite::Statement lookup(db, "SELECT value FROM test WHERE id = ?");
+    lookup.setFullScanPolicy(SQLite::FullScanPolicy::Throw);
+    EXPECT_EQ(SQLite::FullScanPolicy::Throw, lookup.getFullScanPolicy());
+    lookup.bind(1, 2);
+    EXPECT_TRUE(lookup.executeStep());
+    EXPECT_FALSE(lookup.executeStep());
+
+    // A lookup by value does a full scan
+    SQLite::Statement scan(db, "SELECT id FROM test WHERE value = ?");
+    scan.bind(1, "b");
+    EXPECT_TRUE(scan.executeStep());
+    EXPECT_FALSE(scan.executeStep());
+    scan.reset();
+    scan.setFullScanPolicy(SQLite::FullScanPolicy::Throw);
+    EXPECT_TRUE(scan.executeStep());
+    EXPECT_THROW(scan.executeStep(), SQLite::Exception);
+
+    // The same with an UPDATE, reported to a custom handler
+    sFullScanCount = 0;
+    SQLite::setFullScanHandler(&countFullScan);
+    SQLite::Statement update(db, "UPDATE test SET id = id + 10 WHERE value = 'a'");
+    update.setFullScanPolicy(SQLite::FullScanPolicy::Log);
+    EXPECT_EQ(1, update.exec());
+    EXPECT_EQ(1, sFullScanCount);
+    SQLite::setFullScanHandler(nullptr);
+
+    // Once an index is created, there is no more full scan
+    db.exec("CREATE INDEX test_value ON test(value)");
+    SQLite::Statement indexed(db, "SELECT id FROM test WHERE value = ?");
+    indexed.setFullScanPolicy(SQLite::FullScanPolicy::Throw);
+    indexed.bind(1, "b");
+    EXPECT_TRUE(indexed.executeStep());
+    EXPECT_FALSE(indexed.executeStep());
+}
+
+TEST(Statement, errorCodes) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT NOT NULL)");
+    std::error_code error;
+
+    // Compilation error, without exception
+    SQLite::Statement invalid(db, "SELECT * FROM missing", error);
+    EXPECT_EQ(SQLite::Error::error, error);
+    EXPECT_EQ(0, invalid.getColumnCount());
+    EXPECT_FALSE(invalid.executeStep(error));
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    EXPECT_EQ(0, invalid.exec(error));
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.reset(error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.clearBindings(error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(1, 1, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(1, 1u, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(1, 1LL, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(1, 1.0, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(1, std::string("text"), error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(1, "text", error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(1, "blob", 4, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bindNoCopy(1, std::string("text"), error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bindNoCopy(1, "text", error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bindNoCopy(1, "blob", 4, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(1, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(":id", 1, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(":id", 1u, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(":id", 1LL, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(":id", 1.0, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(":id", std::string("text"), error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(":id", "text", error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(":id", "blob", 4, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bindNoCopy(":id", std::string("text"), error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bindNoCopy(":id", "text", error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bindNoCopy(":id", "blob", 4, error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.bind(":id", error);
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    invalid.setFullScanPolicy(SQLite::FullScanPolicy::Throw);
+    EXPECT_EQ(0, invalid.getStatus(true).vmSteps);
+    EXPECT_FALSE(invalid.executeStep(error));
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    EXPECT_NE(nullptr, invalid.getErrorMsg());
+
+    SQLite::Statement insert(db, std::string("INSERT INTO test VALUES (:id, :value)"), error);
+    EXPECT_FALSE(error);
+
+    // Bindings by index and by name
+    insert.bind(1, 1, error);
+    EXPECT_FALSE(error);
+    insert.bind(3, "out of range", error);
+    EXPECT_EQ(SQLite::Error::range, error);
+    insert.bind(":value", "first", error);
+    EXPECT_FALSE(error);
+    insert.bind(":unknown", 1.0, error);
+    EXPECT_EQ(SQLite::Error::range, error);
+    EXPECT_EQ(1, insert.exec(error));
+    EXPECT_FALSE(error);
+
+    // Constraint violations
+    insert.reset(error);
+    EXPECT_FALSE(error);
+    EXPECT_EQ(0, insert.exec(error));
+    EXPECT_EQ(SQLite::Error::constraint, error);
+    insert.reset(error);
+    EXPECT_EQ(SQLite::Error::constraint, error); // reset() returns the error of the last execution
+    insert.clearBindings(error);
+    EXPECT_FALSE(error);
+    insert.bind(":id", 2LL, error);
+    insert.bind(":value", error);
+    EXPECT_FALSE(error);
+    EXPECT_EQ(0, insert.exec(error));
+    EXPECT_EQ(SQLite::Error::constraint, error);
+    insert.reset(error);
+    insert.bindNoCopy(":value", "second", error);
+    EXPECT_EQ(1, insert.exec(error));
+    EXPECT_FALSE(error);
+
+    // exec() does not expect results
+    SQLite::Statement query(db, "SELECT value FROM test ORDER BY id", error);
+    EXPECT_EQ(0, query.exec(error));
+    EXPECT_EQ(SQLite::Error::misuse, error);
+    query.reset(error);
+    EXPECT_TRUE(query.executeStep(error));
+    EXPECT_FALSE(error);
+    EXPECT_EQ("first", query.getColumn(0).getString());
+    EXPECT_TRUE(query.executeStep(error));
+    EXPECT_FALSE(query.executeStep(error));
+    EXPECT_FALSE(error);
+    EXPECT_FALSE(query.executeStep(error));
+    EXPECT_EQ(SQLite::Error::misuse, error); // needs a reset()
+
+    // A full scan forbidden by the policy
+    SQLite::Statement scan(db, "SELECT id FROM test WHERE value = 'second'");
+    scan.setFullScanPolicy(SQLite::FullScanPolicy::Throw);
+    EXPECT_TRUE(scan.executeStep(error));
+    EXPECT_FALSE(scan.executeStep(error));
+    EXPECT_EQ(SQLite::Error::error, error);
+
+    // An exception of the full scan handler
+    SQLite::setFullScanHandler(&throwFullScan);
+    scan.reset();
+    scan.setFullScanPolicy(SQLite::FullScanPolicy::Log);
+    EXPECT_TRUE(scan.executeStep(error));
+    EXPECT_FALSE(scan.executeStep(error));
+    EXPECT_EQ(SQLite::Error::error, error);
+    SQLite::Statement update(db, "UPDATE test SET id = id + 10 WHERE value = 'second'");
+    update.setFullScanPolicy(SQLite::FullScanPolicy::Log);
+    EXPECT_EQ(0, update.exec(error));
+    EXPECT_EQ(SQLite::Error::error, error);
+    update.reset();
+    EXPECT_THROW(update.exec(), std::runtime_error);
+    SQLite::setFullScanHandler(nullptr);
+}
+
+TEST(Statement, explainQueryPlan) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+
+    // A lookup by primary key is a search, without any costly step
+    SQLite::Statement lookup(db, "SELECT value FROM test WHERE id = ?");
+    const SQLite::QueryPlan lookupPlan = lookup.explainQueryPlan();
+    ASSERT_EQ(1u, lookupPlan.steps.size());
+    EXPECT_EQ(0u, lookupPlan.steps[0].detail.find("SEARCH "));
+    EXPECT_FALSE(lookupPlan.steps[0].isFullScan());
+    EXPECT_TRUE(lookupPlan.getCostlySteps().empty());
+
+    // A sort by value scans the table and sorts it in a temporary b-tree
+    SQLite::Statement sort(db, "SELECT id FROM test WHERE value > ? ORDER BY value");
+    const SQLite::QueryPlan sortPlan = sort.explainQueryPlan();
+    ASSERT_EQ(2u, sortPlan.steps.size());
+    EXPECT_TRUE(sortPlan.steps[0].isFullScan());
+    EXPECT_EQ("SCAN test", sortPlan.steps[0].getNormalizedDetail());
+    EXPECT_TRUE(sortPlan.steps[1].usesTempBTree());
+    EXPECT_EQ(2u, sortPlan.getCostlySteps().size());
+
+    // Subqueries are sub-steps
+    SQLite::Statement subquery(db, "SELECT id FROM test WHERE value IN (SELECT value FROM test WHERE id < 10)");
+    const SQLite::QueryPlan subqueryPlan = subquery.explainQueryPlan();
+    size_t children = 0;
+    for (const SQLite::QueryPlanStep& step : subqueryPlan.steps)
+    {
+        children += step.children.size();
+    }
+    EXPECT_GT(children, 0u);
+    EXPECT_NE(std::string::npos, subqueryPlan.toString().find("\n  "));
+
+    // Old style details are normalized
+    const SQLite::QueryPlanStep oldStep = {1, 0, "SCAN TABLE test USING COVERING INDEX test_value", {}};
+    EXPECT_EQ("SCAN test USING COVERING INDEX test_value", oldStep.getNormalizedDetail());
+    const SQLite::QueryPlanStep constantRow = {1, 0, "SCAN CONSTANT ROW", {}};
+    EXPECT_FALSE(constantRow.isFullScan());
+    SQLite::QueryPlan oldPlan;
+    oldPlan.steps.push_back(oldStep);
+    ASSERT_EQ(1u, oldPlan.getCostlySteps().size());
+    EXPECT_EQ("SCAN test", oldPlan.getCostlySteps()[0]);
+
+    // The query must be valid
+    SQLite::Statement invalid(db, "SELECT 1");
+    db.exec("DROP TABLE test");
+    EXPECT_NO_THROW(invalid.explainQueryPlan());
+    EXPECT_THROW(lookup.explainQueryPlan(), SQLite::Exception);
+}
+
+TEST(Statement, move) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, msg TEXT)");
+    db.exec("INSERT INTO test VALUES (1, 'first'), (2, 'second')");
+
+    // The current row and the bindings follow the prepared statement
+    SQLite::Statement query(db, "SELECT id, msg FROM test WHERE id >= ? ORDER BY id");
+    query.bind(1, 1);
+    ASSERT_TRUE(query.executeStep());
+    SQLite::Statement moved(std::move(query));
+    EXPECT_EQ(0, query.getColumnCount());
+    EXPECT_FALSE(query.hasRow());
+    EXPECT_EQ(2, moved.getColumnCount());
+    EXPECT_TRUE(moved.hasRow());
+    EXPECT_EQ(1, moved.getColumn("id").getInt());
+    ASSERT_TRUE(moved.executeStep());
+    EXPECT_STREQ("second", moved.getColumn(1));
+
+    // A Column keeps the moved statement alive
+    const SQLite::Column column = moved.getColumn(0);
+    moved = SQLite::Statement(db, "SELECT count(*) FROM test");
+    EXPECT_EQ(2, column.getInt());
+    ASSERT_TRUE(moved.executeStep());
+    EXPECT_EQ(2, moved.getColumn(0).getInt());
+
+    // Statements can be stored by value in a container
+    std::vector<SQLite::Statement> statements;
+    for (int id = 1; id <= 2; ++id)
+    {
+        statements.emplace_back(db, "SELECT msg FROM test WHERE id = ?");
+        statements.back().bind(1, id);
+    }
+    ASSERT_TRUE(statements[0].executeStep());
+    EXPECT_STREQ("first", statements[0].getColumn(0));
+    ASSERT_TRUE(statements[1].executeStep());
+    EXPECT_STREQ("second", statements[1].getColumn(0));
+}
@@ -0,0 +1,152 @@
+/**
+ * @file    TableFunction_test.cpp
+ * @ingroup tests
+ * @brief   Test of the table-valued SQL functions streaming the rows of C++ generators.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#if (__cplusplus >= 201402L) || ( defined(_MSC_VER) && (_MSC_VER >= 1900) ) // c++14: Visual Studio 2015
+
+/// Numbers from aFirst to aLast, counting the rows generated
+static SQLite::Generator<std::tuple<long long>> range(long long aFirst, long long aLast, int& aNbRows)
+{
+    return SQLite::Generator<std::tuple<long long>>([aFirst, aLast, &aNbRows](std::tuple<long long>& aRow) mutable {
+        if (aFirst > aLast)
+        {
+            return false;
+        }
+        ++aNbRows;
+        std::get<0>(aRow) = aFirst++;
+        return true;
+    });
+}
+
+TEST(TableFunction, range) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    int nbRows = 0;
+    db.createTableFunction("range", [&nbRows](long long aFirst, long long aLast) {
+        return range(aFirst, aLast, nbRows);
+    });
+
+    // Default names of the columns: "value", and "arg1", "arg2" hidden
+    EXPECT_EQ(55, db.execAndGet("SELECT sum(value) FROM range(1, 10)").getInt());
+    EXPECT_EQ(10, nbRows);
+    EXPECT_EQ(3, db.execAndGet("SELECT count(*) FROM range WHERE arg1 = 2 AND arg2 = 4").getInt());
+    EXPECT_EQ(0, db.execAndGet("SELECT count(*) FROM range(1, 0)").getInt());
+    EXPECT_EQ("1-5", db.execAndGet("SELECT DISTINCT arg1 || '-' || arg2 FROM range(1, 5)").getString());
+
+    // A LIMIT stops the generation
+    nbRows = 0;
+    SQLite::Statement query(db, "SELECT value, rowid FROM range(1, 1000000000) LIMIT 3");
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(1, query.getColumn(0).getInt());
+    EXPECT_EQ(1, query.getColumn(1).getInt());
+    ASSERT_TRUE(query.executeStep());
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(3, query.getColumn(0).getInt());
+    EXPECT_EQ(3, query.getColumn(1).getInt());
+    EXPECT_FALSE(query.executeStep());
+    EXPECT_LE(nbRows, 4);
+
+    // Arguments from another table
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, size INTEGER)");
+    db.exec("INSERT INTO test VALUES (1, 2), (2, 3)");
+    EXPECT_EQ(9, db.execAndGet("SELECT sum(r.value) FROM test t, range(1, t.size) r").getInt());
+    EXPECT_EQ(9, db.execAndGet("SELECT sum(r.value) FROM range(1, t.size) r JOIN test t").getInt());
+
+    // All the arguments are needed
+    EXPECT_THROW(db.exec("SELECT * FROM range(1)"), SQLite::Exception);
+    EXPECT_THROW(db.exec("SELECT * FROM range"), SQLite::Exception);
+}
+
+TEST(TableFunction, names) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.createTableFunction(std::string("split"), [](const char* apText, const std::string& aSeparator) {
+        std::string text = apText;
+        size_t position = 0;
+        size_t index = 0;
+        typedef std::tuple<std::string, size_t> Token;
+        return SQLite::Generator<Token>([text, aSeparator, position, index](Token& aToken) mutable {
+            if (position > text.size())
+            {
+                return false;
+            }
+            const size_t end = std::min(text.find(aSeparator, position), text.size());
+            aToken = Token(text.substr(position, end - position), index++);
+            position = end + aSeparator.size();
+            return true;
+        });
+    }, {"token", "position", "text", "separator"});
+
+    SQLite::Statement query(db, "SELECT token, position, text FROM split('a, bc, d', ', ') ORDER BY token DESC");
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ("d", query.getColumn(0).getString());
+    EXPECT_EQ(2, query.getColumn(1).getInt());
+    EXPECT_EQ("a, bc, d", query.getColumn(2).getString());
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ("bc", query.getColumn(0).getString());
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ("a", query.getColumn(0).getString());
+    EXPECT_FALSE(query.executeStep());
+    EXPECT_EQ(1, db.execAndGet("SELECT count(*) FROM split('', ',')").getInt());
+    EXPECT_EQ(2, db.execAndGet("SELECT count(*) FROM split WHERE text = 'x;y' AND separator = ';'").getInt());
+
+    // The names must match the columns and arguments
+    EXPECT_THROW(db.createTableFunction("bad", [](int) { return SQLite::Generator<std::tuple<int>>(
+        [](std::tuple<int>&) { return false; }); }, {"value"}), SQLite::Exception);
+}
+
+TEST(TableFunction, exception) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.createTableFunction("failing", [](int aNbRows) {
+        if (aNbRows < 0)
+        {
+            throw std::invalid_argument("negative number of rows");
+        }
+        return SQLite::Generator<std::tuple<int, double>>([aNbRows](std::tuple<int, double>& aRow) mutable {
+            if (0 == aNbRows)
+            {
+                throw std::runtime_error("out of rows");
+            }
+            aRow = std::make_tuple(aNbRows, aNbRows / 2.0);
+            --aNbRows;
+            return true;
+        });
+    });
+
+    // Default names of several columns: "value1", "value2"
+    EXPECT_DOUBLE_EQ(1.5, db.execAndGet("SELECT value2 FROM failing(3) WHERE value1 = 3").getDouble());
+    try
+    {
+        db.exec("SELECT * FROM failing(-1)");
+        FAIL() << "an exception in a table-valued function must fail the statement";
+    }
+    catch (SQLite::Exception& e)
+    {
+        EXPECT_STREQ("negative number of rows", e.what());
+    }
+    try
+    {
+        db.exec("SELECT * FROM failing(2)");
+        FAIL() << "an exception in a generator must fail the statement";
+    }
+    catch (SQLite::Exception& e)
+    {
+        EXPECT_STREQ("out of rows", e.what());
+    }
+}
+
+#endif // c++14
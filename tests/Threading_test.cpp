@@ -0,0 +1,80 @@
+/**
+ * @file    Threading_test.cpp
+ * @ingroup tests
+ * @brief   Test of the threading mode of SQLite and of the ownership of the connections.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Threading.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Exception.h>
+
+#include <sqlite3.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+TEST(Threading, initialize) {
+    if (0 == sqlite3_threadsafe())
+    {
+        return; // SQLite built without thread support
+    }
+
+    // The threading mode can only be changed while SQLite is not initialized
+    sqlite3_shutdown();
+    SQLite::initialize(SQLite::ThreadingMode::MultiThread);
+    EXPECT_EQ(SQLite::ThreadingMode::MultiThread, SQLite::getThreadingMode());
+    EXPECT_NO_THROW(SQLite::initialize(SQLite::ThreadingMode::MultiThread));
+    EXPECT_THROW(SQLite::initialize(SQLite::ThreadingMode::Serialized), SQLite::Exception);
+    EXPECT_EQ(SQLite::ThreadingMode::MultiThread, SQLite::getThreadingMode());
+    {
+        SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+        EXPECT_FALSE(db.hasMutex());
+        EXPECT_TRUE(db.isOwnedByCurrentThread());
+        SQLite::Database serialized(":memory:", SQLite::OPEN_READWRITE | SQLite::OPEN_FULLMUTEX);
+        EXPECT_TRUE(serialized.hasMutex());
+
+        // Hand the connection over to another thread, then take it back
+        std::thread worker([&db]() {
+            EXPECT_FALSE(db.isOwnedByCurrentThread());
+            db.acquireOwnership();
+            EXPECT_TRUE(db.isOwnedByCurrentThread());
+            db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY)");
+        });
+        worker.join();
+        EXPECT_FALSE(db.isOwnedByCurrentThread());
+        db.acquireOwnership();
+        EXPECT_EQ(1, db.exec("INSERT INTO test VALUES (1)"));
+
+        // The owner thread follows the connection when moved
+        SQLite::Database moved(std::move(db));
+        EXPECT_TRUE(moved.isOwnedByCurrentThread());
+        EXPECT_FALSE(moved.hasMutex());
+    }
+
+    // Back to the default serialized mode
+    sqlite3_shutdown();
+    SQLite::initialize(SQLite::ThreadingMode::Serialized);
+    EXPECT_EQ(SQLite::ThreadingMode::Serialized, SQLite::getThreadingMode());
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    EXPECT_TRUE(db.hasMutex());
+    SQLite::Database nomutex(":memory:", SQLite::OPEN_READWRITE | SQLite::OPEN_NOMUTEX);
+    EXPECT_FALSE(nomutex.hasMutex());
+}
+
+TEST(Threading, sharedCache) {
+    const int flags = SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE | SQLite::OPEN_URI;
+    SQLite::Database db("file:threading?mode=memory", flags | SQLite::OPEN_SHAREDCACHE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY)");
+
+    // Another connection with a shared cache sees the same in-memory database, not one with a private cache
+    SQLite::Database shared("file:threading?mode=memory", flags | SQLite::OPEN_SHAREDCACHE);
+    EXPECT_TRUE(shared.tableExists("test"));
+    SQLite::Database priv("file:threading?mode=memory", flags | SQLite::OPEN_PRIVATECACHE);
+    EXPECT_FALSE(priv.tableExists("test"));
+}
@@ -11,6 +11,7 @@
 
 #include <SQLiteCpp/Transaction.h>
 #include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Errors.h>
 #include <SQLiteCpp/Statement.h>
 #include <SQLiteCpp/Exception.h>
 
@@ -101,3 +102,69 @@ TEST(Transaction, commitRollback) {
     }
     EXPECT_EQ(1, nbRows);
 }
+
+TEST(Transaction, errorCodes) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    std::error_code error;
+
+    {
+        SQLite::Transaction transaction(db, error);
+        EXPECT_FALSE(error);
+        EXPECT_EQ(1, db.exec("INSERT INTO test VALUES (1, 'first')"));
+
+        // A nested BEGIN fails, with nothing to rollback
+        {
+            SQLite::Transaction nested(db, error);
+            EXPECT_EQ(SQLite::Error::error, error);
+        }
+
+        transaction.commit(error);
+        EXPECT_FALSE(error);
+        transaction.commit(error);
+        EXPECT_EQ(SQLite::Error::misuse, error);
+    }
+    EXPECT_EQ(1, db.execAndGet("SELECT count(*) FROM test").getInt());
+
+    // Rollback by the destructor
+    {
+        SQLite::Transaction transaction(db, error);
+        EXPECT_FALSE(error);
+        EXPECT_EQ(1, db.exec("INSERT INTO test VALUES (2, 'second')"));
+    }
+    EXPECT_EQ(1, db.execAndGet("SELECT count(*) FROM test").getInt());
+}
+
+TEST(Transaction, move) {
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE);
+    db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    {
+        SQLite::Transaction transaction(db);
+        db.exec("INSERT INTO test VALUES (1, 'first')");
+        SQLite::Transaction moved(std::move(transaction));
+        EXPECT_THROW(transaction.commit(), SQLite::Exception); // nothing left to commit
+        moved.commit();
+    }
+    EXPECT_EQ(1, db.execAndGet("SELECT count(*) FROM test").getInt());
+
+    {
+        SQLite::Transaction transaction(db);
+        db.exec("INSERT INTO test VALUES (2, 'second')");
+        // Moving the transaction away and back keeps it pending, until rolled back at the end of the scope
+        transaction = SQLite::Transaction(std::move(transaction));
+        EXPECT_EQ(2, db.execAndGet("SELECT count(*) FROM test").getInt());
+    }
+    EXPECT_EQ(1, db.execAndGet("SELECT count(*) FROM test").getInt());
+
+    SQLite::Database other(":memory:", SQLite::OPEN_READWRITE);
+    other.exec("CREATE TABLE test (id INTEGER PRIMARY KEY)");
+    {
+        SQLite::Transaction transaction(db);
+        db.exec("INSERT INTO test VALUES (3, 'third')");
+        transaction = SQLite::Transaction(other);
+        EXPECT_EQ(1, db.execAndGet("SELECT count(*) FROM test").getInt());
+        other.exec("INSERT INTO test VALUES (1)");
+        transaction.commit();
+    }
+    EXPECT_EQ(1, other.execAndGet("SELECT count(*) FROM test").getInt());
+}
@@ -0,0 +1,110 @@
+/**
+ * @file    UringVfs_test.cpp
+ * @ingroup tests
+ * @brief   Test of the io_uring Linux VFS.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/UringVfs.h>
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+TEST(UringVfs, sequentialScan) {
+    remove("uring_test.db3");
+    SQLite::registerUringVfs(64 * 1024);
+    {
+        SQLite::Database db("uring_test.db3", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE, 0, SQLite::URING_VFS_NAME);
+        db.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        SQLite::Transaction transaction(db);
+        SQLite::Statement insert(db, "INSERT INTO test VALUES (NULL, ?)");
+        for (int i = 0; i < 2000; ++i)
+        {
+            insert.bind(1, std::string(500, static_cast<char>('a' + i % 26)));
+            insert.exec();
+            insert.reset();
+        }
+        transaction.commit();
+    }
+    {
+        // A full table scan with a small page cache is served by the read-ahead buffers
+        const SQLite::UringVfsStats before = SQLite::getUringVfsStats();
+        SQLite::Database db("uring_test.db3", SQLite::OPEN_READWRITE, 0, SQLite::URING_VFS_NAME);
+        db.exec("PRAGMA cache_size=10");
+        EXPECT_EQ(2000, db.execAndGet("SELECT count(*) FROM test WHERE length(value) = 500").getInt());
+        const SQLite::UringVfsStats after = SQLite::getUringVfsStats();
+        EXPECT_GT(after.reads - before.reads, 200u);
+        EXPECT_GT(after.readAheadRequests - before.readAheadRequests, 10u);
+        EXPECT_GT(after.readAheadHits - before.readAheadHits, (after.reads - before.reads) / 2);
+        EXPECT_GE(after.readAheadBytes - before.readAheadBytes, 1000u * 1000u);
+
+        // Changes of an other connection are visible
+        SQLite::Database writer("uring_test.db3", SQLite::OPEN_READWRITE, 1000);
+        writer.exec("UPDATE test SET value = 'updated' WHERE id % 2 = 0");
+        EXPECT_EQ(1000, db.execAndGet("SELECT count(*) FROM test WHERE value = 'updated'").getInt());
+
+        // As well as changes of this connection
+        db.exec("DELETE FROM test WHERE id > 1000");
+        EXPECT_EQ(1000, db.execAndGet("SELECT count(*) FROM test").getInt());
+        EXPECT_EQ(500, writer.execAndGet("SELECT count(*) FROM test WHERE value = 'updated'").getInt());
+    }
+    remove("uring_test.db3");
+}
+
+#ifdef F_OFD_GETLK
+// Return true if a lock of the process prevents a write lock of the given byte of the file
+static bool isLocked(const int aProbe, const off_t aOffset)
+{
+    struct flock lock;
+    std::memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = aOffset;
+    lock.l_len = 1;
+    // an open file description lock conflicts with the POSIX locks of the same process
+    return (0 == fcntl(aProbe, F_OFD_GETLK, &lock)) && (F_UNLCK != lock.l_type);
+}
+
+TEST(UringVfs, closeKeepsLocks) {
+    remove("uring_test.db3");
+    SQLite::registerUringVfs(64 * 1024);
+    SQLite::Database writer("uring_test.db3", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    writer.exec("CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    // probe kept open until the end, as closing it would release the locks of the process as well
+    const int probe = open("uring_test.db3", O_RDONLY);
+    ASSERT_LE(0, probe);
+    const off_t reservedByte = 0x40000001; // RESERVED_BYTE of os_unix.c
+    writer.exec("BEGIN IMMEDIATE");
+    writer.exec("INSERT INTO test VALUES (1, 'first')");
+    EXPECT_TRUE(isLocked(probe, reservedByte));
+
+    // A connection of the io_uring VFS reads the file then closes, while the writer holds its lock
+    {
+        SQLite::Database reader("uring_test.db3", SQLite::OPEN_READONLY, 0, SQLite::URING_VFS_NAME);
+        EXPECT_EQ(0, reader.execAndGet("SELECT count(*) FROM test").getInt());
+    }
+    EXPECT_TRUE(isLocked(probe, reservedByte));
+
+    writer.exec("COMMIT");
+    EXPECT_FALSE(isLocked(probe, reservedByte));
+    {
+        SQLite::Database reader("uring_test.db3", SQLite::OPEN_READONLY, 0, SQLite::URING_VFS_NAME);
+        EXPECT_EQ("first", reader.execAndGet("SELECT value FROM test WHERE id = 1").getString());
+    }
+    close(probe);
+    remove("uring_test.db3");
+}
+#endif // F_OFD_GETLK
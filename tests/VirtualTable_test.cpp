@@ -0,0 +1,169 @@
+/**
+ * @file    VirtualTable_test.cpp
+ * @ingroup tests
+ * @brief   Test of the virtual tables exposing C++ containers.
+ *
+ * Copyright (c) 2012-2018 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/VirtualTable.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+/// Rows of the virtual table
+struct Employee
+{
+    long long   id;
+    std::string name;
+    double      salary;
+    bool        manager;
+};
+
+/// Return the plan of a query as text
+static std::string getPlanDetail(SQLite::Database& aDb, const char* apQuery)
+{
+    return SQLite::Statement(aDb, apQuery).explainQueryPlan().toString();
+}
+
+/// Return the result of a query with a single integer column, as a text like "1,2,3"
+static std::string getIds(SQLite::Database& aDb, const char* apQuery)
+{
+    std::string ids;
+    SQLite::Statement query(aDb, apQuery);
+    while (query.executeStep())
+    {
+        if (!ids.empty())
+        {
+            ids += ",";
+        }
+        ids += query.getColumn(0).getText();
+    }
+    return ids;
+}
+
+TEST(VirtualTable, scan) {
+    std::vector<Employee> employees = {
+        { 3, "carol", 3000.5, false },
+        { 1, "alice", 1000.0, true },
+        { 2, "bob", 2000.0, false },
+    };
+    SQLite::VirtualTable<Employee> table(employees);
+    table.addColumn("id", &Employee::id, SQLite::Indexed)
+         .addColumn("name", &Employee::name)
+         .addColumn("salary", &Employee::salary)
+         .addColumn("manager", &Employee::manager);
+    EXPECT_EQ("CREATE TABLE x(\"id\" INTEGER, \"name\" TEXT, \"salary\" REAL, \"manager\" INTEGER)",
+              table.getDeclaration());
+
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.createModule("employees", table);
+
+    // Rows in the order of the vector, the rowid being the position
+    SQLite::Statement query(db, "SELECT rowid, id, name, salary, manager FROM employees");
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(0, query.getColumn(0).getInt());
+    EXPECT_EQ(3, query.getColumn(1).getInt64());
+    EXPECT_EQ("carol", query.getColumn(2).getString());
+    EXPECT_DOUBLE_EQ(3000.5, query.getColumn(3).getDouble());
+    EXPECT_EQ(0, query.getColumn(4).getInt());
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ(1, query.getColumn(0).getInt());
+    EXPECT_EQ("alice", query.getColumn(2).getString());
+    EXPECT_EQ(1, query.getColumn(4).getInt());
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_FALSE(query.executeStep());
+
+    // Read-only
+    EXPECT_THROW(db.exec("INSERT INTO employees VALUES (4, 'dave', 0, 0)"), SQLite::Exception);
+    EXPECT_THROW(db.exec("DROP TABLE employees"), SQLite::Exception);
+}
+
+TEST(VirtualTable, constraints) {
+    std::vector<Employee> employees;
+    for (long long id = 10; id > 0; --id)
+    {
+        employees.push_back({ id, "name" + std::to_string(id), 100.0 * id, false });
+    }
+    employees.push_back({ 5, "Duplicate", 500.0, false });
+    SQLite::VirtualTable<Employee> table(employees);
+    table.addColumn("id", &Employee::id, SQLite::Indexed)
+         .addColumn("name", &Employee::name, SQLite::Indexed)
+         .addColumn("salary", &Employee::salary, SQLite::Indexed);
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.createModule("employees", table);
+
+    // Equality and ranges looked up in the indexes
+    EXPECT_EQ("5,5", getIds(db, "SELECT id FROM employees WHERE id = 5"));
+    EXPECT_EQ("3,4,5,5", getIds(db, "SELECT id FROM employees WHERE id > 2 AND id <= 5 ORDER BY id"));
+    EXPECT_EQ("8,9,10", getIds(db, "SELECT id FROM employees WHERE id >= 8 ORDER BY id"));
+    EXPECT_EQ("1,2", getIds(db, "SELECT id FROM employees WHERE id < 3 ORDER BY id"));
+    EXPECT_EQ("", getIds(db, "SELECT id FROM employees WHERE id > 5 AND id < 5"));
+    EXPECT_EQ("", getIds(db, "SELECT id FROM employees WHERE id = 42"));
+    EXPECT_EQ("", getIds(db, "SELECT id FROM employees WHERE id = NULL"));
+    EXPECT_EQ("7", getIds(db, "SELECT id FROM employees WHERE name = 'name7'"));
+    EXPECT_EQ("2,3", getIds(db, "SELECT id FROM employees WHERE salary BETWEEN 150 AND 300.0 ORDER BY id"));
+    EXPECT_NE(std::string::npos, getPlanDetail(db, "SELECT * FROM employees WHERE id = ?").find("INDEX 1:"));
+
+    // Values of another type than the column, converted by SQLite
+    EXPECT_EQ("5,5", getIds(db, "SELECT id FROM employees WHERE id = '5'"));
+    EXPECT_EQ("3,4", getIds(db, "SELECT id FROM employees WHERE id > 2.5 AND id < 4.5 ORDER BY id"));
+    EXPECT_EQ("", getIds(db, "SELECT id FROM employees WHERE name = 7"));
+
+    // Other collations than BINARY are not pushed down
+    EXPECT_EQ("5", getIds(db, "SELECT id FROM employees WHERE name = 'duplicate' COLLATE NOCASE"));
+    EXPECT_EQ("", getIds(db, "SELECT id FROM employees WHERE name = 'duplicate'"));
+
+    // The index of a number gives the order of the rows
+    EXPECT_EQ("1,2,3,4,5,5,6,7,8,9,10", getIds(db, "SELECT id FROM employees ORDER BY id"));
+    EXPECT_EQ(std::string::npos, getPlanDetail(db, "SELECT * FROM employees ORDER BY id").find("TEMP B-TREE"));
+    EXPECT_EQ("10,9,8", getIds(db, "SELECT id FROM employees ORDER BY id DESC LIMIT 3"));
+
+    // Rows added are found after refresh(), the indexes being unusable until then
+    employees.push_back({ 42, "new", 0.0, false });
+    EXPECT_EQ("42", getIds(db, "SELECT id FROM employees WHERE rowid = 11"));
+    EXPECT_THROW(getIds(db, "SELECT id FROM employees WHERE id = 42"), SQLite::Exception);
+    table.refresh();
+    EXPECT_EQ("42", getIds(db, "SELECT id FROM employees WHERE id = 42"));
+    EXPECT_EQ("10,42", getIds(db, "SELECT id FROM employees WHERE id > 9 ORDER BY id"));
+}
+
+TEST(VirtualTable, join) {
+    std::vector<Employee> employees = {
+        { 1, "alice", 1000.0, true },
+        { 2, "bob", 2000.0, false },
+        { 3, "carol", 3000.0, false },
+    };
+    // Enough rows for a lookup of the employee of each order to be cheaper than scanning the employees
+    for (long long id = 100; id < 1100; ++id)
+    {
+        employees.push_back({ id, "other" + std::to_string(id), 0.0, false });
+    }
+    SQLite::VirtualTable<Employee> table(employees);
+    table.addColumn("id", &Employee::id, SQLite::Indexed).addColumn("name", &Employee::name);
+    SQLite::Database db(":memory:", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE);
+    db.createModule(std::string("employees"), table);
+    db.exec("CREATE TABLE orders (id INTEGER PRIMARY KEY, employee_id INTEGER, amount INTEGER)");
+    db.exec("INSERT INTO orders VALUES (1, 2, 10), (2, 3, 20), (3, 2, 30), (4, 4, 40)");
+
+    const char* join = "SELECT e.name, sum(o.amount) FROM orders o JOIN employees e ON e.id = o.employee_id "
+                       "GROUP BY e.name ORDER BY e.name";
+    SQLite::Statement query(db, join);
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ("bob", query.getColumn(0).getString());
+    EXPECT_EQ(40, query.getColumn(1).getInt());
+    ASSERT_TRUE(query.executeStep());
+    EXPECT_EQ("carol", query.getColumn(0).getString());
+    EXPECT_EQ(20, query.getColumn(1).getInt());
+    EXPECT_FALSE(query.executeStep());
+
+    // The equality of the join is pushed down to the index of the virtual table
+    EXPECT_NE(std::string::npos, getPlanDetail(db, join).find("VIRTUAL TABLE INDEX 1:"));
+}